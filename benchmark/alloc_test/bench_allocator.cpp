@@ -35,12 +35,14 @@
 
 #include <time.h>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "arrow/api.h"
 #include "arrow/io/api.h"
@@ -69,6 +71,7 @@ using namespace vineyard;  // NOLINT(build/namespaces)
 // #define BENCH_JEMALLOC
 // #define BENCH_VINEYARD
 // #define BENCH_VINEYARD_ARENA
+// #define BENCH_VINEYARD_BULK
 
 size_t GetMillisecondCount() {
   return std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -78,9 +81,19 @@ size_t GetMillisecondCount() {
 
 size_t iterCount = 100000000;
 
-void bench() {
+// For BENCH_VINEYARD_BULK: every thread allocates blobs from the vineyardd
+// listening on this socket with its own client, i.e., drives the bulk
+// allocator of vineyardd from concurrent IPC connections.
+std::string ipcSocket;
+
+void bench(size_t const thread_id) {
   size_t start = GetMillisecondCount();
 
+#if defined(BENCH_VINEYARD_BULK)
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipcSocket));
+#endif
+
   size_t maxItems = 1 << 18;   // 512 KB
   size_t maxItemSizeExp = 10;  // 1K
 
@@ -103,6 +116,9 @@ void bench() {
   };
 
   TestBin* baseBuff = nullptr;
+#if defined(BENCH_VINEYARD_BULK)
+  std::vector<std::unique_ptr<BlobWriter>> blobs(maxItems);
+#endif
 #if defined(BENCH_SYSTEM)
   baseBuff = reinterpret_cast<TestBin*>(malloc(maxItems * sizeof(TestBin)));
 #elif defined(BENCH_JEMALLOC)
@@ -137,6 +153,9 @@ void bench() {
         vineyard_free(baseBuff[idx].ptr);
 #elif defined(BENCH_VINEYARD_ARENA)
         vineyard_arena_free(baseBuff[idx].ptr);
+#elif defined(BENCH_VINEYARD_BULK)
+        VINEYARD_CHECK_OK(blobs[idx]->Abort(client));
+        blobs[idx].reset();
 #else
         free(baseBuff[idx].ptr);
 #endif
@@ -155,6 +174,9 @@ void bench() {
 #elif defined(BENCH_VINEYARD_ARENA)
         baseBuff[idx].ptr =
             reinterpret_cast<uint8_t*>(vineyard_arena_malloc(sz));
+#elif defined(BENCH_VINEYARD_BULK)
+        VINEYARD_CHECK_OK(client.CreateBlob(sz, blobs[idx]));
+        baseBuff[idx].ptr = reinterpret_cast<uint8_t*>(blobs[idx]->data());
 #else
         baseBuff[idx].ptr = reinterpret_cast<uint8_t*>(malloc(sz));
 #endif
@@ -166,20 +188,50 @@ void bench() {
     }
   }
 
+#if defined(BENCH_VINEYARD_BULK)
+  for (auto& blob : blobs) {
+    if (blob) {
+      VINEYARD_CHECK_OK(blob->Abort(client));
+    }
+  }
+  client.Disconnect();
+#endif
+
   size_t elapsed = GetMillisecondCount() - start;
-  LOG(INFO) << "usage: " << elapsed << " milliseconds";
+  LOG(INFO) << "thread " << thread_id << " usage: " << elapsed
+            << " milliseconds";
 }
 
 int main(int argc, char** argv) {
   if (argc < 1) {
-    printf("usage ./bench_allocator [<iterations>]");
+    printf("usage ./bench_allocator [<iterations>] [<threads>] [<ipc_socket>]");
     return 1;
   }
   if (argc >= 2) {
     iterCount = static_cast<size_t>(atoll(argv[1]));
   }
+  size_t threads = 1;
+  if (argc >= 3) {
+    threads = static_cast<size_t>(atoll(argv[2]));
+  }
+  if (argc >= 4) {
+    ipcSocket = argv[3];
+  } else {
+    ipcSocket = read_env("VINEYARD_IPC_SOCKET");
+  }
 
-  bench();
+  size_t start = GetMillisecondCount();
+  std::vector<std::thread> workers;
+  for (size_t thread_id = 0; thread_id < threads; ++thread_id) {
+    workers.emplace_back(bench, thread_id);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  size_t elapsed = GetMillisecondCount() - start;
+  LOG(INFO) << threads << " threads usage: " << elapsed << " milliseconds, "
+            << (iterCount * threads * 1000.0 / std::max<size_t>(elapsed, 1))
+            << " operations per second";
 
   LOG(INFO) << "Finish allocator benchmarks...";
   return 0;
@@ -0,0 +1,130 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Measures the scalability of building the CSR of `ArrowFragment` (see Note
+// [Parallel CSR construction] in graph/fragment/property_graph_utils.h) over
+// the number of threads, on a synthetic graph with power-law degrees.
+//
+// See benchmark/csr_build_bench/README.md for the usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arrow/api.h"
+
+#include "common/util/logging.h"
+#include "graph/fragment/property_graph_types.h"
+#include "graph/fragment/property_graph_utils.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+using vid_t = property_graph_types::VID_TYPE;
+using eid_t = property_graph_types::EID_TYPE;
+using vid_array_t = typename ConvertToArrowType<vid_t>::ArrayType;
+
+namespace {
+
+// the src/dst gids of edges, where the src vertices follow a power-law
+// distribution, with vertex 0 as the largest hub.
+void Generate(const IdParser<vid_t>& parser, int64_t vnum, int64_t enum_,
+              std::shared_ptr<vid_array_t>& src_list,
+              std::shared_ptr<vid_array_t>& dst_list) {
+  std::mt19937_64 rng(20211019);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::vector<vid_t> srcs(enum_), dsts(enum_);
+  for (int64_t i = 0; i < enum_; ++i) {
+    int64_t src = static_cast<int64_t>(std::pow(uniform(rng), 4) * vnum);
+    srcs[i] = parser.GenerateId(0, 0, std::min(src, vnum - 1));
+    dsts[i] = parser.GenerateId(0, 0, static_cast<int64_t>(rng() % vnum));
+  }
+  typename ConvertToArrowType<vid_t>::BuilderType builder;
+  CHECK(builder.AppendValues(srcs).ok());
+  CHECK(builder.Finish(&src_list).ok());
+  CHECK(builder.AppendValues(dsts).ok());
+  CHECK(builder.Finish(&dst_list).ok());
+}
+
+template <typename FN>
+double Measure(const FN& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int64_t vnum = argc > 1 ? std::atoll(argv[1]) : 1 << 22;
+  int64_t avg_degree = argc > 2 ? std::atoll(argv[2]) : 16;
+  int max_concurrency = argc > 3 ? std::atoi(argv[3])
+                                 : std::thread::hardware_concurrency();
+  bool directed = argc > 4 ? std::atoi(argv[4]) != 0 : true;
+  int64_t enum_ = vnum * avg_degree;
+
+  IdParser<vid_t> parser;
+  parser.Init(1, 1);
+  std::shared_ptr<vid_array_t> src_list, dst_list;
+  Generate(parser, vnum, enum_, src_list, dst_list);
+  std::vector<vid_t> tvnums{static_cast<vid_t>(vnum)};
+  std::cout << "vertices: " << vnum << ", edges: " << enum_
+            << ", directed: " << directed << std::endl;
+
+  std::shared_ptr<arrow::FixedSizeBinaryArray> expected_edges;
+  double serial_time = 0;
+  std::vector<int> concurrencies;
+  for (int concurrency = 1; concurrency < max_concurrency; concurrency *= 2) {
+    concurrencies.push_back(concurrency);
+  }
+  concurrencies.push_back(max_concurrency);
+  for (int concurrency : concurrencies) {
+    std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>> edges(1);
+    std::vector<std::shared_ptr<arrow::Int64Array>> offsets(1);
+    bool is_multigraph = false;
+    double time = Measure([&]() {
+      if (directed) {
+        generate_directed_csr<vid_t, eid_t>(parser, src_list, dst_list,
+                                            tvnums, 1, concurrency, edges,
+                                            offsets, is_multigraph)
+            .value();
+      } else {
+        generate_undirected_csr<vid_t, eid_t>(parser, src_list, dst_list,
+                                              tvnums, 1, concurrency, edges,
+                                              offsets, is_multigraph)
+            .value();
+      }
+    });
+    if (concurrency == 1) {
+      serial_time = time;
+      expected_edges = edges[0];
+    } else {
+      // the result doesn't depend on the concurrency
+      CHECK(expected_edges->Equals(edges[0]));
+    }
+    std::cout << "threads " << concurrency << ": " << time * 1000 << " ms ("
+              << edges[0]->length() / time / 1e6 << " M edges/s, speedup "
+              << serial_time / time << ")" << std::endl;
+  }
+  return 0;
+}
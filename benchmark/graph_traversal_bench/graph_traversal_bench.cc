@@ -0,0 +1,239 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Compares traversals over the default CSR of `ArrowFragment` (an `NbrUnit`
+// per edge) and over the compact layout (see Note [Compact adjacency lists]
+// in graph/fragment/compact_adj_list.h), on a synthetic power-law graph.
+//
+// See benchmark/graph_traversal_bench/README.md for the usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "arrow/api.h"
+
+#include "common/util/logging.h"
+#include "graph/fragment/compact_adj_list.h"
+#include "graph/fragment/property_graph_types.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+using vid_t = property_graph_types::VID_TYPE;
+using eid_t = property_graph_types::EID_TYPE;
+using nbr_unit_t = property_graph_utils::NbrUnit<vid_t, eid_t>;
+using adj_list_t = property_graph_utils::AdjList<vid_t, eid_t>;
+using compact_adj_list_t = property_graph_utils::CompactAdjList<vid_t, eid_t>;
+
+namespace {
+
+// the graph in both layouts
+struct Graph {
+  int64_t vnum = 0;
+  std::shared_ptr<arrow::FixedSizeBinaryArray> edges;
+  std::shared_ptr<arrow::Int64Array> offsets;
+  std::shared_ptr<arrow::UInt8Array> compact_edges;
+  std::shared_ptr<arrow::Int64Array> compact_offsets;
+  std::shared_ptr<arrow::UInt8Array> compact_eids;
+
+  adj_list_t plain(int64_t v) const {
+    const nbr_unit_t* nbrs =
+        reinterpret_cast<const nbr_unit_t*>(edges->raw_values());
+    const int64_t* offset = offsets->raw_values();
+    return adj_list_t(nbrs + offset[v], nbrs + offset[v + 1], nullptr);
+  }
+
+  compact_adj_list_t compact(int64_t v) const {
+    const int64_t* offset = offsets->raw_values();
+    return compact_adj_list_t(
+        compact_edges->raw_values() + compact_offsets->raw_values()[v],
+        compact_eids->raw_values(), offset[v], offset[v + 1], nullptr);
+  }
+};
+
+// a power-law out-degree distribution, with the neighbors clustered around
+// the source vertex, as the vertex ids after a locality-aware partitioning.
+Graph Generate(int64_t vnum, int64_t avg_degree, int concurrency) {
+  std::mt19937_64 rng(20211019);
+  std::vector<int64_t> offsets(vnum + 1, 0);
+  std::exponential_distribution<double> degree(1.0 / avg_degree);
+  for (int64_t v = 0; v < vnum; ++v) {
+    offsets[v + 1] = offsets[v] + static_cast<int64_t>(degree(rng));
+  }
+  int64_t enum_ = offsets[vnum];
+  std::vector<eid_t> eids(enum_);
+  for (int64_t e = 0; e < enum_; ++e) {
+    eids[e] = e;
+  }
+  std::shuffle(eids.begin(), eids.end(), rng);
+
+  auto buffer = arrow::AllocateBuffer(enum_ * sizeof(nbr_unit_t)).ValueOrDie();
+  nbr_unit_t* nbrs = reinterpret_cast<nbr_unit_t*>(buffer->mutable_data());
+  std::normal_distribution<double> distance(0, vnum / 64.0);
+  for (int64_t v = 0; v < vnum; ++v) {
+    for (int64_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+      int64_t u = (v + static_cast<int64_t>(distance(rng))) % vnum;
+      nbrs[e].vid = static_cast<vid_t>(u < 0 ? u + vnum : u);
+      nbrs[e].eid = eids[e];
+    }
+    std::sort(nbrs + offsets[v], nbrs + offsets[v + 1],
+              [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
+                return lhs.vid < rhs.vid;
+              });
+  }
+
+  Graph graph;
+  graph.vnum = vnum;
+  graph.edges = std::make_shared<arrow::FixedSizeBinaryArray>(
+      arrow::fixed_size_binary(sizeof(nbr_unit_t)), enum_,
+      std::shared_ptr<arrow::Buffer>(std::move(buffer)));
+  arrow::Int64Builder builder;
+  CHECK(builder.AppendValues(offsets).ok());
+  CHECK(builder.Finish(&graph.offsets).ok());
+  generate_compact_csr<vid_t, eid_t>(graph.edges, graph.offsets, concurrency,
+                                     graph.compact_edges,
+                                     graph.compact_offsets, graph.compact_eids)
+      .value();
+  return graph;
+}
+
+template <typename ADJ_LIST_FN>
+int64_t BFS(const Graph& graph, const ADJ_LIST_FN& adj_list) {
+  std::vector<int64_t> depth(graph.vnum, -1);
+  std::vector<int64_t> current, next;
+  current.push_back(0);
+  depth[0] = 0;
+  int64_t visited = 1;
+  for (int64_t level = 1; !current.empty(); ++level) {
+    next.clear();
+    for (int64_t v : current) {
+      for (auto& e : adj_list(v)) {
+        int64_t u = e.neighbor().GetValue();
+        if (depth[u] == -1) {
+          depth[u] = level;
+          next.push_back(u);
+        }
+      }
+    }
+    visited += next.size();
+    current.swap(next);
+  }
+  return visited;
+}
+
+template <typename ADJ_LIST_FN>
+double PageRank(const Graph& graph, const ADJ_LIST_FN& adj_list,
+                int iterations) {
+  std::vector<double> rank(graph.vnum, 1.0 / graph.vnum);
+  std::vector<double> next(graph.vnum);
+  for (int i = 0; i < iterations; ++i) {
+    std::fill(next.begin(), next.end(), 0.15 / graph.vnum);
+    for (int64_t v = 0; v < graph.vnum; ++v) {
+      auto adj = adj_list(v);
+      if (adj.Empty()) {
+        continue;
+      }
+      double delta = 0.85 * rank[v] / adj.Size();
+      for (auto& e : adj) {
+        next[e.neighbor().GetValue()] += delta;
+      }
+    }
+    rank.swap(next);
+  }
+  return rank[0];
+}
+
+// reads the edge ids as well, e.g., to access the edge properties
+template <typename ADJ_LIST_FN>
+eid_t ScanEdges(const Graph& graph, const ADJ_LIST_FN& adj_list) {
+  eid_t checksum = 0;
+  for (int64_t v = 0; v < graph.vnum; ++v) {
+    for (auto& e : adj_list(v)) {
+      checksum += e.neighbor().GetValue() ^ e.edge_id();
+    }
+  }
+  return checksum;
+}
+
+template <typename FN>
+double Measure(const FN& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+void Report(const std::string& name, int64_t edges, double plain,
+            double compact) {
+  std::cout << name << ": plain " << plain * 1000 << " ms ("
+            << edges / plain / 1e6 << " MTEPS), compact " << compact * 1000
+            << " ms (" << edges / compact / 1e6 << " MTEPS)" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int64_t vnum = argc > 1 ? std::atoll(argv[1]) : 1 << 24;
+  int64_t avg_degree = argc > 2 ? std::atoll(argv[2]) : 16;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+  int concurrency = argc > 4 ? std::atoi(argv[4]) : 8;
+
+  Graph graph = Generate(vnum, avg_degree, concurrency);
+  int64_t enum_ = graph.offsets->raw_values()[vnum];
+  auto plain = [&graph](int64_t v) { return graph.plain(v); };
+  auto compact = [&graph](int64_t v) { return graph.compact(v); };
+
+  double plain_bytes = graph.edges->length() * sizeof(nbr_unit_t);
+  double compact_bytes = graph.compact_edges->length() +
+                         graph.compact_offsets->length() * sizeof(int64_t) +
+                         graph.compact_eids->length();
+  std::cout << "vertices: " << vnum << ", edges: " << enum_ << std::endl;
+  std::cout << "adjacency bytes per edge: plain " << plain_bytes / enum_
+            << ", compact " << compact_bytes / enum_ << " (neighbors "
+            << static_cast<double>(graph.compact_edges->length()) / enum_
+            << ", eids "
+            << static_cast<double>(graph.compact_eids->length()) / enum_
+            << ")" << std::endl;
+
+  int64_t plain_visited = 0, compact_visited = 0;
+  double plain_time = Measure([&]() { plain_visited = BFS(graph, plain); });
+  double compact_time =
+      Measure([&]() { compact_visited = BFS(graph, compact); });
+  CHECK_EQ(plain_visited, compact_visited);
+  Report("bfs", enum_, plain_time, compact_time);
+
+  double plain_rank = 0, compact_rank = 0;
+  plain_time =
+      Measure([&]() { plain_rank = PageRank(graph, plain, iterations); });
+  compact_time =
+      Measure([&]() { compact_rank = PageRank(graph, compact, iterations); });
+  CHECK_EQ(plain_rank, compact_rank);
+  Report("pagerank (per iteration)", enum_, plain_time / iterations,
+         compact_time / iterations);
+
+  eid_t plain_checksum = 0, compact_checksum = 0;
+  plain_time = Measure([&]() { plain_checksum = ScanEdges(graph, plain); });
+  compact_time =
+      Measure([&]() { compact_checksum = ScanEdges(graph, compact); });
+  CHECK_EQ(plain_checksum, compact_checksum);
+  Report("scan with eids", enum_, plain_time, compact_time);
+  return 0;
+}
@@ -0,0 +1,297 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Compares reading the edge and neighbor properties through the adjacency
+// lists of `ArrowFragment` (`Nbr::get_data()` per edge) and through the bulk
+// gathers (see Note [Neighbor gathers] in graph/fragment/gather_kernels.h),
+// on a synthetic power-law graph.
+//
+// See benchmark/neighbor_gather_bench/README.md for the usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/util/logging.h"
+#include "graph/fragment/gather_kernels.h"
+#include "graph/fragment/property_graph_types.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+using vid_t = property_graph_types::VID_TYPE;
+using eid_t = property_graph_types::EID_TYPE;
+using nbr_unit_t = property_graph_utils::NbrUnit<vid_t, eid_t>;
+using adj_list_t = property_graph_utils::AdjList<vid_t, eid_t>;
+
+namespace {
+
+// the vertices are processed in chunks, as `GatherOutgoingEdges()` over a
+// vertex range, to keep the gathered arrays in the cache
+constexpr int64_t kChunkSize = 256;
+
+struct Graph {
+  int64_t vnum = 0;
+  std::vector<int64_t> offsets;
+  std::vector<nbr_unit_t> edges;
+  // the edge weights, in the order of the eids
+  std::vector<double> weights;
+  const void* edata_arrays[1];
+
+  adj_list_t adj_list(int64_t v) const {
+    return adj_list_t(&edges[offsets[v]], &edges[offsets[v + 1]],
+                      const_cast<const void**>(edata_arrays));
+  }
+};
+
+// a power-law degree distribution, with the eids shuffled as the edges are
+// sorted by the source vertices when building the CSR
+void Generate(int64_t vnum, int64_t avg_degree, Graph& graph) {
+  std::mt19937_64 rng(20211019);
+  graph.vnum = vnum;
+  graph.offsets.assign(vnum + 1, 0);
+  std::exponential_distribution<double> degree(1.0 / avg_degree);
+  for (int64_t v = 0; v < vnum; ++v) {
+    graph.offsets[v + 1] = graph.offsets[v] + static_cast<int64_t>(degree(rng));
+  }
+  int64_t enum_ = graph.offsets[vnum];
+  std::vector<eid_t> eids(enum_);
+  for (int64_t e = 0; e < enum_; ++e) {
+    eids[e] = e;
+  }
+  std::shuffle(eids.begin(), eids.end(), rng);
+
+  graph.edges.resize(enum_);
+  std::uniform_int_distribution<int64_t> nbr(0, vnum - 1);
+  for (int64_t v = 0; v < vnum; ++v) {
+    for (int64_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+      graph.edges[e].vid = static_cast<vid_t>(nbr(rng));
+      graph.edges[e].eid = eids[e];
+    }
+    std::sort(&graph.edges[graph.offsets[v]],
+              &graph.edges[graph.offsets[v + 1]],
+              [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
+                return lhs.vid < rhs.vid;
+              });
+  }
+  graph.weights.resize(enum_);
+  std::uniform_real_distribution<double> weight(1.0, 100.0);
+  for (int64_t e = 0; e < enum_; ++e) {
+    graph.weights[e] = weight(rng);
+  }
+  graph.edata_arrays[0] = graph.weights.data();
+}
+
+// relaxes all edges per round, reading the weights per edge
+std::vector<double> SSSPByAdjList(const Graph& graph, int rounds) {
+  std::vector<double> dist(graph.vnum, std::numeric_limits<double>::max());
+  dist[0] = 0;
+  for (int round = 0; round < rounds; ++round) {
+    for (int64_t v = 0; v < graph.vnum; ++v) {
+      if (dist[v] == std::numeric_limits<double>::max()) {
+        continue;
+      }
+      for (auto& e : graph.adj_list(v)) {
+        double d = dist[v] + e.get_data<double>(0);
+        vid_t u = e.get_neighbor().GetValue();
+        if (d < dist[u]) {
+          dist[u] = d;
+        }
+      }
+    }
+  }
+  return dist;
+}
+
+// the same relaxations, with the weights gathered per chunk of vertices
+std::vector<double> SSSPByGather(const Graph& graph, int rounds) {
+  std::vector<double> dist(graph.vnum, std::numeric_limits<double>::max());
+  dist[0] = 0;
+  std::vector<double> weights;
+  for (int round = 0; round < rounds; ++round) {
+    for (int64_t begin = 0; begin < graph.vnum; begin += kChunkSize) {
+      int64_t end = std::min(begin + kChunkSize, graph.vnum);
+      int64_t base = graph.offsets[begin];
+      const nbr_unit_t* edges = &graph.edges[base];
+      weights.resize(graph.offsets[end] - base);
+      property_graph_utils::gather_by_eids(graph.weights.data(), edges,
+                                           weights.size(), weights.data());
+      for (int64_t v = begin; v < end; ++v) {
+        if (dist[v] == std::numeric_limits<double>::max()) {
+          continue;
+        }
+        for (int64_t e = graph.offsets[v] - base;
+             e < graph.offsets[v + 1] - base; ++e) {
+          double d = dist[v] + weights[e];
+          if (d < dist[edges[e].vid]) {
+            dist[edges[e].vid] = d;
+          }
+        }
+      }
+    }
+  }
+  return dist;
+}
+
+// pull-style pagerank, reading the contribution of every neighbor
+std::vector<double> PageRankByAdjList(const Graph& graph, int iterations) {
+  std::vector<double> rank(graph.vnum, 1.0 / graph.vnum);
+  std::vector<double> contrib(graph.vnum);
+  for (int i = 0; i < iterations; ++i) {
+    for (int64_t v = 0; v < graph.vnum; ++v) {
+      int64_t degree = graph.offsets[v + 1] - graph.offsets[v];
+      contrib[v] = degree == 0 ? 0 : rank[v] / degree;
+    }
+    for (int64_t v = 0; v < graph.vnum; ++v) {
+      double sum = 0;
+      for (auto& e : graph.adj_list(v)) {
+        sum += contrib[e.get_neighbor().GetValue()];
+      }
+      rank[v] = 0.15 / graph.vnum + 0.85 * sum;
+    }
+  }
+  return rank;
+}
+
+// the same pagerank, with the contributions of the neighbors gathered per
+// chunk of vertices
+std::vector<double> PageRankByGather(const Graph& graph, int iterations) {
+  std::vector<double> rank(graph.vnum, 1.0 / graph.vnum);
+  std::vector<double> contrib(graph.vnum);
+  std::vector<double> values;
+  for (int i = 0; i < iterations; ++i) {
+    for (int64_t v = 0; v < graph.vnum; ++v) {
+      int64_t degree = graph.offsets[v + 1] - graph.offsets[v];
+      contrib[v] = degree == 0 ? 0 : rank[v] / degree;
+    }
+    for (int64_t begin = 0; begin < graph.vnum; begin += kChunkSize) {
+      int64_t end = std::min(begin + kChunkSize, graph.vnum);
+      int64_t base = graph.offsets[begin];
+      values.resize(graph.offsets[end] - base);
+      property_graph_utils::gather_by_nbrs(contrib.data(), &graph.edges[base],
+                                           values.size(), values.data());
+      for (int64_t v = begin; v < end; ++v) {
+        double sum = 0;
+        for (int64_t e = graph.offsets[v] - base;
+             e < graph.offsets[v + 1] - base; ++e) {
+          sum += values[e];
+        }
+        rank[v] = 0.15 / graph.vnum + 0.85 * sum;
+      }
+    }
+  }
+  return rank;
+}
+
+// collects the dense arrays of the neighbors, eids and weights of all edges,
+// e.g., to feed the features of the neighbors to a model
+struct Collected {
+  std::vector<vid_t> nbrs;
+  std::vector<eid_t> eids;
+  std::vector<double> weights;
+
+  bool operator==(const Collected& rhs) const {
+    return nbrs == rhs.nbrs && eids == rhs.eids && weights == rhs.weights;
+  }
+};
+
+void CollectByAdjList(const Graph& graph, Collected& collected) {
+  collected.nbrs.clear();
+  collected.eids.clear();
+  collected.weights.clear();
+  for (int64_t v = 0; v < graph.vnum; ++v) {
+    for (auto& e : graph.adj_list(v)) {
+      collected.nbrs.push_back(e.get_neighbor().GetValue());
+      collected.eids.push_back(e.edge_id());
+      collected.weights.push_back(e.get_data<double>(0));
+    }
+  }
+}
+
+void CollectByGather(const Graph& graph, Collected& collected) {
+  size_t size = graph.edges.size();
+  collected.nbrs.resize(size);
+  collected.eids.resize(size);
+  collected.weights.resize(size);
+  property_graph_utils::gather_nbr_units(graph.edges.data(), size,
+                                         collected.nbrs.data(),
+                                         collected.eids.data());
+  property_graph_utils::gather(graph.weights.data(), collected.eids.data(),
+                               size, collected.weights.data());
+}
+
+template <typename FN>
+double Measure(const FN& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+void Report(const std::string& name, int64_t edges, double adj_list,
+            double gather) {
+  std::cout << name << ": adj list " << adj_list * 1000 << " ms ("
+            << edges / adj_list / 1e6 << " MTEPS), gather " << gather * 1000
+            << " ms (" << edges / gather / 1e6 << " MTEPS)" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int64_t vnum = argc > 1 ? std::atoll(argv[1]) : 1 << 24;
+  int64_t avg_degree = argc > 2 ? std::atoll(argv[2]) : 16;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 5;
+
+  Graph graph;
+  Generate(vnum, avg_degree, graph);
+  int64_t enum_ = graph.offsets[vnum];
+  std::cout << "vertices: " << vnum << ", edges: " << enum_
+            << ", gather isa: "
+            << static_cast<int>(gather_detail::gather_isa())
+            << " (0: scalar, 1: avx2, 2: avx512)" << std::endl;
+
+  std::vector<double> expected, actual;
+  double adj_list_time =
+      Measure([&]() { expected = SSSPByAdjList(graph, iterations); });
+  double gather_time =
+      Measure([&]() { actual = SSSPByGather(graph, iterations); });
+  CHECK(expected == actual);
+  Report("sssp (per round)", enum_, adj_list_time / iterations,
+         gather_time / iterations);
+
+  adj_list_time =
+      Measure([&]() { expected = PageRankByAdjList(graph, iterations); });
+  gather_time =
+      Measure([&]() { actual = PageRankByGather(graph, iterations); });
+  CHECK(expected == actual);
+  Report("pagerank (per iteration)", enum_, adj_list_time / iterations,
+         gather_time / iterations);
+
+  // warms up the arrays, to exclude the page faults
+  Collected expected_collected, actual_collected;
+  CollectByGather(graph, expected_collected);
+  CollectByGather(graph, actual_collected);
+  adj_list_time =
+      Measure([&]() { CollectByAdjList(graph, expected_collected); });
+  gather_time = Measure([&]() { CollectByGather(graph, actual_collected); });
+  CHECK(expected_collected == actual_collected);
+  Report("collect", enum_, adj_list_time, gather_time);
+  return 0;
+}
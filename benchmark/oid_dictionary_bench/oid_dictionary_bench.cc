@@ -0,0 +1,185 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Measures converting a chunk of string oids to gids, as the edge loading
+// does (see Note [Dictionary-encoded oids] in
+// graph/loader/fragment_loader_utils.h), row by row and through the
+// `OidDictionary`, on columns of low, power-law and unique cardinality.
+//
+// See benchmark/oid_dictionary_bench/README.md for the usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arrow/api.h"
+#include "flat_hash_map/flat_hash_map.hpp"
+
+#include "common/util/arrow.h"
+#include "common/util/logging.h"
+#include "graph/fragment/property_graph_types.h"
+#include "graph/loader/fragment_loader_utils.h"
+#include "graph/utils/partitioner.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+using oid_t = std::string;
+using vid_t = property_graph_types::VID_TYPE;
+using internal_oid_t = typename InternalType<oid_t>::type;
+using oid_array_t = typename ConvertToArrowType<oid_t>::ArrayType;
+
+namespace {
+
+constexpr fid_t kFragmentNum = 4;
+
+// stands for the vertex map: the hash index of the oids, of all fragments
+using index_t = ska::flat_hash_map<internal_oid_t, int64_t>;
+
+std::shared_ptr<oid_array_t> MakeOids(const std::vector<int64_t>& vertices) {
+  typename ConvertToArrowType<oid_t>::BuilderType builder;
+  for (auto v : vertices) {
+    CHECK_ARROW_ERROR(builder.Append("vertex_" + std::to_string(v)));
+  }
+  std::shared_ptr<oid_array_t> oids;
+  CHECK_ARROW_ERROR(builder.Finish(&oids));
+  return oids;
+}
+
+// resolves the gids as the row by row lookups of the edge loading do, i.e.,
+// hashes the oid for the partitioner and again for the vertex map
+void Resolve(const index_t& index, const HashPartitioner<oid_t>& partitioner,
+             const IdParser<vid_t>& parser, const internal_oid_t* oids,
+             size_t size, vid_t* gids) {
+  for (size_t k = 0; k < size; ++k) {
+    fid_t fid = partitioner.GetPartitionId(oid_t(oids[k]));
+    gids[k] = parser.GenerateId(fid, 0, index.at(oids[k]));
+  }
+}
+
+void RowByRow(const index_t& index, const HashPartitioner<oid_t>& partitioner,
+              const IdParser<vid_t>& parser, const oid_array_t& array,
+              std::vector<vid_t>& gids) {
+  size_t size = array.length();
+  std::vector<internal_oid_t> oids(size);
+  for (size_t k = 0; k < size; ++k) {
+    oids[k] = array.GetView(k);
+  }
+  gids.resize(size);
+  Resolve(index, partitioner, parser, oids.data(), size, gids.data());
+}
+
+// returns the number of distinct oids, or -1 if the chunk falls back to the
+// row by row lookups
+int64_t Dictionary(const index_t& index,
+                const HashPartitioner<oid_t>& partitioner,
+                const IdParser<vid_t>& parser, const oid_array_t& array,
+                std::vector<vid_t>& gids) {
+  OidDictionary<oid_t> dictionary;
+  if (!dictionary.Encode(array)) {
+    RowByRow(index, partitioner, parser, array, gids);
+    return -1;
+  }
+  auto& values = dictionary.values();
+  std::vector<vid_t> distinct_gids(values.size());
+  Resolve(index, partitioner, parser, values.data(), values.size(),
+          distinct_gids.data());
+  size_t size = array.length();
+  const int32_t* codes = dictionary.codes().data();
+  gids.resize(size);
+  for (size_t k = 0; k < size; ++k) {
+    gids[k] = distinct_gids[codes[k]];
+  }
+  return static_cast<int64_t>(values.size());
+}
+
+template <typename FN>
+double Measure(const FN& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int64_t vnum = argc > 1 ? std::atoll(argv[1]) : 1 << 22;
+  int64_t rows = argc > 2 ? std::atoll(argv[2]) : 1 << 22;
+  // the unique column needs as many vertices as rows
+  rows = std::min(rows, vnum);
+
+  auto vertex_oids = MakeOids([&]() {
+    std::vector<int64_t> vertices(vnum);
+    std::iota(vertices.begin(), vertices.end(), 0);
+    return vertices;
+  }());
+  index_t index;
+  for (int64_t v = 0; v < vnum; ++v) {
+    index.emplace(vertex_oids->GetView(v), v);
+  }
+  HashPartitioner<oid_t> partitioner;
+  partitioner.Init(kFragmentNum);
+  IdParser<vid_t> parser;
+  parser.Init(kFragmentNum, 1);
+  std::cout << "vertices: " << vnum << ", rows per chunk: " << rows
+            << std::endl;
+
+  std::mt19937_64 rng(20211019);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::vector<std::pair<std::string, std::vector<int64_t>>> workloads(3);
+  workloads[0].first = "low";
+  workloads[1].first = "power-law";
+  workloads[2].first = "unique";
+  for (int64_t i = 0; i < rows; ++i) {
+    workloads[0].second.push_back(static_cast<int64_t>(rng() % 1024));
+    int64_t v = static_cast<int64_t>(std::pow(uniform(rng), 4) * vnum);
+    workloads[1].second.push_back(std::min(v, vnum - 1));
+  }
+  workloads[2].second.resize(vnum);
+  std::iota(workloads[2].second.begin(), workloads[2].second.end(), 0);
+  std::shuffle(workloads[2].second.begin(), workloads[2].second.end(), rng);
+  workloads[2].second.resize(rows);
+
+  for (auto const& workload : workloads) {
+    auto oids = MakeOids(workload.second);
+    std::vector<vid_t> expected, gids;
+    double row_time = Measure(
+        [&]() { RowByRow(index, partitioner, parser, *oids, expected); });
+    int64_t distinct = -1;
+    double dictionary_time = Measure([&]() {
+      distinct = Dictionary(index, partitioner, parser, *oids, gids);
+    });
+    CHECK(expected == gids);
+
+    std::cout << workload.first << ": row by row " << row_time * 1000
+              << " ms (" << rows / row_time / 1e6 << " M rows/s), dictionary "
+              << dictionary_time * 1000 << " ms ("
+              << rows / dictionary_time / 1e6 << " M rows/s, "
+              << (distinct < 0 ? std::string("fell back")
+                               : std::to_string(distinct) + " distinct")
+              << ", speedup " << row_time / dictionary_time << ")"
+              << std::endl;
+  }
+  return 0;
+}
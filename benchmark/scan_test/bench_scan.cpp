@@ -0,0 +1,135 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Compares scanning a shared memory column backed by 4K pages, transparent
+// huge pages and explicit (hugetlb) huge pages, the same kinds of mappings
+// that vineyardd creates with `--transparent_hugepage` and `--hugetlbfs_path`.
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000
+#endif
+
+enum class PageKind { k4K, kTHP, kHugeTLB };
+
+static const char* PageKindName(PageKind kind) {
+  switch (kind) {
+  case PageKind::k4K:
+    return "4K";
+  case PageKind::kTHP:
+    return "THP";
+  case PageKind::kHugeTLB:
+    return "hugetlb";
+  }
+  return "unknown";
+}
+
+static int64_t* MapColumn(size_t bytes, PageKind kind) {
+  int flags = MAP_SHARED | MAP_ANONYMOUS;
+  if (kind == PageKind::kHugeTLB) {
+    flags |= MAP_HUGETLB;
+  }
+  void* pointer = mmap(NULL, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (pointer == MAP_FAILED) {
+    return nullptr;
+  }
+  if (kind == PageKind::k4K) {
+    madvise(pointer, bytes, MADV_NOHUGEPAGE);
+  } else if (kind == PageKind::kTHP) {
+    madvise(pointer, bytes, MADV_HUGEPAGE);
+  }
+  return reinterpret_cast<int64_t*>(pointer);
+}
+
+template <typename F>
+static double Measure(F const& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static void RunBench(PageKind kind, size_t bytes, size_t probes) {
+  int64_t* column = MapColumn(bytes, kind);
+  if (column == nullptr) {
+    std::cout << PageKindName(kind) << ": mmap failed, " << strerror(errno)
+              << std::endl;
+    return;
+  }
+  size_t length = bytes / sizeof(int64_t);
+  double populate_ms = Measure([&]() {
+    for (size_t i = 0; i < length; ++i) {
+      column[i] = static_cast<int64_t>(i);
+    }
+  });
+
+  volatile int64_t sink = 0;
+  double seq_ms = Measure([&]() {
+    int64_t sum = 0;
+    for (size_t i = 0; i < length; ++i) {
+      sum += column[i];
+    }
+    sink = sum;
+  });
+
+  std::vector<size_t> indices(probes);
+  std::mt19937_64 rng(0x5eed);
+  std::uniform_int_distribution<size_t> dist(0, length - 1);
+  for (auto& index : indices) {
+    index = dist(rng);
+  }
+  double random_ms = Measure([&]() {
+    int64_t sum = 0;
+    for (size_t const index : indices) {
+      sum += column[index];
+    }
+    sink = sum;
+  });
+  (void) sink;
+
+  double gb = static_cast<double>(bytes) / (1024.0 * 1024.0 * 1024.0);
+  std::cout << PageKindName(kind) << ": populate " << populate_ms
+            << " ms, sequential scan " << seq_ms << " ms ("
+            << gb / (seq_ms / 1000.0) << " GiB/s), random probes "
+            << random_ms * 1e6 / probes << " ns/probe" << std::endl;
+  munmap(column, bytes);
+}
+
+int main(int argc, char** argv) {
+  // default: a 1 GiB column and 16M random probes
+  size_t bytes = argc > 1 ? std::stoull(argv[1]) << 20 : size_t{1} << 30;
+  size_t probes = argc > 2 ? std::stoull(argv[2]) : size_t{1} << 24;
+  // keep the mapping a multiple of 2M so that hugetlb mappings are valid
+  bytes = (bytes + (size_t{2} << 20) - 1) & ~((size_t{2} << 20) - 1);
+
+  std::cout << "column size: " << (bytes >> 20) << " MiB, random probes: "
+            << probes << std::endl;
+  for (auto kind : {PageKind::k4K, PageKind::kTHP, PageKind::kHugeTLB}) {
+    RunBench(kind, bytes, probes);
+  }
+  return 0;
+}
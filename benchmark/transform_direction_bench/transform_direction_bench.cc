@@ -0,0 +1,186 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Measures the scalability of turning the directed adjacency lists of
+// `ArrowFragment` into undirected ones, as `TransformDirection()` does (see
+// Note [Merging directed CSR] in graph/fragment/property_graph_utils.h), over
+// the number of threads, on a synthetic graph with power-law degrees, against
+// the former serial merge that appends the edges one by one.
+//
+// See benchmark/transform_direction_bench/README.md for the usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arrow/api.h"
+
+#include "common/util/logging.h"
+#include "graph/fragment/property_graph_types.h"
+#include "graph/fragment/property_graph_utils.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+using vid_t = property_graph_types::VID_TYPE;
+using eid_t = property_graph_types::EID_TYPE;
+using vid_array_t = typename ConvertToArrowType<vid_t>::ArrayType;
+using nbr_unit_t = property_graph_utils::NbrUnit<vid_t, eid_t>;
+
+namespace {
+
+// the src/dst gids of edges, where the src vertices follow a power-law
+// distribution, with vertex 0 as the largest hub.
+void Generate(const IdParser<vid_t>& parser, int64_t vnum, int64_t enum_,
+              std::shared_ptr<vid_array_t>& src_list,
+              std::shared_ptr<vid_array_t>& dst_list) {
+  std::mt19937_64 rng(20211019);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::vector<vid_t> srcs(enum_), dsts(enum_);
+  for (int64_t i = 0; i < enum_; ++i) {
+    int64_t src = static_cast<int64_t>(std::pow(uniform(rng), 4) * vnum);
+    srcs[i] = parser.GenerateId(0, 0, std::min(src, vnum - 1));
+    dsts[i] = parser.GenerateId(0, 0, static_cast<int64_t>(rng() % vnum));
+  }
+  typename ConvertToArrowType<vid_t>::BuilderType builder;
+  CHECK(builder.AppendValues(srcs).ok());
+  CHECK(builder.Finish(&src_list).ok());
+  CHECK(builder.AppendValues(dsts).ok());
+  CHECK(builder.Finish(&dst_list).ok());
+}
+
+const nbr_unit_t* Units(const std::shared_ptr<arrow::FixedSizeBinaryArray>& a) {
+  return reinterpret_cast<const nbr_unit_t*>(a->GetValue(0));
+}
+
+// the merge of `TransformDirection()` before the parallel one
+void SerialMerge(const nbr_unit_t* ie, const int64_t* ie_offsets,
+                 const nbr_unit_t* oe, const int64_t* oe_offsets, vid_t tvnum,
+                 std::shared_ptr<arrow::FixedSizeBinaryArray>& edges,
+                 std::shared_ptr<arrow::Int64Array>& offsets,
+                 bool& is_multigraph) {
+  PodArrayBuilder<nbr_unit_t> edge_builder;
+  arrow::Int64Builder offset_builder;
+  CHECK_ARROW_ERROR(offset_builder.Append(0));
+  for (vid_t v = 0; v < tvnum; ++v) {
+    for (int64_t k = ie_offsets[v]; k < ie_offsets[v + 1]; ++k) {
+      CHECK_ARROW_ERROR(
+          edge_builder.Append(reinterpret_cast<const uint8_t*>(ie + k)));
+    }
+    for (int64_t k = oe_offsets[v]; k < oe_offsets[v + 1]; ++k) {
+      CHECK_ARROW_ERROR(
+          edge_builder.Append(reinterpret_cast<const uint8_t*>(oe + k)));
+    }
+    CHECK_ARROW_ERROR(offset_builder.Append(edge_builder.length()));
+  }
+  CHECK_ARROW_ERROR(offset_builder.Finish(&offsets));
+  sort_edges_with_respect_to_vertex(edge_builder, offsets, tvnum, 1);
+  check_is_multigraph(edge_builder, offsets, tvnum, 1, is_multigraph);
+  CHECK_ARROW_ERROR(edge_builder.Finish(&edges));
+}
+
+template <typename FN>
+double Measure(const FN& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int64_t vnum = argc > 1 ? std::atoll(argv[1]) : 1 << 22;
+  int64_t avg_degree = argc > 2 ? std::atoll(argv[2]) : 16;
+  int max_concurrency = argc > 3 ? std::atoi(argv[3])
+                                 : std::thread::hardware_concurrency();
+  int64_t enum_ = vnum * avg_degree;
+
+  IdParser<vid_t> parser;
+  parser.Init(1, 1);
+  std::shared_ptr<vid_array_t> src_list, dst_list;
+  Generate(parser, vnum, enum_, src_list, dst_list);
+  std::vector<vid_t> tvnums{static_cast<vid_t>(vnum)};
+  std::cout << "vertices: " << vnum << ", edges: " << enum_ << std::endl;
+
+  // the directed lists, and the undirected ones as the expected result
+  std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>> oe(1), ie(1),
+      expected(1);
+  std::vector<std::shared_ptr<arrow::Int64Array>> oe_offsets(1),
+      ie_offsets(1), expected_offsets(1);
+  bool expected_is_multigraph = false;
+  generate_directed_csr<vid_t, eid_t>(parser, src_list, dst_list, tvnums, 1,
+                                      max_concurrency, oe, oe_offsets,
+                                      expected_is_multigraph)
+      .value();
+  generate_directed_csr<vid_t, eid_t>(parser, dst_list, src_list, tvnums, 1,
+                                      max_concurrency, ie, ie_offsets,
+                                      expected_is_multigraph)
+      .value();
+  expected_is_multigraph = false;
+  generate_undirected_csr<vid_t, eid_t>(parser, src_list, dst_list, tvnums, 1,
+                                        max_concurrency, expected,
+                                        expected_offsets,
+                                        expected_is_multigraph)
+      .value();
+
+  std::shared_ptr<arrow::FixedSizeBinaryArray> edges;
+  std::shared_ptr<arrow::Int64Array> offsets;
+  bool is_multigraph = false;
+  double serial_time = Measure([&]() {
+    SerialMerge(Units(ie[0]), ie_offsets[0]->raw_values(), Units(oe[0]),
+                oe_offsets[0]->raw_values(), tvnums[0], edges, offsets,
+                is_multigraph);
+  });
+  CHECK(expected[0]->Equals(edges));
+  CHECK(expected_offsets[0]->Equals(offsets));
+  CHECK_EQ(expected_is_multigraph, is_multigraph);
+  std::cout << "serial append: " << serial_time * 1000 << " ms ("
+            << edges->length() / serial_time / 1e6 << " M edges/s)"
+            << std::endl;
+
+  std::vector<int> concurrencies;
+  for (int concurrency = 1; concurrency < max_concurrency; concurrency *= 2) {
+    concurrencies.push_back(concurrency);
+  }
+  concurrencies.push_back(max_concurrency);
+  for (int concurrency : concurrencies) {
+    std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>> merged;
+    std::vector<std::shared_ptr<arrow::Int64Array>> merged_offsets;
+    is_multigraph = false;
+    double time = Measure([&]() {
+      merge_directed_csr<vid_t, eid_t>(
+          {Units(ie[0])}, {ie_offsets[0]->raw_values()}, {Units(oe[0])},
+          {oe_offsets[0]->raw_values()}, tvnums, concurrency, merged,
+          merged_offsets, is_multigraph)
+          .value();
+    });
+    CHECK(expected[0]->Equals(merged[0]));
+    CHECK(expected_offsets[0]->Equals(merged_offsets[0]));
+    CHECK_EQ(expected_is_multigraph, is_multigraph);
+    std::cout << "threads " << concurrency << ": " << time * 1000 << " ms ("
+              << merged[0]->length() / time / 1e6
+              << " M edges/s, speedup over serial append " << serial_time / time
+              << ")" << std::endl;
+  }
+  return 0;
+}
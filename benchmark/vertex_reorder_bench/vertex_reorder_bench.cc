@@ -0,0 +1,266 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// Compares traversals and property scans over the CSR of `ArrowFragment`
+// with the inner vertices in the input order and in the degree order (the
+// `reorder_vertices` option of `ArrowFragmentLoader`, see Note [Vertex
+// reordering] in graph/loader/basic_ev_fragment_loader.h), on a synthetic
+// power-law graph.
+//
+// See benchmark/vertex_reorder_bench/README.md for the usage.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arrow/api.h"
+
+#include "common/util/logging.h"
+#include "graph/fragment/property_graph_types.h"
+#include "graph/fragment/property_graph_utils.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+using vid_t = property_graph_types::VID_TYPE;
+using eid_t = property_graph_types::EID_TYPE;
+using nbr_unit_t = property_graph_utils::NbrUnit<vid_t, eid_t>;
+using adj_list_t = property_graph_utils::AdjList<vid_t, eid_t>;
+
+namespace {
+
+// the graph, and a vertex property column
+struct Graph {
+  int64_t vnum = 0;
+  std::shared_ptr<arrow::FixedSizeBinaryArray> edges;
+  std::shared_ptr<arrow::Int64Array> offsets;
+  std::shared_ptr<arrow::Int64Array> property;
+
+  adj_list_t adj_list(int64_t v) const {
+    const nbr_unit_t* nbrs =
+        reinterpret_cast<const nbr_unit_t*>(edges->raw_values());
+    const int64_t* offset = offsets->raw_values();
+    return adj_list_t(nbrs + offset[v], nbrs + offset[v + 1], nullptr);
+  }
+};
+
+// builds the CSR of the edges as `(src, dst)` pairs, with the vertex `v`
+// renamed to `ids[v]` and the eids following the input order of edges.
+Graph Build(int64_t vnum,
+            const std::vector<std::pair<int64_t, int64_t>>& edge_list,
+            const std::vector<int64_t>& ids,
+            const std::vector<int64_t>& property) {
+  int64_t enum_ = edge_list.size();
+  std::vector<int64_t> offsets(vnum + 1, 0);
+  for (auto const& e : edge_list) {
+    ++offsets[ids[e.first] + 1];
+  }
+  for (int64_t v = 0; v < vnum; ++v) {
+    offsets[v + 1] += offsets[v];
+  }
+  auto buffer = arrow::AllocateBuffer(enum_ * sizeof(nbr_unit_t)).ValueOrDie();
+  nbr_unit_t* nbrs = reinterpret_cast<nbr_unit_t*>(buffer->mutable_data());
+  std::vector<int64_t> cursor(offsets.begin(), offsets.end() - 1);
+  for (int64_t e = 0; e < enum_; ++e) {
+    nbr_unit_t& nbr = nbrs[cursor[ids[edge_list[e].first]]++];
+    nbr.vid = static_cast<vid_t>(ids[edge_list[e].second]);
+    nbr.eid = static_cast<eid_t>(e);
+  }
+  for (int64_t v = 0; v < vnum; ++v) {
+    std::sort(nbrs + offsets[v], nbrs + offsets[v + 1],
+              [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
+                return lhs.vid < rhs.vid;
+              });
+  }
+  std::vector<int64_t> renamed_property(vnum);
+  for (int64_t v = 0; v < vnum; ++v) {
+    renamed_property[ids[v]] = property[v];
+  }
+
+  Graph graph;
+  graph.vnum = vnum;
+  graph.edges = std::make_shared<arrow::FixedSizeBinaryArray>(
+      arrow::fixed_size_binary(sizeof(nbr_unit_t)), enum_,
+      std::shared_ptr<arrow::Buffer>(std::move(buffer)));
+  arrow::Int64Builder builder;
+  CHECK(builder.AppendValues(offsets).ok());
+  CHECK(builder.Finish(&graph.offsets).ok());
+  CHECK(builder.AppendValues(renamed_property).ok());
+  CHECK(builder.Finish(&graph.property).ok());
+  return graph;
+}
+
+// a power-law graph where the hubs are scattered over the input order, as
+// the inner vertices after shuffling by a hash partitioner.
+void Generate(int64_t vnum, int64_t avg_degree,
+              std::vector<std::pair<int64_t, int64_t>>& edge_list,
+              std::vector<int64_t>& property) {
+  std::mt19937_64 rng(20211019);
+  std::vector<int64_t> popularity(vnum);
+  std::iota(popularity.begin(), popularity.end(), 0);
+  std::shuffle(popularity.begin(), popularity.end(), rng);
+
+  std::exponential_distribution<double> degree(1.0 / avg_degree);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  for (int64_t v = 0; v < vnum; ++v) {
+    int64_t out_degree = static_cast<int64_t>(degree(rng));
+    for (int64_t i = 0; i < out_degree; ++i) {
+      // skewed to the popular vertices
+      double rank = std::pow(uniform(rng), 3) * vnum;
+      edge_list.emplace_back(
+          v, popularity[std::min(static_cast<int64_t>(rank), vnum - 1)]);
+    }
+  }
+  property.resize(vnum);
+  for (int64_t v = 0; v < vnum; ++v) {
+    property[v] = static_cast<int64_t>(rng() % 1024);
+  }
+}
+
+int64_t BFS(const Graph& graph, int64_t root) {
+  std::vector<int64_t> depth(graph.vnum, -1);
+  std::vector<int64_t> current, next;
+  current.push_back(root);
+  depth[root] = 0;
+  int64_t visited = 1;
+  for (int64_t level = 1; !current.empty(); ++level) {
+    next.clear();
+    for (int64_t v : current) {
+      for (auto& e : graph.adj_list(v)) {
+        int64_t u = e.neighbor().GetValue();
+        if (depth[u] == -1) {
+          depth[u] = level;
+          next.push_back(u);
+        }
+      }
+    }
+    visited += next.size();
+    current.swap(next);
+  }
+  return visited;
+}
+
+std::vector<double> PageRank(const Graph& graph, int iterations) {
+  std::vector<double> rank(graph.vnum, 1.0 / graph.vnum);
+  std::vector<double> next(graph.vnum);
+  for (int i = 0; i < iterations; ++i) {
+    std::fill(next.begin(), next.end(), 0.15 / graph.vnum);
+    for (int64_t v = 0; v < graph.vnum; ++v) {
+      auto adj = graph.adj_list(v);
+      if (adj.Empty()) {
+        continue;
+      }
+      double delta = 0.85 * rank[v] / adj.Size();
+      for (auto& e : adj) {
+        next[e.neighbor().GetValue()] += delta;
+      }
+    }
+    rank.swap(next);
+  }
+  return rank;
+}
+
+// reads the property of the neighbors, e.g., to aggregate the messages
+int64_t ScanProperty(const Graph& graph) {
+  const int64_t* property = graph.property->raw_values();
+  int64_t checksum = 0;
+  for (int64_t v = 0; v < graph.vnum; ++v) {
+    for (auto& e : graph.adj_list(v)) {
+      checksum += property[e.neighbor().GetValue()];
+    }
+  }
+  return checksum;
+}
+
+template <typename FN>
+double Measure(const FN& fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+void Report(const std::string& name, int64_t edges, double input,
+            double reordered) {
+  std::cout << name << ": input order " << input * 1000 << " ms ("
+            << edges / input / 1e6 << " MTEPS), degree order "
+            << reordered * 1000 << " ms (" << edges / reordered / 1e6
+            << " MTEPS)" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int64_t vnum = argc > 1 ? std::atoll(argv[1]) : 1 << 22;
+  int64_t avg_degree = argc > 2 ? std::atoll(argv[2]) : 16;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 10;
+
+  std::vector<std::pair<int64_t, int64_t>> edge_list;
+  std::vector<int64_t> property;
+  Generate(vnum, avg_degree, edge_list, property);
+  int64_t enum_ = edge_list.size();
+
+  std::vector<int64_t> identity(vnum);
+  std::iota(identity.begin(), identity.end(), 0);
+  Graph input = Build(vnum, edge_list, identity, property);
+
+  std::vector<int64_t> degrees(vnum, 0), order, ids(vnum);
+  for (auto const& e : edge_list) {
+    ++degrees[e.first];
+    ++degrees[e.second];
+  }
+  double reorder_time = Measure([&]() {
+    generate_degree_order(degrees, order);
+    for (int64_t i = 0; i < vnum; ++i) {
+      ids[order[i]] = i;
+    }
+  });
+  Graph reordered = Build(vnum, edge_list, ids, property);
+  std::cout << "vertices: " << vnum << ", edges: " << enum_
+            << ", ordering: " << reorder_time * 1000 << " ms" << std::endl;
+
+  int64_t input_visited = 0, reordered_visited = 0;
+  double input_time = Measure([&]() { input_visited = BFS(input, 0); });
+  double reordered_time =
+      Measure([&]() { reordered_visited = BFS(reordered, ids[0]); });
+  CHECK_EQ(input_visited, reordered_visited);
+  Report("bfs", enum_, input_time, reordered_time);
+
+  std::vector<double> input_rank, reordered_rank;
+  input_time = Measure([&]() { input_rank = PageRank(input, iterations); });
+  reordered_time =
+      Measure([&]() { reordered_rank = PageRank(reordered, iterations); });
+  for (int64_t v = 0; v < vnum; ++v) {
+    CHECK_LT(std::fabs(input_rank[v] - reordered_rank[ids[v]]), 1e-9);
+  }
+  Report("pagerank (per iteration)", enum_, input_time / iterations,
+         reordered_time / iterations);
+
+  int64_t input_checksum = 0, reordered_checksum = 0;
+  input_time = Measure([&]() { input_checksum = ScanProperty(input); });
+  reordered_time =
+      Measure([&]() { reordered_checksum = ScanProperty(reordered); });
+  CHECK_EQ(input_checksum, reordered_checksum);
+  Report("scan neighbor properties", enum_, input_time, reordered_time);
+  return 0;
+}
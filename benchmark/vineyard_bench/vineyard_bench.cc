@@ -0,0 +1,595 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+// End-to-end benchmarks of vineyardd, as seen by the clients.
+//
+// The benchmark starts a vineyardd with the local metastore (unless
+// `--attach` is given), runs the selected workloads and emits the results
+// as json, with the latency percentiles of every measured operation.
+//
+// See benchmark/vineyard_bench/README.md for the usage.
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "basic/stream/byte_stream.h"
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "client/ds/object_meta.h"
+#include "client/ds/remote_blob.h"
+#include "client/rpc_client.h"
+#include "common/util/config.h"
+#include "common/util/flags.h"
+#include "common/util/json.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+DEFINE_string(vineyardd, "vineyardd", "vineyardd executable to start");
+DEFINE_string(socket, "",
+              "IPC socket of vineyardd, a temporary one if not given");
+DEFINE_int32(rpc_port, 0, "RPC port of vineyardd, a random one if not given");
+DEFINE_string(size, "4Gi", "shared memory size of vineyardd");
+DEFINE_bool(attach, false,
+            "use a running vineyardd at --socket and --rpc_port rather than "
+            "starting one");
+DEFINE_string(workloads, "blob,object,list,stream,rpc,contention",
+              "the workloads to run");
+DEFINE_uint64(iterations, 1000, "iterations of each measurement");
+DEFINE_string(blob_sizes, "64,4096,65536,1048576,16777216",
+              "blob sizes of the blob workload");
+DEFINE_string(graph_depths, "1,4,8", "depths of the object graphs");
+DEFINE_uint64(graph_fanout, 2, "fanout of the object graphs");
+DEFINE_string(list_counts, "100,1000,10000",
+              "object counts of the list workload");
+DEFINE_string(chunk_sizes, "4096,65536,1048576,16777216",
+              "chunk sizes of the stream workload");
+DEFINE_uint64(stream_bytes, 256 * 1024 * 1024,
+              "bytes to send in each stream");
+DEFINE_string(rpc_sizes, "4096,1048576,67108864",
+              "blob sizes of the rpc workload");
+DEFINE_string(clients, "1,2,4,8,16",
+              "client counts of the contention workload");
+DEFINE_string(output, "",
+              "write the json results to the file rather than stdout");
+
+namespace {
+
+struct Options {
+  std::string vineyardd;
+  std::string socket;
+  int rpc_port;
+  std::string size;
+  bool attach;
+  std::vector<std::string> workloads;
+  size_t iterations;
+  std::vector<size_t> blob_sizes;
+  std::vector<size_t> graph_depths;
+  size_t graph_fanout;
+  std::vector<size_t> list_counts;
+  std::vector<size_t> chunk_sizes;
+  size_t stream_bytes;
+  std::vector<size_t> rpc_sizes;
+  std::vector<size_t> clients;
+  std::string output;
+};
+
+std::vector<std::string> SplitString(std::string const& value) {
+  std::vector<std::string> items;
+  size_t start = 0;
+  while (start <= value.size()) {
+    size_t end = value.find(',', start);
+    if (end == std::string::npos) {
+      end = value.size();
+    }
+    if (end > start) {
+      items.emplace_back(value.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return items;
+}
+
+std::vector<size_t> SplitSizes(std::string const& value) {
+  std::vector<size_t> sizes;
+  for (auto const& item : SplitString(value)) {
+    sizes.emplace_back(std::stoull(item));
+  }
+  return sizes;
+}
+
+Options ParseOptions() {
+  Options options;
+  options.vineyardd = FLAGS_vineyardd;
+  options.socket = FLAGS_socket;
+  options.rpc_port = FLAGS_rpc_port;
+  options.size = FLAGS_size;
+  options.attach = FLAGS_attach;
+  options.workloads = SplitString(FLAGS_workloads);
+  options.iterations = std::max<size_t>(FLAGS_iterations, 1);
+  options.blob_sizes = SplitSizes(FLAGS_blob_sizes);
+  options.graph_depths = SplitSizes(FLAGS_graph_depths);
+  options.graph_fanout = std::max<size_t>(FLAGS_graph_fanout, 1);
+  options.list_counts = SplitSizes(FLAGS_list_counts);
+  options.chunk_sizes = SplitSizes(FLAGS_chunk_sizes);
+  options.stream_bytes = FLAGS_stream_bytes;
+  options.rpc_sizes = SplitSizes(FLAGS_rpc_sizes);
+  options.clients = SplitSizes(FLAGS_clients);
+  options.output = FLAGS_output;
+  if (options.socket.empty()) {
+    options.socket =
+        "/tmp/vineyard_bench." + std::to_string(getpid()) + ".sock";
+  }
+  if (options.rpc_port == 0) {
+    options.rpc_port = 19600 + getpid() % 10000;
+  }
+  return options;
+}
+
+using Clock = std::chrono::steady_clock;
+
+double ElapsedMicros(Clock::time_point const& start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+      .count();
+}
+
+/**
+ * @brief Summarize the latency samples (in microseconds) as count, mean, min,
+ * max and percentiles.
+ */
+json Summarize(std::vector<double>& samples) {
+  json summary;
+  summary["count"] = samples.size();
+  if (samples.empty()) {
+    return summary;
+  }
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double sample : samples) {
+    total += sample;
+  }
+  auto percentile = [&samples](double p) {
+    size_t rank = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+    return samples[std::min(rank, samples.size() - 1)];
+  };
+  summary["mean_us"] = total / samples.size();
+  summary["min_us"] = samples.front();
+  summary["p50_us"] = percentile(0.50);
+  summary["p90_us"] = percentile(0.90);
+  summary["p99_us"] = percentile(0.99);
+  summary["p999_us"] = percentile(0.999);
+  summary["max_us"] = samples.back();
+  return summary;
+}
+
+double BandwidthMBps(size_t const bytes, double const micros) {
+  return micros <= 0 ? 0 : bytes / micros;  // bytes/us == MB/s
+}
+
+/**
+ * @brief Start vineyardd with the local metastore and wait until it accepts
+ * IPC connections.
+ */
+pid_t LaunchVineyardd(Options const& options) {
+  std::vector<std::string> args = {
+      options.vineyardd,
+      "--meta=local",
+      "--socket=" + options.socket,
+      "--rpc_socket_port=" + std::to_string(options.rpc_port),
+      "--size=" + options.size,
+  };
+  pid_t pid = fork();
+  if (pid == 0) {
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+      argv.emplace_back(&arg[0]);
+    }
+    argv.emplace_back(nullptr);
+    execvp(argv[0], argv.data());
+    std::cerr << "Failed to start " << options.vineyardd << ": "
+              << strerror(errno) << std::endl;
+    _exit(127);
+  }
+  if (pid < 0) {
+    LOG(ERROR) << "Failed to fork: " << strerror(errno);
+    return -1;
+  }
+  for (int retry = 0; retry < 300; ++retry) {
+    int status = 0;
+    if (waitpid(pid, &status, WNOHANG) == pid) {
+      LOG(ERROR) << "vineyardd exited unexpectedly";
+      return -1;
+    }
+    Client client;
+    if (client.Connect(options.socket).ok()) {
+      client.Disconnect();
+      return pid;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  LOG(ERROR) << "Timeout when waiting for vineyardd to be ready";
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+  return -1;
+}
+
+void StopVineyardd(pid_t const pid) {
+  if (pid <= 0) {
+    return;
+  }
+  kill(pid, SIGTERM);
+  waitpid(pid, nullptr, 0);
+}
+
+/**
+ * @brief CreateBlob/Seal/GetBlob/DelData latency by blob size.
+ */
+json BenchBlob(Options const& options, Client& client) {
+  json results = json::array();
+  for (size_t const size : options.blob_sizes) {
+    std::vector<double> create, seal, get, del;
+    for (size_t iter = 0; iter < options.iterations; ++iter) {
+      auto start = Clock::now();
+      std::unique_ptr<BlobWriter> writer;
+      VINEYARD_CHECK_OK(client.CreateBlob(size, writer));
+      create.emplace_back(ElapsedMicros(start));
+      if (size > 0) {
+        writer->data()[0] = static_cast<char>(iter);
+      }
+
+      start = Clock::now();
+      ObjectID id = writer->Seal(client)->id();
+      seal.emplace_back(ElapsedMicros(start));
+
+      start = Clock::now();
+      std::shared_ptr<Blob> blob;
+      VINEYARD_CHECK_OK(client.GetBlob(id, blob));
+      get.emplace_back(ElapsedMicros(start));
+
+      start = Clock::now();
+      VINEYARD_CHECK_OK(client.DelData(id));
+      del.emplace_back(ElapsedMicros(start));
+    }
+    json result;
+    result["size"] = size;
+    result["create"] = Summarize(create);
+    result["seal"] = Summarize(seal);
+    result["get"] = Summarize(get);
+    result["delete"] = Summarize(del);
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+ObjectID BuildObjectGraph(Client& client, size_t const depth,
+                          size_t const fanout, size_t& nodes) {
+  nodes += 1;
+  if (depth == 0) {
+    std::unique_ptr<BlobWriter> writer;
+    VINEYARD_CHECK_OK(client.CreateBlob(64, writer));
+    return writer->Seal(client)->id();
+  }
+  ObjectMeta meta;
+  meta.SetTypeName("vineyard::bench::Node");
+  meta.AddKeyValue("depth", depth);
+  for (size_t index = 0; index < fanout; ++index) {
+    meta.AddMember("child_" + std::to_string(index),
+                   BuildObjectGraph(client, depth - 1, fanout, nodes));
+  }
+  meta.SetNBytes(0);
+  ObjectID id = InvalidObjectID();
+  VINEYARD_CHECK_OK(client.CreateMetaData(meta, id));
+  return id;
+}
+
+/**
+ * @brief GetMetaData/GetObject latency on object graphs of the given depths.
+ */
+json BenchObject(Options const& options, Client& client) {
+  json results = json::array();
+  for (size_t const depth : options.graph_depths) {
+    size_t nodes = 0;
+    auto start = Clock::now();
+    ObjectID root =
+        BuildObjectGraph(client, depth, options.graph_fanout, nodes);
+    double build = ElapsedMicros(start);
+
+    std::vector<double> get_meta, get_object;
+    for (size_t iter = 0; iter < options.iterations; ++iter) {
+      start = Clock::now();
+      ObjectMeta meta;
+      VINEYARD_CHECK_OK(client.GetMetaData(root, meta));
+      get_meta.emplace_back(ElapsedMicros(start));
+
+      start = Clock::now();
+      std::shared_ptr<Object> object;
+      VINEYARD_CHECK_OK(client.GetObject(root, object));
+      get_object.emplace_back(ElapsedMicros(start));
+    }
+    VINEYARD_CHECK_OK(client.DelData(root, true, true));
+
+    json result;
+    result["depth"] = depth;
+    result["fanout"] = options.graph_fanout;
+    result["nodes"] = nodes;
+    result["build_us"] = build;
+    result["get_metadata"] = Summarize(get_meta);
+    result["get_object"] = Summarize(get_object);
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+/**
+ * @brief ListData latency with N objects in vineyardd.
+ */
+json BenchList(Options const& options, Client& client) {
+  json results = json::array();
+  for (size_t const count : options.list_counts) {
+    std::vector<ObjectID> ids;
+    for (size_t index = 0; index < count; ++index) {
+      ObjectMeta meta;
+      meta.SetTypeName("vineyard::bench::Item");
+      meta.AddKeyValue("index", index);
+      meta.SetNBytes(0);
+      ObjectID id = InvalidObjectID();
+      VINEYARD_CHECK_OK(client.CreateMetaData(meta, id));
+      ids.emplace_back(id);
+    }
+
+    std::vector<double> list;
+    for (size_t iter = 0; iter < options.iterations; ++iter) {
+      auto start = Clock::now();
+      std::unordered_map<ObjectID, json> metas;
+      VINEYARD_CHECK_OK(
+          client.ListData("vineyard::bench::Item", false, count, metas));
+      list.emplace_back(ElapsedMicros(start));
+      CHECK_EQ(metas.size(), count);
+    }
+    VINEYARD_CHECK_OK(client.DelData(ids, true, true));
+
+    json result;
+    result["objects"] = count;
+    result["list"] = Summarize(list);
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+/**
+ * @brief Stream throughput by chunk size, between a writer and a reader that
+ * connect to vineyardd with separate clients.
+ */
+json BenchStream(Options const& options, Client& client) {
+  json results = json::array();
+  for (size_t const chunk_size : options.chunk_sizes) {
+    size_t chunks = std::max<size_t>(options.stream_bytes / chunk_size, 1);
+    std::map<std::string, std::string> params{{"kind", "bench"}};
+    ObjectID stream_id = ByteStream::Make<ByteStream>(client, params);
+
+    std::vector<double> push, pull;
+    size_t received = 0;
+    auto start = Clock::now();
+    std::thread reader([&]() {
+      Client reader_client;
+      VINEYARD_CHECK_OK(reader_client.Connect(options.socket));
+      auto stream = reader_client.GetObject<ByteStream>(stream_id);
+      VINEYARD_CHECK_OK(stream->OpenReader(&reader_client));
+      while (true) {
+        auto pull_start = Clock::now();
+        std::shared_ptr<Blob> chunk;
+        auto status = stream->Next(chunk);
+        if (!status.ok()) {
+          CHECK(status.IsStreamDrained()) << status.ToString();
+          break;
+        }
+        pull.emplace_back(ElapsedMicros(pull_start));
+        received += chunk->allocated_size();
+        VINEYARD_CHECK_OK(reader_client.DelData(chunk->id()));
+      }
+      reader_client.Disconnect();
+    });
+
+    Client writer_client;
+    VINEYARD_CHECK_OK(writer_client.Connect(options.socket));
+    auto stream = writer_client.GetObject<ByteStream>(stream_id);
+    VINEYARD_CHECK_OK(stream->OpenWriter(&writer_client));
+    for (size_t index = 0; index < chunks; ++index) {
+      auto push_start = Clock::now();
+      std::unique_ptr<BlobWriter> writer;
+      VINEYARD_CHECK_OK(writer_client.CreateBlob(chunk_size, writer));
+      memset(writer->data(), static_cast<int>(index), chunk_size);
+      VINEYARD_CHECK_OK(stream->Push(writer->Seal(writer_client)));
+      push.emplace_back(ElapsedMicros(push_start));
+    }
+    VINEYARD_CHECK_OK(stream->Finish());
+    reader.join();
+    double elapsed = ElapsedMicros(start);
+    writer_client.Disconnect();
+    VINEYARD_CHECK_OK(client.DelData(stream_id));
+
+    json result;
+    result["chunk_size"] = chunk_size;
+    result["chunks"] = chunks;
+    result["bytes"] = received;
+    result["elapsed_us"] = elapsed;
+    result["throughput_MBps"] = BandwidthMBps(received, elapsed);
+    result["push"] = Summarize(push);
+    result["pull"] = Summarize(pull);
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+/**
+ * @brief Remote blob bandwidth over the loopback RPC socket.
+ */
+json BenchRPC(Options const& options) {
+  json results = json::array();
+  RPCClient client;
+  VINEYARD_CHECK_OK(client.Connect("127.0.0.1", options.rpc_port));
+  for (size_t const size : options.rpc_sizes) {
+    // keep each measurement within ~1GiB of traffic
+    size_t iterations = std::max<size_t>(
+        std::min<size_t>(options.iterations, (size_t{1} << 30) / size), 3);
+    std::vector<double> create, get;
+    for (size_t iter = 0; iter < iterations; ++iter) {
+      auto writer = std::make_shared<RemoteBlobWriter>(size);
+      memset(writer->data(), static_cast<int>(iter), size);
+      auto start = Clock::now();
+      ObjectID id = InvalidObjectID();
+      VINEYARD_CHECK_OK(client.CreateRemoteBlob(writer, id));
+      create.emplace_back(ElapsedMicros(start));
+
+      start = Clock::now();
+      std::shared_ptr<RemoteBlob> blob;
+      VINEYARD_CHECK_OK(client.GetRemoteBlob(id, blob));
+      get.emplace_back(ElapsedMicros(start));
+      VINEYARD_CHECK_OK(client.DelData(id));
+    }
+
+    json result;
+    result["size"] = size;
+    result["create"] = Summarize(create);
+    result["create_bandwidth_MBps"] =
+        BandwidthMBps(size, result["create"]["mean_us"].get<double>());
+    result["get"] = Summarize(get);
+    result["get_bandwidth_MBps"] =
+        BandwidthMBps(size, result["get"]["mean_us"].get<double>());
+    results.push_back(std::move(result));
+  }
+  client.Disconnect();
+  return results;
+}
+
+/**
+ * @brief Many clients creating, sealing, getting and deleting small blobs
+ * concurrently.
+ */
+json BenchContention(Options const& options) {
+  constexpr size_t kBlobSize = 4096;
+  json results = json::array();
+  for (size_t const clients : options.clients) {
+    std::vector<std::vector<double>> samples(clients);
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (size_t index = 0; index < clients; ++index) {
+      workers.emplace_back([&options, &samples, index]() {
+        Client client;
+        VINEYARD_CHECK_OK(client.Connect(options.socket));
+        auto& latencies = samples[index];
+        latencies.reserve(options.iterations);
+        for (size_t iter = 0; iter < options.iterations; ++iter) {
+          auto op_start = Clock::now();
+          std::unique_ptr<BlobWriter> writer;
+          VINEYARD_CHECK_OK(client.CreateBlob(kBlobSize, writer));
+          ObjectID id = writer->Seal(client)->id();
+          std::shared_ptr<Blob> blob;
+          VINEYARD_CHECK_OK(client.GetBlob(id, blob));
+          VINEYARD_CHECK_OK(client.DelData(id));
+          latencies.emplace_back(ElapsedMicros(op_start));
+        }
+        client.Disconnect();
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    double elapsed = ElapsedMicros(start);
+
+    std::vector<double> merged;
+    for (auto const& latencies : samples) {
+      merged.insert(merged.end(), latencies.begin(), latencies.end());
+    }
+    json result;
+    result["clients"] = clients;
+    result["blob_size"] = kBlobSize;
+    result["elapsed_us"] = elapsed;
+    result["rounds_per_second"] = merged.size() * 1e6 / elapsed;
+    result["round"] = Summarize(merged);  // create + seal + get + delete
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  flags::SetUsageMessage("Usage: vineyard_bench [--option=value ...]");
+  flags::ParseCommandLineFlags(&argc, &argv, true);
+  Options options = ParseOptions();
+
+  pid_t server = -1;
+  if (!options.attach) {
+    server = LaunchVineyardd(options);
+    if (server == -1) {
+      return 1;
+    }
+  }
+
+  json report;
+  report["version"] = VINEYARD_VERSION_STRING;
+  report["timestamp"] = static_cast<int64_t>(std::time(nullptr));
+  report["hardware_concurrency"] = std::thread::hardware_concurrency();
+  report["iterations"] = options.iterations;
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(options.socket));
+  for (auto const& workload : options.workloads) {
+    LOG(INFO) << "Running workload: " << workload;
+    if (workload == "blob") {
+      report["blob"] = BenchBlob(options, client);
+    } else if (workload == "object") {
+      report["object"] = BenchObject(options, client);
+    } else if (workload == "list") {
+      report["list"] = BenchList(options, client);
+    } else if (workload == "stream") {
+      report["stream"] = BenchStream(options, client);
+    } else if (workload == "rpc") {
+      report["rpc"] = BenchRPC(options);
+    } else if (workload == "contention") {
+      report["contention"] = BenchContention(options);
+    } else {
+      LOG(WARNING) << "Unknown workload: " << workload;
+    }
+  }
+  client.Disconnect();
+  StopVineyardd(server);
+
+  if (options.output.empty()) {
+    std::cout << report.dump(2) << std::endl;
+  } else {
+    std::ofstream out(options.output);
+    out << report.dump(2) << std::endl;
+  }
+  return 0;
+}
@@ -39,6 +39,7 @@ limitations under the License.
 #include "common/util/typename.h"
 
 #include "graph/fragment/arrow_fragment.vineyard.h"
+#include "graph/fragment/compact_adj_list.h"
 #include "graph/fragment/graph_schema.h"
 #include "graph/fragment/property_graph_types.h"
 #include "graph/fragment/property_graph_utils.h"
@@ -144,6 +145,28 @@ class BasicArrowFragmentBuilder
                                                        oe_offsets_lists_[i][j]);
             this->set_oe_offsets_lists_(i, j, oeo.Seal(*client));
           }
+          if (compact_edges_) {
+            if (this->directed_) {
+              vineyard::NumericArrayBuilder<uint8_t> ie(
+                  *client, compact_ie_lists_[i][j]);
+              this->set_compact_ie_lists_(i, j, ie.Seal(*client));
+              vineyard::NumericArrayBuilder<int64_t> ieo(
+                  *client, compact_ie_offsets_lists_[i][j]);
+              this->set_compact_ie_offsets_lists_(i, j, ieo.Seal(*client));
+              vineyard::NumericArrayBuilder<uint8_t> iee(
+                  *client, compact_ie_eids_lists_[i][j]);
+              this->set_compact_ie_eids_lists_(i, j, iee.Seal(*client));
+            }
+            vineyard::NumericArrayBuilder<uint8_t> oe(*client,
+                                                      compact_oe_lists_[i][j]);
+            this->set_compact_oe_lists_(i, j, oe.Seal(*client));
+            vineyard::NumericArrayBuilder<int64_t> oeo(
+                *client, compact_oe_offsets_lists_[i][j]);
+            this->set_compact_oe_offsets_lists_(i, j, oeo.Seal(*client));
+            vineyard::NumericArrayBuilder<uint8_t> oee(
+                *client, compact_oe_eids_lists_[i][j]);
+            this->set_compact_oe_eids_lists_(i, j, oee.Seal(*client));
+          }
           return Status::OK();
         };
         tg.AddTask(fn, &client);
@@ -164,11 +187,12 @@ class BasicArrowFragmentBuilder
       fid_t fid, fid_t fnum,
       std::vector<std::shared_ptr<arrow::Table>>&& vertex_tables,
       std::vector<std::shared_ptr<arrow::Table>>&& edge_tables,
-      bool directed = true, int concurrency = 1) {
+      bool directed = true, int concurrency = 1, bool compact_edges = false) {
     this->fid_ = fid;
     this->fnum_ = fnum;
     this->directed_ = directed;
     this->is_multigraph_ = false;
+    this->compact_edges_ = compact_edges;
     this->vertex_label_num_ = vertex_tables.size();
     this->edge_label_num_ = edge_tables.size();
 
@@ -313,6 +337,54 @@ class BasicArrowFragmentBuilder
         oe_offsets_lists_[v_label][e_label] = sub_oe_offset_lists[v_label];
       }
     }
+    if (compact_edges_) {
+      BOOST_LEAF_CHECK(initCompactEdges(concurrency));
+    }
+    return {};
+  }
+
+  // Re-encodes the adjacency lists in the compact layout, and leaves the
+  // `ie_lists_` and `oe_lists_` empty.
+  boost::leaf::result<void> initCompactEdges(int concurrency) {
+    std::shared_ptr<arrow::FixedSizeBinaryArray> empty_list;
+    arrow::FixedSizeBinaryBuilder empty_builder(
+        arrow::fixed_size_binary(sizeof(nbr_unit_t)));
+    ARROW_OK_OR_RAISE(empty_builder.Finish(&empty_list));
+
+    auto resize = [this](auto& lists) {
+      lists.resize(this->vertex_label_num_);
+      for (auto& list : lists) {
+        list.resize(this->edge_label_num_);
+      }
+    };
+    resize(compact_oe_lists_);
+    resize(compact_oe_offsets_lists_);
+    resize(compact_oe_eids_lists_);
+    if (this->directed_) {
+      resize(compact_ie_lists_);
+      resize(compact_ie_offsets_lists_);
+      resize(compact_ie_eids_lists_);
+    }
+
+    for (label_id_t v_label = 0; v_label < this->vertex_label_num_; ++v_label) {
+      for (label_id_t e_label = 0; e_label < this->edge_label_num_;
+           ++e_label) {
+        BOOST_LEAF_CHECK(generate_compact_csr<vid_t, eid_t>(
+            oe_lists_[v_label][e_label], oe_offsets_lists_[v_label][e_label],
+            concurrency, compact_oe_lists_[v_label][e_label],
+            compact_oe_offsets_lists_[v_label][e_label],
+            compact_oe_eids_lists_[v_label][e_label]));
+        oe_lists_[v_label][e_label] = empty_list;
+        if (this->directed_) {
+          BOOST_LEAF_CHECK(generate_compact_csr<vid_t, eid_t>(
+              ie_lists_[v_label][e_label], ie_offsets_lists_[v_label][e_label],
+              concurrency, compact_ie_lists_[v_label][e_label],
+              compact_ie_offsets_lists_[v_label][e_label],
+              compact_ie_eids_lists_[v_label][e_label]));
+          ie_lists_[v_label][e_label] = empty_list;
+        }
+      }
+    }
     return {};
   }
 
@@ -329,6 +401,14 @@ class BasicArrowFragmentBuilder
   std::vector<std::vector<std::shared_ptr<arrow::Int64Array>>>
       ie_offsets_lists_, oe_offsets_lists_;
 
+  bool compact_edges_ = false;
+  std::vector<std::vector<std::shared_ptr<arrow::UInt8Array>>>
+      compact_ie_lists_, compact_oe_lists_;
+  std::vector<std::vector<std::shared_ptr<arrow::Int64Array>>>
+      compact_ie_offsets_lists_, compact_oe_offsets_lists_;
+  std::vector<std::vector<std::shared_ptr<arrow::UInt8Array>>>
+      compact_ie_eids_lists_, compact_oe_eids_lists_;
+
   std::shared_ptr<vertex_map_t> vm_ptr_;
 
   IdParser<vid_t> vid_parser_;
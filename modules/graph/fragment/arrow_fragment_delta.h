@@ -0,0 +1,1241 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef MODULES_GRAPH_FRAGMENT_ARROW_FRAGMENT_DELTA_H_
+#define MODULES_GRAPH_FRAGMENT_ARROW_FRAGMENT_DELTA_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arrow/api.h"
+#include "boost/leaf.hpp"
+
+#include "basic/ds/arrow.h"
+#include "basic/ds/arrow_utils.h"
+#include "client/client.h"
+#include "common/util/typename.h"
+
+#include "graph/fragment/arrow_fragment.h"
+#include "graph/fragment/property_graph_types.h"
+#include "graph/fragment/property_graph_utils.h"
+#include "graph/utils/error.h"
+#include "graph/utils/thread_group.h"
+
+/**
+ * Note [Delta segments]
+ *
+ * Adding edges through `ArrowFragment::AddEdges()` re-generates and re-seals
+ * the whole CSR, which costs time proportional to the size of the graph even
+ * for a handful of new edges. `MutableArrowFragment` instead keeps the
+ * immutable `ArrowFragment` as a base and puts every batch of new edges into
+ * a small sealed `ArrowFragmentDelta`:
+ *
+ * - the edge table of each edge label, as `| src : gid | dst : gid | props |`,
+ *   the same schema as the tables passed to `ArrowFragment::AddEdges()`;
+ * - a sparse CSR for each (vertex label, edge label), i.e., the sorted local
+ *   ids of the vertices that have edges in the segment, the offsets, and the
+ *   `NbrUnit`s whose `eid` is the row in the edge table of the segment;
+ * - the global ids of the outer vertices that first appear in the segment,
+ *   their local ids continue after the vertices of the base fragment and of
+ *   the preceding segments.
+ *
+ * The adjacency list of a vertex is the base list followed by the lists in
+ * each segment (`MergedAdjList`). Edge ids continue after the edges of the
+ * base and of the preceding segments, which are exactly the edge ids after
+ * a compaction.
+ *
+ * Compaction rebuilds a new base fragment from the edges of the base and of
+ * the segments, in a background thread, while new segments can still be
+ * appended. As the local ids of outer vertices in the new base are re-assigned,
+ * segments appended during the compaction are re-built against the new base,
+ * which only costs time proportional to those segments.
+ *
+ * Only edges of existing edge labels between vertices that are known to the
+ * vertex map are supported, new labels still go through `AddEdges()` and
+ * `AddVertices()` of `ArrowFragment`.
+ */
+
+namespace vineyard {
+
+namespace property_graph_utils {
+
+// A vertex has at most one list in the base fragment and one in each delta
+// segment, the `MutableArrowFragment` compacts before exceeding that.
+static constexpr size_t kMaxDeltaSegments = 16;
+
+template <typename VID_T, typename EID_T>
+class MergedAdjList;
+
+template <typename VID_T, typename EID_T>
+struct MergedNbr {
+ private:
+  using prop_id_t = property_graph_types::PROP_ID_TYPE;
+  using adj_list_t = MergedAdjList<VID_T, EID_T>;
+
+ public:
+  MergedNbr() : list_(nullptr), segment_(0), nbr_(nullptr) {}
+  MergedNbr(const adj_list_t* list, size_t segment,
+            const NbrUnit<VID_T, EID_T>* nbr)
+      : list_(list), segment_(segment), nbr_(nbr) {}
+
+  grape::Vertex<VID_T> neighbor() const {
+    return grape::Vertex<VID_T>(nbr_->vid);
+  }
+
+  grape::Vertex<VID_T> get_neighbor() const {
+    return grape::Vertex<VID_T>(nbr_->vid);
+  }
+
+  EID_T edge_id() const { return list_->eid_offset(segment_) + nbr_->eid; }
+
+  template <typename T>
+  T get_data(prop_id_t prop_id) const {
+    return ValueGetter<T>::Value(list_->edata_arrays(segment_)[prop_id],
+                                 nbr_->eid);
+  }
+
+  std::string get_str(prop_id_t prop_id) const {
+    return get_data<std::string>(prop_id);
+  }
+
+  double get_double(prop_id_t prop_id) const {
+    return get_data<double>(prop_id);
+  }
+
+  int64_t get_int(prop_id_t prop_id) const {
+    return get_data<int64_t>(prop_id);
+  }
+
+  inline const MergedNbr& operator++() const {
+    if (++nbr_ == list_->end_unit(segment_)) {
+      list_->seek(segment_ + 1, segment_, nbr_);
+    }
+    return *this;
+  }
+
+  inline MergedNbr operator++(int) const {
+    MergedNbr ret(*this);
+    ++(*this);
+    return ret;
+  }
+
+  inline bool operator==(const MergedNbr& rhs) const {
+    return segment_ == rhs.segment_ && nbr_ == rhs.nbr_;
+  }
+  inline bool operator!=(const MergedNbr& rhs) const {
+    return !(*this == rhs);
+  }
+
+  inline const MergedNbr& operator*() const { return *this; }
+
+ private:
+  const adj_list_t* list_;
+  mutable size_t segment_;
+  mutable const NbrUnit<VID_T, EID_T>* nbr_;
+};
+
+/**
+ * @brief The adjacency list of a vertex in the base fragment and in the delta
+ * segments, see Note [Delta segments].
+ *
+ * The neighbors are sorted inside each segment, but not across segments.
+ */
+template <typename VID_T, typename EID_T>
+class MergedAdjList {
+  struct Segment {
+    const NbrUnit<VID_T, EID_T>* begin;
+    const NbrUnit<VID_T, EID_T>* end;
+    const void** edata_arrays;
+    EID_T eid_offset;
+  };
+
+ public:
+  MergedAdjList() : segment_num_(0), size_(0) {}
+
+  /**
+   * @brief Appends the list of the next segment, whose edge ids start at
+   * `eid_offset`.
+   */
+  inline void Append(const AdjList<VID_T, EID_T>& list, EID_T eid_offset) {
+    if (list.Empty()) {
+      return;
+    }
+    segments_[segment_num_++] = Segment{list.begin_unit(), list.end_unit(),
+                                        list.edata_arrays(), eid_offset};
+    size_ += list.Size();
+  }
+
+  inline MergedNbr<VID_T, EID_T> begin() const {
+    return segment_num_ == 0
+               ? end()
+               : MergedNbr<VID_T, EID_T>(this, 0, segments_[0].begin);
+  }
+
+  inline MergedNbr<VID_T, EID_T> end() const {
+    return MergedNbr<VID_T, EID_T>(this, segment_num_, nullptr);
+  }
+
+  inline size_t Size() const { return size_; }
+
+  inline bool Empty() const { return size_ == 0; }
+
+  inline bool NotEmpty() const { return size_ != 0; }
+
+  size_t size() const { return size_; }
+
+ private:
+  inline const NbrUnit<VID_T, EID_T>* end_unit(size_t segment) const {
+    return segments_[segment].end;
+  }
+
+  inline const void** edata_arrays(size_t segment) const {
+    return segments_[segment].edata_arrays;
+  }
+
+  inline EID_T eid_offset(size_t segment) const {
+    return segments_[segment].eid_offset;
+  }
+
+  // only non-empty lists are appended, thus the next segment, if any, is
+  // where the iteration continues.
+  inline void seek(size_t segment, size_t& current,
+                   const NbrUnit<VID_T, EID_T>*& nbr) const {
+    current = segment;
+    nbr = segment < segment_num_ ? segments_[segment].begin : nullptr;
+  }
+
+  std::array<Segment, kMaxDeltaSegments + 1> segments_;
+  size_t segment_num_;
+  size_t size_;
+
+  friend struct MergedNbr<VID_T, EID_T>;
+};
+
+}  // namespace property_graph_utils
+
+/**
+ * @brief Generates the sparse CSR of the edges of a delta segment, where
+ * `srcs` are the sorted distinct source vertices.
+ */
+template <typename VID_T, typename EID_T>
+boost::leaf::result<void> generate_sparse_csr(
+    std::vector<std::pair<VID_T, property_graph_utils::NbrUnit<VID_T, EID_T>>>&
+        edges,
+    std::shared_ptr<typename ConvertToArrowType<VID_T>::ArrayType>& srcs,
+    std::shared_ptr<arrow::FixedSizeBinaryArray>& nbrs,
+    std::shared_ptr<arrow::Int64Array>& offsets) {
+  using nbr_unit_t = property_graph_utils::NbrUnit<VID_T, EID_T>;
+  std::sort(edges.begin(), edges.end(),
+            [](const std::pair<VID_T, nbr_unit_t>& lhs,
+               const std::pair<VID_T, nbr_unit_t>& rhs) {
+              return lhs.first < rhs.first ||
+                     (lhs.first == rhs.first &&
+                      lhs.second.vid < rhs.second.vid);
+            });
+
+  typename ConvertToArrowType<VID_T>::BuilderType src_builder;
+  arrow::FixedSizeBinaryBuilder nbr_builder(
+      arrow::fixed_size_binary(sizeof(nbr_unit_t)));
+  arrow::Int64Builder offset_builder;
+  ARROW_OK_OR_RAISE(nbr_builder.Reserve(edges.size()));
+  for (size_t i = 0; i < edges.size(); ++i) {
+    if (i == 0 || edges[i].first != edges[i - 1].first) {
+      ARROW_OK_OR_RAISE(src_builder.Append(edges[i].first));
+      ARROW_OK_OR_RAISE(offset_builder.Append(i));
+    }
+    ARROW_OK_OR_RAISE(nbr_builder.Append(
+        reinterpret_cast<const uint8_t*>(&edges[i].second)));
+  }
+  ARROW_OK_OR_RAISE(offset_builder.Append(edges.size()));
+  ARROW_OK_OR_RAISE(src_builder.Finish(&srcs));
+  ARROW_OK_OR_RAISE(nbr_builder.Finish(&nbrs));
+  ARROW_OK_OR_RAISE(offset_builder.Finish(&offsets));
+  return {};
+}
+
+template <typename VID_T>
+class ArrowFragmentDeltaBuilder;
+
+/**
+ * @brief A sealed batch of edges appended to an `ArrowFragment`, see
+ * Note [Delta segments].
+ */
+template <typename VID_T>
+class ArrowFragmentDelta : public Registered<ArrowFragmentDelta<VID_T>> {
+ public:
+  using vid_t = VID_T;
+  using eid_t = property_graph_types::EID_TYPE;
+  using label_id_t = property_graph_types::LABEL_ID_TYPE;
+  using vertex_t = grape::Vertex<vid_t>;
+  using nbr_unit_t = property_graph_utils::NbrUnit<vid_t, eid_t>;
+  using adj_list_t = property_graph_utils::AdjList<vid_t, eid_t>;
+  using vid_array_t = typename ConvertToArrowType<vid_t>::ArrayType;
+
+  static std::unique_ptr<Object> Create() __attribute__((used)) {
+    return std::static_pointer_cast<Object>(
+        std::unique_ptr<ArrowFragmentDelta<VID_T>>{
+            new ArrowFragmentDelta<VID_T>()});
+  }
+
+  /**
+   * @brief The fragment whose local ids are used by the segment.
+   */
+  ObjectID base_id() const { return base_id_; }
+
+  bool directed() const { return directed_; }
+
+  label_id_t vertex_label_num() const { return vertex_label_num_; }
+
+  label_id_t edge_label_num() const { return edge_label_num_; }
+
+  /**
+   * @brief The number of vertices of the label, including the outer vertices
+   * of this and the preceding segments.
+   */
+  vid_t GetVerticesNum(label_id_t label) const { return tvnums_[label]; }
+
+  /**
+   * @brief The global ids of the outer vertices that first appear in this
+   * segment.
+   */
+  std::shared_ptr<vid_array_t> GetOuterVertexGids(label_id_t label) const {
+    return ovgid_lists_[label]->GetArray();
+  }
+
+  int64_t edge_num(label_id_t e_label) const {
+    return edge_tables_[e_label]->num_rows();
+  }
+
+  /**
+   * @brief The edges of the label, as `| src : gid | dst : gid | props |`.
+   */
+  std::shared_ptr<arrow::Table> edge_data_table(label_id_t e_label) const {
+    return edge_tables_[e_label]->GetTable();
+  }
+
+  adj_list_t GetOutgoingAdjList(const vertex_t& v, label_id_t e_label) const {
+    return lookup(oe_lists_, v, e_label);
+  }
+
+  adj_list_t GetIncomingAdjList(const vertex_t& v, label_id_t e_label) const {
+    return lookup(directed_ ? ie_lists_ : oe_lists_, v, e_label);
+  }
+
+  void Construct(const ObjectMeta& meta) override {
+    this->meta_ = meta;
+    this->id_ = meta.GetId();
+
+    base_id_ = meta.GetKeyValue<ObjectID>("base_id");
+    directed_ = meta.GetKeyValue<bool>("directed");
+    vertex_label_num_ = meta.GetKeyValue<label_id_t>("vertex_label_num");
+    edge_label_num_ = meta.GetKeyValue<label_id_t>("edge_label_num");
+    meta.GetKeyValue("tvnums", tvnums_);
+    vid_parser_.Init(meta.GetKeyValue<fid_t>("fnum"), vertex_label_num_);
+
+    ovgid_lists_.resize(vertex_label_num_);
+    for (label_id_t i = 0; i < vertex_label_num_; ++i) {
+      ovgid_lists_[i] = std::dynamic_pointer_cast<NumericArray<vid_t>>(
+          meta.GetMember(generate_name_with_suffix("ovgid_lists", i)));
+    }
+    edge_tables_.resize(edge_label_num_);
+    for (label_id_t i = 0; i < edge_label_num_; ++i) {
+      edge_tables_[i] = std::dynamic_pointer_cast<Table>(
+          meta.GetMember(generate_name_with_suffix("edge_tables", i)));
+    }
+    auto construct_csr = [&](const std::string& prefix,
+                             std::vector<std::vector<Csr>>& lists) {
+      lists.resize(vertex_label_num_);
+      for (label_id_t i = 0; i < vertex_label_num_; ++i) {
+        lists[i].resize(edge_label_num_);
+        for (label_id_t j = 0; j < edge_label_num_; ++j) {
+          auto& csr = lists[i][j];
+          csr.srcs = std::dynamic_pointer_cast<NumericArray<vid_t>>(
+              meta.GetMember(
+                  generate_name_with_suffix(prefix + "_srcs", i, j)));
+          csr.nbrs = std::dynamic_pointer_cast<FixedSizeBinaryArray>(
+              meta.GetMember(
+                  generate_name_with_suffix(prefix + "_nbrs", i, j)));
+          csr.offsets = std::dynamic_pointer_cast<NumericArray<int64_t>>(
+              meta.GetMember(
+                  generate_name_with_suffix(prefix + "_offsets", i, j)));
+        }
+      }
+    };
+    construct_csr("oe", oe_lists_);
+    if (directed_) {
+      construct_csr("ie", ie_lists_);
+    }
+    initPointers();
+  }
+
+ private:
+  struct Csr {
+    std::shared_ptr<NumericArray<vid_t>> srcs;
+    std::shared_ptr<FixedSizeBinaryArray> nbrs;
+    std::shared_ptr<NumericArray<int64_t>> offsets;
+
+    const vid_t* srcs_ptr = nullptr;
+    const nbr_unit_t* nbrs_ptr = nullptr;
+    const int64_t* offsets_ptr = nullptr;
+    int64_t length = 0;
+  };
+
+  void initPointers() {
+    edge_tables_columns_.resize(edge_label_num_);
+    flatten_edge_tables_columns_.resize(edge_label_num_, nullptr);
+    for (label_id_t i = 0; i < edge_label_num_; ++i) {
+      if (edge_tables_[i]->num_rows() == 0) {
+        continue;
+      }
+      auto table = edge_tables_[i]->GetTable();
+      auto& columns = edge_tables_columns_[i];
+      columns.resize(table->num_columns());
+      for (int j = 0; j < table->num_columns(); ++j) {
+        columns[j] = get_arrow_array_data(table->column(j)->chunk(0));
+      }
+      // skip the src and dst columns, to index properties as the base
+      flatten_edge_tables_columns_[i] = columns.data() + 2;
+    }
+
+    auto init_csr = [](std::vector<std::vector<Csr>>& lists) {
+      for (auto& sub_lists : lists) {
+        for (auto& csr : sub_lists) {
+          csr.srcs_ptr = csr.srcs->GetArray()->raw_values();
+          csr.nbrs_ptr = reinterpret_cast<const nbr_unit_t*>(
+              csr.nbrs->GetArray()->raw_values());
+          csr.offsets_ptr = csr.offsets->GetArray()->raw_values();
+          csr.length = csr.srcs->GetArray()->length();
+        }
+      }
+    };
+    init_csr(oe_lists_);
+    init_csr(ie_lists_);
+  }
+
+  adj_list_t lookup(const std::vector<std::vector<Csr>>& lists,
+                    const vertex_t& v, label_id_t e_label) const {
+    label_id_t v_label = vid_parser_.GetLabelId(v.GetValue());
+    const Csr& csr = lists[v_label][e_label];
+    const vid_t* end = csr.srcs_ptr + csr.length;
+    const vid_t* iter = std::lower_bound(csr.srcs_ptr, end, v.GetValue());
+    if (iter == end || *iter != v.GetValue()) {
+      return adj_list_t();
+    }
+    int64_t index = iter - csr.srcs_ptr;
+    return adj_list_t(csr.nbrs_ptr + csr.offsets_ptr[index],
+                      csr.nbrs_ptr + csr.offsets_ptr[index + 1],
+                      flatten_edge_tables_columns_[e_label]);
+  }
+
+  ObjectID base_id_ = InvalidObjectID();
+  bool directed_ = true;
+  label_id_t vertex_label_num_ = 0;
+  label_id_t edge_label_num_ = 0;
+  std::vector<vid_t> tvnums_;
+
+  std::vector<std::shared_ptr<NumericArray<vid_t>>> ovgid_lists_;
+  std::vector<std::shared_ptr<Table>> edge_tables_;
+  std::vector<std::vector<const void*>> edge_tables_columns_;
+  std::vector<const void**> flatten_edge_tables_columns_;
+
+  std::vector<std::vector<Csr>> ie_lists_, oe_lists_;
+
+  IdParser<vid_t> vid_parser_;
+
+  friend class ArrowFragmentDeltaBuilder<VID_T>;
+};
+
+template <typename VID_T>
+class ArrowFragmentDeltaBuilder : public ObjectBuilder {
+  using vid_t = VID_T;
+  using label_id_t = property_graph_types::LABEL_ID_TYPE;
+  using vid_array_t = typename ConvertToArrowType<vid_t>::ArrayType;
+
+  struct CsrArrays {
+    std::shared_ptr<vid_array_t> srcs;
+    std::shared_ptr<arrow::FixedSizeBinaryArray> nbrs;
+    std::shared_ptr<arrow::Int64Array> offsets;
+  };
+
+ public:
+  ArrowFragmentDeltaBuilder(ObjectID base_id, fid_t fnum, bool directed,
+                            label_id_t vertex_label_num,
+                            label_id_t edge_label_num)
+      : base_id_(base_id),
+        fnum_(fnum),
+        directed_(directed),
+        vertex_label_num_(vertex_label_num),
+        edge_label_num_(edge_label_num),
+        ovgid_lists_(vertex_label_num),
+        edge_tables_(edge_label_num),
+        oe_lists_(vertex_label_num, std::vector<CsrArrays>(edge_label_num)),
+        ie_lists_(vertex_label_num, std::vector<CsrArrays>(edge_label_num)) {}
+
+  void set_tvnums(const std::vector<vid_t>& tvnums) { tvnums_ = tvnums; }
+
+  void set_ovgid_list(label_id_t label, std::shared_ptr<vid_array_t> list) {
+    ovgid_lists_[label] = list;
+  }
+
+  void set_edge_table(label_id_t e_label,
+                      std::shared_ptr<arrow::Table> edge_table) {
+    edge_tables_[e_label] = edge_table;
+  }
+
+  void set_oe_list(label_id_t v_label, label_id_t e_label,
+                   std::shared_ptr<vid_array_t> srcs,
+                   std::shared_ptr<arrow::FixedSizeBinaryArray> nbrs,
+                   std::shared_ptr<arrow::Int64Array> offsets) {
+    oe_lists_[v_label][e_label] = CsrArrays{srcs, nbrs, offsets};
+  }
+
+  void set_ie_list(label_id_t v_label, label_id_t e_label,
+                   std::shared_ptr<vid_array_t> srcs,
+                   std::shared_ptr<arrow::FixedSizeBinaryArray> nbrs,
+                   std::shared_ptr<arrow::Int64Array> offsets) {
+    ie_lists_[v_label][e_label] = CsrArrays{srcs, nbrs, offsets};
+  }
+
+  Status Build(Client& client) override { return Status::OK(); }
+
+  std::shared_ptr<Object> _Seal(Client& client) override {
+    // ensure the builder hasn't been sealed yet.
+    ENSURE_NOT_SEALED(this);
+
+    VINEYARD_CHECK_OK(this->Build(client));
+
+    auto delta = std::make_shared<ArrowFragmentDelta<vid_t>>();
+    delta->base_id_ = base_id_;
+    delta->directed_ = directed_;
+    delta->vertex_label_num_ = vertex_label_num_;
+    delta->edge_label_num_ = edge_label_num_;
+    delta->tvnums_ = tvnums_;
+    delta->ovgid_lists_.resize(vertex_label_num_);
+    delta->edge_tables_.resize(edge_label_num_);
+    delta->oe_lists_.resize(vertex_label_num_);
+    if (directed_) {
+      delta->ie_lists_.resize(vertex_label_num_);
+    }
+
+    ThreadGroup tg;
+    for (label_id_t i = 0; i < vertex_label_num_; ++i) {
+      auto fn = [this, i, &delta](Client* client) {
+        NumericArrayBuilder<vid_t> builder(*client, ovgid_lists_[i]);
+        delta->ovgid_lists_[i] =
+            std::dynamic_pointer_cast<NumericArray<vid_t>>(
+                builder.Seal(*client));
+        return Status::OK();
+      };
+      tg.AddTask(fn, &client);
+    }
+    for (label_id_t i = 0; i < edge_label_num_; ++i) {
+      auto fn = [this, i, &delta](Client* client) {
+        TableBuilder builder(*client, edge_tables_[i]);
+        delta->edge_tables_[i] =
+            std::dynamic_pointer_cast<Table>(builder.Seal(*client));
+        return Status::OK();
+      };
+      tg.AddTask(fn, &client);
+    }
+    auto seal_csr = [](Client& client, const CsrArrays& arrays,
+                       typename ArrowFragmentDelta<vid_t>::Csr& csr) {
+      NumericArrayBuilder<vid_t> srcs(client, arrays.srcs);
+      csr.srcs =
+          std::dynamic_pointer_cast<NumericArray<vid_t>>(srcs.Seal(client));
+      FixedSizeBinaryArrayBuilder nbrs(client, arrays.nbrs);
+      csr.nbrs =
+          std::dynamic_pointer_cast<FixedSizeBinaryArray>(nbrs.Seal(client));
+      NumericArrayBuilder<int64_t> offsets(client, arrays.offsets);
+      csr.offsets = std::dynamic_pointer_cast<NumericArray<int64_t>>(
+          offsets.Seal(client));
+    };
+    for (label_id_t i = 0; i < vertex_label_num_; ++i) {
+      delta->oe_lists_[i].resize(edge_label_num_);
+      if (directed_) {
+        delta->ie_lists_[i].resize(edge_label_num_);
+      }
+      for (label_id_t j = 0; j < edge_label_num_; ++j) {
+        auto fn = [this, i, j, &delta, &seal_csr](Client* client) {
+          seal_csr(*client, oe_lists_[i][j], delta->oe_lists_[i][j]);
+          if (directed_) {
+            seal_csr(*client, ie_lists_[i][j], delta->ie_lists_[i][j]);
+          }
+          return Status::OK();
+        };
+        tg.AddTask(fn, &client);
+      }
+    }
+    tg.TakeResults();
+
+    delta->meta_.SetTypeName(type_name<ArrowFragmentDelta<vid_t>>());
+    delta->meta_.AddKeyValue("base_id", base_id_);
+    delta->meta_.AddKeyValue("fnum", fnum_);
+    delta->meta_.AddKeyValue("directed", directed_);
+    delta->meta_.AddKeyValue("vertex_label_num", vertex_label_num_);
+    delta->meta_.AddKeyValue("edge_label_num", edge_label_num_);
+    delta->meta_.AddKeyValue("tvnums", tvnums_);
+    for (label_id_t i = 0; i < vertex_label_num_; ++i) {
+      delta->meta_.AddMember(generate_name_with_suffix("ovgid_lists", i),
+                             delta->ovgid_lists_[i]);
+    }
+    for (label_id_t i = 0; i < edge_label_num_; ++i) {
+      delta->meta_.AddMember(generate_name_with_suffix("edge_tables", i),
+                             delta->edge_tables_[i]);
+    }
+    using csr_t = typename ArrowFragmentDelta<vid_t>::Csr;
+    auto add_csr = [&delta](const std::string& prefix, label_id_t i,
+                            label_id_t j, const csr_t& csr) {
+      delta->meta_.AddMember(generate_name_with_suffix(prefix + "_srcs", i, j),
+                             csr.srcs);
+      delta->meta_.AddMember(generate_name_with_suffix(prefix + "_nbrs", i, j),
+                             csr.nbrs);
+      delta->meta_.AddMember(
+          generate_name_with_suffix(prefix + "_offsets", i, j), csr.offsets);
+    };
+    for (label_id_t i = 0; i < vertex_label_num_; ++i) {
+      for (label_id_t j = 0; j < edge_label_num_; ++j) {
+        add_csr("oe", i, j, delta->oe_lists_[i][j]);
+        if (directed_) {
+          add_csr("ie", i, j, delta->ie_lists_[i][j]);
+        }
+      }
+    }
+    delta->vid_parser_.Init(fnum_, vertex_label_num_);
+    delta->initPointers();
+
+    VINEYARD_CHECK_OK(client.CreateMetaData(delta->meta_, delta->id_));
+    // mark the builder as sealed
+    this->set_sealed(true);
+
+    return std::static_pointer_cast<Object>(delta);
+  }
+
+ private:
+  ObjectID base_id_;
+  fid_t fnum_;
+  bool directed_;
+  label_id_t vertex_label_num_;
+  label_id_t edge_label_num_;
+  std::vector<vid_t> tvnums_;
+
+  std::vector<std::shared_ptr<vid_array_t>> ovgid_lists_;
+  std::vector<std::shared_ptr<arrow::Table>> edge_tables_;
+  std::vector<std::vector<CsrArrays>> oe_lists_, ie_lists_;
+};
+
+/**
+ * @brief An `ArrowFragment` with appendable edges, which are kept in delta
+ * segments and compacted into a new base fragment in the background, see
+ * Note [Delta segments].
+ *
+ * The methods are not thread-safe, they are expected to be called from the
+ * thread that also traverses the fragment, and a finished background
+ * compaction takes effect only in `AddEdges()`, `PollCompaction()` and
+ * `Compact()`.
+ */
+template <typename OID_T, typename VID_T>
+class MutableArrowFragment {
+ public:
+  using oid_t = OID_T;
+  using vid_t = VID_T;
+  using eid_t = property_graph_types::EID_TYPE;
+  using label_id_t = property_graph_types::LABEL_ID_TYPE;
+  using fragment_t = ArrowFragment<oid_t, vid_t>;
+  using delta_t = ArrowFragmentDelta<vid_t>;
+  using vertex_t = grape::Vertex<vid_t>;
+  using vertex_range_t = grape::VertexRange<vid_t>;
+  using nbr_unit_t = property_graph_utils::NbrUnit<vid_t, eid_t>;
+  using nbr_t = property_graph_utils::MergedNbr<vid_t, eid_t>;
+  using adj_list_t = property_graph_utils::MergedAdjList<vid_t, eid_t>;
+  using vid_array_t = typename ConvertToArrowType<vid_t>::ArrayType;
+
+  MutableArrowFragment(Client& client, std::shared_ptr<fragment_t> base)
+      : client_(client) {
+    reset(base);
+  }
+
+  ~MutableArrowFragment() {
+    if (compaction_.valid()) {
+      compaction_.wait();
+    }
+  }
+
+  const std::shared_ptr<fragment_t>& base() const { return base_; }
+
+  const std::vector<std::shared_ptr<delta_t>>& deltas() const {
+    return deltas_;
+  }
+
+  /**
+   * @brief Compacts in the background once there are at least `threshold`
+   * delta segments, 0 disables the automatic compaction.
+   */
+  void set_compaction_threshold(size_t threshold) {
+    compaction_threshold_ = threshold;
+  }
+
+  fid_t fid() const { return base_->fid(); }
+
+  fid_t fnum() const { return base_->fnum(); }
+
+  bool directed() const { return base_->directed(); }
+
+  label_id_t vertex_label_num() const { return base_->vertex_label_num(); }
+
+  label_id_t edge_label_num() const { return base_->edge_label_num(); }
+
+  const PropertyGraphSchema& schema() const { return base_->schema(); }
+
+  vertex_range_t Vertices(label_id_t label_id) const {
+    return vertex_range_t(
+        vid_parser_.GenerateId(0, label_id, 0),
+        vid_parser_.GenerateId(0, label_id, tvnums_[label_id]));
+  }
+
+  vertex_range_t InnerVertices(label_id_t label_id) const {
+    return base_->InnerVertices(label_id);
+  }
+
+  vertex_range_t OuterVertices(label_id_t label_id) const {
+    return vertex_range_t(
+        vid_parser_.GenerateId(0, label_id,
+                               base_->GetInnerVerticesNum(label_id)),
+        vid_parser_.GenerateId(0, label_id, tvnums_[label_id]));
+  }
+
+  vid_t GetVerticesNum(label_id_t label_id) const { return tvnums_[label_id]; }
+
+  bool IsInnerVertex(const vertex_t& v) const {
+    return base_->IsInnerVertex(v);
+  }
+
+  bool IsOuterVertex(const vertex_t& v) const {
+    label_id_t label = vid_parser_.GetLabelId(v.GetValue());
+    vid_t offset = vid_parser_.GetOffset(v.GetValue());
+    return offset < tvnums_[label] &&
+           offset >= base_->GetInnerVerticesNum(label);
+  }
+
+  bool Gid2Vertex(const vid_t& gid, vertex_t& v) const {
+    if (base_->Gid2Vertex(gid, v)) {
+      return true;
+    }
+    auto& map = extra_ovg2l_maps_[vid_parser_.GetLabelId(gid)];
+    auto iter = map.find(gid);
+    if (iter == map.end()) {
+      return false;
+    }
+    v.SetValue(iter->second);
+    return true;
+  }
+
+  vid_t Vertex2Gid(const vertex_t& v) const {
+    return IsInnerVertex(v) ? base_->GetInnerVertexGid(v)
+                            : GetOuterVertexGid(v);
+  }
+
+  vid_t GetOuterVertexGid(const vertex_t& v) const {
+    label_id_t label = vid_parser_.GetLabelId(v.GetValue());
+    vid_t offset = vid_parser_.GetOffset(v.GetValue());
+    vid_t base_tvnum = base_->GetVerticesNum(label);
+    return offset < base_tvnum ? base_->GetOuterVertexGid(v)
+                               : extra_ovgids_[label][offset - base_tvnum];
+  }
+
+  oid_t GetId(const vertex_t& v) const {
+    return IsInnerVertex(v) ? base_->GetId(v)
+                            : base_->Gid2Oid(GetOuterVertexGid(v));
+  }
+
+  adj_list_t GetOutgoingAdjList(const vertex_t& v, label_id_t e_label) const {
+    adj_list_t list;
+    if (inBase(v)) {
+      list.Append(base_->GetOutgoingAdjList(v, e_label), 0);
+    }
+    for (size_t i = 0; i < deltas_.size(); ++i) {
+      list.Append(deltas_[i]->GetOutgoingAdjList(v, e_label),
+                  eid_offsets_[i][e_label]);
+    }
+    return list;
+  }
+
+  adj_list_t GetIncomingAdjList(const vertex_t& v, label_id_t e_label) const {
+    adj_list_t list;
+    if (inBase(v)) {
+      list.Append(base_->GetIncomingAdjList(v, e_label), 0);
+    }
+    for (size_t i = 0; i < deltas_.size(); ++i) {
+      list.Append(deltas_[i]->GetIncomingAdjList(v, e_label),
+                  eid_offsets_[i][e_label]);
+    }
+    return list;
+  }
+
+  int GetLocalOutDegree(const vertex_t& v, label_id_t e_label) const {
+    return GetOutgoingAdjList(v, e_label).Size();
+  }
+
+  int GetLocalInDegree(const vertex_t& v, label_id_t e_label) const {
+    return GetIncomingAdjList(v, e_label).Size();
+  }
+
+  /**
+   * @brief Appends the edges as a new delta segment.
+   *
+   * @param edge_tables_map Edges of existing edge labels, as
+   *  | src : gid | dst : gid | property_1 | ... | property_m |
+   * where the properties follow the schema of the edge label, and at least
+   * one of src and dst is an inner vertex of the fragment.
+   * @return The object id of the delta segment.
+   */
+  boost::leaf::result<ObjectID> AddEdges(
+      std::map<label_id_t, std::shared_ptr<arrow::Table>>&& edge_tables_map,
+      int concurrency = 1) {
+    if (base_->compact_edges()) {
+      RETURN_GS_ERROR(ErrorCode::kUnsupportedOperationError,
+                      "Cannot append edges to the fragment with compact edges");
+    }
+    BOOST_LEAF_CHECK(PollCompaction());
+    if (deltas_.size() >= property_graph_utils::kMaxDeltaSegments) {
+      BOOST_LEAF_CHECK(PollCompaction(true));
+    }
+    if (deltas_.size() >= property_graph_utils::kMaxDeltaSegments) {
+      BOOST_LEAF_CHECK(Compact(concurrency));
+    }
+
+    for (auto& pair : edge_tables_map) {
+      BOOST_LEAF_ASSIGN(pair.second, checkEdgeTable(pair.first, pair.second));
+    }
+    BOOST_LEAF_AUTO(delta, buildDelta(edge_tables_map));
+    append(delta);
+
+    if (compaction_threshold_ != 0 && deltas_.size() >= compaction_threshold_) {
+      CompactAsync(concurrency);
+    }
+    return delta->id();
+  }
+
+  /**
+   * @brief Appends a delta segment that was built upon the base fragment,
+   * e.g., to restore the fragment from the base and segments.
+   */
+  boost::leaf::result<void> AddDelta(std::shared_ptr<delta_t> delta) {
+    if (delta->base_id() != base_->id()) {
+      RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                      "The delta segment is not built upon the fragment");
+    }
+    for (label_id_t i = 0; i < vertex_label_num(); ++i) {
+      int64_t prev_tvnum = static_cast<int64_t>(delta->GetVerticesNum(i)) -
+                           delta->GetOuterVertexGids(i)->length();
+      if (prev_tvnum != static_cast<int64_t>(tvnums_[i])) {
+        RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                        "The delta segment doesn't follow the last segment");
+      }
+    }
+    if (deltas_.size() >= property_graph_utils::kMaxDeltaSegments) {
+      RETURN_GS_ERROR(ErrorCode::kInvalidOperationError,
+                      "Too many delta segments, compact first");
+    }
+    append(delta);
+    return {};
+  }
+
+  /**
+   * @brief Folds all delta segments into a new base fragment, and waits until
+   * it is finished.
+   *
+   * @return The object id of the new base fragment.
+   */
+  boost::leaf::result<ObjectID> Compact(int concurrency = 1) {
+    BOOST_LEAF_CHECK(PollCompaction(true));
+    if (deltas_.empty()) {
+      return base_->id();
+    }
+    BOOST_LEAF_AUTO(frag_id, compact(client_, base_, deltas_, concurrency));
+    BOOST_LEAF_CHECK(replaceBase(frag_id, deltas_.size()));
+    return frag_id;
+  }
+
+  /**
+   * @brief Starts to fold the current delta segments into a new base fragment
+   * in the background, unless there is a running compaction.
+   */
+  void CompactAsync(int concurrency = 1) {
+    if (compaction_.valid() || deltas_.empty()) {
+      return;
+    }
+    Client* client = &client_;
+    auto base = base_;
+    auto deltas = deltas_;
+    compacting_delta_num_ = deltas.size();
+    compaction_ = std::async(
+        std::launch::async, [client, base, deltas, concurrency]() {
+          return boost::leaf::try_handle_all(
+              [&]() -> boost::leaf::result<compaction_result_t> {
+                BOOST_LEAF_AUTO(frag_id,
+                                compact(*client, base, deltas, concurrency));
+                return compaction_result_t(frag_id, GSError());
+              },
+              [](const GSError& e) {
+                return compaction_result_t(InvalidObjectID(), e);
+              },
+              [](const boost::leaf::error_info&) {
+                return compaction_result_t(
+                    InvalidObjectID(),
+                    GSError(ErrorCode::kUnspecificError,
+                            "Unmatched error in compaction"));
+              });
+        });
+  }
+
+  /**
+   * @brief Switches to the new base fragment if the background compaction has
+   * finished, or waits for it when `wait` is true.
+   *
+   * @return Whether the base fragment has been switched.
+   */
+  boost::leaf::result<bool> PollCompaction(bool wait = false) {
+    if (!compaction_.valid()) {
+      return false;
+    }
+    if (!wait && compaction_.wait_for(std::chrono::seconds(0)) !=
+                     std::future_status::ready) {
+      return false;
+    }
+    compaction_result_t result = compaction_.get();
+    if (result.second) {
+      return boost::leaf::new_error(result.second);
+    }
+    BOOST_LEAF_CHECK(replaceBase(result.first, compacting_delta_num_));
+    return true;
+  }
+
+ private:
+  using compaction_result_t = std::pair<ObjectID, GSError>;
+
+  void reset(std::shared_ptr<fragment_t> base) {
+    base_ = base;
+    deltas_.clear();
+    eid_offsets_.clear();
+    label_id_t vertex_label_num = base_->vertex_label_num();
+    label_id_t edge_label_num = base_->edge_label_num();
+    vid_parser_.Init(base_->fnum(), vertex_label_num);
+    tvnums_.resize(vertex_label_num);
+    extra_ovgids_.clear();
+    extra_ovgids_.resize(vertex_label_num);
+    extra_ovg2l_maps_.clear();
+    extra_ovg2l_maps_.resize(vertex_label_num);
+    for (label_id_t i = 0; i < vertex_label_num; ++i) {
+      tvnums_[i] = base_->GetVerticesNum(i);
+    }
+    edge_nums_.resize(edge_label_num);
+    for (label_id_t i = 0; i < edge_label_num; ++i) {
+      edge_nums_[i] = base_->edge_data_table(i)->num_rows();
+    }
+  }
+
+  void append(std::shared_ptr<delta_t> delta) {
+    for (label_id_t i = 0; i < vertex_label_num(); ++i) {
+      auto ovgids = delta->GetOuterVertexGids(i);
+      for (int64_t k = 0; k < ovgids->length(); ++k) {
+        extra_ovg2l_maps_[i].emplace(ovgids->Value(k),
+                                     vid_parser_.GenerateId(0, i, tvnums_[i]));
+        extra_ovgids_[i].push_back(ovgids->Value(k));
+        ++tvnums_[i];
+      }
+    }
+    eid_offsets_.push_back(edge_nums_);
+    for (label_id_t i = 0; i < edge_label_num(); ++i) {
+      edge_nums_[i] += delta->edge_num(i);
+    }
+    deltas_.push_back(delta);
+  }
+
+  // outer vertices introduced by the delta segments have no base lists
+  bool inBase(const vertex_t& v) const {
+    return vid_parser_.GetOffset(v.GetValue()) <
+           static_cast<int64_t>(base_->GetVerticesNum(
+               vid_parser_.GetLabelId(v.GetValue())));
+  }
+
+  boost::leaf::result<std::shared_ptr<arrow::Table>> checkEdgeTable(
+      label_id_t e_label, std::shared_ptr<arrow::Table> table) const {
+    if (e_label < 0 || e_label >= edge_label_num()) {
+      RETURN_GS_ERROR(
+          ErrorCode::kInvalidValueError,
+          "Edge label " + std::to_string(e_label) +
+              " doesn't exist, new labels should be added to the fragment");
+    }
+    auto schema = base_->edge_data_table(e_label)->schema();
+    bool valid = table->num_columns() == schema->num_fields() + 2;
+    for (int i = 0; valid && i < 2; ++i) {
+      valid = table->field(i)->type()->Equals(
+          ConvertToArrowType<vid_t>::TypeValue());
+    }
+    for (int i = 0; valid && i < schema->num_fields(); ++i) {
+      valid = table->field(i + 2)->type()->Equals(schema->field(i)->type());
+    }
+    if (!valid) {
+      RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                      "The edge table doesn't match the schema of edge label " +
+                          std::to_string(e_label));
+    }
+    ARROW_OK_ASSIGN_OR_RAISE(
+        table, table->CombineChunks(arrow::default_memory_pool()));
+    return table;
+  }
+
+  boost::leaf::result<std::shared_ptr<delta_t>> buildDelta(
+      const std::map<label_id_t, std::shared_ptr<arrow::Table>>&
+          edge_tables_map) {
+    label_id_t vertex_label_num = base_->vertex_label_num();
+    label_id_t edge_label_num = base_->edge_label_num();
+    bool directed = base_->directed();
+    ArrowFragmentDeltaBuilder<vid_t> builder(base_->id(), base_->fnum(),
+                                             directed, vertex_label_num,
+                                             edge_label_num);
+
+    std::vector<vid_t> tvnums = tvnums_;
+    std::vector<std::vector<vid_t>> ovgids(vertex_label_num);
+    std::vector<typename fragment_t::ovg2l_map_t> ovg2l_maps(vertex_label_num);
+    auto gid2lid = [&](vid_t gid) -> vid_t {
+      vertex_t v;
+      if (Gid2Vertex(gid, v)) {
+        return v.GetValue();
+      }
+      label_id_t label = vid_parser_.GetLabelId(gid);
+      auto iter = ovg2l_maps[label].find(gid);
+      if (iter != ovg2l_maps[label].end()) {
+        return iter->second;
+      }
+      vid_t lid = vid_parser_.GenerateId(0, label, tvnums[label]++);
+      ovg2l_maps[label].emplace(gid, lid);
+      ovgids[label].push_back(gid);
+      return lid;
+    };
+
+    std::vector<std::vector<std::pair<vid_t, nbr_unit_t>>> oe(vertex_label_num),
+        ie(vertex_label_num);
+    for (label_id_t e_label = 0; e_label < edge_label_num; ++e_label) {
+      std::shared_ptr<arrow::Table> table;
+      auto iter = edge_tables_map.find(e_label);
+      if (iter != edge_tables_map.end()) {
+        table = iter->second;
+      } else {
+        BOOST_LEAF_ASSIGN(table, emptyEdgeTable(e_label));
+      }
+
+      int64_t edge_num = table->num_rows();
+      if (edge_num > 0) {
+        auto srcs =
+            std::dynamic_pointer_cast<vid_array_t>(table->column(0)->chunk(0));
+        auto dsts =
+            std::dynamic_pointer_cast<vid_array_t>(table->column(1)->chunk(0));
+        for (int64_t i = 0; i < edge_num; ++i) {
+          vid_t src_gid = srcs->Value(i), dst_gid = dsts->Value(i);
+          if (vid_parser_.GetFid(src_gid) != fid() &&
+              vid_parser_.GetFid(dst_gid) != fid()) {
+            RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                            "Neither end of the edge belongs to the fragment");
+          }
+          vid_t src = gid2lid(src_gid), dst = gid2lid(dst_gid);
+          oe[vid_parser_.GetLabelId(src)].emplace_back(src,
+                                                       nbr_unit_t(dst, i));
+          if (directed) {
+            ie[vid_parser_.GetLabelId(dst)].emplace_back(dst,
+                                                         nbr_unit_t(src, i));
+          } else {
+            oe[vid_parser_.GetLabelId(dst)].emplace_back(dst,
+                                                         nbr_unit_t(src, i));
+          }
+        }
+      }
+
+      for (label_id_t v_label = 0; v_label < vertex_label_num; ++v_label) {
+        std::shared_ptr<vid_array_t> srcs;
+        std::shared_ptr<arrow::FixedSizeBinaryArray> nbrs;
+        std::shared_ptr<arrow::Int64Array> offsets;
+        BOOST_LEAF_CHECK((generate_sparse_csr<vid_t, eid_t>(
+            oe[v_label], srcs, nbrs, offsets)));
+        builder.set_oe_list(v_label, e_label, srcs, nbrs, offsets);
+        oe[v_label].clear();
+        if (directed) {
+          BOOST_LEAF_CHECK((generate_sparse_csr<vid_t, eid_t>(
+              ie[v_label], srcs, nbrs, offsets)));
+          builder.set_ie_list(v_label, e_label, srcs, nbrs, offsets);
+          ie[v_label].clear();
+        }
+      }
+      builder.set_edge_table(e_label, table);
+    }
+
+    for (label_id_t i = 0; i < vertex_label_num; ++i) {
+      typename ConvertToArrowType<vid_t>::BuilderType ovgid_builder;
+      std::shared_ptr<vid_array_t> ovgid_list;
+      ARROW_OK_OR_RAISE(ovgid_builder.AppendValues(ovgids[i]));
+      ARROW_OK_OR_RAISE(ovgid_builder.Finish(&ovgid_list));
+      builder.set_ovgid_list(i, ovgid_list);
+    }
+    builder.set_tvnums(tvnums);
+    return std::dynamic_pointer_cast<delta_t>(builder.Seal(client_));
+  }
+
+  boost::leaf::result<std::shared_ptr<arrow::Table>> emptyEdgeTable(
+      label_id_t e_label) const {
+    auto schema = base_->edge_data_table(e_label)->schema();
+    std::vector<std::shared_ptr<arrow::Field>> fields = {
+        arrow::field("src", ConvertToArrowType<vid_t>::TypeValue()),
+        arrow::field("dst", ConvertToArrowType<vid_t>::TypeValue())};
+    fields.insert(fields.end(), schema->fields().begin(),
+                  schema->fields().end());
+    std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+    for (auto const& field : fields) {
+      columns.push_back(std::make_shared<arrow::ChunkedArray>(
+          arrow::ArrayVector{}, field->type()));
+    }
+    return arrow::Table::Make(arrow::schema(fields), columns);
+  }
+
+  // the segments appended during the background compaction are re-built, as
+  // the outer vertices of the new base have different local ids.
+  boost::leaf::result<void> replaceBase(ObjectID frag_id,
+                                        size_t compacted_delta_num) {
+    auto base =
+        std::dynamic_pointer_cast<fragment_t>(client_.GetObject(frag_id));
+    if (base == nullptr) {
+      RETURN_GS_ERROR(ErrorCode::kVineyardError,
+                      "Failed to get the compacted fragment " +
+                          ObjectIDToString(frag_id));
+    }
+    std::vector<std::shared_ptr<delta_t>> remaining(
+        deltas_.begin() + compacted_delta_num, deltas_.end());
+    reset(base);
+    for (auto const& delta : remaining) {
+      std::map<label_id_t, std::shared_ptr<arrow::Table>> edge_tables_map;
+      for (label_id_t i = 0; i < edge_label_num(); ++i) {
+        edge_tables_map[i] = delta->edge_data_table(i);
+      }
+      BOOST_LEAF_AUTO(rebuilt, buildDelta(edge_tables_map));
+      append(rebuilt);
+    }
+    return {};
+  }
+
+  // | src : gid | dst : gid | props | of the base fragment, the rows are
+  // ordered by edge ids.
+  static boost::leaf::result<std::shared_ptr<arrow::Table>> baseEdgeTable(
+      const std::shared_ptr<fragment_t>& base, label_id_t e_label,
+      int concurrency) {
+    auto table = base->edge_data_table(e_label);
+    int64_t edge_num = table->num_rows();
+    std::vector<vid_t> srcs(edge_num), dsts(edge_num);
+    for (label_id_t v_label = 0; v_label < base->vertex_label_num();
+         ++v_label) {
+      vid_t begin = base->Vertices(v_label).begin().GetValue();
+      auto fill = [&](vid_t vid) {
+        vertex_t v(vid);
+        vid_t src = base->Vertex2Gid(v);
+        for (auto& e : base->GetOutgoingAdjList(v, e_label)) {
+          vid_t dst = base->Vertex2Gid(e.neighbor());
+          // an undirected edge is in the lists of both ends
+          if (base->directed() || src <= dst) {
+            srcs[e.edge_id()] = src;
+            dsts[e.edge_id()] = dst;
+          }
+        }
+      };
+      parallel_for(begin, begin + base->GetVerticesNum(v_label), fill,
+                   concurrency);
+    }
+
+    typename ConvertToArrowType<vid_t>::BuilderType src_builder, dst_builder;
+    std::shared_ptr<vid_array_t> src_array, dst_array;
+    ARROW_OK_OR_RAISE(src_builder.AppendValues(srcs));
+    ARROW_OK_OR_RAISE(src_builder.Finish(&src_array));
+    ARROW_OK_OR_RAISE(dst_builder.AppendValues(dsts));
+    ARROW_OK_OR_RAISE(dst_builder.Finish(&dst_array));
+    ARROW_OK_ASSIGN_OR_RAISE(
+        table,
+        table->AddColumn(0,
+                         arrow::field("src", src_array->type()),
+                         std::make_shared<arrow::ChunkedArray>(src_array)));
+    ARROW_OK_ASSIGN_OR_RAISE(
+        table,
+        table->AddColumn(1,
+                         arrow::field("dst", dst_array->type()),
+                         std::make_shared<arrow::ChunkedArray>(dst_array)));
+    return table;
+  }
+
+  static boost::leaf::result<ObjectID> compact(
+      Client& client, std::shared_ptr<fragment_t> base,
+      std::vector<std::shared_ptr<delta_t>> deltas, int concurrency) {
+    std::vector<std::shared_ptr<arrow::Table>> vertex_tables, edge_tables;
+    for (label_id_t i = 0; i < base->vertex_label_num(); ++i) {
+      vertex_tables.push_back(base->vertex_data_table(i));
+    }
+    for (label_id_t i = 0; i < base->edge_label_num(); ++i) {
+      BOOST_LEAF_AUTO(table, baseEdgeTable(base, i, concurrency));
+      std::vector<std::shared_ptr<arrow::Table>> tables = {table};
+      for (auto const& delta : deltas) {
+        if (delta->edge_num(i) > 0) {
+          tables.push_back(delta->edge_data_table(i));
+        }
+      }
+      edge_tables.push_back(ConcatenateTables(tables));
+    }
+
+    BasicArrowFragmentBuilder<oid_t, vid_t> builder(client,
+                                                    base->GetVertexMap());
+    PropertyGraphSchema schema = base->schema();
+    builder.SetPropertyGraphSchema(std::move(schema));
+    BOOST_LEAF_CHECK(builder.Init(base->fid(), base->fnum(),
+                                  std::move(vertex_tables),
+                                  std::move(edge_tables), base->directed(),
+                                  concurrency));
+    auto frag = builder.Seal(client);
+    VY_OK_OR_RAISE(client.Persist(frag->id()));
+    return frag->id();
+  }
+
+  Client& client_;
+
+  std::shared_ptr<fragment_t> base_;
+  std::vector<std::shared_ptr<delta_t>> deltas_;
+
+  IdParser<vid_t> vid_parser_;
+  std::vector<vid_t> tvnums_;
+  // the outer vertices introduced by the delta segments
+  std::vector<std::vector<vid_t>> extra_ovgids_;
+  std::vector<typename fragment_t::ovg2l_map_t> extra_ovg2l_maps_;
+  // the number of edges, and where the edge ids of each segment start
+  std::vector<eid_t> edge_nums_;
+  std::vector<std::vector<eid_t>> eid_offsets_;
+
+  size_t compaction_threshold_ = 4;
+  size_t compacting_delta_num_ = 0;
+  std::future<compaction_result_t> compaction_;
+};
+
+}  // namespace vineyard
+
+#endif  // MODULES_GRAPH_FRAGMENT_ARROW_FRAGMENT_DELTA_H_
@@ -164,6 +164,10 @@ ArrowFragment<OID_T, VID_T>::AddNewVertexEdgeLabels(
     const std::vector<std::set<std::pair<std::string, std::string>>>&
         edge_relations,
     int concurrency) {
+  if (compact_edges_) {
+    RETURN_GS_ERROR(ErrorCode::kUnsupportedOperationError,
+                    "Cannot modify the fragment with compact edges");
+  }
   int extra_vertex_label_num = vertex_tables.size();
   int total_vertex_label_num = vertex_label_num_ + extra_vertex_label_num;
   int extra_edge_label_num = edge_tables.size();
@@ -563,6 +567,10 @@ template <typename OID_T, typename VID_T>
 boost::leaf::result<ObjectID> ArrowFragment<OID_T, VID_T>::AddNewVertexLabels(
     Client& client, std::vector<std::shared_ptr<arrow::Table>>&& vertex_tables,
     ObjectID vm_id) {
+  if (compact_edges_) {
+    RETURN_GS_ERROR(ErrorCode::kUnsupportedOperationError,
+                    "Cannot modify the fragment with compact edges");
+  }
   int extra_vertex_label_num = vertex_tables.size();
   int total_vertex_label_num = vertex_label_num_ + extra_vertex_label_num;
 
@@ -692,6 +700,10 @@ boost::leaf::result<ObjectID> ArrowFragment<OID_T, VID_T>::AddNewEdgeLabels(
     const std::vector<std::set<std::pair<std::string, std::string>>>&
         edge_relations,
     int concurrency) {
+  if (compact_edges_) {
+    RETURN_GS_ERROR(ErrorCode::kUnsupportedOperationError,
+                    "Cannot modify the fragment with compact edges");
+  }
   int extra_edge_label_num = edge_tables.size();
   int total_edge_label_num = edge_label_num_ + extra_edge_label_num;
 
@@ -1100,6 +1112,10 @@ template <typename OID_T, typename VID_T>
 boost::leaf::result<vineyard::ObjectID>
 ArrowFragment<OID_T, VID_T>::TransformDirection(vineyard::Client& client,
                                                 int concurrency) {
+  if (compact_edges_) {
+    RETURN_GS_ERROR(ErrorCode::kUnsupportedOperationError,
+                    "Cannot modify the fragment with compact edges");
+  }
   ArrowFragmentBaseBuilder<OID_T, VID_T> builder(*this);
   builder.set_directed_(!directed_);
 
@@ -1115,8 +1131,8 @@ ArrowFragment<OID_T, VID_T>::TransformDirection(vineyard::Client& client,
 
   if (directed_) {
     bool is_multigraph = is_multigraph_;
-    directedCSR2Undirected(oe_lists, oe_offsets_lists, concurrency,
-                           is_multigraph);
+    BOOST_LEAF_CHECK(directedCSR2Undirected(oe_lists, oe_offsets_lists,
+                                            concurrency, is_multigraph));
 
     for (label_id_t i = 0; i < vertex_label_num_; ++i) {
       for (label_id_t j = 0; j < edge_label_num_; ++j) {
@@ -1157,22 +1173,26 @@ void ArrowFragment<OID_T, VID_T>::initDestFidList(
       fid_list_offset.resize(ivnum_ + 1, NULL);
       for (vid_t i = 0; i < ivnum_; ++i) {
         dstset.clear();
-        if (in_edge) {
-          auto es = GetIncomingAdjList(v, e_label_id);
+        auto collect = [this, &dstset](const auto& es) {
           for (auto& e : es) {
             fid_t f = GetFragId(e.neighbor());
             if (f != fid_) {
               dstset.insert(f);
             }
           }
+        };
+        if (in_edge) {
+          if (compact_edges_) {
+            collect(GetIncomingCompactAdjList(v, e_label_id));
+          } else {
+            collect(GetIncomingAdjList(v, e_label_id));
+          }
         }
         if (out_edge) {
-          auto es = GetOutgoingAdjList(v, e_label_id);
-          for (auto& e : es) {
-            fid_t f = GetFragId(e.neighbor());
-            if (f != fid_) {
-              dstset.insert(f);
-            }
+          if (compact_edges_) {
+            collect(GetOutgoingCompactAdjList(v, e_label_id));
+          } else {
+            collect(GetOutgoingAdjList(v, e_label_id));
           }
         }
         id_num[i] = dstset.size();
@@ -1192,48 +1212,42 @@ void ArrowFragment<OID_T, VID_T>::initDestFidList(
 }
 
 template <typename OID_T, typename VID_T>
-void ArrowFragment<OID_T, VID_T>::directedCSR2Undirected(
+boost::leaf::result<void>
+ArrowFragment<OID_T, VID_T>::directedCSR2Undirected(
     std::vector<std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>>>&
         oe_lists,
     std::vector<std::vector<std::shared_ptr<arrow::Int64Array>>>&
         oe_offsets_lists,
     int concurrency, bool& is_multigraph) {
+  // merges the lists of all labels at once, see also Note [Merging directed
+  // CSR]
+  std::vector<const nbr_unit_t*> ies, oes;
+  std::vector<const int64_t*> ie_offsets, oe_offsets;
+  std::vector<vid_t> tvnums;
   for (label_id_t v_label = 0; v_label < vertex_label_num_; ++v_label) {
     for (label_id_t e_label = 0; e_label < edge_label_num_; ++e_label) {
-      const nbr_unit_t* ie = ie_ptr_lists_.at(v_label).at(e_label);
-      const nbr_unit_t* oe = oe_ptr_lists_.at(v_label).at(e_label);
-      const int64_t* ie_offset = ie_offsets_ptr_lists_.at(v_label).at(e_label);
-      const int64_t* oe_offset = oe_offsets_ptr_lists_.at(v_label).at(e_label);
-
-      // Merge edges from two array into one
-      vineyard::PodArrayBuilder<nbr_unit_t> edge_builder;
-      arrow::Int64Builder offset_builder;
-      CHECK_ARROW_ERROR(offset_builder.Append(0));
-      for (int offset = 0; offset < tvnums_[v_label]; ++offset) {
-        for (int k = ie_offset[offset]; k < ie_offset[offset + 1]; ++k) {
-          CHECK_ARROW_ERROR(
-              edge_builder.Append(reinterpret_cast<const uint8_t*>(ie + k)));
-        }
-        for (int k = oe_offset[offset]; k < oe_offset[offset + 1]; ++k) {
-          CHECK_ARROW_ERROR(
-              edge_builder.Append(reinterpret_cast<const uint8_t*>(oe + k)));
-        }
-        CHECK_ARROW_ERROR(offset_builder.Append(edge_builder.length()));
-      }
-      CHECK_ARROW_ERROR(
-          offset_builder.Finish(&oe_offsets_lists[v_label][e_label]));
-
-      sort_edges_with_respect_to_vertex(edge_builder,
-                                        oe_offsets_lists[v_label][e_label],
-                                        tvnums_[v_label], concurrency);
-      if (!is_multigraph) {
-        check_is_multigraph(edge_builder, oe_offsets_lists[v_label][e_label],
-                            tvnums_[v_label], concurrency, is_multigraph);
-      }
+      ies.push_back(ie_ptr_lists_.at(v_label).at(e_label));
+      oes.push_back(oe_ptr_lists_.at(v_label).at(e_label));
+      ie_offsets.push_back(ie_offsets_ptr_lists_.at(v_label).at(e_label));
+      oe_offsets.push_back(oe_offsets_ptr_lists_.at(v_label).at(e_label));
+      tvnums.push_back(tvnums_[v_label]);
+    }
+  }
+
+  std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>> edges;
+  std::vector<std::shared_ptr<arrow::Int64Array>> edge_offsets;
+  BOOST_LEAF_CHECK((merge_directed_csr<vid_t, eid_t>(
+      ies, ie_offsets, oes, oe_offsets, tvnums, concurrency, edges,
+      edge_offsets, is_multigraph)));
 
-      CHECK_ARROW_ERROR(edge_builder.Finish(&oe_lists[v_label][e_label]));
+  for (label_id_t v_label = 0; v_label < vertex_label_num_; ++v_label) {
+    for (label_id_t e_label = 0; e_label < edge_label_num_; ++e_label) {
+      size_t index = v_label * edge_label_num_ + e_label;
+      oe_lists[v_label][e_label] = edges[index];
+      oe_offsets_lists[v_label][e_label] = edge_offsets[index];
     }
   }
+  return {};
 }
 }  // namespace vineyard
 
@@ -0,0 +1,405 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef MODULES_GRAPH_FRAGMENT_ARROW_FRAGMENT_VIEW_H_
+#define MODULES_GRAPH_FRAGMENT_ARROW_FRAGMENT_VIEW_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arrow/api.h"
+#include "boost/leaf.hpp"
+
+#include "graph/fragment/arrow_fragment.h"
+#include "graph/fragment/graph_schema.h"
+#include "graph/fragment/property_graph_types.h"
+#include "graph/fragment/property_graph_utils.h"
+#include "graph/utils/error.h"
+
+/**
+ * Note [Projected views]
+ *
+ * `ArrowFragment::Project()` seals a new fragment object that shares the
+ * members of the base fragment but carries a schema where the labels and
+ * properties out of the projection are invalidated, i.e., every projection
+ * creates (and leaves behind) metadata in the vineyard server.
+ *
+ * `ArrowFragmentView` is the client-side counterpart: it keeps the base
+ * fragment and the mappings from the labels and properties of the view to
+ * those of the base, and translates them at access time. Opening a view
+ * costs time proportional to the selected labels and properties, and nothing
+ * is created in the vineyard server.
+ *
+ * Unlike `Project()`, the labels and the properties of a view are numbered
+ * densely from zero, in the order of the selection, and the schema of the
+ * view only contains the selected ones. The vertices are the vertices of the
+ * base fragment, i.e., they still carry the label ids of the base fragment
+ * in their vids, which `vertex_label()` maps back. As with `Project()`, the
+ * adjacency lists are shared with the base fragment, thus the neighbors of
+ * an edge label are not filtered by the selected vertex labels.
+ */
+
+namespace vineyard {
+
+template <typename OID_T, typename VID_T>
+class ArrowFragmentView {
+ public:
+  using oid_t = OID_T;
+  using vid_t = VID_T;
+  using eid_t = property_graph_types::EID_TYPE;
+  using label_id_t = property_graph_types::LABEL_ID_TYPE;
+  using prop_id_t = property_graph_types::PROP_ID_TYPE;
+  using fragment_t = ArrowFragment<oid_t, vid_t>;
+  using vertex_t = grape::Vertex<vid_t>;
+  using vertex_range_t = grape::VertexRange<vid_t>;
+  using nbr_unit_t = property_graph_utils::NbrUnit<vid_t, eid_t>;
+  using adj_list_t = property_graph_utils::AdjList<vid_t, eid_t>;
+  using compact_adj_list_t = property_graph_utils::CompactAdjList<vid_t, eid_t>;
+
+  /**
+   * @brief Opens a view of `base` with the given vertex and edge labels, each
+   * with the given properties (in the order of the view), as the arguments
+   * of `ArrowFragment::Project()`, see also Note [Projected views].
+   */
+  static boost::leaf::result<std::shared_ptr<ArrowFragmentView>> Project(
+      const std::shared_ptr<fragment_t>& base,
+      const std::map<label_id_t, std::vector<prop_id_t>>& vertices,
+      const std::map<label_id_t, std::vector<prop_id_t>>& edges) {
+    std::shared_ptr<ArrowFragmentView> view(new ArrowFragmentView(base));
+    BOOST_LEAF_CHECK(view->init(vertices, edges));
+    return view;
+  }
+
+  const std::shared_ptr<fragment_t>& base() const { return base_; }
+
+  fid_t fid() const { return base_->fid(); }
+
+  fid_t fnum() const { return base_->fnum(); }
+
+  bool directed() const { return base_->directed(); }
+
+  bool compact_edges() const { return base_->compact_edges(); }
+
+  const PropertyGraphSchema& schema() const { return schema_; }
+
+  label_id_t vertex_label_num() const {
+    return static_cast<label_id_t>(vertex_labels_.size());
+  }
+
+  label_id_t edge_label_num() const {
+    return static_cast<label_id_t>(edge_labels_.size());
+  }
+
+  prop_id_t vertex_property_num(label_id_t label) const {
+    return static_cast<prop_id_t>(vertex_props_[label].size());
+  }
+
+  prop_id_t edge_property_num(label_id_t label) const {
+    return static_cast<prop_id_t>(edge_props_[label].size());
+  }
+
+  label_id_t base_vertex_label(label_id_t label) const {
+    return vertex_labels_[label];
+  }
+
+  label_id_t base_edge_label(label_id_t label) const {
+    return edge_labels_[label];
+  }
+
+  prop_id_t base_vertex_property(label_id_t label, prop_id_t prop) const {
+    return vertex_props_[label][prop];
+  }
+
+  prop_id_t base_edge_property(label_id_t label, prop_id_t prop) const {
+    return edge_props_[label][prop];
+  }
+
+  std::shared_ptr<arrow::DataType> vertex_property_type(label_id_t label,
+                                                        prop_id_t prop) const {
+    return base_->vertex_property_type(vertex_labels_[label],
+                                       vertex_props_[label][prop]);
+  }
+
+  std::shared_ptr<arrow::DataType> edge_property_type(label_id_t label,
+                                                      prop_id_t prop) const {
+    return base_->edge_property_type(edge_labels_[label],
+                                     edge_props_[label][prop]);
+  }
+
+  /**
+   * @brief The selected columns of the vertex table of the base fragment,
+   * without copying the columns.
+   */
+  std::shared_ptr<arrow::Table> vertex_data_table(label_id_t label) const {
+    return selectColumns(base_->vertex_data_table(vertex_labels_[label]),
+                         vertex_props_[label]);
+  }
+
+  std::shared_ptr<arrow::Table> edge_data_table(label_id_t label) const {
+    return selectColumns(base_->edge_data_table(edge_labels_[label]),
+                         edge_props_[label]);
+  }
+
+  template <typename DATA_T>
+  property_graph_utils::EdgeDataColumn<DATA_T, nbr_unit_t> edge_data_column(
+      label_id_t label, prop_id_t prop) const {
+    return base_->template edge_data_column<DATA_T>(edge_labels_[label],
+                                                    edge_props_[label][prop]);
+  }
+
+  template <typename DATA_T>
+  property_graph_utils::VertexDataColumn<DATA_T, vid_t> vertex_data_column(
+      label_id_t label, prop_id_t prop) const {
+    return base_->template vertex_data_column<DATA_T>(
+        vertex_labels_[label], vertex_props_[label][prop]);
+  }
+
+  label_id_t vertex_label(const vertex_t& v) const {
+    return base_vertex_labels_[base_->vertex_label(v)];
+  }
+
+  vertex_range_t Vertices(label_id_t label) const {
+    return base_->Vertices(vertex_labels_[label]);
+  }
+
+  vertex_range_t InnerVertices(label_id_t label) const {
+    return base_->InnerVertices(vertex_labels_[label]);
+  }
+
+  vertex_range_t OuterVertices(label_id_t label) const {
+    return base_->OuterVertices(vertex_labels_[label]);
+  }
+
+  vid_t GetVerticesNum(label_id_t label) const {
+    return base_->GetVerticesNum(vertex_labels_[label]);
+  }
+
+  vid_t GetInnerVerticesNum(label_id_t label) const {
+    return base_->GetInnerVerticesNum(vertex_labels_[label]);
+  }
+
+  vid_t GetOuterVerticesNum(label_id_t label) const {
+    return base_->GetOuterVerticesNum(vertex_labels_[label]);
+  }
+
+  bool IsInnerVertex(const vertex_t& v) const {
+    return base_->IsInnerVertex(v);
+  }
+
+  bool IsOuterVertex(const vertex_t& v) const {
+    return base_->IsOuterVertex(v);
+  }
+
+  bool GetVertex(label_id_t label, const oid_t& oid, vertex_t& v) const {
+    return base_->GetVertex(vertex_labels_[label], oid, v);
+  }
+
+  oid_t GetId(const vertex_t& v) const { return base_->GetId(v); }
+
+  fid_t GetFragId(const vertex_t& v) const { return base_->GetFragId(v); }
+
+  bool Gid2Vertex(const vid_t& gid, vertex_t& v) const {
+    return base_->Gid2Vertex(gid, v);
+  }
+
+  vid_t Vertex2Gid(const vertex_t& v) const { return base_->Vertex2Gid(v); }
+
+  template <typename T>
+  T GetData(const vertex_t& v, prop_id_t prop) const {
+    return base_->template GetData<T>(
+        v, base_vertex_props_[base_->vertex_label(v)][prop]);
+  }
+
+  int GetLocalOutDegree(const vertex_t& v, label_id_t e_label) const {
+    return base_->GetLocalOutDegree(v, edge_labels_[e_label]);
+  }
+
+  int GetLocalInDegree(const vertex_t& v, label_id_t e_label) const {
+    return base_->GetLocalInDegree(v, edge_labels_[e_label]);
+  }
+
+  /**
+   * @brief The outgoing adjacency list, where `get_data()` of the neighbors
+   * takes the edge properties of the view.
+   */
+  adj_list_t GetOutgoingAdjList(const vertex_t& v, label_id_t e_label) const {
+    auto list = base_->GetOutgoingRawAdjList(v, edge_labels_[e_label]);
+    return adj_list_t(list.begin(), list.end(), edgeColumns(e_label));
+  }
+
+  adj_list_t GetIncomingAdjList(const vertex_t& v, label_id_t e_label) const {
+    auto list = base_->GetIncomingRawAdjList(v, edge_labels_[e_label]);
+    return adj_list_t(list.begin(), list.end(), edgeColumns(e_label));
+  }
+
+  compact_adj_list_t GetOutgoingCompactAdjList(const vertex_t& v,
+                                               label_id_t e_label) const {
+    return compactAdjList(v, e_label, base_->oe_offsets_ptr_lists_,
+                          base_->compact_oe_ptr_lists_,
+                          base_->compact_oe_offsets_ptr_lists_,
+                          base_->compact_oe_eids_ptr_lists_);
+  }
+
+  compact_adj_list_t GetIncomingCompactAdjList(const vertex_t& v,
+                                               label_id_t e_label) const {
+    return compactAdjList(v, e_label, base_->ie_offsets_ptr_lists_,
+                          base_->compact_ie_ptr_lists_,
+                          base_->compact_ie_offsets_ptr_lists_,
+                          base_->compact_ie_eids_ptr_lists_);
+  }
+
+ private:
+  explicit ArrowFragmentView(const std::shared_ptr<fragment_t>& base)
+      : base_(base) {}
+
+  boost::leaf::result<void> init(
+      const std::map<label_id_t, std::vector<prop_id_t>>& vertices,
+      const std::map<label_id_t, std::vector<prop_id_t>>& edges) {
+    const PropertyGraphSchema& base_schema = base_->schema();
+    label_id_t base_vertex_label_num = base_->vertex_label_num_;
+    label_id_t base_edge_label_num = base_->edge_label_num_;
+    base_vertex_labels_.resize(base_vertex_label_num, -1);
+    base_vertex_props_.resize(base_vertex_label_num);
+    schema_.set_fnum(base_schema.fnum());
+
+    // the entries of the view, with the properties in the order of the view
+    auto add_entry = [this, &base_schema](
+                         label_id_t base_label,
+                         const std::vector<prop_id_t>& props,
+                         const std::string& type) -> boost::leaf::result<void> {
+      const Entry& base_entry = base_schema.GetEntry(base_label, type);
+      Entry* entry = schema_.CreateEntry(base_entry.label, type);
+      for (prop_id_t prop : props) {
+        if (prop < 0 ||
+            prop >= static_cast<prop_id_t>(base_entry.props_.size()) ||
+            !base_entry.valid_properties[prop]) {
+          RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                          "Invalid property " + std::to_string(prop) +
+                              " of " + type + " label " + base_entry.label);
+        }
+        entry->AddProperty(base_entry.props_[prop].name,
+                           base_entry.props_[prop].type);
+      }
+      for (const auto& key : base_entry.primary_keys) {
+        if (entry->GetPropertyId(key) != -1) {
+          entry->AddPrimaryKey(key);
+        }
+      }
+      return {};
+    };
+
+    for (const auto& pair : vertices) {
+      if (pair.first < 0 || pair.first >= base_vertex_label_num) {
+        RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                        "Invalid vertex label " + std::to_string(pair.first));
+      }
+      BOOST_LEAF_CHECK(add_entry(pair.first, pair.second, "VERTEX"));
+      base_vertex_labels_[pair.first] = vertex_label_num();
+      base_vertex_props_[pair.first] = pair.second;
+      vertex_labels_.push_back(pair.first);
+      vertex_props_.push_back(pair.second);
+    }
+
+    for (const auto& pair : edges) {
+      if (pair.first < 0 || pair.first >= base_edge_label_num) {
+        RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                        "Invalid edge label " + std::to_string(pair.first));
+      }
+      BOOST_LEAF_CHECK(add_entry(pair.first, pair.second, "EDGE"));
+      // keeps the relations between the selected vertex labels
+      Entry& entry = schema_.GetMutableEntry(edge_label_num(), "EDGE");
+      for (const auto& relation :
+           base_schema.GetEntry(pair.first, "EDGE").relations) {
+        if (schema_.GetVertexLabelId(relation.first) != -1 &&
+            schema_.GetVertexLabelId(relation.second) != -1) {
+          entry.AddRelation(relation.first, relation.second);
+        }
+      }
+      std::vector<const void*> columns;
+      for (prop_id_t prop : pair.second) {
+        columns.push_back(base_->edge_tables_columns_[pair.first][prop]);
+      }
+      edge_labels_.push_back(pair.first);
+      edge_props_.push_back(pair.second);
+      edge_columns_.push_back(std::move(columns));
+    }
+
+    std::string error_message;
+    if (!schema_.Validate(error_message)) {
+      RETURN_GS_ERROR(ErrorCode::kInvalidValueError, error_message);
+    }
+    return {};
+  }
+
+  const void** edgeColumns(label_id_t e_label) const {
+    auto& columns = edge_columns_[e_label];
+    return columns.empty() ? nullptr
+                           : const_cast<const void**>(columns.data());
+  }
+
+  compact_adj_list_t compactAdjList(
+      const vertex_t& v, label_id_t e_label,
+      const std::vector<std::vector<const int64_t*>>& offsets_ptr_lists,
+      const std::vector<std::vector<const uint8_t*>>& compact_ptr_lists,
+      const std::vector<std::vector<const int64_t*>>&
+          compact_offsets_ptr_lists,
+      const std::vector<std::vector<const uint8_t*>>& compact_eids_ptr_lists)
+      const {
+    label_id_t v_label = base_->vertex_label(v);
+    label_id_t base_e_label = edge_labels_[e_label];
+    int64_t v_offset = base_->vertex_offset(v);
+    const int64_t* offset_array = offsets_ptr_lists[v_label][base_e_label];
+    return compact_adj_list_t(
+        compact_ptr_lists[v_label][base_e_label] +
+            compact_offsets_ptr_lists[v_label][base_e_label][v_offset],
+        compact_eids_ptr_lists[v_label][base_e_label], offset_array[v_offset],
+        offset_array[v_offset + 1], edgeColumns(e_label));
+  }
+
+  static std::shared_ptr<arrow::Table> selectColumns(
+      const std::shared_ptr<arrow::Table>& table,
+      const std::vector<prop_id_t>& props) {
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+    for (prop_id_t prop : props) {
+      fields.push_back(table->schema()->field(prop));
+      columns.push_back(table->column(prop));
+    }
+    return arrow::Table::Make(arrow::schema(fields), columns,
+                              table->num_rows());
+  }
+
+  std::shared_ptr<fragment_t> base_;
+  PropertyGraphSchema schema_;
+
+  // view label -> base label, and the base properties of the view labels
+  std::vector<label_id_t> vertex_labels_, edge_labels_;
+  std::vector<std::vector<prop_id_t>> vertex_props_, edge_props_;
+
+  // base vertex label -> view label (or -1), and its base properties, as the
+  // vertices carry the base labels
+  std::vector<label_id_t> base_vertex_labels_;
+  std::vector<std::vector<prop_id_t>> base_vertex_props_;
+
+  // the edge data arrays of the view labels, in the order of the view
+  std::vector<std::vector<const void*>> edge_columns_;
+};
+
+}  // namespace vineyard
+
+#endif  // MODULES_GRAPH_FRAGMENT_ARROW_FRAGMENT_VIEW_H_
@@ -0,0 +1,490 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef MODULES_GRAPH_FRAGMENT_COMPACT_ADJ_LIST_H_
+#define MODULES_GRAPH_FRAGMENT_COMPACT_ADJ_LIST_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "arrow/api.h"
+#include "boost/leaf.hpp"
+
+#include "graph/fragment/property_graph_types.h"
+#include "graph/fragment/property_graph_utils.h"
+#include "graph/utils/error.h"
+
+namespace vineyard {
+
+/**
+ * Note [Compact adjacency lists]
+ *
+ * The default CSR of `ArrowFragment` stores an `NbrUnit` (the neighbor's vid
+ * and the eid, 16 bytes with 64-bit ids) per edge. The compact layout, which
+ * is selected when building the fragment, stores the neighbors and the eids
+ * of each (vertex label, edge label) pair as two byte streams instead:
+ *
+ * - The neighbors of every vertex (already sorted by the CSR generation) are
+ *   cut into blocks of at most `kCompactBlockSize` values. A block is
+ *
+ *     | count - 1 (1 byte) | width (1 byte) | base (varint) | deltas |
+ *
+ *   where the `count - 1` deltas between consecutive neighbors are packed
+ *   with the same bit width, thus unpacking a block is a branch-free loop
+ *   over unaligned 8-byte loads followed by a prefix sum. A new block is
+ *   started when a delta is wider than `kCompactSplitBits`, which happens at
+ *   the boundaries of vertex labels, to avoid widening the whole block.
+ *
+ * - The eids are packed with a fixed bit width (the first byte of the stream)
+ *   in the CSR order, so the eid of the k-th edge is looked up by position,
+ *   and only when it is asked for.
+ *
+ * The byte offsets of the neighbors of each vertex are kept in an extra
+ * int64 array, and the edge offsets arrays are kept as-is, giving the degrees
+ * and the positions of the eids. Both streams are padded by
+ * `kCompactPadding` bytes to make the 8-byte loads safe.
+ */
+constexpr size_t kCompactBlockSize = 128;
+constexpr int kCompactSplitBits = 32;
+constexpr size_t kCompactPadding = 8;
+
+namespace compact_detail {
+
+inline int bit_width(uint64_t value) {
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+// unpacking reads 8 bytes at a time, widths above 56 use the whole word
+inline int packed_width(uint64_t value) {
+  int width = bit_width(value);
+  return width > 56 ? 64 : width;
+}
+
+inline size_t packed_bytes(size_t count, int width) {
+  return (count * width + 7) / 8;
+}
+
+inline void append_varint(std::vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+inline const uint8_t* read_varint(const uint8_t* in, uint64_t& value) {
+  value = 0;
+  int shift = 0;
+  while (*in & 0x80) {
+    value |= static_cast<uint64_t>(*in++ & 0x7f) << shift;
+    shift += 7;
+  }
+  value |= static_cast<uint64_t>(*in++) << shift;
+  return in;
+}
+
+/**
+ * @brief Append `count` values with the given width, the values must fit in
+ * `width` bits.
+ */
+inline void pack(const uint64_t* values, size_t count, int width,
+                 std::vector<uint8_t>& out) {
+  size_t start = out.size();
+  size_t bytes = packed_bytes(count, width);
+  out.resize(start + bytes + kCompactPadding, 0);
+  uint8_t* data = out.data() + start;
+  if (width == 64) {
+    memcpy(data, values, count * sizeof(uint64_t));
+  } else if (width > 0) {
+    for (size_t i = 0; i < count; ++i) {
+      size_t bit = i * width;
+      uint64_t word;
+      memcpy(&word, data + (bit >> 3), sizeof(uint64_t));
+      word |= values[i] << (bit & 7);
+      memcpy(data + (bit >> 3), &word, sizeof(uint64_t));
+    }
+  }
+  out.resize(start + bytes);
+}
+
+inline uint64_t unpack_one(const uint8_t* in, size_t index, int width) {
+  if (width == 0) {
+    return 0;
+  }
+  size_t bit = index * width;
+  uint64_t word;
+  memcpy(&word, in + (bit >> 3), sizeof(uint64_t));
+  if (width == 64) {
+    return word;
+  }
+  return (word >> (bit & 7)) & ((static_cast<uint64_t>(1) << width) - 1);
+}
+
+template <typename T>
+inline void unpack(const uint8_t* in, size_t count, int width, T* out) {
+  if (width == 0) {
+    std::fill(out, out + count, 0);
+  } else if (width == 64) {
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t word;
+      memcpy(&word, in + i * sizeof(uint64_t), sizeof(uint64_t));
+      out[i] = static_cast<T>(word);
+    }
+  } else {
+    const uint64_t mask = (static_cast<uint64_t>(1) << width) - 1;
+    for (size_t i = 0; i < count; ++i) {
+      size_t bit = i * width;
+      uint64_t word;
+      memcpy(&word, in + (bit >> 3), sizeof(uint64_t));
+      out[i] = static_cast<T>((word >> (bit & 7)) & mask);
+    }
+  }
+}
+
+/**
+ * @brief Decode the block at `in` into `out` (which must be able to hold
+ * `kCompactBlockSize` values), returns the start of the next block.
+ */
+template <typename VID_T>
+inline const uint8_t* decode_block(const uint8_t* in, VID_T* out,
+                                   size_t& count) {
+  count = static_cast<size_t>(in[0]) + 1;
+  int width = in[1];
+  uint64_t base;
+  in = read_varint(in + 2, base);
+  out[0] = static_cast<VID_T>(base);
+  unpack(in, count - 1, width, out + 1);
+  for (size_t i = 1; i < count; ++i) {
+    out[i] += out[i - 1];
+  }
+  return in + packed_bytes(count - 1, width);
+}
+
+template <typename VID_T, typename EID_T>
+inline void encode_list(
+    const property_graph_utils::NbrUnit<VID_T, EID_T>* nbrs, size_t size,
+    std::vector<uint8_t>& out) {
+  uint64_t deltas[kCompactBlockSize];
+  size_t index = 0;
+  while (index < size) {
+    uint64_t base = nbrs[index].vid, prev = base, bits = 0;
+    size_t count = 1;
+    while (index + count < size && count < kCompactBlockSize) {
+      uint64_t value = nbrs[index + count].vid;
+      if (value < prev || bit_width(value - prev) > kCompactSplitBits) {
+        break;
+      }
+      deltas[count - 1] = value - prev;
+      bits |= value - prev;
+      prev = value;
+      ++count;
+    }
+    int width = packed_width(bits);
+    out.push_back(static_cast<uint8_t>(count - 1));
+    out.push_back(static_cast<uint8_t>(width));
+    append_varint(out, base);
+    pack(deltas, count - 1, width, out);
+    index += count;
+  }
+}
+
+}  // namespace compact_detail
+
+namespace property_graph_utils {
+
+template <typename VID_T, typename EID_T>
+class CompactAdjList;
+
+/**
+ * @brief CompactNbr is the iterator of the compact adjacency list, the
+ * neighbors are decoded block by block into the buffer of the list.
+ */
+template <typename VID_T, typename EID_T>
+struct CompactNbr {
+ private:
+  using prop_id_t = property_graph_types::PROP_ID_TYPE;
+
+ public:
+  CompactNbr() : list_(nullptr), index_(0) {}
+  CompactNbr(const CompactAdjList<VID_T, EID_T>* list, size_t index)
+      : list_(list), index_(index) {}
+
+  grape::Vertex<VID_T> neighbor() const {
+    return grape::Vertex<VID_T>(list_->vid_at(index_));
+  }
+
+  grape::Vertex<VID_T> get_neighbor() const { return neighbor(); }
+
+  EID_T edge_id() const { return list_->eid_at(index_); }
+
+  template <typename T>
+  T get_data(prop_id_t prop_id) const {
+    return ValueGetter<T>::Value(list_->edata_arrays_[prop_id], edge_id());
+  }
+
+  std::string get_str(prop_id_t prop_id) const {
+    return ValueGetter<std::string>::Value(list_->edata_arrays_[prop_id],
+                                           edge_id());
+  }
+
+  double get_double(prop_id_t prop_id) const {
+    return ValueGetter<double>::Value(list_->edata_arrays_[prop_id],
+                                      edge_id());
+  }
+
+  int64_t get_int(prop_id_t prop_id) const {
+    return ValueGetter<int64_t>::Value(list_->edata_arrays_[prop_id],
+                                       edge_id());
+  }
+
+  inline const CompactNbr& operator++() const {
+    ++index_;
+    list_->advance(index_);
+    return *this;
+  }
+
+  inline CompactNbr operator++(int) const {
+    CompactNbr ret(*this);
+    ++(*this);
+    return ret;
+  }
+
+  inline bool operator==(const CompactNbr& rhs) const {
+    return index_ == rhs.index_;
+  }
+  inline bool operator!=(const CompactNbr& rhs) const {
+    return index_ != rhs.index_;
+  }
+
+  inline bool operator<(const CompactNbr& rhs) const {
+    return index_ < rhs.index_;
+  }
+
+  inline const CompactNbr& operator*() const { return *this; }
+
+ private:
+  const CompactAdjList<VID_T, EID_T>* list_;
+  mutable size_t index_;
+};
+
+/**
+ * @brief CompactAdjList is the adjacency list of a vertex in the compact
+ * layout, see also Note [Compact adjacency lists].
+ *
+ * It can only be iterated forward, and the iterators of the same list share
+ * the decoding buffer, i.e., the list cannot be traversed by two iterators
+ * at the same time.
+ */
+template <typename VID_T, typename EID_T>
+class CompactAdjList {
+ public:
+  CompactAdjList()
+      : nbrs_(nullptr),
+        eids_(nullptr),
+        eid_begin_(0),
+        size_(0),
+        edata_arrays_(nullptr) {}
+
+  CompactAdjList(const uint8_t* nbrs, const uint8_t* eids, int64_t eid_begin,
+                 int64_t eid_end, const void** edata_arrays)
+      : nbrs_(nbrs),
+        eids_(eids),
+        eid_begin_(eid_begin),
+        size_(static_cast<size_t>(eid_end - eid_begin)),
+        edata_arrays_(edata_arrays) {}
+
+  CompactAdjList(const CompactAdjList& rhs)
+      : nbrs_(rhs.nbrs_),
+        eids_(rhs.eids_),
+        eid_begin_(rhs.eid_begin_),
+        size_(rhs.size_),
+        edata_arrays_(rhs.edata_arrays_) {}
+
+  CompactAdjList& operator=(const CompactAdjList& rhs) {
+    nbrs_ = rhs.nbrs_;
+    eids_ = rhs.eids_;
+    eid_begin_ = rhs.eid_begin_;
+    size_ = rhs.size_;
+    edata_arrays_ = rhs.edata_arrays_;
+    return *this;
+  }
+
+  inline CompactNbr<VID_T, EID_T> begin() const {
+    block_begin_ = block_end_ = 0;
+    next_block_ = nbrs_;
+    advance(0);
+    return CompactNbr<VID_T, EID_T>(this, 0);
+  }
+
+  inline CompactNbr<VID_T, EID_T> end() const {
+    return CompactNbr<VID_T, EID_T>(this, size_);
+  }
+
+  inline size_t Size() const { return size_; }
+
+  inline bool Empty() const { return size_ == 0; }
+
+  inline bool NotEmpty() const { return size_ != 0; }
+
+  size_t size() const { return size_; }
+
+  /**
+   * @brief Decode all neighbors into `vids`, which is faster than iterating
+   * when the eids are not needed.
+   */
+  void Decode(std::vector<VID_T>& vids) const {
+    vids.resize(size_);
+    const uint8_t* block = nbrs_;
+    size_t count = 0;
+    for (size_t index = 0; index < size_; index += count) {
+      block = compact_detail::decode_block(block, &vids[index], count);
+    }
+  }
+
+ private:
+  inline void advance(size_t index) const {
+    if (index == block_end_ && index < size_) {
+      size_t count = 0;
+      next_block_ = compact_detail::decode_block(next_block_, buffer_, count);
+      block_begin_ = index;
+      block_end_ = index + count;
+    }
+  }
+
+  inline VID_T vid_at(size_t index) const {
+    return buffer_[index - block_begin_];
+  }
+
+  inline EID_T eid_at(size_t index) const {
+    return static_cast<EID_T>(
+        compact_detail::unpack_one(eids_ + 1, eid_begin_ + index, eids_[0]));
+  }
+
+  const uint8_t* nbrs_;
+  const uint8_t* eids_;
+  int64_t eid_begin_;
+  size_t size_;
+  const void** edata_arrays_;
+
+  mutable const uint8_t* next_block_ = nullptr;
+  mutable size_t block_begin_ = 0, block_end_ = 0;
+  mutable VID_T buffer_[kCompactBlockSize];
+
+  friend struct CompactNbr<VID_T, EID_T>;
+};
+
+template <typename VID_T>
+using CompactAdjListDefault =
+    CompactAdjList<VID_T, property_graph_types::EID_TYPE>;
+
+}  // namespace property_graph_utils
+
+/**
+ * @brief Encode the CSR `edges`/`edge_offsets` into the compact layout, see
+ * also Note [Compact adjacency lists].
+ */
+template <typename VID_T, typename EID_T>
+boost::leaf::result<void> generate_compact_csr(
+    const std::shared_ptr<arrow::FixedSizeBinaryArray>& edges,
+    const std::shared_ptr<arrow::Int64Array>& edge_offsets, int concurrency,
+    std::shared_ptr<arrow::UInt8Array>& compact_edges,
+    std::shared_ptr<arrow::Int64Array>& compact_offsets,
+    std::shared_ptr<arrow::UInt8Array>& compact_eids) {
+  using nbr_unit_t = property_graph_utils::NbrUnit<VID_T, EID_T>;
+
+  const nbr_unit_t* nbrs =
+      reinterpret_cast<const nbr_unit_t*>(edges->raw_values());
+  const int64_t* offsets = edge_offsets->raw_values();
+  int64_t vnum = edge_offsets->length() - 1;
+  int64_t enum_ = offsets[vnum];
+  concurrency = std::max(concurrency, 1);
+
+  // neighbors, encoded in chunks of vertices
+  const int64_t vchunk = 4096;
+  int64_t vchunk_num = (vnum + vchunk - 1) / vchunk;
+  std::vector<std::vector<uint8_t>> chunks(vchunk_num);
+  std::vector<int64_t> byte_offsets(vnum + 1, 0);
+  parallel_for(
+      static_cast<int64_t>(0), vchunk_num,
+      [&](int64_t chunk) {
+        auto& out = chunks[chunk];
+        int64_t end = std::min(vnum, (chunk + 1) * vchunk);
+        for (int64_t v = chunk * vchunk; v < end; ++v) {
+          compact_detail::encode_list(nbrs + offsets[v],
+                                      offsets[v + 1] - offsets[v], out);
+          byte_offsets[v + 1] = out.size();
+        }
+      },
+      concurrency, 1);
+
+  arrow::UInt8Builder edges_builder;
+  arrow::Int64Builder offsets_builder;
+  ARROW_OK_OR_RAISE(offsets_builder.Reserve(vnum + 1));
+  offsets_builder.UnsafeAppend(0);
+  int64_t total = 0;
+  for (int64_t chunk = 0; chunk < vchunk_num; ++chunk) {
+    int64_t end = std::min(vnum, (chunk + 1) * vchunk);
+    for (int64_t v = chunk * vchunk; v < end; ++v) {
+      offsets_builder.UnsafeAppend(total + byte_offsets[v + 1]);
+    }
+    total += chunks[chunk].size();
+  }
+  ARROW_OK_OR_RAISE(edges_builder.Reserve(total + kCompactPadding));
+  for (auto& chunk : chunks) {
+    ARROW_OK_OR_RAISE(edges_builder.AppendValues(chunk));
+    std::vector<uint8_t>().swap(chunk);
+  }
+  ARROW_OK_OR_RAISE(
+      edges_builder.AppendValues(std::vector<uint8_t>(kCompactPadding, 0)));
+  ARROW_OK_OR_RAISE(edges_builder.Finish(&compact_edges));
+  ARROW_OK_OR_RAISE(offsets_builder.Finish(&compact_offsets));
+
+  // eids, the chunks are multiples of 8 edges to make them byte-aligned
+  uint64_t max_eid = 0;
+  for (int64_t e = 0; e < enum_; ++e) {
+    max_eid = std::max(max_eid, static_cast<uint64_t>(nbrs[e].eid));
+  }
+  int width = compact_detail::packed_width(max_eid);
+  const int64_t echunk = 8 * 65536;
+  int64_t echunk_num = (enum_ + echunk - 1) / echunk;
+  std::vector<uint8_t> eids(
+      1 + compact_detail::packed_bytes(enum_, width) + kCompactPadding, 0);
+  eids[0] = static_cast<uint8_t>(width);
+  parallel_for(
+      static_cast<int64_t>(0), echunk_num,
+      [&](int64_t chunk) {
+        int64_t begin = chunk * echunk;
+        int64_t end = std::min(enum_, begin + echunk);
+        std::vector<uint64_t> values(end - begin);
+        for (int64_t e = begin; e < end; ++e) {
+          values[e - begin] = static_cast<uint64_t>(nbrs[e].eid);
+        }
+        std::vector<uint8_t> out;
+        compact_detail::pack(values.data(), values.size(), width, out);
+        memcpy(&eids[1 + begin / 8 * width], out.data(), out.size());
+      },
+      concurrency, 1);
+  arrow::UInt8Builder eids_builder;
+  ARROW_OK_OR_RAISE(eids_builder.AppendValues(eids));
+  ARROW_OK_OR_RAISE(eids_builder.Finish(&compact_eids));
+  return {};
+}
+
+}  // namespace vineyard
+
+#endif  // MODULES_GRAPH_FRAGMENT_COMPACT_ADJ_LIST_H_
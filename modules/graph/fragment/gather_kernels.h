@@ -0,0 +1,388 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef MODULES_GRAPH_FRAGMENT_GATHER_KERNELS_H_
+#define MODULES_GRAPH_FRAGMENT_GATHER_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define VINEYARD_GATHER_X86_64
+#endif
+
+#include "graph/fragment/compact_adj_list.h"
+#include "graph/fragment/property_graph_types.h"
+
+namespace vineyard {
+
+/**
+ * Note [Neighbor gathers]
+ *
+ * Reading the neighbors, the eids and the edge (or neighbor) properties by
+ * iterating the `AdjList`s costs an indirection through `Nbr` and the edge
+ * data arrays per edge. The gathers produce them as dense arrays for a range
+ * of vertices instead:
+ *
+ * - the neighbors and the eids of the range are split from the `NbrUnit`s,
+ *   which is a sequential pass over the CSR as the edges of consecutive
+ *   vertices are adjacent (for the compact layout the blocks are decoded,
+ *   see also Note [Compact adjacency lists]), and
+ * - the properties are gathered by the eids (or by the offsets of the
+ *   neighbors) into a dense array, prefetching `kGatherPrefetchDistance`
+ *   positions ahead, using the AVX-512 or AVX2 gather instructions if the
+ *   CPU supports them. The instruction set is detected at runtime, thus no
+ *   `-march` flag is required when building. `gather_by_nbrs()` and
+ *   `gather_by_eids()` read the ids from the `NbrUnit`s directly, to skip
+ *   the split when only the properties are needed.
+ *
+ * The vectorized paths cover the 4-byte and 8-byte properties indexed by
+ * 64-bit ids, the other cases fall back to the (prefetching) scalar loop.
+ *
+ * The gathers pay off when the dense arrays are needed anyway, e.g., to feed
+ * the neighbors to a model or to a vectorized computation. When the values
+ * are consumed by a simple loop right away, the out-of-order cores already
+ * overlap the misses of the iterators and the gathers can be slower, see
+ * also benchmark/neighbor_gather_bench.
+ */
+namespace gather_detail {
+
+static constexpr size_t kGatherPrefetchDistance = 32;
+
+enum class GatherISA { kScalar, kAVX2, kAVX512 };
+
+inline GatherISA gather_isa() {
+  static const GatherISA isa = []() {
+#ifdef VINEYARD_GATHER_X86_64
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+      return GatherISA::kAVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      return GatherISA::kAVX2;
+    }
+#endif
+    return GatherISA::kScalar;
+  }();
+  return isa;
+}
+
+// the ids to gather by are read as `indices[i * STRIDE]`, i.e., a dense array
+// of ids for `STRIDE = 1`, or a field of the 16-byte `NbrUnit`s for `STRIDE
+// = 2`, to gather by the neighbors or the eids without splitting the units
+template <size_t STRIDE, typename T, typename INDEX_T>
+inline void gather_scalar(const T* values, const INDEX_T* indices,
+                          size_t begin, size_t size, INDEX_T mask, T* out) {
+  size_t i = begin;
+  for (; i + kGatherPrefetchDistance < size; ++i) {
+    __builtin_prefetch(
+        values + (indices[(i + kGatherPrefetchDistance) * STRIDE] & mask));
+    out[i] = values[indices[i * STRIDE] & mask];
+  }
+  for (; i < size; ++i) {
+    out[i] = values[indices[i * STRIDE] & mask];
+  }
+}
+
+template <size_t STRIDE, typename T>
+inline void prefetch_window(const T* values, const uint64_t* indices,
+                            size_t index, size_t width, size_t size,
+                            uint64_t mask) {
+  if (index + kGatherPrefetchDistance + width <= size) {
+    for (size_t k = index + kGatherPrefetchDistance;
+         k < index + kGatherPrefetchDistance + width; ++k) {
+      __builtin_prefetch(values + (indices[k * STRIDE] & mask));
+    }
+  }
+}
+
+#ifdef VINEYARD_GATHER_X86_64
+
+// the vectorized kernels move the values as integers of the same width, and
+// return the number of values gathered, the tail is left to the scalar loop.
+// With `STRIDE = 2` the loads of the ids cover one more id than the block,
+// which stays in bounds as the block is followed by another unit.
+
+template <size_t STRIDE>
+__attribute__((target("avx2"))) inline __m256i load_index_avx2(
+    const uint64_t* indices, size_t index) {
+  if (STRIDE == 1) {
+    return _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(indices + index));
+  }
+  // [i0, x0, i1, x1] and [i2, x2, i3, x3] to [i0, i1, i2, i3]
+  __m256i lo = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(indices + index * 2));
+  __m256i hi = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i*>(indices + index * 2 + 4));
+  return _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(lo, hi), 0xd8);
+}
+
+template <size_t STRIDE>
+__attribute__((target("avx512f"))) inline __m512i load_index_avx512(
+    const uint64_t* indices, size_t index) {
+  if (STRIDE == 1) {
+    return _mm512_loadu_si512(indices + index);
+  }
+  __m512i lo = _mm512_loadu_si512(indices + index * 2);
+  __m512i hi = _mm512_loadu_si512(indices + index * 2 + 8);
+  return _mm512_permutex2var_epi64(
+      lo, _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0), hi);
+}
+
+template <size_t STRIDE>
+__attribute__((target("avx2"))) inline size_t gather64_avx2(
+    const uint64_t* values, const uint64_t* indices, size_t size,
+    uint64_t mask, uint64_t* out) {
+  const long long* base = reinterpret_cast<const long long*>(values);
+  const __m256i vmask = _mm256_set1_epi64x(static_cast<long long>(mask));
+  size_t i = 0;
+  for (; i + 4 + (STRIDE - 1) <= size; i += 4) {
+    prefetch_window<STRIDE>(values, indices, i, 4, size, mask);
+    __m256i index =
+        _mm256_and_si256(load_index_avx2<STRIDE>(indices, i), vmask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_i64gather_epi64(base, index, 8));
+  }
+  return i;
+}
+
+template <size_t STRIDE>
+__attribute__((target("avx2"))) inline size_t gather32_avx2(
+    const uint32_t* values, const uint64_t* indices, size_t size,
+    uint64_t mask, uint32_t* out) {
+  const int* base = reinterpret_cast<const int*>(values);
+  const __m256i vmask = _mm256_set1_epi64x(static_cast<long long>(mask));
+  size_t i = 0;
+  for (; i + 4 + (STRIDE - 1) <= size; i += 4) {
+    prefetch_window<STRIDE>(values, indices, i, 4, size, mask);
+    __m256i index =
+        _mm256_and_si256(load_index_avx2<STRIDE>(indices, i), vmask);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm256_i64gather_epi32(base, index, 4));
+  }
+  return i;
+}
+
+template <size_t STRIDE>
+__attribute__((target("avx512f"))) inline size_t gather64_avx512(
+    const uint64_t* values, const uint64_t* indices, size_t size,
+    uint64_t mask, uint64_t* out) {
+  const __m512i vmask = _mm512_set1_epi64(static_cast<long long>(mask));
+  size_t i = 0;
+  for (; i + 8 + (STRIDE - 1) <= size; i += 8) {
+    prefetch_window<STRIDE>(values, indices, i, 8, size, mask);
+    __m512i index =
+        _mm512_and_si512(load_index_avx512<STRIDE>(indices, i), vmask);
+    _mm512_storeu_si512(out + i, _mm512_i64gather_epi64(index, values, 8));
+  }
+  return i;
+}
+
+template <size_t STRIDE>
+__attribute__((target("avx512f"))) inline size_t gather32_avx512(
+    const uint32_t* values, const uint64_t* indices, size_t size,
+    uint64_t mask, uint32_t* out) {
+  const __m512i vmask = _mm512_set1_epi64(static_cast<long long>(mask));
+  size_t i = 0;
+  for (; i + 8 + (STRIDE - 1) <= size; i += 8) {
+    prefetch_window<STRIDE>(values, indices, i, 8, size, mask);
+    __m512i index =
+        _mm512_and_si512(load_index_avx512<STRIDE>(indices, i), vmask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_i64gather_epi32(index, values, 4));
+  }
+  return i;
+}
+
+// splits `NbrUnit`s of 64-bit vids and eids, two units per 256-bit lane
+__attribute__((target("avx2"))) inline size_t split_units_avx2(
+    const uint64_t* units, size_t size, uint64_t* vids, uint64_t* eids) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    __m256i lo =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(units + 2 * i));
+    __m256i hi = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(units + 2 * i + 4));
+    // [v0, v2, v1, v3] and [e0, e2, e1, e3]
+    __m256i v = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(lo, hi), 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(vids + i), v);
+    if (eids != nullptr) {
+      __m256i e =
+          _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(lo, hi), 0xd8);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(eids + i), e);
+    }
+  }
+  return i;
+}
+
+#endif  // VINEYARD_GATHER_X86_64
+
+template <typename T>
+using gather_word_t =
+    typename std::conditional<sizeof(T) == 8, uint64_t, uint32_t>::type;
+
+template <size_t STRIDE, typename T, typename INDEX_T>
+inline size_t gather_simd(const T* values, const INDEX_T* indices,
+                          size_t size, INDEX_T mask, T* out) {
+#ifdef VINEYARD_GATHER_X86_64
+  if (!std::is_arithmetic<T>::value || sizeof(INDEX_T) != 8 ||
+      (sizeof(T) != 8 && sizeof(T) != 4)) {
+    return 0;
+  }
+  using word_t = gather_word_t<T>;
+  const word_t* words = reinterpret_cast<const word_t*>(values);
+  const uint64_t* index = reinterpret_cast<const uint64_t*>(indices);
+  word_t* target = reinterpret_cast<word_t*>(out);
+  switch (gather_isa()) {
+  case GatherISA::kAVX512:
+    return sizeof(T) == 8
+               ? gather64_avx512<STRIDE>(
+                     reinterpret_cast<const uint64_t*>(words), index, size,
+                     mask, reinterpret_cast<uint64_t*>(target))
+               : gather32_avx512<STRIDE>(
+                     reinterpret_cast<const uint32_t*>(words), index, size,
+                     mask, reinterpret_cast<uint32_t*>(target));
+  case GatherISA::kAVX2:
+    return sizeof(T) == 8
+               ? gather64_avx2<STRIDE>(
+                     reinterpret_cast<const uint64_t*>(words), index, size,
+                     mask, reinterpret_cast<uint64_t*>(target))
+               : gather32_avx2<STRIDE>(
+                     reinterpret_cast<const uint32_t*>(words), index, size,
+                     mask, reinterpret_cast<uint32_t*>(target));
+  default:
+    return 0;
+  }
+#else
+  return 0;
+#endif
+}
+
+template <size_t STRIDE, typename T, typename INDEX_T>
+inline void gather(const T* values, const INDEX_T* indices, size_t size,
+                   INDEX_T mask, T* out) {
+  static_assert(std::is_arithmetic<T>::value,
+                "Only the numeric properties can be gathered");
+  size_t done = gather_simd<STRIDE>(values, indices, size, mask, out);
+  gather_scalar<STRIDE>(values, indices, done, size, mask, out);
+}
+
+}  // namespace gather_detail
+
+namespace property_graph_utils {
+
+/**
+ * @brief Gathers `out[i] = values[indices[i] & mask]` for `i` in
+ * `[0, size)`, see also Note [Neighbor gathers].
+ */
+template <typename T, typename INDEX_T>
+inline void gather(const T* values, const INDEX_T* indices, size_t size,
+                   T* out, INDEX_T mask = ~static_cast<INDEX_T>(0)) {
+  gather_detail::gather<1>(values, indices, size, mask, out);
+}
+
+/**
+ * @brief Gathers the values of the neighbors, `out[i] = values[units[i].vid
+ * & mask]` for `i` in `[0, size)`, without splitting the units.
+ */
+template <typename T, typename VID_T, typename EID_T>
+inline void gather_by_nbrs(const T* values, const NbrUnit<VID_T, EID_T>* units,
+                           size_t size, T* out,
+                           VID_T mask = ~static_cast<VID_T>(0)) {
+  static_assert(sizeof(NbrUnit<VID_T, EID_T>) == 2 * sizeof(VID_T),
+                "The units must be pairs of ids of the same width");
+  gather_detail::gather<2>(values, reinterpret_cast<const VID_T*>(units),
+                           size, mask, out);
+}
+
+/**
+ * @brief Gathers the values of the edges, `out[i] = values[units[i].eid]`
+ * for `i` in `[0, size)`, without splitting the units.
+ */
+template <typename T, typename VID_T, typename EID_T>
+inline void gather_by_eids(const T* values, const NbrUnit<VID_T, EID_T>* units,
+                           size_t size, T* out) {
+  static_assert(sizeof(NbrUnit<VID_T, EID_T>) == 2 * sizeof(EID_T),
+                "The units must be pairs of ids of the same width");
+  gather_detail::gather<2>(values, reinterpret_cast<const EID_T*>(units) + 1,
+                           size, ~static_cast<EID_T>(0), out);
+}
+
+/**
+ * @brief Splits the `NbrUnit`s into the dense arrays of the neighbors and the
+ * eids, `eids` can be nullptr if the eids are not needed.
+ */
+template <typename VID_T, typename EID_T>
+inline void gather_nbr_units(const NbrUnit<VID_T, EID_T>* units, size_t size,
+                             VID_T* vids, EID_T* eids) {
+  size_t i = 0;
+#ifdef VINEYARD_GATHER_X86_64
+  if (sizeof(VID_T) == 8 && sizeof(EID_T) == 8 &&
+      sizeof(NbrUnit<VID_T, EID_T>) == 16 &&
+      gather_detail::gather_isa() != gather_detail::GatherISA::kScalar) {
+    i = gather_detail::split_units_avx2(
+        reinterpret_cast<const uint64_t*>(units), size,
+        reinterpret_cast<uint64_t*>(vids), reinterpret_cast<uint64_t*>(eids));
+  }
+#endif
+  for (; i < size; ++i) {
+    vids[i] = units[i].vid;
+    if (eids != nullptr) {
+      eids[i] = units[i].eid;
+    }
+  }
+}
+
+/**
+ * @brief Decodes the compact adjacency lists of the vertices at offsets
+ * `[begin, end)` into the dense arrays of the neighbors and the eids, see
+ * also Note [Compact adjacency lists].
+ *
+ * The `vids` and `eids` must be able to hold `offsets[end] - offsets[begin]`
+ * values, `eids` can be nullptr if the eids are not needed.
+ */
+template <typename VID_T, typename EID_T>
+inline void gather_compact_nbrs(const uint8_t* nbrs,
+                                const int64_t* byte_offsets,
+                                const uint8_t* eids_stream,
+                                const int64_t* offsets, int64_t begin,
+                                int64_t end, VID_T* vids, EID_T* eids) {
+  VID_T* target = vids;
+  for (int64_t v = begin; v < end; ++v) {
+    const uint8_t* block = nbrs + byte_offsets[v];
+    VID_T* list_end = target + (offsets[v + 1] - offsets[v]);
+    size_t count = 0;
+    while (target < list_end) {
+      block = compact_detail::decode_block(block, target, count);
+      target += count;
+    }
+  }
+  if (eids != nullptr) {
+    int width = eids_stream[0];
+    for (int64_t e = offsets[begin]; e < offsets[end]; ++e) {
+      eids[e - offsets[begin]] = static_cast<EID_T>(
+          compact_detail::unpack_one(eids_stream + 1, e, width));
+    }
+  }
+}
+
+}  // namespace property_graph_utils
+
+}  // namespace vineyard
+
+#endif  // MODULES_GRAPH_FRAGMENT_GATHER_KERNELS_H_
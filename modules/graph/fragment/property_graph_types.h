@@ -522,6 +522,8 @@ class AdjList {
 
   inline const NbrUnit<VID_T, EID_T>* end_unit() const { return end_; }
 
+  inline const void** edata_arrays() const { return edata_arrays_; }
+
  private:
   const NbrUnit<VID_T, EID_T>* begin_;
   const NbrUnit<VID_T, EID_T>* end_;
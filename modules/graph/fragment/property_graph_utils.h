@@ -17,9 +17,12 @@ limitations under the License.
 #define MODULES_GRAPH_FRAGMENT_PROPERTY_GRAPH_UTILS_H_
 
 #include <algorithm>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -330,6 +333,22 @@ inline void parallel_prefix_sum(const int* input, int64_t* output,
   }
 }
 
+/**
+ * @brief Generates the order of vertices by their descending degrees, where
+ * `order[i]` is the index of the i-th vertex in the new order, and vertices of
+ * the same degree keep their relative order, see also Note [Vertex
+ * reordering].
+ */
+inline void generate_degree_order(const std::vector<int64_t>& degrees,
+                                  std::vector<int64_t>& order) {
+  order.resize(degrees.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&degrees](int64_t lhs, int64_t rhs) {
+                     return degrees[lhs] > degrees[rhs];
+                   });
+}
+
 template <typename VID_T>
 void collect_outer_vertices(
     const IdParser<VID_T>& parser,
@@ -426,34 +445,140 @@ boost::leaf::result<void> generate_local_id_list(
   return {};
 }
 
+/**
+ * Note [Parallel CSR construction]
+ *
+ * The adjacency lists are built in four steps, each of them balanced by the
+ * number of edges rather than the number of vertices, as a few hub vertices
+ * may own most of the edges of a power-law graph:
+ *
+ *  1. the degrees are counted with atomic adds and turned into the offsets
+ *     with `parallel_prefix_sum`;
+ *  2. the vertices of each label are split into buckets of consecutive
+ *     vertices with roughly the same number of edges, see
+ *     `generate_balanced_vertex_ranges`, and the edges, split into chunks of
+ *     the same size, are counted per (bucket, chunk) and scattered into the
+ *     buckets with the positions from a `parallel_prefix_sum` over the counts,
+ *     where every (bucket, chunk) slot is written by a single thread and no
+ *     lock or atomic is needed;
+ *  3. each bucket is placed into the CSR with a counting sort by the source
+ *     vertices, which keeps the edges in the input order;
+ *  4. the neighbors of each vertex are sorted by (vid, eid), where the hub
+ *     vertices with more edges than a bucket are sorted with all threads.
+ *
+ * The result does not depend on the concurrency, i.e., the parallel edges of
+ * a multigraph are ordered by their edge ids.
+ */
+
+/**
+ * @brief Splits the vertices [0, vnum) into at most `parts` ranges of
+ * consecutive vertices with roughly the same number of edges, where the
+ * ranges are [bounds[i], bounds[i + 1]).
+ */
+inline void generate_balanced_vertex_ranges(const int64_t* offsets,
+                                            int64_t vnum, int parts,
+                                            std::vector<int64_t>& bounds) {
+  bounds.clear();
+  bounds.push_back(0);
+  int64_t total = offsets[vnum];
+  for (int i = 1; i < parts; ++i) {
+    int64_t target = total / parts * i + total % parts * i / parts;
+    int64_t v = std::lower_bound(offsets, offsets + vnum + 1, target) - offsets;
+    if (v > bounds.back() && v < vnum) {
+      bounds.push_back(v);
+    }
+  }
+  if (vnum > bounds.back()) {
+    bounds.push_back(vnum);
+  }
+}
+
+/**
+ * @brief Sorts the range with a parallel merge sort, i.e., sorting
+ * `concurrency` blocks in parallel and merging them pairwise.
+ */
+template <typename T, typename COMPARE_T>
+void parallel_sort(T* begin, T* end, const COMPARE_T& compare,
+                   int concurrency) {
+  int64_t length = end - begin;
+  if (concurrency <= 1 || length < 8192) {
+    std::sort(begin, end, compare);
+    return;
+  }
+  std::vector<int64_t> bounds(concurrency + 1);
+  for (int i = 0; i <= concurrency; ++i) {
+    bounds[i] =
+        length / concurrency * i + length % concurrency * i / concurrency;
+  }
+  parallel_for(
+      0, concurrency,
+      [&](int i) {
+        std::sort(begin + bounds[i], begin + bounds[i + 1], compare);
+      },
+      concurrency, 1);
+  for (int width = 1; width < concurrency; width *= 2) {
+    int merges = (concurrency + 2 * width - 1) / (2 * width);
+    parallel_for(
+        0, merges,
+        [&](int i) {
+          int first = i * 2 * width;
+          if (first + width < concurrency) {
+            int last = std::min(first + 2 * width, concurrency);
+            std::inplace_merge(begin + bounds[first],
+                               begin + bounds[first + width],
+                               begin + bounds[last], compare);
+          }
+        },
+        concurrency, 1);
+  }
+}
+
 template <typename VID_T, typename EID_T>
 void sort_edges_with_respect_to_vertex(
     vineyard::PodArrayBuilder<property_graph_utils::NbrUnit<VID_T, EID_T>>&
         builder,
     std::shared_ptr<arrow::Int64Array> offsets, VID_T tvnum, int concurrency) {
   using nbr_unit_t = property_graph_utils::NbrUnit<VID_T, EID_T>;
+  auto compare = [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
+    return lhs.vid < rhs.vid || (lhs.vid == rhs.vid && lhs.eid < rhs.eid);
+  };
 
   const int64_t* offsets_ptr = offsets->raw_values();
   if (concurrency == 1) {
     for (VID_T i = 0; i < tvnum; ++i) {
       nbr_unit_t* begin = builder.MutablePointer(offsets_ptr[i]);
       nbr_unit_t* end = builder.MutablePointer(offsets_ptr[i + 1]);
-      std::sort(begin, end, [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
-        return lhs.vid < rhs.vid;
-      });
+      std::sort(begin, end, compare);
     }
   } else {
+    // see Note [Parallel CSR construction]
+    int parts = concurrency * 4;
+    int64_t hub_degree =
+        std::max(offsets_ptr[tvnum] / parts, static_cast<int64_t>(8192));
+    std::vector<int64_t> bounds;
+    generate_balanced_vertex_ranges(offsets_ptr, tvnum, parts, bounds);
+    std::vector<std::vector<int64_t>> hubs(bounds.size());
     parallel_for(
-        static_cast<VID_T>(0), tvnum,
-        [offsets_ptr, &builder](VID_T i) {
-          nbr_unit_t* begin = builder.MutablePointer(offsets_ptr[i]);
-          nbr_unit_t* end = builder.MutablePointer(offsets_ptr[i + 1]);
-          std::sort(begin, end,
-                    [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
-                      return lhs.vid < rhs.vid;
-                    });
+        static_cast<size_t>(1), bounds.size(),
+        [&](size_t i) {
+          for (int64_t v = bounds[i - 1]; v < bounds[i]; ++v) {
+            if (offsets_ptr[v + 1] - offsets_ptr[v] > hub_degree) {
+              hubs[i].push_back(v);
+              continue;
+            }
+            nbr_unit_t* begin = builder.MutablePointer(offsets_ptr[v]);
+            nbr_unit_t* end = builder.MutablePointer(offsets_ptr[v + 1]);
+            std::sort(begin, end, compare);
+          }
         },
-        concurrency);
+        concurrency, 1);
+    for (auto const& vertices : hubs) {
+      for (int64_t v : vertices) {
+        parallel_sort(builder.MutablePointer(offsets_ptr[v]),
+                      builder.MutablePointer(offsets_ptr[v + 1]), compare,
+                      concurrency);
+      }
+    }
   }
 }
 
@@ -465,73 +590,90 @@ void check_is_multigraph(
     bool& is_multigraph) {
   using nbr_unit_t = property_graph_utils::NbrUnit<VID_T, EID_T>;
   const int64_t* offsets_ptr = offsets->raw_values();
+  auto check = [offsets_ptr, &builder](int64_t v) {
+    nbr_unit_t* begin = builder.MutablePointer(offsets_ptr[v]);
+    nbr_unit_t* end = builder.MutablePointer(offsets_ptr[v + 1]);
+    nbr_unit_t* loc = std::adjacent_find(
+        begin, end, [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
+          return lhs.vid == rhs.vid;
+        });
+    return loc != end;
+  };
   if (concurrency == 1) {
     for (VID_T i = 0; i < tvnum; ++i) {
-      nbr_unit_t* begin = builder.MutablePointer(offsets_ptr[i]);
-      nbr_unit_t* end = builder.MutablePointer(offsets_ptr[i + 1]);
-      nbr_unit_t* loc = std::adjacent_find(
-          begin, end, [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
-            return lhs.vid == rhs.vid;
-          });
-      if (loc != end) {
+      if (check(i)) {
         is_multigraph = true;
         break;
       }
     }
   } else {
+    // balanced by the number of edges, see Note [Parallel CSR construction]
+    std::vector<int64_t> bounds;
+    generate_balanced_vertex_ranges(offsets_ptr, tvnum, concurrency * 4,
+                                    bounds);
+    std::atomic<bool> found(false);
     parallel_for(
-        static_cast<VID_T>(0), tvnum,
-        [offsets_ptr, &builder, &is_multigraph](VID_T i) {
-          if (!is_multigraph) {
-            nbr_unit_t* begin = builder.MutablePointer(offsets_ptr[i]);
-            nbr_unit_t* end = builder.MutablePointer(offsets_ptr[i + 1]);
-            nbr_unit_t* loc = std::adjacent_find(
-                begin, end, [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
-                  return lhs.vid == rhs.vid;
-                });
-            if (loc != end) {
-              __sync_or_and_fetch(
-                  reinterpret_cast<unsigned char*>(&is_multigraph), 1);
+        static_cast<size_t>(1), bounds.size(),
+        [&](size_t i) {
+          for (int64_t v = bounds[i - 1]; v < bounds[i]; ++v) {
+            if (found.load(std::memory_order_relaxed)) {
+              return;
+            }
+            if (check(v)) {
+              found.store(true, std::memory_order_relaxed);
+              return;
             }
           }
         },
-        concurrency);
+        concurrency, 1);
+    if (found.load()) {
+      is_multigraph = true;
+    }
   }
 }
 
+/**
+ * @brief Generates the CSR of edges from `src_list` to `dst_list` for each
+ * vertex label, see also Note [Parallel CSR construction]. When `undirected`
+ * is true, the edge from `dst_list` to `src_list` is added as well.
+ */
 template <typename VID_T, typename EID_T>
-boost::leaf::result<void> generate_directed_csr(
-    IdParser<VID_T>& parser,
-    const std::shared_ptr<
-        typename vineyard::ConvertToArrowType<VID_T>::ArrayType>& src_list,
-    const std::shared_ptr<
-        typename vineyard::ConvertToArrowType<VID_T>::ArrayType>& dst_list,
+boost::leaf::result<void> generate_csr(
+    IdParser<VID_T>& parser, const VID_T* src_list_ptr,
+    const VID_T* dst_list_ptr, int64_t edge_num, bool undirected,
     std::vector<VID_T> tvnums, int vertex_label_num, int concurrency,
     std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>>& edges,
     std::vector<std::shared_ptr<arrow::Int64Array>>& edge_offsets,
     bool& is_multigraph) {
+  using nbr_unit_t = property_graph_utils::NbrUnit<VID_T, EID_T>;
+
+  // the i-th entry is the edge `i % edge_num`, reversed if i >= edge_num
+  int64_t entry_num = undirected ? edge_num * 2 : edge_num;
+  auto entry_src = [&](int64_t i) {
+    return i < edge_num ? src_list_ptr[i] : dst_list_ptr[i - edge_num];
+  };
+  auto entry_dst = [&](int64_t i) {
+    return i < edge_num ? dst_list_ptr[i] : src_list_ptr[i - edge_num];
+  };
+
+  // 1. counts the degrees
   std::vector<std::vector<int>> degree(vertex_label_num);
   std::vector<int64_t> actual_edge_num(vertex_label_num, 0);
   for (int v_label = 0; v_label != vertex_label_num; ++v_label) {
     degree[v_label].resize(tvnums[v_label], 0);
   }
-  int64_t edge_num = src_list->length();
-  const VID_T* src_list_ptr = src_list->raw_values();
-  const VID_T* dst_list_ptr = dst_list->raw_values();
-
   if (concurrency == 1) {
-    for (int64_t i = 0; i < edge_num; ++i) {
-      VID_T src_id = src_list_ptr[i];
+    for (int64_t i = 0; i < entry_num; ++i) {
+      VID_T src_id = entry_src(i);
       ++degree[parser.GetLabelId(src_id)][parser.GetOffset(src_id)];
     }
   } else {
     parallel_for(
-        static_cast<int64_t>(0), edge_num,
-        [&degree, parser, src_list_ptr](int64_t i) {
-          VID_T src_id = src_list_ptr[i];
-          auto label = parser.GetLabelId(src_id);
-          int64_t offset = parser.GetOffset(src_id);
-          grape::atomic_add(degree[label][offset], 1);
+        static_cast<int64_t>(0), entry_num,
+        [&degree, &parser, &entry_src](int64_t i) {
+          VID_T src_id = entry_src(i);
+          grape::atomic_add(
+              degree[parser.GetLabelId(src_id)][parser.GetOffset(src_id)], 1);
         },
         concurrency);
   }
@@ -568,7 +710,8 @@ boost::leaf::result<void> generate_directed_csr(
     ARROW_OK_OR_RAISE(builder.Finish(&edge_offsets[v_label]));
     actual_edge_num[v_label] = offset_vec[tvnum];
   }
-  using nbr_unit_t = property_graph_utils::NbrUnit<VID_T, EID_T>;
+  degree.clear();
+
   std::vector<vineyard::PodArrayBuilder<nbr_unit_t>> edge_builders(
       vertex_label_num);
   for (int v_label = 0; v_label != vertex_label_num; ++v_label) {
@@ -578,33 +721,92 @@ boost::leaf::result<void> generate_directed_csr(
   }
 
   if (concurrency == 1) {
-    for (int64_t i = 0; i < edge_num; ++i) {
-      VID_T src_id = src_list_ptr[i];
+    for (int64_t i = 0; i < entry_num; ++i) {
+      VID_T src_id = entry_src(i);
       int v_label = parser.GetLabelId(src_id);
       int64_t v_offset = parser.GetOffset(src_id);
       nbr_unit_t* ptr =
           edge_builders[v_label].MutablePointer(offsets[v_label][v_offset]);
-      ptr->vid = dst_list->Value(i);
-      ptr->eid = static_cast<EID_T>(i);
+      ptr->vid = entry_dst(i);
+      ptr->eid = static_cast<EID_T>(i < edge_num ? i : i - edge_num);
       ++offsets[v_label][v_offset];
     }
-  } else {
+  } else if (entry_num > 0) {
+    // 2. scatters the edges into buckets of balanced vertex ranges
+    int parts = concurrency * 4;
+    std::vector<std::vector<int64_t>> bounds(vertex_label_num);
+    std::vector<int> bucket_begin(vertex_label_num + 1, 0);
+    for (int v_label = 0; v_label != vertex_label_num; ++v_label) {
+      generate_balanced_vertex_ranges(offsets[v_label].data(),
+                                      tvnums[v_label], parts, bounds[v_label]);
+      bucket_begin[v_label + 1] = bucket_begin[v_label] +
+                                  static_cast<int>(bounds[v_label].size()) - 1;
+    }
+    auto bucket_of = [&](VID_T src_id) {
+      int v_label = parser.GetLabelId(src_id);
+      int64_t v_offset = parser.GetOffset(src_id);
+      auto const& bound = bounds[v_label];
+      return bucket_begin[v_label] +
+             static_cast<int>(
+                 std::upper_bound(bound.begin() + 1, bound.end(), v_offset) -
+                 (bound.begin() + 1));
+    };
+
+    int bucket_num = bucket_begin[vertex_label_num];
+    int chunk_num = parts;
+    int64_t chunk_size = (entry_num + chunk_num - 1) / chunk_num;
+    // the counts and positions of (bucket, chunk), in the order of buckets
+    std::vector<int> counts(static_cast<size_t>(bucket_num) * chunk_num, 0);
+    std::vector<int64_t> positions(counts.size() + 1, 0);
     parallel_for(
-        static_cast<int64_t>(0), edge_num,
-        [src_list_ptr, dst_list_ptr, &parser, &edge_builders,
-         &offsets](int64_t i) {
-          VID_T src_id = src_list_ptr[i];
-          int v_label = parser.GetLabelId(src_id);
-          int64_t v_offset = parser.GetOffset(src_id);
-          int64_t adj_offset =
-              __sync_fetch_and_add(&offsets[v_label][v_offset], 1);
-          nbr_unit_t* ptr = edge_builders[v_label].MutablePointer(adj_offset);
-          ptr->vid = dst_list_ptr[i];
-          ptr->eid = static_cast<EID_T>(i);
+        0, chunk_num,
+        [&](int chunk) {
+          int64_t begin = std::min(chunk * chunk_size, entry_num);
+          int64_t end = std::min(begin + chunk_size, entry_num);
+          for (int64_t i = begin; i < end; ++i) {
+            ++counts[bucket_of(entry_src(i)) * chunk_num + chunk];
+          }
         },
-        concurrency);
+        concurrency, 1);
+    parallel_prefix_sum(counts.data(), &positions[1], counts.size(),
+                        concurrency);
+
+    std::vector<int64_t> bucketed_entries(entry_num);
+    parallel_for(
+        0, chunk_num,
+        [&](int chunk) {
+          int64_t begin = std::min(chunk * chunk_size, entry_num);
+          int64_t end = std::min(begin + chunk_size, entry_num);
+          for (int64_t i = begin; i < end; ++i) {
+            int64_t& position =
+                positions[bucket_of(entry_src(i)) * chunk_num + chunk];
+            bucketed_entries[position++] = i;
+          }
+        },
+        concurrency, 1);
+
+    // 3. counting sort in each bucket, the ranges of buckets are the
+    // `positions` of the first chunk after the scattering above
+    parallel_for(
+        0, bucket_num,
+        [&](int bucket) {
+          int64_t begin = bucket == 0 ? 0 : positions[bucket * chunk_num - 1];
+          int64_t end = positions[(bucket + 1) * chunk_num - 1];
+          for (int64_t k = begin; k < end; ++k) {
+            int64_t i = bucketed_entries[k];
+            VID_T src_id = entry_src(i);
+            int v_label = parser.GetLabelId(src_id);
+            int64_t v_offset = parser.GetOffset(src_id);
+            nbr_unit_t* ptr = edge_builders[v_label].MutablePointer(
+                offsets[v_label][v_offset]++);
+            ptr->vid = entry_dst(i);
+            ptr->eid = static_cast<EID_T>(i < edge_num ? i : i - edge_num);
+          }
+        },
+        concurrency, 1);
   }
 
+  // 4. sorts the neighbors
   for (int v_label = 0; v_label != vertex_label_num; ++v_label) {
     sort_edges_with_respect_to_vertex(edge_builders[v_label],
                                       edge_offsets[v_label], tvnums[v_label],
@@ -620,7 +822,7 @@ boost::leaf::result<void> generate_directed_csr(
 }
 
 template <typename VID_T, typename EID_T>
-boost::leaf::result<void> generate_undirected_csr(
+boost::leaf::result<void> generate_directed_csr(
     IdParser<VID_T>& parser,
     const std::shared_ptr<
         typename vineyard::ConvertToArrowType<VID_T>::ArrayType>& src_list,
@@ -630,139 +832,141 @@ boost::leaf::result<void> generate_undirected_csr(
     std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>>& edges,
     std::vector<std::shared_ptr<arrow::Int64Array>>& edge_offsets,
     bool& is_multigraph) {
-  std::vector<std::vector<int>> degree(vertex_label_num);
-  std::vector<int64_t> actual_edge_num(vertex_label_num, 0);
-  for (int v_label = 0; v_label != vertex_label_num; ++v_label) {
-    degree[v_label].resize(tvnums[v_label], 0);
-  }
-  int64_t edge_num = src_list->length();
-  const VID_T* src_list_ptr = src_list->raw_values();
-  const VID_T* dst_list_ptr = dst_list->raw_values();
-
-  if (concurrency == 1) {
-    for (int64_t i = 0; i < edge_num; ++i) {
-      VID_T src_id = src_list_ptr[i];
-      VID_T dst_id = dst_list_ptr[i];
-      ++degree[parser.GetLabelId(src_id)][parser.GetOffset(src_id)];
-      ++degree[parser.GetLabelId(dst_id)][parser.GetOffset(dst_id)];
-    }
-  } else {
-    parallel_for(
-        static_cast<int64_t>(0), edge_num,
-        [&degree, &parser, src_list_ptr, dst_list_ptr](int64_t i) {
-          auto src_id = src_list_ptr[i];
-          auto dst_id = dst_list_ptr[i];
-          grape::atomic_add(
-              degree[parser.GetLabelId(src_id)][parser.GetOffset(src_id)], 1);
-          grape::atomic_add(
-              degree[parser.GetLabelId(dst_id)][parser.GetOffset(dst_id)], 1);
-        },
-        concurrency);
-  }
-
-  std::vector<std::vector<int64_t>> offsets(vertex_label_num);
-  for (int v_label = 0; v_label != vertex_label_num; ++v_label) {
-    auto tvnum = tvnums[v_label];
-    auto& offset_vec = offsets[v_label];
-    auto& degree_vec = degree[v_label];
-    arrow::Int64Builder builder;
-
-    offset_vec.resize(tvnum + 1);
-    offset_vec[0] = 0;
+  return generate_csr<VID_T, EID_T>(
+      parser, src_list->raw_values(), dst_list->raw_values(),
+      src_list->length(), false, tvnums, vertex_label_num, concurrency, edges,
+      edge_offsets, is_multigraph);
+}
 
-    if (tvnum > 0) {
-      if (concurrency == 1) {
-        for (VID_T i = 0; i < tvnum; ++i) {
-          offset_vec[i + 1] = offset_vec[i] + degree_vec[i];
-        }
-        ARROW_OK_OR_RAISE(builder.AppendValues(offset_vec));
-      } else {
-        parallel_prefix_sum(degree_vec.data(), &offset_vec[1], tvnum,
-                            concurrency);
-        ARROW_OK_OR_RAISE(builder.Resize(tvnum + 1));
-        parallel_for(
-            static_cast<VID_T>(0), tvnum + 1,
-            [&offset_vec, &builder](VID_T i) { builder[i] = offset_vec[i]; },
-            concurrency);
-        ARROW_OK_OR_RAISE(builder.Advance(tvnum + 1));
-      }
-    } else {
-      ARROW_OK_OR_RAISE(builder.AppendValues(offset_vec));
-    }
-    ARROW_OK_OR_RAISE(builder.Finish(&edge_offsets[v_label]));
-    actual_edge_num[v_label] = offset_vec[tvnum];
-  }
+template <typename VID_T, typename EID_T>
+boost::leaf::result<void> generate_undirected_csr(
+    IdParser<VID_T>& parser,
+    const std::shared_ptr<
+        typename vineyard::ConvertToArrowType<VID_T>::ArrayType>& src_list,
+    const std::shared_ptr<
+        typename vineyard::ConvertToArrowType<VID_T>::ArrayType>& dst_list,
+    std::vector<VID_T> tvnums, int vertex_label_num, int concurrency,
+    std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>>& edges,
+    std::vector<std::shared_ptr<arrow::Int64Array>>& edge_offsets,
+    bool& is_multigraph) {
+  return generate_csr<VID_T, EID_T>(
+      parser, src_list->raw_values(), dst_list->raw_values(),
+      src_list->length(), true, tvnums, vertex_label_num, concurrency, edges,
+      edge_offsets, is_multigraph);
+}
 
+/**
+ * Note [Merging directed CSR]
+ *
+ * Turning a directed fragment into an undirected one merges, for every
+ * (vertex label, edge label), the incoming and the outgoing adjacency lists
+ * of each vertex. As both offsets arrays are prefix sums already, the offsets
+ * of the merged CSR are their element-wise sums and need no counting pass.
+ * The neighbors are then written into the balanced vertex ranges (see
+ * `generate_balanced_vertex_ranges`) of all the CSRs at once, so that labels
+ * with few edges don't leave threads idle. The lists of an `ArrowFragment`
+ * are sorted by (vid, eid), hence the two lists of a vertex are merged in a
+ * single linear pass rather than sorted, falling back to `std::sort` for the
+ * lists that aren't sorted, and checked for parallel edges on the way.
+ */
+template <typename VID_T, typename EID_T>
+boost::leaf::result<void> merge_directed_csr(
+    const std::vector<const property_graph_utils::NbrUnit<VID_T, EID_T>*>&
+        ie_lists,
+    const std::vector<const int64_t*>& ie_offsets_lists,
+    const std::vector<const property_graph_utils::NbrUnit<VID_T, EID_T>*>&
+        oe_lists,
+    const std::vector<const int64_t*>& oe_offsets_lists,
+    const std::vector<VID_T>& tvnums, int concurrency,
+    std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>>& edges,
+    std::vector<std::shared_ptr<arrow::Int64Array>>& edge_offsets,
+    bool& is_multigraph) {
   using nbr_unit_t = property_graph_utils::NbrUnit<VID_T, EID_T>;
+  auto compare = [](const nbr_unit_t& lhs, const nbr_unit_t& rhs) {
+    return lhs.vid < rhs.vid || (lhs.vid == rhs.vid && lhs.eid < rhs.eid);
+  };
 
-  std::vector<vineyard::PodArrayBuilder<nbr_unit_t>> edge_builders(
-      vertex_label_num);
-  for (int v_label = 0; v_label != vertex_label_num; ++v_label) {
-    // FixedSizeBinaryBuilder has different behaviour on `Resize/Advance`
-    ARROW_OK_OR_RAISE(
-        edge_builders[v_label].ResizeAndFill(actual_edge_num[v_label]));
-  }
+  size_t csr_num = tvnums.size();
+  edges.resize(csr_num);
+  edge_offsets.resize(csr_num);
 
-  if (concurrency == 1) {
-    for (int64_t i = 0; i < edge_num; ++i) {
-      VID_T src_id = src_list_ptr[i];
-      VID_T dst_id = dst_list_ptr[i];
-      auto src_label = parser.GetLabelId(src_id);
-      int64_t src_offset = parser.GetOffset(src_id);
-      auto dst_label = parser.GetLabelId(dst_id);
-      int64_t dst_offset = parser.GetOffset(dst_id);
-
-      nbr_unit_t* src_ptr = edge_builders[src_label].MutablePointer(
-          offsets[src_label][src_offset]);
-      src_ptr->vid = dst_id;
-      src_ptr->eid = static_cast<EID_T>(i);
-      ++offsets[src_label][src_offset];
-
-      nbr_unit_t* dst_ptr = edge_builders[dst_label].MutablePointer(
-          offsets[dst_label][dst_offset]);
-      dst_ptr->vid = src_id;
-      dst_ptr->eid = static_cast<EID_T>(i);
-      ++offsets[dst_label][dst_offset];
-    }
-  } else {
+  // 1. sums up the offsets
+  std::vector<int64_t> edge_nums(csr_num);
+  for (size_t i = 0; i < csr_num; ++i) {
+    const int64_t* ie_offsets = ie_offsets_lists[i];
+    const int64_t* oe_offsets = oe_offsets_lists[i];
+    VID_T tvnum = tvnums[i];
+    arrow::Int64Builder builder;
+    ARROW_OK_OR_RAISE(builder.Resize(tvnum + 1));
     parallel_for(
-        static_cast<int64_t>(0), edge_num,
-        [src_list_ptr, dst_list_ptr, &parser, &edge_builders,
-         &offsets](int64_t i) {
-          VID_T src_id = src_list_ptr[i];
-          VID_T dst_id = dst_list_ptr[i];
-          auto src_label = parser.GetLabelId(src_id);
-          int64_t src_offset = parser.GetOffset(src_id);
-          auto dst_label = parser.GetLabelId(dst_id);
-          int64_t dst_offset = parser.GetOffset(dst_id);
-
-          int64_t oe_offset =
-              __sync_fetch_and_add(&offsets[src_label][src_offset], 1);
-          nbr_unit_t* src_ptr =
-              edge_builders[src_label].MutablePointer(oe_offset);
-          src_ptr->vid = dst_id;
-          src_ptr->eid = static_cast<EID_T>(i);
-
-          int64_t ie_offset =
-              __sync_fetch_and_add(&offsets[dst_label][dst_offset], 1);
-          nbr_unit_t* dst_ptr =
-              edge_builders[dst_label].MutablePointer(ie_offset);
-          dst_ptr->vid = src_id;
-          dst_ptr->eid = static_cast<EID_T>(i);
+        static_cast<VID_T>(0), tvnum + 1,
+        [&](VID_T v) {
+          builder[v] = (ie_offsets[v] - ie_offsets[0]) +
+                       (oe_offsets[v] - oe_offsets[0]);
         },
         concurrency);
+    ARROW_OK_OR_RAISE(builder.Advance(tvnum + 1));
+    ARROW_OK_OR_RAISE(builder.Finish(&edge_offsets[i]));
+    edge_nums[i] = edge_offsets[i]->Value(tvnum);
   }
 
-  for (int v_label = 0; v_label != vertex_label_num; ++v_label) {
-    sort_edges_with_respect_to_vertex(edge_builders[v_label],
-                                      edge_offsets[v_label], tvnums[v_label],
-                                      concurrency);
-    if (!is_multigraph) {
-      check_is_multigraph(edge_builders[v_label], edge_offsets[v_label],
-                          tvnums[v_label], concurrency, is_multigraph);
+  // 2. merges the neighbors, over the vertex ranges of all CSRs
+  std::vector<vineyard::PodArrayBuilder<nbr_unit_t>> edge_builders(csr_num);
+  std::vector<std::pair<size_t, std::pair<int64_t, int64_t>>> ranges;
+  for (size_t i = 0; i < csr_num; ++i) {
+    // FixedSizeBinaryBuilder has different behaviour on `Resize/Advance`
+    ARROW_OK_OR_RAISE(edge_builders[i].ResizeAndFill(edge_nums[i]));
+    std::vector<int64_t> bounds;
+    generate_balanced_vertex_ranges(edge_offsets[i]->raw_values(), tvnums[i],
+                                    concurrency * 4, bounds);
+    for (size_t k = 1; k < bounds.size(); ++k) {
+      ranges.emplace_back(i, std::make_pair(bounds[k - 1], bounds[k]));
     }
-    ARROW_OK_OR_RAISE(edge_builders[v_label].Advance(actual_edge_num[v_label]));
-    ARROW_OK_OR_RAISE(edge_builders[v_label].Finish(&edges[v_label]));
+  }
+  std::atomic<bool> found(is_multigraph);
+  parallel_for(
+      static_cast<size_t>(0), ranges.size(),
+      [&](size_t k) {
+        size_t i = ranges[k].first;
+        const nbr_unit_t* ie = ie_lists[i];
+        const nbr_unit_t* oe = oe_lists[i];
+        const int64_t* ie_offsets = ie_offsets_lists[i];
+        const int64_t* oe_offsets = oe_offsets_lists[i];
+        const int64_t* offsets = edge_offsets[i]->raw_values();
+        for (int64_t v = ranges[k].second.first; v < ranges[k].second.second;
+             ++v) {
+          if (offsets[v] == offsets[v + 1]) {
+            continue;
+          }
+          const nbr_unit_t* ie_begin = ie + ie_offsets[v];
+          const nbr_unit_t* ie_end = ie + ie_offsets[v + 1];
+          const nbr_unit_t* oe_begin = oe + oe_offsets[v];
+          const nbr_unit_t* oe_end = oe + oe_offsets[v + 1];
+          nbr_unit_t* begin = edge_builders[i].MutablePointer(offsets[v]);
+          nbr_unit_t* end = begin + (offsets[v + 1] - offsets[v]);
+          if (std::is_sorted(ie_begin, ie_end, compare) &&
+              std::is_sorted(oe_begin, oe_end, compare)) {
+            std::merge(ie_begin, ie_end, oe_begin, oe_end, begin, compare);
+          } else {
+            std::copy(oe_begin, oe_end, std::copy(ie_begin, ie_end, begin));
+            std::sort(begin, end, compare);
+          }
+          if (!found.load(std::memory_order_relaxed) &&
+              std::adjacent_find(begin, end,
+                                 [](const nbr_unit_t& lhs,
+                                    const nbr_unit_t& rhs) {
+                                   return lhs.vid == rhs.vid;
+                                 }) != end) {
+            found.store(true, std::memory_order_relaxed);
+          }
+        }
+      },
+      concurrency, 1);
+  is_multigraph = found.load();
+
+  for (size_t i = 0; i < csr_num; ++i) {
+    ARROW_OK_OR_RAISE(edge_builders[i].Advance(edge_nums[i]));
+    ARROW_OK_OR_RAISE(edge_builders[i].Finish(&edges[i]));
   }
   return {};
 }
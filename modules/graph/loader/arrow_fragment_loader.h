@@ -47,6 +47,7 @@ limitations under the License.
 #include "graph/loader/basic_ev_fragment_loader.h"
 #include "graph/loader/fragment_loader_utils.h"
 #include "graph/utils/error.h"
+#include "graph/utils/mpi_utils.h"
 #include "graph/utils/partitioner.h"
 #include "graph/utils/thread_group.h"
 #include "graph/vertex_map/arrow_vertex_map.h"
@@ -115,6 +116,19 @@ boost::leaf::result<std::vector<std::shared_ptr<arrow::Table>>> GatherVTables(
     Client& client, const std::vector<ObjectID>& vstreams, int part_id,
     int part_num);
 
+/**
+ * @brief The options of the layout of the fragments built by
+ * `ArrowFragmentLoader`.
+ */
+struct ArrowFragmentLoaderOptions {
+  // stores the adjacency lists in the compact layout, see also Note [Compact
+  // adjacency lists].
+  bool compact_edges = false;
+  // orders the inner vertices by their degrees, see also Note [Vertex
+  // reordering].
+  bool reorder_vertices = false;
+};
+
 template <typename OID_T = property_graph_types::OID_TYPE,
           typename VID_T = property_graph_types::VID_TYPE>
 class ArrowFragmentLoader {
@@ -130,8 +144,12 @@ class ArrowFragmentLoader {
   static constexpr const char* DST_LABEL_TAG = "dst_label";
 
   static constexpr int id_column = 0;
+  static constexpr int src_column = 0;
+  static constexpr int dst_column = 1;
 #ifdef HASH_PARTITION
-  using partitioner_t = HashPartitioner<oid_t>;
+  // hashes the oids, unless a streaming strategy is set, see also
+  // `SetPartitionStrategy()`
+  using partitioner_t = StreamingPartitioner<oid_t>;
 #else
   using partitioner_t = SegmentedPartitioner<oid_t>;
 #endif
@@ -148,66 +166,100 @@ class ArrowFragmentLoader {
    * /data/twitter_e_0_0_0#src_label=v0&dst_label=v0&label=e0;/data/twitter_e_0_1_0#src_label=v0&dst_label=v1&label=e0;/data/twitter_e_1_0_0#src_label=v1&dst_label=v0&label=e0;/data/twitter_e_1_1_0#src_label=v1&dst_label=v1&label=e0
    * @param vfiles An example of vfile: /data/twitter_v_0#label=v0
    * @param directed
+   * @param generate_eid
+   * @param options The layout of the fragments, see also
+   * `ArrowFragmentLoaderOptions`.
    */
   ArrowFragmentLoader(Client& client, const grape::CommSpec& comm_spec,
                       const std::vector<std::string>& efiles,
                       const std::vector<std::string>& vfiles,
-                      bool directed = true, bool generate_eid = false)
+                      bool directed = true, bool generate_eid = false,
+                      const ArrowFragmentLoaderOptions& options = {})
       : client_(client),
         comm_spec_(comm_spec),
         efiles_(efiles),
         vfiles_(vfiles),
         directed_(directed),
-        generate_eid_(generate_eid) {}
+        generate_eid_(generate_eid),
+        options_(options) {}
 
   ArrowFragmentLoader(Client& client, const grape::CommSpec& comm_spec,
                       const std::vector<std::string>& efiles,
-                      bool directed = true, bool generate_eid = false)
+                      bool directed = true, bool generate_eid = false,
+                      const ArrowFragmentLoaderOptions& options = {})
       : client_(client),
         comm_spec_(comm_spec),
         efiles_(efiles),
         vfiles_(),
         directed_(directed),
-        generate_eid_(generate_eid) {}
+        generate_eid_(generate_eid),
+        options_(options) {}
 
   ArrowFragmentLoader(Client& client, const grape::CommSpec& comm_spec,
                       const std::vector<ObjectID>& vstreams,
                       const std::vector<std::vector<ObjectID>>& estreams,
-                      bool directed = true, bool generate_eid = false)
+                      bool directed = true, bool generate_eid = false,
+                      const ArrowFragmentLoaderOptions& options = {})
       : client_(client),
         comm_spec_(comm_spec),
         v_streams_(vstreams),
         e_streams_(estreams),
         directed_(directed),
-        generate_eid_(generate_eid) {}
+        generate_eid_(generate_eid),
+        options_(options) {}
 
   ArrowFragmentLoader(
       Client& client, const grape::CommSpec& comm_spec,
       std::vector<std::shared_ptr<arrow::Table>> const& partial_v_tables,
       std::vector<std::vector<std::shared_ptr<arrow::Table>>> const&
           partial_e_tables,
-      bool directed = true, bool generate_eid = false)
+      bool directed = true, bool generate_eid = false,
+      const ArrowFragmentLoaderOptions& options = {})
       : client_(client),
         comm_spec_(comm_spec),
         partial_v_tables_(partial_v_tables),
         partial_e_tables_(partial_e_tables),
         directed_(directed),
-        generate_eid_(generate_eid) {}
+        generate_eid_(generate_eid),
+        options_(options) {}
 
   ArrowFragmentLoader(
       Client& client, const grape::CommSpec& comm_spec,
       std::vector<std::vector<std::shared_ptr<arrow::Table>>> const&
           partial_e_tables,
-      bool directed = true, bool generate_eid = false)
+      bool directed = true, bool generate_eid = false,
+      const ArrowFragmentLoaderOptions& options = {})
       : client_(client),
         comm_spec_(comm_spec),
         partial_v_tables_(),
         partial_e_tables_(partial_e_tables),
         directed_(directed),
-        generate_eid_(generate_eid) {}
+        generate_eid_(generate_eid),
+        options_(options) {}
 
   ~ArrowFragmentLoader() = default;
 
+  /**
+   * @brief Sets the strategy to partition the vertices, see also Note
+   * [Streaming graph partitioning]. Defaults to hashing the oids.
+   *
+   * @param strategy Hash, LDG, Fennel, or the degree-aware hybrid.
+   * @param slack The fragments hold at most `(1 + slack)` times of the
+   * average number of vertices.
+   */
+  void SetPartitionStrategy(PartitionStrategy strategy, double slack = 0.1) {
+    partition_strategy_ = strategy;
+    partition_slack_ = slack;
+  }
+
+  /**
+   * @brief Whether to log the edge cut and the balance of the fragments after
+   * loading, which traverses the fragments. Must be the same on all workers.
+   */
+  void SetReportPartitionQuality(bool report) {
+    report_partition_quality_ = report;
+  }
+
   boost::leaf::result<ObjectID> LoadFragment() {
     BOOST_LEAF_CHECK(initPartitioner());
 
@@ -270,11 +322,17 @@ class ArrowFragmentLoader {
       RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
                       "Error when processing input source");
     }
+#ifdef HASH_PARTITION
+    if (partition_strategy_ != PartitionStrategy::kHash) {
+      BOOST_LEAF_CHECK(streamPartition(partial_v_tables, partial_e_tables));
+    }
+#endif
 
     std::shared_ptr<BasicEVFragmentLoader<OID_T, VID_T, partitioner_t>>
         basic_fragment_loader = std::make_shared<
             BasicEVFragmentLoader<OID_T, VID_T, partitioner_t>>(
-            client_, comm_spec_, partitioner_, directed_, true, generate_eid_);
+            client_, comm_spec_, partitioner_, directed_, true, generate_eid_,
+            options_.compact_edges, options_.reorder_vertices);
 
     BOOST_LEAF_AUTO(v_e_tables,
                     preprocessInputs(partial_v_tables, partial_e_tables));
@@ -286,6 +344,12 @@ class ArrowFragmentLoader {
       BOOST_LEAF_CHECK(
           basic_fragment_loader->AddVertexTable(pair.first, pair.second));
     }
+    if (options_.reorder_vertices) {
+      for (auto& table : edge_tables_with_label) {
+        BOOST_LEAF_CHECK(basic_fragment_loader->AddVertexDegrees(
+            table.src_label, table.dst_label, table.table));
+      }
+    }
     BOOST_LEAF_CHECK(basic_fragment_loader->ConstructVertices());
 
     partial_v_tables.clear();
@@ -300,7 +364,11 @@ class ArrowFragmentLoader {
 
     BOOST_LEAF_CHECK(basic_fragment_loader->ConstructEdges());
 
-    return basic_fragment_loader->ConstructFragment();
+    BOOST_LEAF_AUTO(frag_id, basic_fragment_loader->ConstructFragment());
+    if (report_partition_quality_) {
+      reportPartitionQuality(frag_id);
+    }
+    return frag_id;
   }
 
   boost::leaf::result<ObjectID> LoadFragmentAsFragmentGroup() {
@@ -352,6 +420,331 @@ class ArrowFragmentLoader {
     return {};
   }
 
+  /**
+   * @brief Places the endpoints of the edges by the streaming partitioner,
+   * see also Note [Streaming graph partitioning].
+   *
+   * Neither the edges nor the placements are gathered to a single worker:
+   * the vertices are streamed by their owners, and at last each worker keeps
+   * the placements of the oids that it looks up when building the fragment,
+   * i.e., of its inputs and of the inner and outer vertices of its fragment.
+   * The vertices absent from the edges are left to hashing.
+   */
+  boost::leaf::result<void> streamPartition(
+      const std::vector<std::shared_ptr<arrow::Table>>& v_tables,
+      const std::vector<std::vector<std::shared_ptr<arrow::Table>>>& e_tables) {
+    using placements_t = typename partitioner_t::placements_t;
+    static constexpr int kStreamingRounds = 8;
+
+    int worker_num = comm_spec_.worker_num();
+    int worker_id = comm_spec_.worker_id();
+    fid_t fnum = comm_spec_.fnum();
+    HashPartitioner<oid_t> owners;
+    owners.Init(worker_num);
+
+    // the endpoints of the local edges, as `src_0, dst_0, src_1, dst_1, ...`
+    std::vector<oid_t> endpoints;
+    for (auto const& tables : e_tables) {
+      for (auto const& table : tables) {
+        auto srcs = table->column(src_column);
+        auto dsts = table->column(dst_column);
+        if (!srcs->type()->Equals(ConvertToArrowType<oid_t>::TypeValue()) ||
+            !dsts->type()->Equals(ConvertToArrowType<oid_t>::TypeValue())) {
+          // reported when adding the edge table
+          continue;
+        }
+        // the columns may be chunked differently
+        size_t base = endpoints.size();
+        endpoints.resize(base + 2 * table->num_rows());
+        for (auto const& column : {srcs, dsts}) {
+          size_t index = base + (column == srcs ? 0 : 1);
+          for (auto const& chunk : column->chunks()) {
+            auto oids = std::dynamic_pointer_cast<oid_array_t>(chunk);
+            for (int64_t k = 0; k < oids->length(); ++k, index += 2) {
+              endpoints[index] = oid_t(oids->GetView(k));
+            }
+          }
+        }
+      }
+    }
+
+    // the placements of the owned vertices
+    placements_t owned_fids;
+    {
+      // sends the edges to the owners of both endpoints, as the pairs of
+      // `(owned, neighbor)`
+      std::vector<std::vector<oid_t>> pairs_out(worker_num), pairs_in;
+      for (size_t k = 0; k < endpoints.size(); k += 2) {
+        for (int end = 0; end < 2; ++end) {
+          auto& pairs = pairs_out[owners.GetPartitionId(endpoints[k + end])];
+          pairs.push_back(endpoints[k + end]);
+          pairs.push_back(endpoints[k + 1 - end]);
+        }
+      }
+      AllToAll(pairs_out, pairs_in, comm_spec_);
+
+      // indexes the owned vertices and their neighbors, where the owned
+      // vertices are those with neighbors, in the order of appearances
+      ska::flat_hash_map<oid_t, int64_t> oid_to_index;
+      std::vector<oid_t> oids;
+      std::vector<int64_t> edges;
+      for (auto& pairs : pairs_in) {
+        for (auto& oid : pairs) {
+          auto iter = oid_to_index.find(oid);
+          if (iter == oid_to_index.end()) {
+            iter = oid_to_index.emplace(oid, oids.size()).first;
+            oids.emplace_back(oid);
+          }
+          edges.push_back(iter->second);
+        }
+        std::vector<oid_t>().swap(pairs);
+      }
+      int64_t vnum = oids.size();
+      std::vector<int64_t> offsets(vnum + 1, 0), neighbors(edges.size() / 2);
+      for (size_t k = 0; k < edges.size(); k += 2) {
+        ++offsets[edges[k] + 1];
+      }
+      for (int64_t v = 0; v < vnum; ++v) {
+        offsets[v + 1] += offsets[v];
+      }
+      std::vector<int64_t> cursor(offsets.begin(), offsets.end() - 1);
+      for (size_t k = 0; k < edges.size(); k += 2) {
+        neighbors[cursor[edges[k]]++] = edges[k + 1];
+      }
+      std::vector<int64_t>().swap(edges);
+      std::vector<int64_t>().swap(cursor);
+
+      std::vector<int64_t> owned;
+      for (int64_t v = 0; v < vnum; ++v) {
+        if (offsets[v + 1] > offsets[v]) {
+          owned.push_back(v);
+        }
+      }
+      // the edges are counted from both endpoints
+      int64_t local_counts[2] = {static_cast<int64_t>(owned.size()),
+                                 static_cast<int64_t>(neighbors.size())};
+      int64_t total_counts[2];
+      MPI_Allreduce(local_counts, total_counts, 2, MPI_INT64_T, MPI_SUM,
+                    comm_spec_.comm());
+      if (total_counts[0] == 0) {
+        return {};
+      }
+      StreamingPlacer placer(partition_strategy_, fnum, total_counts[0],
+                             total_counts[1] / 2, partition_slack_);
+
+      std::vector<fid_t> fids(vnum, fnum);
+      std::vector<int64_t> sizes(fnum, 0);
+      // publishes the new placements to the owners of the neighbors, and
+      // sums up the sizes of the fragments
+      auto sync_placements = [&](const std::vector<int64_t>& placed) {
+        std::vector<int64_t> added(fnum, 0);
+        std::vector<std::vector<oid_t>> oids_out(worker_num), oids_in;
+        std::vector<std::vector<fid_t>> fids_out(worker_num), fids_in;
+        std::vector<int64_t> last_sent(worker_num, -1);
+        for (int64_t v : placed) {
+          ++added[fids[v]];
+          for (int64_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+            int owner = owners.GetPartitionId(oids[neighbors[k]]);
+            if (owner != worker_id && last_sent[owner] != v) {
+              last_sent[owner] = v;
+              oids_out[owner].push_back(oids[v]);
+              fids_out[owner].push_back(fids[v]);
+            }
+          }
+        }
+        MPI_Allreduce(MPI_IN_PLACE, added.data(), fnum, MPI_INT64_T, MPI_SUM,
+                      comm_spec_.comm());
+        for (fid_t fid = 0; fid < fnum; ++fid) {
+          sizes[fid] += added[fid];
+        }
+        AllToAll(oids_out, oids_in, comm_spec_);
+        AllToAll(fids_out, fids_in, comm_spec_);
+        for (int i = 0; i < worker_num; ++i) {
+          for (size_t k = 0; k < oids_in[i].size(); ++k) {
+            auto iter = oid_to_index.find(oids_in[i][k]);
+            if (iter != oid_to_index.end()) {
+              fids[iter->second] = fids_in[i][k];
+            }
+          }
+        }
+      };
+
+      // spreads the hubs round-robin, continuing the hubs of the previous
+      // workers
+      std::vector<int64_t> placed;
+      for (int64_t v : owned) {
+        if (placer.IsHub(offsets[v + 1] - offsets[v])) {
+          placed.push_back(v);
+        }
+      }
+      int64_t local_hubs = placed.size(), previous_hubs = 0;
+      MPI_Exscan(&local_hubs, &previous_hubs, 1, MPI_INT64_T, MPI_SUM,
+                 comm_spec_.comm());
+      if (worker_id == 0) {
+        previous_hubs = 0;  // undefined on the first worker
+      }
+      for (size_t k = 0; k < placed.size(); ++k) {
+        fids[placed[k]] = (previous_hubs + k) % fnum;
+      }
+      sync_placements(placed);
+
+      size_t round_size =
+          (owned.size() + kStreamingRounds - 1) / kStreamingRounds;
+      std::vector<fid_t> neighbor_fids;
+      for (int round = 0; round < kStreamingRounds; ++round) {
+        placer.StartRound(sizes, worker_id, worker_num);
+        placed.clear();
+        size_t begin = std::min(owned.size(), round * round_size);
+        size_t end = std::min(owned.size(), begin + round_size);
+        for (size_t i = begin; i < end; ++i) {
+          int64_t v = owned[i];
+          if (fids[v] != fnum) {
+            continue;
+          }
+          neighbor_fids.clear();
+          for (int64_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+            neighbor_fids.push_back(fids[neighbors[k]]);
+          }
+          fids[v] = placer.Place(neighbor_fids.data(), neighbor_fids.size());
+          placed.push_back(v);
+        }
+        sync_placements(placed);
+      }
+
+      owned_fids.reserve(owned.size());
+      for (int64_t v : owned) {
+        owned_fids.emplace(oids[v], fids[v]);
+      }
+    }
+
+    // fetches the placements of the local oids from their owners
+    placements_t placements;
+    {
+      ska::flat_hash_set<oid_t> local_oids(endpoints.begin(), endpoints.end());
+      for (auto const& table : v_tables) {
+        auto column = table->column(id_column);
+        if (!column->type()->Equals(ConvertToArrowType<oid_t>::TypeValue())) {
+          continue;
+        }
+        for (auto const& chunk : column->chunks()) {
+          auto oids = std::dynamic_pointer_cast<oid_array_t>(chunk);
+          for (int64_t k = 0; k < oids->length(); ++k) {
+            local_oids.emplace(oid_t(oids->GetView(k)));
+          }
+        }
+      }
+      std::vector<std::vector<oid_t>> requests_out(worker_num), requests_in;
+      for (auto const& oid : local_oids) {
+        requests_out[owners.GetPartitionId(oid)].push_back(oid);
+      }
+      ska::flat_hash_set<oid_t>().swap(local_oids);
+      AllToAll(requests_out, requests_in, comm_spec_);
+      // the isolated vertices are left to hashing
+      std::vector<std::vector<oid_t>> oids_out(worker_num), oids_in;
+      std::vector<std::vector<fid_t>> fids_out(worker_num), fids_in;
+      for (int i = 0; i < worker_num; ++i) {
+        for (auto const& oid : requests_in[i]) {
+          auto iter = owned_fids.find(oid);
+          if (iter != owned_fids.end()) {
+            oids_out[i].push_back(oid);
+            fids_out[i].push_back(iter->second);
+          }
+        }
+        std::vector<oid_t>().swap(requests_in[i]);
+      }
+      placements_t().swap(owned_fids);
+      AllToAll(oids_out, oids_in, comm_spec_);
+      AllToAll(fids_out, fids_in, comm_spec_);
+      for (int i = 0; i < worker_num; ++i) {
+        for (size_t k = 0; k < oids_in[i].size(); ++k) {
+          placements.emplace(std::move(oids_in[i][k]), fids_in[i][k]);
+        }
+      }
+    }
+
+    // sends the placements of the endpoints to the fragments of the edges,
+    // as the fragments look up both endpoints of the edges they receive
+    {
+      std::vector<std::vector<oid_t>> oids_out(worker_num), oids_in;
+      std::vector<std::vector<fid_t>> fids_out(worker_num), fids_in;
+      for (size_t k = 0; k < endpoints.size(); k += 2) {
+        auto src = placements.find(endpoints[k]);
+        auto dst = placements.find(endpoints[k + 1]);
+        for (auto const& end : {src, dst}) {
+          if (end == placements.end()) {
+            continue;
+          }
+          int worker = comm_spec_.FragToWorker(end->second);
+          if (worker == worker_id) {
+            continue;
+          }
+          for (auto const& item : {src, dst}) {
+            if (item != placements.end()) {
+              oids_out[worker].push_back(item->first);
+              fids_out[worker].push_back(item->second);
+            }
+          }
+        }
+      }
+      std::vector<oid_t>().swap(endpoints);
+      AllToAll(oids_out, oids_in, comm_spec_);
+      AllToAll(fids_out, fids_in, comm_spec_);
+      for (int i = 0; i < worker_num; ++i) {
+        for (size_t k = 0; k < oids_in[i].size(); ++k) {
+          placements.emplace(std::move(oids_in[i][k]), fids_in[i][k]);
+        }
+      }
+    }
+    partitioner_.Init(fnum, std::move(placements));
+    return {};
+  }
+
+  /**
+   * @brief Logs the edge cut and the balance of the fragments, see also
+   * `SetReportPartitionQuality()`.
+   */
+  void reportPartitionQuality(ObjectID frag_id) {
+    auto frag = std::dynamic_pointer_cast<ArrowFragment<OID_T, VID_T>>(
+        client_.GetObject(frag_id));
+    // the local inner vertices, outer vertices, edges and cut edges, where
+    // the edges are counted at the fragment of the sources
+    int64_t local[4] = {0, 0, 0, 0};
+    for (label_id_t v_label = 0; v_label < frag->vertex_label_num();
+         ++v_label) {
+      local[0] += frag->GetInnerVerticesNum(v_label);
+      local[1] += frag->GetOuterVerticesNum(v_label);
+      for (auto& v : frag->InnerVertices(v_label)) {
+        for (label_id_t e_label = 0; e_label < frag->edge_label_num();
+             ++e_label) {
+          if (frag->compact_edges()) {
+            for (auto& e : frag->GetOutgoingCompactAdjList(v, e_label)) {
+              ++local[2];
+              local[3] += frag->IsOuterVertex(e.neighbor());
+            }
+          } else {
+            for (auto& e : frag->GetOutgoingAdjList(v, e_label)) {
+              ++local[2];
+              local[3] += frag->IsOuterVertex(e.neighbor());
+            }
+          }
+        }
+      }
+    }
+    int64_t total[4], max[4];
+    MPI_Allreduce(local, total, 4, MPI_INT64_T, MPI_SUM, comm_spec_.comm());
+    MPI_Allreduce(local, max, 4, MPI_INT64_T, MPI_MAX, comm_spec_.comm());
+    if (comm_spec_.worker_id() == 0) {
+      double fnum = comm_spec_.fnum();
+      double vnum = std::max(total[0], static_cast<int64_t>(1));
+      double enum_ = std::max(total[2], static_cast<int64_t>(1));
+      LOG(INFO) << "Partition quality: edge cut " << total[3] << "/"
+                << total[2] << " (" << 100.0 * total[3] / enum_
+                << "%), outer vertices " << total[1]
+                << ", vertex imbalance (max/avg) " << max[0] * fnum / vnum
+                << ", edge imbalance (max/avg) " << max[2] * fnum / enum_;
+    }
+  }
+
   boost::leaf::result<std::vector<std::shared_ptr<arrow::Table>>>
   loadVertexTables(const std::vector<std::string>& files, int index,
                    int total_parts) {
@@ -561,6 +954,11 @@ class ArrowFragmentLoader {
 
   bool directed_;
   bool generate_eid_;
+  ArrowFragmentLoaderOptions options_;
+
+  PartitionStrategy partition_strategy_ = PartitionStrategy::kHash;
+  double partition_slack_ = 0.1;
+  bool report_partition_quality_ = false;
 
   std::function<void(IIOAdaptor*)> io_deleter_ = [](IIOAdaptor* adaptor) {
     VINEYARD_DISCARD(adaptor->Close());
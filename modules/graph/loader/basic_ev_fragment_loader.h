@@ -16,10 +16,12 @@ limitations under the License.
 #ifndef MODULES_GRAPH_LOADER_BASIC_EV_FRAGMENT_LOADER_H_
 #define MODULES_GRAPH_LOADER_BASIC_EV_FRAGMENT_LOADER_H_
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -28,6 +30,8 @@ limitations under the License.
 #include "graph/fragment/arrow_fragment.h"
 #include "graph/fragment/arrow_fragment_group.h"
 #include "graph/fragment/property_graph_types.h"
+#include "graph/fragment/property_graph_utils.h"
+#include "graph/loader/fragment_loader_utils.h"
 #include "graph/utils/error.h"
 #include "graph/utils/table_shuffler.h"
 #include "graph/utils/table_shuffler_beta.h"
@@ -54,13 +58,17 @@ class BasicEVFragmentLoader {
                                  const grape::CommSpec& comm_spec,
                                  const PARTITIONER_T& partitioner,
                                  bool directed = true, bool retain_oid = false,
-                                 bool generate_eid = false)
+                                 bool generate_eid = false,
+                                 bool compact_edges = false,
+                                 bool reorder_vertices = false)
       : client_(client),
         comm_spec_(comm_spec),
         partitioner_(partitioner),
         directed_(directed),
         retain_oid_(retain_oid),
-        generate_eid_(generate_eid) {}
+        generate_eid_(generate_eid),
+        compact_edges_(compact_edges),
+        reorder_vertices_(reorder_vertices) {}
 
   /**
    * @brief Add a loaded vertex table.
@@ -85,6 +93,42 @@ class BasicEVFragmentLoader {
     return {};
   }
 
+  /**
+   * @brief Count the degrees of vertices in a loaded edge table, which decide
+   * the order of inner vertices when `reorder_vertices` is enabled, see also
+   * Note [Vertex reordering]. The edge tables must be counted before
+   * ConstructVertices().
+   *
+   * @param src_label src vertex label name.
+   * @param dst_label dst vertex label name.
+   * @param edge_table
+   *  | src : OID_T | dst : OID_T | property_1 | ... | property_m |
+   * @return
+   */
+  boost::leaf::result<void> AddVertexDegrees(
+      const std::string& src_label, const std::string& dst_label,
+      std::shared_ptr<arrow::Table> edge_table) {
+    auto count = [this](const std::string& label,
+                        const std::shared_ptr<arrow::ChunkedArray>& column)
+        -> boost::leaf::result<void> {
+      if (!column->type()->Equals(ConvertToArrowType<oid_t>::TypeValue())) {
+        RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                        "OID_T is not same with the src/dst column of edges");
+      }
+      auto& degrees = vertex_degrees_[label];
+      for (auto const& chunk : column->chunks()) {
+        auto oids = std::dynamic_pointer_cast<oid_array_t>(chunk);
+        for (int64_t i = 0; i < oids->length(); ++i) {
+          ++degrees[oid_t(oids->GetView(i))];
+        }
+      }
+      return {};
+    };
+    BOOST_LEAF_CHECK(count(src_label, edge_table->column(src_column)));
+    BOOST_LEAF_CHECK(count(dst_label, edge_table->column(dst_column)));
+    return {};
+  }
+
   /// Set attributes: vertex_label_num_, vm_ptr_, output_vertex_tables_
   ///                 vertex_label_to_index_, vertex_labels_
   boost::leaf::result<void> ConstructVertices(
@@ -123,6 +167,9 @@ class BasicEVFragmentLoader {
         BOOST_LEAF_AUTO(tmp_table,
                         beta::ShufflePropertyVertexTable<partitioner_t>(
                             comm_spec_, partitioner_, vertex_table));
+        if (reorder_vertices_) {
+          BOOST_LEAF_ASSIGN(tmp_table, reorderVertices(v_label, tmp_table));
+        }
 
         auto local_oid_array = std::dynamic_pointer_cast<oid_array_t>(
             tmp_table->column(id_column)->chunk(0));
@@ -430,7 +477,8 @@ class BasicEVFragmentLoader {
 
     BOOST_LEAF_CHECK(frag_builder.Init(
         comm_spec_.fid(), comm_spec_.fnum(), std::move(output_vertex_tables_),
-        std::move(output_edge_tables_), directed_, thread_num));
+        std::move(output_edge_tables_), directed_, thread_num,
+        compact_edges_));
 
     auto frag = std::dynamic_pointer_cast<ArrowFragment<oid_t, vid_t>>(
         frag_builder.Seal(client_));
@@ -481,6 +529,10 @@ class BasicEVFragmentLoader {
         (std::thread::hardware_concurrency() + comm_spec_.local_num() - 1) /
         comm_spec_.local_num();
     std::vector<std::thread> parse_threads(thread_num);
+    // the threads left over by the chunks help to resolve the large chunks
+    int chunk_concurrency =
+        std::max(1, thread_num / static_cast<int>(std::max(
+                                     chunk_num, static_cast<size_t>(1))));
 
     std::atomic<size_t> cur(0);
     std::vector<arrow::Status> statuses(thread_num, arrow::Status::OK());
@@ -504,11 +556,43 @@ class BasicEVFragmentLoader {
                 return;
               }
 
-              for (size_t k = 0; k != size; ++k) {
-                internal_oid_t oid = oid_array->GetView(k);
-                fid_t fid = partitioner_.GetPartitionId(oid_t(oid));
-                if (!vm->GetGid(fid, label_id, oid, builder[k])) {
-                  LOG(ERROR) << "Mapping vertex " << oid << " failed.";
+              // resolves the chunk in a batch, see also Note [Batched
+              // vertex lookups], and the repeated string oids only once,
+              // see also Note [Dictionary-encoded oids]
+              std::vector<internal_oid_t> oids;
+              OidDictionary<oid_t> dictionary;
+              bool encoded = std::is_same<oid_t, std::string>::value &&
+                             dictionary.Encode(*oid_array);
+              if (encoded) {
+                oids.swap(dictionary.values());
+              } else {
+                oids.resize(size);
+                for (size_t k = 0; k != size; ++k) {
+                  oids[k] = oid_array->GetView(k);
+                }
+              }
+              size_t oid_num = oids.size();
+              std::vector<fid_t> fids(oid_num);
+              for (size_t k = 0; k != oid_num; ++k) {
+                fids[k] = partitioner_.GetPartitionId(oid_t(oids[k]));
+              }
+              std::vector<vid_t> gids(encoded ? oid_num : 0);
+              vid_t* gids_out = encoded ? gids.data() : &builder[0];
+              if (oid_num > 0) {
+                std::unique_ptr<bool[]> found(new bool[oid_num]);
+                size_t resolved =
+                    vm->GetGids(fids.data(), label_id, oids.data(), oid_num,
+                                gids_out, found.get(), chunk_concurrency);
+                for (size_t k = 0; resolved != oid_num && k != oid_num; ++k) {
+                  if (!found[k]) {
+                    LOG(ERROR) << "Mapping vertex " << oids[k] << " failed.";
+                  }
+                }
+              }
+              if (encoded) {
+                const int32_t* codes = dictionary.codes().data();
+                for (size_t k = 0; k != size; ++k) {
+                  builder[k] = gids[codes[k]];
                 }
               }
 
@@ -539,6 +623,88 @@ class BasicEVFragmentLoader {
     return std::make_shared<arrow::ChunkedArray>(chunks_out);
   }
 
+  /**
+   * Note [Vertex reordering]
+   *
+   * The local ids of inner vertices follow the rows of the vertex tables after
+   * shuffling, i.e., the order of input files, which rarely reflects how the
+   * vertices are accessed together. With `reorder_vertices` the rows of the
+   * shuffled vertex tables (thus the vertex properties) are sorted by the
+   * descending (in + out) degrees of vertices over all edge labels, keeping
+   * the input order for vertices of the same degree. The hubs, which appear in
+   * most of the adjacency lists, are then packed into the head of the vertex
+   * property arrays and of the per-vertex states of applications.
+   *
+   * The order is decided before the vertex map is built, hence the vertex map
+   * carries the new order of oids, and the edges, which are converted to gids
+   * afterwards, need no remapping.
+   */
+  boost::leaf::result<std::shared_ptr<arrow::Table>> reorderVertices(
+      label_id_t v_label, std::shared_ptr<arrow::Table> vertex_table) {
+    std::shared_ptr<arrow::Table> partial_degree_table;
+    {
+      typename ConvertToArrowType<oid_t>::BuilderType oid_builder;
+      arrow::Int64Builder degree_builder;
+      for (auto const& kv : vertex_degrees_[vertex_labels_[v_label]]) {
+        ARROW_OK_OR_RAISE(oid_builder.Append(kv.first));
+        ARROW_OK_OR_RAISE(degree_builder.Append(kv.second));
+      }
+      vertex_degrees_.erase(vertex_labels_[v_label]);
+      std::shared_ptr<arrow::Array> oid_array, degree_array;
+      ARROW_OK_OR_RAISE(oid_builder.Finish(&oid_array));
+      ARROW_OK_OR_RAISE(degree_builder.Finish(&degree_array));
+      auto schema = arrow::schema(
+          {arrow::field("id", ConvertToArrowType<oid_t>::TypeValue()),
+           arrow::field("degree", arrow::int64())});
+      partial_degree_table =
+          arrow::Table::Make(schema, {oid_array, degree_array});
+    }
+    // the partial degrees are summed up on the owner of the vertices
+    BOOST_LEAF_AUTO(degree_table,
+                    beta::ShufflePropertyVertexTable<partitioner_t>(
+                        comm_spec_, partitioner_, partial_degree_table));
+
+    int64_t row_num = vertex_table->num_rows();
+    if (row_num == 0) {
+      return vertex_table;
+    }
+    // the keys are views of `degree_table`
+    ska::flat_hash_map<internal_oid_t, int64_t> degrees;
+    if (degree_table->num_rows() > 0) {
+      auto oids = std::dynamic_pointer_cast<oid_array_t>(
+          degree_table->column(0)->chunk(0));
+      auto counts = std::dynamic_pointer_cast<arrow::Int64Array>(
+          degree_table->column(1)->chunk(0));
+      for (int64_t i = 0; i < oids->length(); ++i) {
+        degrees[oids->GetView(i)] += counts->Value(i);
+      }
+    }
+    auto oids = std::dynamic_pointer_cast<oid_array_t>(
+        vertex_table->column(id_column)->chunk(0));
+    std::vector<int64_t> vertex_degrees(row_num, 0);
+    for (int64_t i = 0; i < row_num; ++i) {
+      auto iter = degrees.find(oids->GetView(i));
+      if (iter != degrees.end()) {
+        vertex_degrees[i] = iter->second;
+      }
+    }
+    std::vector<int64_t> order;
+    generate_degree_order(vertex_degrees, order);
+
+    std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+    VY_OK_OR_RAISE(TableToRecordBatches(vertex_table, &batches));
+    if (batches.size() != 1) {
+      RETURN_GS_ERROR(ErrorCode::kInvalidValueError,
+                      "The shuffled vertex table is expected to have a "
+                      "single chunk");
+    }
+    std::shared_ptr<arrow::RecordBatch> reordered;
+    beta::SelectRows(batches[0], order, reordered);
+    std::shared_ptr<arrow::Table> table_out;
+    VY_OK_OR_RAISE(RecordBatchesToTable({reordered}, &table_out));
+    return table_out;
+  }
+
   boost::leaf::result<void> initSchema(PropertyGraphSchema& schema) {
     schema.set_fnum(comm_spec_.fnum());
     for (label_id_t v_label = 0; v_label != vertex_label_num_; ++v_label) {
@@ -638,6 +804,11 @@ class BasicEVFragmentLoader {
   bool directed_;
   bool retain_oid_;
   bool generate_eid_;
+  bool compact_edges_;
+  bool reorder_vertices_;
+
+  // partial degrees of vertices, for reordering
+  std::map<std::string, ska::flat_hash_map<oid_t, int64_t>> vertex_degrees_;
 
   std::map<std::string, label_id_t> vertex_label_to_index_;
   std::vector<std::string> vertex_labels_;
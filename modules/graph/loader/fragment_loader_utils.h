@@ -17,6 +17,7 @@ limitations under the License.
 #define MODULES_GRAPH_LOADER_FRAGMENT_LOADER_UTILS_H_
 
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <memory>
 #include <set>
@@ -24,6 +25,8 @@ limitations under the License.
 #include <unordered_set>
 #include <vector>
 
+#include "flat_hash_map/flat_hash_map.hpp"
+
 #include "graph/utils/table_shuffler_beta.h"
 
 namespace vineyard {
@@ -76,6 +79,68 @@ class OidSet {
   std::unordered_set<internal_oid_t> oids;
 };
 
+/**
+ * Note [Dictionary-encoded oids]
+ *
+ * The endpoints of edges repeat: a vertex appears in the src (dst) column of
+ * the edge tables once per outgoing (incoming) edge. Converting the string
+ * oids to gids row by row hashes the same string for the partitioner and
+ * again for the vertex map on every occurrence. `OidDictionary` encodes an
+ * oid array into dense int32 codes over its distinct oids, the conversion
+ * then resolves each distinct oid once and gathers the gids by the codes.
+ *
+ * The encoding still hashes every row once, into a table that is local to
+ * the chunk and much smaller than the vertex map, hence it pays off only when
+ * the oids repeat. `Encode()` gives up and returns false when more than
+ * `max_distinct_ratio` of the first `kSampleSize` rows are distinct, and the
+ * caller falls back to the row by row lookups.
+ */
+template <typename T>
+class OidDictionary {
+  using oid_t = T;
+  using internal_oid_t = typename InternalType<oid_t>::type;
+  using oid_array_t = typename vineyard::ConvertToArrowType<oid_t>::ArrayType;
+
+ public:
+  static constexpr int64_t kSampleSize = 4096;
+
+  bool Encode(const oid_array_t& array, double max_distinct_ratio = 0.5) {
+    int64_t size = array.length();
+    values_.clear();
+    codes_.clear();
+    if (size > std::numeric_limits<int32_t>::max()) {
+      return false;
+    }
+    ska::flat_hash_map<internal_oid_t, int32_t> index;
+    codes_.resize(size);
+    for (int64_t i = 0; i < size; ++i) {
+      int32_t code = static_cast<int32_t>(values_.size());
+      auto ret = index.emplace(array.GetView(i), code);
+      if (ret.second) {
+        values_.push_back(ret.first->first);
+      }
+      codes_[i] = ret.first->second;
+      if (i + 1 == kSampleSize &&
+          values_.size() > max_distinct_ratio * kSampleSize) {
+        values_.clear();
+        codes_.clear();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// The distinct oids, in the order of their first occurrences.
+  std::vector<internal_oid_t>& values() { return values_; }
+
+  /// The code of every row, i.e., the index of its oid in `values()`.
+  const std::vector<int32_t>& codes() const { return codes_; }
+
+ private:
+  std::vector<internal_oid_t> values_;
+  std::vector<int32_t> codes_;
+};
+
 struct InputTable {
   InputTable(const std::string& src_label_, const std::string& dst_label_,
              const std::string& edge_label_,
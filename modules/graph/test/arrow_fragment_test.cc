@@ -15,14 +15,23 @@ limitations under the License.
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "glog/logging.h"
 
 #include "client/client.h"
 
 #include "graph/fragment/arrow_fragment.h"
+#include "graph/fragment/arrow_fragment_delta.h"
+#include "graph/fragment/arrow_fragment_view.h"
 #include "graph/fragment/graph_schema.h"
 #include "graph/loader/arrow_fragment_loader.h"
 
@@ -99,6 +108,468 @@ void traverse_graph(std::shared_ptr<GraphType> graph, const std::string& path) {
   }
 }
 
+void CheckCompactEdges(vineyard::Client& client, vineyard::ObjectID plain_id,
+                       vineyard::ObjectID compact_id) {
+  auto plain_fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(plain_id));
+  auto compact_fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(compact_id));
+  auto locations = plain_fg->FragmentLocations();
+  for (const auto& pair : plain_fg->Fragments()) {
+    if (locations.at(pair.first) != client.instance_id()) {
+      continue;
+    }
+    auto plain =
+        std::dynamic_pointer_cast<GraphType>(client.GetObject(pair.second));
+    auto compact = std::dynamic_pointer_cast<GraphType>(
+        client.GetObject(compact_fg->Fragments().at(pair.first)));
+    CHECK(!plain->compact_edges());
+    CHECK(compact->compact_edges());
+    CHECK_EQ(plain->GetEdgeNum(), compact->GetEdgeNum());
+
+    auto check = [](const GraphType::adj_list_t& expected,
+                    const GraphType::compact_adj_list_t& actual) {
+      CHECK_EQ(expected.Size(), actual.Size());
+      auto iter = expected.begin();
+      for (auto& e : actual) {
+        CHECK_EQ(iter.neighbor().GetValue(), e.neighbor().GetValue());
+        CHECK_EQ(iter.edge_id(), e.edge_id());
+        ++iter;
+      }
+    };
+    auto check_decoded = [](const GraphType::adj_list_t& expected,
+                            const GraphType::adj_list_t& actual) {
+      CHECK_EQ(expected.Size(), actual.Size());
+      auto iter = expected.begin();
+      for (auto& e : actual) {
+        CHECK_EQ(iter.neighbor().GetValue(), e.neighbor().GetValue());
+        CHECK_EQ(iter.edge_id(), e.edge_id());
+        ++iter;
+      }
+    };
+    for (LabelType v_label = 0; v_label != plain->vertex_label_num();
+         ++v_label) {
+      for (auto v : plain->InnerVertices(v_label)) {
+        for (LabelType e_label = 0; e_label != plain->edge_label_num();
+             ++e_label) {
+          check(plain->GetOutgoingAdjList(v, e_label),
+                compact->GetOutgoingCompactAdjList(v, e_label));
+          check(plain->GetIncomingAdjList(v, e_label),
+                compact->GetIncomingCompactAdjList(v, e_label));
+          // the plain lists of compact fragments are decoded on demand
+          check_decoded(plain->GetOutgoingAdjList(v, e_label),
+                        compact->GetOutgoingAdjList(v, e_label));
+          check_decoded(plain->GetIncomingAdjList(v, e_label),
+                        compact->GetIncomingAdjList(v, e_label));
+        }
+      }
+    }
+  }
+  LOG(INFO) << "Passed compact edges test...";
+}
+
+template <typename T>
+void CheckGatheredEdgeData(std::shared_ptr<GraphType> graph,
+                           LabelType e_label, GraphType::prop_id_t prop_id,
+                           const GraphType::vertex_range_t& range,
+                           const std::vector<int64_t>& offsets,
+                           const std::vector<GraphType::eid_t>& eids) {
+  std::vector<T> data(eids.size());
+  graph->GatherEdgeData<T>(e_label, prop_id, eids.data(), eids.size(),
+                           data.data());
+  size_t index = 0;
+  for (auto v : range) {
+    for (auto& e : graph->GetOutgoingAdjList(v, e_label)) {
+      CHECK_EQ(e.get_data<T>(prop_id), data[index++]);
+    }
+  }
+  CHECK_EQ(index, static_cast<size_t>(offsets.back()));
+}
+
+void CheckGatheredEdges(vineyard::Client& client, vineyard::ObjectID plain_id,
+                        vineyard::ObjectID compact_id) {
+  auto plain_fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(plain_id));
+  auto compact_fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(compact_id));
+  auto locations = plain_fg->FragmentLocations();
+  for (const auto& pair : plain_fg->Fragments()) {
+    if (locations.at(pair.first) != client.instance_id()) {
+      continue;
+    }
+    auto plain =
+        std::dynamic_pointer_cast<GraphType>(client.GetObject(pair.second));
+    auto compact = std::dynamic_pointer_cast<GraphType>(
+        client.GetObject(compact_fg->Fragments().at(pair.first)));
+
+    std::vector<int64_t> offsets, compact_offsets;
+    std::vector<GraphType::vid_t> nbrs, compact_nbrs;
+    std::vector<GraphType::eid_t> eids, compact_eids;
+    for (LabelType v_label = 0; v_label != plain->vertex_label_num();
+         ++v_label) {
+      auto range = plain->InnerVertices(v_label);
+      for (LabelType e_label = 0; e_label != plain->edge_label_num();
+           ++e_label) {
+        plain->GatherOutgoingEdges(range, e_label, offsets, nbrs, &eids);
+        compact->GatherOutgoingEdges(range, e_label, compact_offsets,
+                                     compact_nbrs, &compact_eids);
+        CHECK(offsets == compact_offsets);
+        CHECK(nbrs == compact_nbrs);
+        CHECK(eids == compact_eids);
+        int64_t index = 0;
+        for (auto v : range) {
+          CHECK_EQ(offsets[v.GetValue() - range.begin().GetValue()], index);
+          for (auto& e : plain->GetOutgoingAdjList(v, e_label)) {
+            CHECK_EQ(e.neighbor().GetValue(), nbrs[index]);
+            CHECK_EQ(e.edge_id(), eids[index]);
+            ++index;
+          }
+        }
+
+        plain->GatherIncomingEdges(range, e_label, offsets, nbrs, nullptr);
+        compact->GatherIncomingEdges(range, e_label, compact_offsets,
+                                     compact_nbrs, nullptr);
+        CHECK(nbrs == compact_nbrs);
+
+        // the numeric edge properties, gathered by the outgoing eids
+        plain->GatherOutgoingEdges(range, e_label, offsets, nbrs, &eids);
+        auto table = plain->edge_data_table(e_label);
+        for (int prop_id = 0; prop_id < table->num_columns(); ++prop_id) {
+          auto type = table->column(prop_id)->type();
+          if (type->Equals(arrow::int64())) {
+            CheckGatheredEdgeData<int64_t>(plain, e_label, prop_id, range,
+                                           offsets, eids);
+          } else if (type->Equals(arrow::float64())) {
+            CheckGatheredEdgeData<double>(plain, e_label, prop_id, range,
+                                          offsets, eids);
+          }
+        }
+      }
+    }
+  }
+  LOG(INFO) << "Passed gathered edges test...";
+}
+
+void CheckFragmentView(vineyard::Client& client, vineyard::ObjectID group_id) {
+  using ViewType = ArrowFragmentView<property_graph_types::OID_TYPE,
+                                     property_graph_types::VID_TYPE>;
+  auto fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(group_id));
+  auto locations = fg->FragmentLocations();
+  for (const auto& pair : fg->Fragments()) {
+    if (locations.at(pair.first) != client.instance_id()) {
+      continue;
+    }
+    auto frag =
+        std::dynamic_pointer_cast<GraphType>(client.GetObject(pair.second));
+
+    // all labels, with the properties in the reversed order
+    std::map<LabelType, std::vector<LabelType>> vertices, edges;
+    for (LabelType label = 0; label != frag->vertex_label_num(); ++label) {
+      for (int prop = frag->vertex_property_num(label) - 1; prop >= 0;
+           --prop) {
+        vertices[label].push_back(prop);
+      }
+    }
+    for (LabelType label = 0; label != frag->edge_label_num(); ++label) {
+      for (int prop = frag->edge_property_num(label) - 1; prop >= 0; --prop) {
+        edges[label].push_back(prop);
+      }
+    }
+    auto view = ViewType::Project(frag, vertices, edges).value();
+    CHECK_EQ(view->vertex_label_num(), frag->vertex_label_num());
+    CHECK_EQ(view->edge_label_num(), frag->edge_label_num());
+
+    for (LabelType e_label = 0; e_label != view->edge_label_num();
+         ++e_label) {
+      int prop_num = view->edge_property_num(e_label);
+      auto table = view->edge_data_table(e_label);
+      CHECK_EQ(table->num_columns(), prop_num);
+      for (int prop = 0; prop < prop_num; ++prop) {
+        CHECK(table->column(prop)->Equals(
+            frag->edge_data_table(e_label)->column(prop_num - 1 - prop)));
+      }
+    }
+    for (LabelType v_label = 0; v_label != view->vertex_label_num();
+         ++v_label) {
+      int prop_num = view->vertex_property_num(v_label);
+      for (auto v : view->InnerVertices(v_label)) {
+        CHECK_EQ(view->vertex_label(v), v_label);
+        CHECK_EQ(view->GetId(v), frag->GetId(v));
+        for (int prop = 0; prop < prop_num; ++prop) {
+          if (view->vertex_property_type(v_label, prop)->Equals(
+                  arrow::int64())) {
+            CHECK_EQ(view->GetData<int64_t>(v, prop),
+                     frag->GetData<int64_t>(v, prop_num - 1 - prop));
+          }
+        }
+        for (LabelType e_label = 0; e_label != view->edge_label_num();
+             ++e_label) {
+          auto expected = frag->GetOutgoingAdjList(v, e_label);
+          auto actual = view->GetOutgoingAdjList(v, e_label);
+          CHECK_EQ(expected.Size(), actual.Size());
+          int edge_prop_num = view->edge_property_num(e_label);
+          auto iter = expected.begin();
+          for (auto& e : actual) {
+            CHECK_EQ(iter.neighbor().GetValue(), e.neighbor().GetValue());
+            for (int prop = 0; prop < edge_prop_num; ++prop) {
+              if (view->edge_property_type(e_label, prop)->Equals(
+                      arrow::int64())) {
+                CHECK_EQ(e.get_data<int64_t>(prop),
+                         iter.get_data<int64_t>(edge_prop_num - 1 - prop));
+              }
+            }
+            ++iter;
+          }
+        }
+      }
+    }
+
+    // a single label with no properties
+    std::map<LabelType, std::vector<LabelType>> single_vertex{{0, {}}};
+    std::map<LabelType, std::vector<LabelType>> single_edge{{0, {}}};
+    auto single = ViewType::Project(frag, single_vertex, single_edge).value();
+    CHECK_EQ(single->vertex_label_num(), 1);
+    CHECK_EQ(single->vertex_property_num(0), 0);
+    CHECK_EQ(single->schema().vertex_label_num(), 1);
+
+    // invalid labels are rejected
+    std::map<LabelType, std::vector<LabelType>> invalid{
+        {frag->vertex_label_num(), {}}};
+    CHECK(!ViewType::Project(frag, invalid, {}));
+  }
+  LOG(INFO) << "Passed fragment view test...";
+}
+
+void CheckReorderedVertices(vineyard::Client& client,
+                            vineyard::ObjectID plain_id,
+                            vineyard::ObjectID reordered_id) {
+  auto plain_fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(plain_id));
+  auto reordered_fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(reordered_id));
+  auto locations = plain_fg->FragmentLocations();
+  for (const auto& pair : plain_fg->Fragments()) {
+    if (locations.at(pair.first) != client.instance_id()) {
+      continue;
+    }
+    auto plain =
+        std::dynamic_pointer_cast<GraphType>(client.GetObject(pair.second));
+    auto reordered = std::dynamic_pointer_cast<GraphType>(
+        client.GetObject(reordered_fg->Fragments().at(pair.first)));
+    CHECK_EQ(plain->GetEdgeNum(), reordered->GetEdgeNum());
+
+    auto degree = [](const std::shared_ptr<GraphType>& graph,
+                     const GraphType::vertex_t& v) {
+      int64_t degree = 0;
+      for (LabelType e_label = 0; e_label != graph->edge_label_num();
+           ++e_label) {
+        degree += graph->GetLocalOutDegree(v, e_label);
+        if (graph->directed()) {
+          degree += graph->GetLocalInDegree(v, e_label);
+        }
+      }
+      return degree;
+    };
+    for (LabelType v_label = 0; v_label != plain->vertex_label_num();
+         ++v_label) {
+      CHECK_EQ(plain->GetInnerVerticesNum(v_label),
+               reordered->GetInnerVerticesNum(v_label));
+      int64_t last_degree = std::numeric_limits<int64_t>::max();
+      for (auto v : reordered->InnerVertices(v_label)) {
+        GraphType::vertex_t u;
+        CHECK(plain->GetInnerVertex(v_label, reordered->GetId(v), u));
+        int64_t current_degree = degree(reordered, v);
+        CHECK_EQ(degree(plain, u), current_degree);
+        CHECK_LE(current_degree, last_degree);
+        last_degree = current_degree;
+      }
+    }
+  }
+  LOG(INFO) << "Passed reordered vertices test...";
+}
+
+void CheckDeltaEdges(vineyard::Client& client, vineyard::ObjectID group_id) {
+  using vid_t = GraphType::vid_t;
+  using MutableGraphType =
+      MutableArrowFragment<property_graph_types::OID_TYPE, vid_t>;
+
+  auto fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(group_id));
+  auto locations = fg->FragmentLocations();
+  for (const auto& pair : fg->Fragments()) {
+    if (locations.at(pair.first) != client.instance_id()) {
+      continue;
+    }
+    auto frag =
+        std::dynamic_pointer_cast<GraphType>(client.GetObject(pair.second));
+    MutableGraphType mutable_frag(client, frag);
+    mutable_frag.set_compaction_threshold(0);
+
+    // appends the first edges of each label once more
+    std::vector<std::vector<std::pair<vid_t, vid_t>>> appended(
+        frag->edge_label_num());
+    std::map<LabelType, std::shared_ptr<arrow::Table>> edge_tables;
+    for (LabelType e_label = 0; e_label != frag->edge_label_num();
+         ++e_label) {
+      auto table = frag->edge_data_table(e_label);
+      int64_t edge_num = std::min<int64_t>(table->num_rows(), 1024);
+      auto& edges = appended[e_label];
+      edges.resize(edge_num);
+      for (LabelType v_label = 0; v_label != frag->vertex_label_num();
+           ++v_label) {
+        for (auto v : frag->Vertices(v_label)) {
+          for (auto& e : frag->GetOutgoingAdjList(v, e_label)) {
+            if (static_cast<int64_t>(e.edge_id()) < edge_num) {
+              edges[e.edge_id()] = std::make_pair(
+                  frag->Vertex2Gid(v), frag->Vertex2Gid(e.neighbor()));
+            }
+          }
+        }
+      }
+      typename ConvertToArrowType<vid_t>::BuilderType src_builder, dst_builder;
+      for (auto const& edge : edges) {
+        CHECK(src_builder.Append(edge.first).ok());
+        CHECK(dst_builder.Append(edge.second).ok());
+      }
+      std::shared_ptr<arrow::Array> srcs, dsts;
+      CHECK(src_builder.Finish(&srcs).ok());
+      CHECK(dst_builder.Finish(&dsts).ok());
+      table = table->Slice(0, edge_num);
+      table = table->AddColumn(0, arrow::field("src", srcs->type()),
+                               std::make_shared<arrow::ChunkedArray>(srcs))
+                  .ValueOrDie();
+      table = table->AddColumn(1, arrow::field("dst", dsts->type()),
+                               std::make_shared<arrow::ChunkedArray>(dsts))
+                  .ValueOrDie();
+      edge_tables[e_label] = table;
+    }
+    mutable_frag.AddEdges(std::move(edge_tables)).value();
+    CHECK_EQ(mutable_frag.deltas().size(), 1u);
+
+    std::vector<std::vector<size_t>> degrees;
+    for (LabelType v_label = 0; v_label != frag->vertex_label_num();
+         ++v_label) {
+      for (LabelType e_label = 0; e_label != frag->edge_label_num();
+           ++e_label) {
+        int64_t base_edge_num = frag->edge_data_table(e_label)->num_rows();
+        auto& edges = appended[e_label];
+        std::vector<size_t> degree;
+        for (auto v : frag->InnerVertices(v_label)) {
+          auto oe = mutable_frag.GetOutgoingAdjList(v, e_label);
+          CHECK_GE(oe.Size(), frag->GetOutgoingAdjList(v, e_label).Size());
+          for (auto& e : oe) {
+            int64_t eid = e.edge_id();
+            if (eid < base_edge_num) {
+              continue;
+            }
+            auto edge = std::make_pair(mutable_frag.Vertex2Gid(v),
+                                       mutable_frag.Vertex2Gid(e.neighbor()));
+            CHECK(edge == edges[eid - base_edge_num] ||
+                  (!frag->directed() &&
+                   edge == std::make_pair(edges[eid - base_edge_num].second,
+                                          edges[eid - base_edge_num].first)));
+          }
+          degree.push_back(oe.Size());
+        }
+        degrees.push_back(degree);
+      }
+    }
+
+    mutable_frag.Compact().value();
+    CHECK(mutable_frag.deltas().empty());
+    auto compacted = mutable_frag.base();
+    size_t index = 0;
+    for (LabelType v_label = 0; v_label != frag->vertex_label_num();
+         ++v_label) {
+      for (LabelType e_label = 0; e_label != frag->edge_label_num();
+           ++e_label) {
+        CHECK_EQ(compacted->edge_data_table(e_label)->num_rows(),
+                 frag->edge_data_table(e_label)->num_rows() +
+                     static_cast<int64_t>(appended[e_label].size()));
+        auto& degree = degrees[index++];
+        size_t k = 0;
+        for (auto v : compacted->InnerVertices(v_label)) {
+          CHECK_EQ(compacted->GetOutgoingAdjList(v, e_label).Size(),
+                   degree[k++]);
+        }
+      }
+    }
+  }
+  LOG(INFO) << "Passed delta edges test...";
+}
+
+void CheckStreamingPlacement() {
+  // two cliques of 8 vertices, interleaved in the stream
+  const int64_t vnum = 16;
+  std::vector<int64_t> offsets(1, 0), neighbors;
+  for (int64_t v = 0; v < vnum; ++v) {
+    for (int64_t u = v % 2; u < vnum; u += 2) {
+      if (u != v) {
+        neighbors.push_back(u);
+      }
+    }
+    offsets.push_back(neighbors.size());
+  }
+  for (auto strategy : {PartitionStrategy::kLDG, PartitionStrategy::kFennel,
+                        PartitionStrategy::kHybrid}) {
+    std::vector<fid_t> fids;
+    generate_streaming_partition(strategy, 2, offsets, neighbors, 0.1, fids);
+    CHECK_EQ(fids.size(), static_cast<size_t>(vnum));
+    CHECK_NE(fids[0], fids[1]);
+    for (int64_t v = 2; v < vnum; ++v) {
+      CHECK_EQ(fids[v], fids[v % 2]);
+    }
+  }
+  LOG(INFO) << "Passed streaming placement test...";
+}
+
+// sums up the hashes of the vertices and edges (by oids), and the vertices
+void SummarizeFragments(vineyard::Client& client, vineyard::ObjectID group_id,
+                        const grape::CommSpec& comm_spec,
+                        uint64_t summary[3]) {
+  auto fg = std::dynamic_pointer_cast<vineyard::ArrowFragmentGroup>(
+      client.GetObject(group_id));
+  auto locations = fg->FragmentLocations();
+  std::hash<GraphType::oid_t> hasher;
+  uint64_t local[3] = {0, 0, 0};
+  for (const auto& pair : fg->Fragments()) {
+    if (locations.at(pair.first) != client.instance_id()) {
+      continue;
+    }
+    auto frag =
+        std::dynamic_pointer_cast<GraphType>(client.GetObject(pair.second));
+    for (LabelType v_label = 0; v_label != frag->vertex_label_num();
+         ++v_label) {
+      for (auto v : frag->InnerVertices(v_label)) {
+        auto oid = frag->GetId(v);
+        local[0] += hasher(oid);
+        local[2] += 1;
+        for (LabelType e_label = 0; e_label != frag->edge_label_num();
+             ++e_label) {
+          for (auto& e : frag->GetOutgoingAdjList(v, e_label)) {
+            local[1] += hasher(oid) * 31 + hasher(frag->GetId(e.neighbor()));
+          }
+        }
+      }
+    }
+  }
+  MPI_Allreduce(local, summary, 3, MPI_UINT64_T, MPI_SUM, comm_spec.comm());
+}
+
+void CheckStreamingPartition(vineyard::Client& client,
+                             const grape::CommSpec& comm_spec,
+                             vineyard::ObjectID plain_id,
+                             vineyard::ObjectID streamed_id) {
+  uint64_t expected[3], actual[3];
+  SummarizeFragments(client, plain_id, comm_spec, expected);
+  SummarizeFragments(client, streamed_id, comm_spec, actual);
+  CHECK_EQ(expected[0], actual[0]);
+  CHECK_EQ(expected[1], actual[1]);
+  CHECK_EQ(expected[2], actual[2]);
+  LOG(INFO) << "Passed streaming partition test...";
+}
+
 int main(int argc, char** argv) {
   if (argc < 6) {
     printf(
@@ -181,6 +652,46 @@ int main(int argc, char** argv) {
       vineyard::ObjectID fragment_group_id =
           loader->LoadFragmentAsFragmentGroup().value();
       WriteOut(client, comm_spec, fragment_group_id);
+
+      ArrowFragmentLoaderOptions compact_options;
+      compact_options.compact_edges = true;
+      auto compact_loader =
+          std::make_unique<ArrowFragmentLoader<property_graph_types::OID_TYPE,
+                                               property_graph_types::VID_TYPE>>(
+              client, comm_spec, efiles, vfiles, directed != 0, false,
+              compact_options);
+      vineyard::ObjectID compact_group_id =
+          compact_loader->LoadFragmentAsFragmentGroup().value();
+      CheckCompactEdges(client, fragment_group_id, compact_group_id);
+      CheckGatheredEdges(client, fragment_group_id, compact_group_id);
+      CheckDeltaEdges(client, fragment_group_id);
+      CheckFragmentView(client, fragment_group_id);
+
+      ArrowFragmentLoaderOptions reordered_options;
+      reordered_options.reorder_vertices = true;
+      auto reordered_loader =
+          std::make_unique<ArrowFragmentLoader<property_graph_types::OID_TYPE,
+                                               property_graph_types::VID_TYPE>>(
+              client, comm_spec, efiles, vfiles, directed != 0, false,
+              reordered_options);
+      vineyard::ObjectID reordered_group_id =
+          reordered_loader->LoadFragmentAsFragmentGroup().value();
+      CheckReorderedVertices(client, fragment_group_id, reordered_group_id);
+
+      CheckStreamingPlacement();
+      for (auto strategy : {PartitionStrategy::kLDG, PartitionStrategy::kFennel,
+                            PartitionStrategy::kHybrid}) {
+        auto streamed_loader = std::make_unique<
+            ArrowFragmentLoader<property_graph_types::OID_TYPE,
+                                property_graph_types::VID_TYPE>>(
+            client, comm_spec, efiles, vfiles, directed != 0);
+        streamed_loader->SetPartitionStrategy(strategy);
+        streamed_loader->SetReportPartitionQuality(true);
+        vineyard::ObjectID streamed_group_id =
+            streamed_loader->LoadFragmentAsFragmentGroup().value();
+        CheckStreamingPartition(client, comm_spec, fragment_group_id,
+                                streamed_group_id);
+      }
     }
 
     // Load from efiles
@@ -0,0 +1,194 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arrow/api.h"
+#include "glog/logging.h"
+
+#include "grape/grape.h"
+#include "grape/util.h"
+
+#include "client/client.h"
+#include "graph/loader/basic_ev_fragment_loader.h"
+#include "graph/loader/fragment_loader_utils.h"
+#include "graph/utils/partitioner.h"
+#include "graph/vertex_map/arrow_vertex_map.h"
+#include "graph/vertex_map/arrow_vertex_map_builder.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+using oid_t = std::string;
+using vid_t = property_graph_types::VID_TYPE;
+using internal_oid_t = typename InternalType<oid_t>::type;
+using oid_array_t = typename ConvertToArrowType<oid_t>::ArrayType;
+using vid_array_t = typename ConvertToArrowType<vid_t>::ArrayType;
+using vertex_map_t = ArrowVertexMap<internal_oid_t, vid_t>;
+using loader_t = BasicEVFragmentLoader<oid_t, vid_t, HashPartitioner<oid_t>>;
+
+constexpr int64_t kVertexNum = 20000;
+
+std::string Oid(int64_t v) { return "vertex_" + std::to_string(v); }
+
+std::shared_ptr<oid_array_t> MakeOids(const std::vector<int64_t>& vertices) {
+  typename ConvertToArrowType<oid_t>::BuilderType builder;
+  for (auto v : vertices) {
+    CHECK(builder.Append(Oid(v)).ok());
+  }
+  std::shared_ptr<oid_array_t> oids;
+  CHECK(builder.Finish(&oids).ok());
+  return oids;
+}
+
+// `rows` vertices out of the first `distinct` ones, each of them repeated
+std::vector<int64_t> Repeated(int64_t rows, int64_t distinct) {
+  std::vector<int64_t> vertices(rows);
+  for (int64_t i = 0; i < rows; ++i) {
+    vertices[i] = (i * 7919) % distinct;
+  }
+  return vertices;
+}
+
+void CheckEncode(const oid_array_t& oids, bool expected_encoded,
+                 double max_distinct_ratio = 0.5) {
+  OidDictionary<oid_t> dictionary;
+  bool encoded = dictionary.Encode(oids, max_distinct_ratio);
+  CHECK_EQ(encoded, expected_encoded);
+  if (!encoded) {
+    CHECK(dictionary.values().empty());
+    CHECK(dictionary.codes().empty());
+    return;
+  }
+  auto const& values = dictionary.values();
+  auto const& codes = dictionary.codes();
+  CHECK_EQ(codes.size(), static_cast<size_t>(oids.length()));
+  for (int64_t i = 0; i < oids.length(); ++i) {
+    CHECK_LT(static_cast<size_t>(codes[i]), values.size());
+    CHECK_EQ(values[codes[i]], oids.GetView(i));
+  }
+  // the values are distinct, in the order of the first occurrences
+  int32_t next_code = 0;
+  for (int64_t i = 0; i < oids.length(); ++i) {
+    CHECK_LE(codes[i], next_code);
+    if (codes[i] == next_code) {
+      ++next_code;
+    }
+  }
+  CHECK_EQ(static_cast<size_t>(next_code), values.size());
+}
+
+// the gids of the edges agree with the row by row lookups, whether the
+// chunks of the oid columns are dictionary-encoded or not
+void CheckEdgesId2Gid(loader_t& loader, const vertex_map_t& vm,
+                      const HashPartitioner<oid_t>& partitioner,
+                      const std::vector<std::shared_ptr<arrow::Array>>& srcs,
+                      const std::vector<std::shared_ptr<arrow::Array>>& dsts) {
+  auto oid_type = ConvertToArrowType<oid_t>::TypeValue();
+  auto schema = arrow::schema(
+      {arrow::field("src", oid_type), arrow::field("dst", oid_type)});
+  auto table = arrow::Table::Make(
+      schema, {std::make_shared<arrow::ChunkedArray>(srcs),
+               std::make_shared<arrow::ChunkedArray>(dsts)});
+  auto gid_table = loader.edgesId2Gid(table, 0, 0).value();
+
+  for (int column = 0; column < 2; ++column) {
+    auto oids = table->column(column);
+    auto gids = gid_table->column(column);
+    CHECK_EQ(oids->length(), gids->length());
+    CHECK_EQ(oids->num_chunks(), gids->num_chunks());
+    for (int chunk = 0; chunk < oids->num_chunks(); ++chunk) {
+      auto oid_chunk =
+          std::dynamic_pointer_cast<oid_array_t>(oids->chunk(chunk));
+      auto gid_chunk =
+          std::dynamic_pointer_cast<vid_array_t>(gids->chunk(chunk));
+      for (int64_t i = 0; i < oid_chunk->length(); ++i) {
+        internal_oid_t oid = oid_chunk->GetView(i);
+        vid_t gid;
+        CHECK(vm.GetGid(partitioner.GetPartitionId(oid_t(oid)), 0, oid, gid));
+        CHECK_EQ(gid_chunk->Value(i), gid);
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage: ./oid_dictionary_test <ipc_socket>\n");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  auto low = MakeOids(Repeated(3 * OidDictionary<oid_t>::kSampleSize, 100));
+  std::vector<int64_t> all(kVertexNum);
+  for (int64_t i = 0; i < kVertexNum; ++i) {
+    all[i] = (i * 7919) % kVertexNum;
+  }
+  auto high = MakeOids(all);
+  // distinct, but shorter than the sample
+  auto short_high = MakeOids(Repeated(OidDictionary<oid_t>::kSampleSize / 2,
+                                      kVertexNum));
+
+  CheckEncode(*low, true);
+  CheckEncode(*high, false);
+  CheckEncode(*high, true, 1.0);
+  CheckEncode(*short_high, true);
+  CheckEncode(*MakeOids({}), true);
+  LOG(INFO) << "Passed oid dictionary encoding test...";
+
+  grape::InitMPIComm();
+  {
+    grape::CommSpec comm_spec;
+    comm_spec.Init(MPI_COMM_WORLD);
+    CHECK_EQ(comm_spec.fnum(), 1u);
+
+    Client client;
+    VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+    LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+    std::vector<int64_t> vertices(kVertexNum);
+    for (int64_t i = 0; i < kVertexNum; ++i) {
+      vertices[i] = i;
+    }
+    std::vector<std::vector<std::shared_ptr<oid_array_t>>> oid_lists{
+        {MakeOids(vertices)}};
+    BasicArrowVertexMapBuilder<internal_oid_t, vid_t> vm_builder(client, 1, 1,
+                                                                 oid_lists);
+    auto vm = std::dynamic_pointer_cast<vertex_map_t>(vm_builder.Seal(client));
+
+    HashPartitioner<oid_t> partitioner;
+    partitioner.Init(comm_spec.fnum());
+    loader_t loader(client, comm_spec, partitioner);
+    loader.set_vm_ptr(vm);
+
+    // the low cardinality and the short columns, which are encoded
+    CheckEdgesId2Gid(loader, *vm, partitioner, {low, low}, {low, short_high});
+    // high cardinality columns, which fall back to the row by row lookups
+    CheckEdgesId2Gid(loader, *vm, partitioner, {high}, {high});
+    // encoded and not encoded chunks in the same column
+    CheckEdgesId2Gid(loader, *vm, partitioner, {low, high}, {high, low});
+    LOG(INFO) << "Passed edges id to gid test...";
+
+    VINEYARD_CHECK_OK(client.DelData(vm->id(), true, true));
+    client.Disconnect();
+  }
+  grape::FinalizeMPIComm();
+
+  LOG(INFO) << "Passed oid dictionary tests...";
+  return 0;
+}
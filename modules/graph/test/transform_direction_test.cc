@@ -0,0 +1,133 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "arrow/api.h"
+#include "glog/logging.h"
+
+#include "graph/fragment/property_graph_types.h"
+#include "graph/fragment/property_graph_utils.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+using vid_t = property_graph_types::VID_TYPE;
+using eid_t = property_graph_types::EID_TYPE;
+using vid_array_t = typename ConvertToArrowType<vid_t>::ArrayType;
+using nbr_unit_t = property_graph_utils::NbrUnit<vid_t, eid_t>;
+
+// (label, offset) of a vertex
+using vertex_t = std::pair<int, int64_t>;
+
+namespace {
+
+std::shared_ptr<vid_array_t> MakeIds(const IdParser<vid_t>& parser,
+                                     const std::vector<vertex_t>& vertices) {
+  typename ConvertToArrowType<vid_t>::BuilderType builder;
+  for (auto const& v : vertices) {
+    CHECK(builder.Append(parser.GenerateId(0, v.first, v.second)).ok());
+  }
+  std::shared_ptr<vid_array_t> ids;
+  CHECK(builder.Finish(&ids).ok());
+  return ids;
+}
+
+const nbr_unit_t* Units(const std::shared_ptr<arrow::FixedSizeBinaryArray>& a) {
+  return reinterpret_cast<const nbr_unit_t*>(a->GetValue(0));
+}
+
+// merges the directed lists of the edges as `TransformDirection()` does and
+// compares the result with the undirected lists generated from the same edges
+void CheckTransform(const std::vector<vid_t>& tvnums,
+                    const std::vector<vertex_t>& srcs,
+                    const std::vector<vertex_t>& dsts,
+                    bool expected_is_multigraph) {
+  int vertex_label_num = static_cast<int>(tvnums.size());
+  IdParser<vid_t> parser;
+  parser.Init(1, vertex_label_num);
+  auto src_list = MakeIds(parser, srcs);
+  auto dst_list = MakeIds(parser, dsts);
+
+  std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>> oe, ie, expected;
+  std::vector<std::shared_ptr<arrow::Int64Array>> oe_offsets, ie_offsets,
+      expected_offsets;
+  bool directed_is_multigraph = false;
+  generate_directed_csr<vid_t, eid_t>(parser, src_list, dst_list, tvnums,
+                                      vertex_label_num, 1, oe, oe_offsets,
+                                      directed_is_multigraph)
+      .value();
+  generate_directed_csr<vid_t, eid_t>(parser, dst_list, src_list, tvnums,
+                                      vertex_label_num, 1, ie, ie_offsets,
+                                      directed_is_multigraph)
+      .value();
+  bool is_multigraph = false;
+  generate_undirected_csr<vid_t, eid_t>(parser, src_list, dst_list, tvnums,
+                                        vertex_label_num, 1, expected,
+                                        expected_offsets, is_multigraph)
+      .value();
+  CHECK_EQ(is_multigraph, expected_is_multigraph);
+
+  std::vector<const nbr_unit_t*> ies, oes;
+  std::vector<const int64_t*> ie_offsets_ptrs, oe_offsets_ptrs;
+  for (int i = 0; i < vertex_label_num; ++i) {
+    ies.push_back(Units(ie[i]));
+    oes.push_back(Units(oe[i]));
+    ie_offsets_ptrs.push_back(ie_offsets[i]->raw_values());
+    oe_offsets_ptrs.push_back(oe_offsets[i]->raw_values());
+  }
+  for (int concurrency : {1, 3}) {
+    std::vector<std::shared_ptr<arrow::FixedSizeBinaryArray>> merged;
+    std::vector<std::shared_ptr<arrow::Int64Array>> merged_offsets;
+    // starts from the flag of the directed fragment, as TransformDirection
+    bool merged_is_multigraph = directed_is_multigraph;
+    merge_directed_csr<vid_t, eid_t>(ies, ie_offsets_ptrs, oes,
+                                     oe_offsets_ptrs, tvnums, concurrency,
+                                     merged, merged_offsets,
+                                     merged_is_multigraph)
+        .value();
+    CHECK_EQ(merged.size(), tvnums.size());
+    for (int i = 0; i < vertex_label_num; ++i) {
+      CHECK(expected_offsets[i]->Equals(merged_offsets[i]));
+      CHECK(expected[i]->Equals(merged[i]));
+    }
+    CHECK_EQ(merged_is_multigraph, expected_is_multigraph);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<vid_t> tvnums{4, 3};
+
+  // a simple graph over two vertex labels, with an isolated vertex (0, 3)
+  CheckTransform(tvnums, {{0, 0}, {0, 0}, {0, 1}, {1, 0}, {1, 2}},
+                 {{0, 1}, {1, 1}, {0, 2}, {0, 2}, {0, 0}}, false);
+  LOG(INFO) << "Passed simple graph transform direction test...";
+
+  // edges in both directions become parallel edges once undirected
+  CheckTransform(tvnums, {{0, 0}, {0, 1}, {1, 0}},
+                 {{0, 1}, {0, 0}, {1, 2}}, true);
+  LOG(INFO) << "Passed reciprocal edges transform direction test...";
+
+  // a directed multigraph, including a parallel self loop
+  CheckTransform(tvnums, {{0, 0}, {0, 0}, {0, 2}, {1, 1}, {1, 1}, {0, 3}},
+                 {{1, 0}, {1, 0}, {0, 1}, {1, 1}, {1, 1}, {0, 0}}, true);
+  LOG(INFO) << "Passed multigraph transform direction test...";
+
+  LOG(INFO) << "Passed transform direction tests...";
+  return 0;
+}
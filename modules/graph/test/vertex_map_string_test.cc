@@ -141,11 +141,40 @@ int main(int argc, char** argv) {
         uint64_t gid = id_parser.GenerateId(i, j, k);
         arrow::util::string_view oid;
         CHECK(vm_ptr->GetOid(gid, oid));
+        uint64_t actual_gid;
+        CHECK(vm_ptr->GetGid(i, j, oid, actual_gid));
+        CHECK_EQ(gid, actual_gid);
 
         fout << oid << std::endl;
       }
 
       fout.close();
+
+      uint64_t gid;
+      CHECK(!vm_ptr->GetGid(i, j, "__not_a_vertex__", gid));
+
+      // the batched lookups agree with the single ones
+      std::vector<uint64_t> gids(vnum), batch_gids(vnum + 1);
+      std::vector<arrow::util::string_view> oids(vnum + 1);
+      std::unique_ptr<bool[]> found(new bool[vnum + 1]);
+      for (uint64_t k = 0; k < vnum; ++k) {
+        gids[k] = id_parser.GenerateId(i, j, k);
+      }
+      CHECK_EQ(vm_ptr->GetOids(gids.data(), vnum, oids.data(), found.get()),
+               vnum);
+      oids[vnum] = "__not_a_vertex__";
+      CHECK_EQ(vm_ptr->GetGids(i, j, oids.data(), vnum + 1, batch_gids.data(),
+                               found.get()),
+               vnum);
+      CHECK(!found[vnum]);
+      for (uint64_t k = 0; k < vnum; ++k) {
+        CHECK(found[k]);
+        CHECK_EQ(batch_gids[k], gids[k]);
+      }
+      CHECK_EQ(vm_ptr->GetGids(j, oids.data(), vnum, batch_gids.data()), vnum);
+      for (uint64_t k = 0; k < vnum; ++k) {
+        CHECK_EQ(batch_gids[k], gids[k]);
+      }
     }
   }
 
@@ -18,8 +18,11 @@ limitations under the License.
 
 #include <algorithm>
 #include <limits>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "grape/communication/sync_comm.h"
 #include "grape/serialization/in_archive.h"
 #include "grape/serialization/out_archive.h"
 #include "grape/worker/comm_spec.h"
@@ -106,6 +109,38 @@ static void _GatherL(const T& object, int root, MPI_Comm comm) {
               root, comm);
 }
 
+/**
+ * @brief Exchanges the objects between all workers, where `out[i]` is sent to
+ * the worker `i` and `in[i]` is received from the worker `i`. The objects are
+ * sent as archives by `grape::sync_comm`, thus are not limited by the `int`
+ * counts of MPI.
+ */
+template <class T>
+static void AllToAll(std::vector<T>& out, std::vector<T>& in,
+                     const grape::CommSpec& comm_spec) {
+  int worker_num = comm_spec.worker_num();
+  int worker_id = comm_spec.worker_id();
+  in.clear();
+  in.resize(worker_num);
+  std::thread send_thread([&]() {
+    for (int i = 1; i < worker_num; ++i) {
+      int dst_worker_id = (worker_id + worker_num - i) % worker_num;
+      grape::InArchive ia;
+      ia << out[dst_worker_id];
+      T().swap(out[dst_worker_id]);
+      grape::sync_comm::Send(ia, dst_worker_id, 0, comm_spec.comm());
+    }
+  });
+  for (int i = 1; i < worker_num; ++i) {
+    int src_worker_id = (worker_id + i) % worker_num;
+    grape::OutArchive oa;
+    grape::sync_comm::Recv(oa, src_worker_id, 0, comm_spec.comm());
+    oa >> in[src_worker_id];
+  }
+  send_thread.join();
+  in[worker_id] = std::move(out[worker_id]);
+}
+
 }  // namespace vineyard
 
 #endif  // MODULES_GRAPH_UTILS_MPI_UTILS_H_
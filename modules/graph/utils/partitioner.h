@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef MODULES_GRAPH_UTILS_PARTITIONER_H_
 #define MODULES_GRAPH_UTILS_PARTITIONER_H_
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -142,6 +145,234 @@ class SegmentedPartitioner {
   ska::flat_hash_map<OID_T, fid_t> o2f_;
 };
 
+/**
+ * Note [Streaming graph partitioning]
+ *
+ * Hashing the oids cuts most of the edges of power-law graphs, which blows up
+ * the outer vertices of fragments and the messages between them. The
+ * streaming partitioners visit the vertices once, in the order given, and
+ * place each vertex into the fragment that holds most of its already placed
+ * neighbors, weighted by a penalty on the size of the fragment:
+ *
+ * - LDG (linear deterministic greedy) scores the fragment `i` by
+ *   `|N(v) & P_i| * (1 - |P_i| / C)`, and
+ * - Fennel scores it by `|N(v) & P_i| - alpha * gamma * |P_i|^(gamma - 1)`,
+ *   where `gamma = 1.5` and `alpha = sqrt(fnum) * m / n^1.5`,
+ *
+ * where `C = (1 + slack) * n / fnum` is the capacity of a fragment, and the
+ * full fragments are skipped. The ties go to the smaller fragment.
+ *
+ * The hybrid strategy is degree-aware: the vertices with a degree of more
+ * than `kHubDegreeFactor` times of the average degree are spread round-robin
+ * first, as their edges would be cut by any placement, and the remaining
+ * vertices are streamed by Fennel, counting the hubs as placed neighbors.
+ * Fragments are edge-cut, hence the edges of the hubs are not split like in
+ * vertex-cut partitioners, but the hubs no longer drag their neighbors into a
+ * single fragment.
+ *
+ * When loading fragments, the stream is split over the workers: every vertex
+ * is owned by a worker (by hashing), which receives the edges of the vertex
+ * and places it. The owners stream their vertices in a few rounds, and
+ * exchange the placements with the owners of the neighbors and the sizes of
+ * the fragments between the rounds. In each round a worker may fill its share
+ * of the room left in the fragments, thus the fragments exceed the capacity
+ * by at most `worker_num` vertices, when some worker runs out of its shares.
+ */
+enum class PartitionStrategy { kHash, kLDG, kFennel, kHybrid };
+
+/**
+ * @brief Places the streamed vertices into fragments, see also Note
+ * [Streaming graph partitioning].
+ */
+class StreamingPlacer {
+ public:
+  StreamingPlacer(PartitionStrategy strategy, fid_t fnum, int64_t vnum,
+                  int64_t edge_num, double slack)
+      : strategy_(strategy),
+        fnum_(fnum),
+        sizes_(fnum, 0),
+        budgets_(fnum, 0),
+        counts_(fnum, 0) {
+    vnum = std::max(vnum, static_cast<int64_t>(1));
+    capacity_ = static_cast<int64_t>(
+        std::ceil(std::max(std::ceil(static_cast<double>(vnum) / fnum),
+                           (1 + slack) * vnum / fnum)));
+    alpha_ = std::sqrt(static_cast<double>(fnum)) * edge_num /
+             std::pow(static_cast<double>(vnum), kGamma);
+    hub_degree_ = kHubDegreeFactor *
+                  std::max(2 * edge_num / vnum, static_cast<int64_t>(1));
+  }
+
+  int64_t capacity() const { return capacity_; }
+
+  bool IsHub(int64_t degree) const {
+    return strategy_ == PartitionStrategy::kHybrid && degree > hub_degree_;
+  }
+
+  /**
+   * @brief Starts a round with the (global) sizes of the fragments, where the
+   * worker may fill its share of the room left in each fragment.
+   */
+  void StartRound(const std::vector<int64_t>& sizes, int worker_id,
+                  int worker_num) {
+    sizes_ = sizes;
+    for (fid_t fid = 0; fid < fnum_; ++fid) {
+      int64_t room = std::max(capacity_ - sizes_[fid], static_cast<int64_t>(0));
+      budgets_[fid] = room / worker_num + (worker_id < room % worker_num);
+    }
+  }
+
+  void Assign(fid_t fid) {
+    ++sizes_[fid];
+    if (budgets_[fid] > 0) {
+      --budgets_[fid];
+    }
+  }
+
+  /**
+   * @brief Places the vertex, given the fragments of its placed neighbors,
+   * where the unplaced neighbors (i.e., `fnum`) are ignored.
+   */
+  fid_t Place(const fid_t* neighbors, size_t neighbor_num) {
+    for (size_t k = 0; k < neighbor_num; ++k) {
+      fid_t fid = neighbors[k];
+      if (fid < fnum_ && counts_[fid]++ == 0) {
+        touched_.push_back(fid);
+      }
+    }
+    fid_t best = fnum_;
+    double best_score = 0;
+    for (fid_t fid = 0; fid < fnum_; ++fid) {
+      if (budgets_[fid] <= 0) {
+        continue;
+      }
+      double score = 0;
+      if (strategy_ == PartitionStrategy::kLDG) {
+        score = counts_[fid] *
+                (1 - static_cast<double>(sizes_[fid]) / capacity_);
+      } else {
+        score = counts_[fid] -
+                alpha_ * kGamma *
+                    std::pow(static_cast<double>(sizes_[fid]), kGamma - 1);
+      }
+      if (best == fnum_ || score > best_score ||
+          (score == best_score && sizes_[fid] < sizes_[best])) {
+        best = fid;
+        best_score = score;
+      }
+    }
+    if (best == fnum_) {
+      // no share left in this round, goes to the smallest fragment
+      best = static_cast<fid_t>(
+          std::min_element(sizes_.begin(), sizes_.end()) - sizes_.begin());
+    }
+    for (fid_t fid : touched_) {
+      counts_[fid] = 0;
+    }
+    touched_.clear();
+    Assign(best);
+    return best;
+  }
+
+ private:
+  static constexpr int64_t kHubDegreeFactor = 16;
+  static constexpr double kGamma = 1.5;
+
+  PartitionStrategy strategy_;
+  fid_t fnum_;
+  int64_t capacity_;
+  double alpha_;
+  int64_t hub_degree_;
+
+  std::vector<int64_t> sizes_, budgets_;
+  std::vector<int64_t> counts_;
+  std::vector<fid_t> touched_;
+};
+
+/**
+ * @brief Places the vertices `[0, n)` of the undirected graph, where the
+ * neighbors of `v` are `neighbors[offsets[v], offsets[v + 1])`, into `fnum`
+ * fragments in a single stream, see also Note [Streaming graph partitioning].
+ */
+inline void generate_streaming_partition(PartitionStrategy strategy,
+                                         fid_t fnum,
+                                         const std::vector<int64_t>& offsets,
+                                         const std::vector<int64_t>& neighbors,
+                                         double slack,
+                                         std::vector<fid_t>& fids) {
+  int64_t vnum = static_cast<int64_t>(offsets.size()) - 1;
+  fids.assign(std::max(vnum, static_cast<int64_t>(0)), fnum);
+  if (vnum <= 0) {
+    return;
+  }
+  StreamingPlacer placer(strategy, fnum, vnum, neighbors.size() / 2, slack);
+  placer.StartRound(std::vector<int64_t>(fnum, 0), 0, 1);
+
+  fid_t next = 0;
+  for (int64_t v = 0; v < vnum; ++v) {
+    if (placer.IsHub(offsets[v + 1] - offsets[v])) {
+      fids[v] = next;
+      placer.Assign(next);
+      next = (next + 1) % fnum;
+    }
+  }
+  std::vector<fid_t> placed;
+  for (int64_t v = 0; v < vnum; ++v) {
+    if (fids[v] != fnum) {
+      continue;
+    }
+    placed.clear();
+    for (int64_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+      placed.push_back(fids[neighbors[k]]);
+    }
+    fids[v] = placer.Place(placed.data(), placed.size());
+  }
+}
+
+/**
+ * @brief Places the oids as given by a streaming partitioner, see also Note
+ * [Streaming graph partitioning], and the oids that were not placed (e.g.,
+ * the isolated vertices, or when no placements are given) by hashing.
+ *
+ * The placements are expected to cover the oids that will be looked up on
+ * this worker, rather than all oids.
+ */
+template <typename OID_T>
+class StreamingPartitioner {
+ public:
+  using oid_t = OID_T;
+  using placements_t = ska::flat_hash_map<OID_T, fid_t>;
+
+  StreamingPartitioner() : fnum_(1) {}
+
+  void Init(fid_t fnum) {
+    fnum_ = fnum;
+    hash_partitioner_.Init(fnum);
+    placements_.reset();
+  }
+
+  void Init(fid_t fnum, placements_t&& placements) {
+    Init(fnum);
+    placements_ = std::make_shared<const placements_t>(std::move(placements));
+  }
+
+  inline fid_t GetPartitionId(const OID_T& oid) const {
+    if (placements_ != nullptr) {
+      auto iter = placements_->find(oid);
+      if (iter != placements_->end()) {
+        return iter->second;
+      }
+    }
+    return hash_partitioner_.GetPartitionId(oid);
+  }
+
+ private:
+  fid_t fnum_;
+  HashPartitioner<OID_T> hash_partitioner_;
+  // shared by the copies of the partitioner
+  std::shared_ptr<const placements_t> placements_;
+};
+
 }  // namespace vineyard
 
 #endif  // MODULES_GRAPH_UTILS_PARTITIONER_H_
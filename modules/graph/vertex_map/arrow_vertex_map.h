@@ -21,6 +21,7 @@ limitations under the License.
 #include <map>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <string>
 #include <thread>
 #include <vector>
@@ -33,6 +34,7 @@ limitations under the License.
 #include "common/util/typename.h"
 
 #include "graph/fragment/property_graph_types.h"
+#include "graph/vertex_map/string_hash_index.h"
 
 namespace gs {
 
@@ -43,6 +45,141 @@ class ArrowProjectedVertexMap;
 
 namespace vineyard {
 
+/**
+ * Note [Batched vertex lookups]
+ *
+ * `GetGids()` and `GetOids()` of the vertex maps resolve a batch of ids at
+ * once. Looking up the ids one by one spends most of the time on the cache
+ * misses of the hash table probes (or the oid arrays), hence the batched
+ * lookups prefetch the first probe of the id `kLookupPrefetchDistance`
+ * positions ahead of the one being resolved, so that the misses of a window
+ * of ids overlap. The batches of at least `kParallelLookupThreshold` ids are
+ * further split into `concurrency` ranges that are resolved in parallel.
+ *
+ * The results are written into the caller's buffers: `gids[i]` (`oids[i]`)
+ * is left untouched and `found[i]` is false if the i-th id is absent, and
+ * `found` can be nullptr when the caller knows all ids exist. The lookups
+ * return the number of resolved ids.
+ */
+namespace vertex_map_impl {
+
+static constexpr size_t kLookupPrefetchDistance = 16;
+static constexpr size_t kParallelLookupThreshold = 1 << 16;
+
+// runs `func(begin, end)` over the ranges of `[0, size)` and sums the results
+template <typename FUNC_T>
+size_t parallel_lookup(size_t size, int concurrency, const FUNC_T& func) {
+  if (concurrency <= 1 || size < kParallelLookupThreshold) {
+    return func(0, size);
+  }
+  size_t chunk = (size + concurrency - 1) / concurrency;
+  std::vector<size_t> resolved(concurrency, 0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < concurrency; ++i) {
+    threads.emplace_back([&func, &resolved, chunk, size, i]() {
+      size_t begin = std::min(chunk * i, size);
+      size_t end = std::min(begin + chunk, size);
+      resolved[i] = func(begin, end);
+    });
+  }
+  for (auto& thrd : threads) {
+    thrd.join();
+  }
+  return std::accumulate(resolved.begin(), resolved.end(),
+                         static_cast<size_t>(0));
+}
+
+// `fid_of(i)` gives the fragment that the i-th oid belongs to
+template <typename VERTEX_MAP_T, typename FID_FN_T, typename OID_T,
+          typename VID_T>
+size_t get_gids(const VERTEX_MAP_T& vm, const FID_FN_T& fid_of,
+                property_graph_types::LABEL_ID_TYPE label_id,
+                const OID_T* oids, size_t size, VID_T* gids, bool* found,
+                int concurrency) {
+  return parallel_lookup(size, concurrency, [&](size_t begin, size_t end) {
+    size_t resolved = 0;
+    size_t ahead = std::min(begin + kLookupPrefetchDistance, end);
+    for (size_t i = begin; i < ahead; ++i) {
+      vm.PrefetchGid(fid_of(i), label_id, oids[i]);
+    }
+    for (size_t i = begin; i < end; ++i, ++ahead) {
+      if (ahead < end) {
+        vm.PrefetchGid(fid_of(ahead), label_id, oids[ahead]);
+      }
+      bool hit = vm.GetGid(fid_of(i), label_id, oids[i], gids[i]);
+      resolved += hit;
+      if (found != nullptr) {
+        found[i] = hit;
+      }
+    }
+    return resolved;
+  });
+}
+
+// tries the fragments one by one, on the oids that are still absent
+template <typename VERTEX_MAP_T, typename OID_T, typename VID_T>
+size_t get_gids_in_fragments(const VERTEX_MAP_T& vm, fid_t fnum,
+                             property_graph_types::LABEL_ID_TYPE label_id,
+                             const OID_T* oids, size_t size, VID_T* gids,
+                             bool* found, int concurrency) {
+  if (found != nullptr) {
+    std::fill(found, found + size, false);
+  }
+  std::vector<size_t> pending(size);
+  std::iota(pending.begin(), pending.end(), 0);
+  std::vector<OID_T> pending_oids(oids, oids + size);
+  std::vector<VID_T> pending_gids(size);
+  std::unique_ptr<bool[]> hits(new bool[size]);
+  size_t resolved = 0;
+  for (fid_t fid = 0; fid < fnum && !pending.empty(); ++fid) {
+    size_t num = pending.size();
+    resolved += get_gids(
+        vm, [fid](size_t) { return fid; }, label_id, pending_oids.data(), num,
+        pending_gids.data(), hits.get(), concurrency);
+    size_t remaining = 0;
+    for (size_t k = 0; k < num; ++k) {
+      if (hits[k]) {
+        gids[pending[k]] = pending_gids[k];
+        if (found != nullptr) {
+          found[pending[k]] = true;
+        }
+      } else {
+        pending[remaining] = pending[k];
+        pending_oids[remaining] = pending_oids[k];
+        ++remaining;
+      }
+    }
+    pending.resize(remaining);
+    pending_oids.resize(remaining);
+  }
+  return resolved;
+}
+
+template <typename VERTEX_MAP_T, typename OID_T, typename VID_T>
+size_t get_oids(const VERTEX_MAP_T& vm, const VID_T* gids, size_t size,
+                OID_T* oids, bool* found, int concurrency) {
+  return parallel_lookup(size, concurrency, [&](size_t begin, size_t end) {
+    size_t resolved = 0;
+    size_t ahead = std::min(begin + kLookupPrefetchDistance, end);
+    for (size_t i = begin; i < ahead; ++i) {
+      vm.PrefetchOid(gids[i]);
+    }
+    for (size_t i = begin; i < end; ++i, ++ahead) {
+      if (ahead < end) {
+        vm.PrefetchOid(gids[ahead]);
+      }
+      bool hit = vm.GetOid(gids[i], oids[i]);
+      resolved += hit;
+      if (found != nullptr) {
+        found[i] = hit;
+      }
+    }
+    return resolved;
+  });
+}
+
+}  // namespace vertex_map_impl
+
 template <typename OID_T, typename VID_T>
 class ArrowVertexMapBuilder;
 
@@ -104,6 +241,28 @@ class ArrowVertexMap
     return false;
   }
 
+  /**
+   * @brief Hints that the gid of the oid will be looked up shortly.
+   */
+  void PrefetchGid(fid_t fid, label_id_t label_id, const oid_t& oid) const {
+    o2g_[fid][label_id].prefetch(oid);
+  }
+
+  /**
+   * @brief Hints that the oid of the gid will be looked up shortly.
+   */
+  void PrefetchOid(vid_t gid) const {
+    fid_t fid = id_parser_.GetFid(gid);
+    label_id_t label = id_parser_.GetLabelId(gid);
+    int64_t offset = id_parser_.GetOffset(gid);
+    if (fid < fnum_ && label < label_num_ && label >= 0) {
+      auto const& array = oid_arrays_[fid][label];
+      if (offset < array->length()) {
+        __builtin_prefetch(array->raw_values() + offset);
+      }
+    }
+  }
+
   bool GetGid(fid_t fid, label_id_t label_id, oid_t oid, vid_t& gid) const {
     auto iter = o2g_[fid][label_id].find(oid);
     if (iter != o2g_[fid][label_id].end()) {
@@ -122,6 +281,49 @@ class ArrowVertexMap
     return false;
   }
 
+  /**
+   * @brief Resolves the gids of a batch of oids in the fragment `fid`, see
+   * also Note [Batched vertex lookups].
+   */
+  size_t GetGids(fid_t fid, label_id_t label_id, const oid_t* oids,
+                 size_t size, vid_t* gids, bool* found = nullptr,
+                 int concurrency = 1) const {
+    return vertex_map_impl::get_gids(
+        *this, [fid](size_t) { return fid; }, label_id, oids, size, gids,
+        found, concurrency);
+  }
+
+  /**
+   * @brief Resolves the gids of a batch of oids, where the i-th oid belongs
+   * to the fragment `fids[i]`.
+   */
+  size_t GetGids(const fid_t* fids, label_id_t label_id, const oid_t* oids,
+                 size_t size, vid_t* gids, bool* found = nullptr,
+                 int concurrency = 1) const {
+    return vertex_map_impl::get_gids(
+        *this, [fids](size_t i) { return fids[i]; }, label_id, oids, size,
+        gids, found, concurrency);
+  }
+
+  /**
+   * @brief Resolves the gids of a batch of oids in any fragment.
+   */
+  size_t GetGids(label_id_t label_id, const oid_t* oids, size_t size,
+                 vid_t* gids, bool* found = nullptr,
+                 int concurrency = 1) const {
+    return vertex_map_impl::get_gids_in_fragments(
+        *this, fnum_, label_id, oids, size, gids, found, concurrency);
+  }
+
+  /**
+   * @brief Resolves the oids of a batch of gids.
+   */
+  size_t GetOids(const vid_t* gids, size_t size, oid_t* oids,
+                 bool* found = nullptr, int concurrency = 1) const {
+    return vertex_map_impl::get_oids(*this, gids, size, oids, found,
+                                     concurrency);
+  }
+
   std::vector<oid_t> GetOids(fid_t fid, label_id_t label_id) {
     auto array = oid_arrays_[fid][label_id];
     std::vector<oid_t> oids;
@@ -225,13 +427,23 @@ class ArrowVertexMap<arrow::util::string_view, VID_T>
     id_parser_.Init(fnum_, label_num_);
 
     oid_arrays_.resize(fnum_);
+    o2g_index_.resize(fnum_);
     for (fid_t i = 0; i < fnum_; ++i) {
       oid_arrays_[i].resize(label_num_);
+      o2g_index_[i].resize(label_num_);
       for (label_id_t j = 0; j < label_num_; ++j) {
+        std::string suffix = std::to_string(i) + "_" + std::to_string(j);
         typename InternalType<oid_t>::vineyard_array_type array;
-        array.Construct(meta.GetMemberMeta("oid_arrays_" + std::to_string(i) +
-                                           "_" + std::to_string(j)));
+        array.Construct(meta.GetMemberMeta("oid_arrays_" + suffix));
         oid_arrays_[i][j] = array.GetArray();
+
+        // the vertex maps sealed without the index fall back to hashmaps
+        if (meta.Haskey("o2g_index_" + suffix)) {
+          NumericArray<uint64_t> index;
+          index.Construct(meta.GetMemberMeta("o2g_index_" + suffix));
+          o2g_index_[i][j] =
+              StringHashIndex(oid_arrays_[i][j], index.GetArray());
+        }
       }
     }
 
@@ -252,7 +464,42 @@ class ArrowVertexMap<arrow::util::string_view, VID_T>
     return false;
   }
 
+  /**
+   * @brief Hints that the gid of the oid will be looked up shortly, which is
+   * a no-op for the vertex maps sealed without the string hash index.
+   */
+  void PrefetchGid(fid_t fid, label_id_t label_id, const oid_t& oid) const {
+    auto const& index = o2g_index_[fid][label_id];
+    if (index.valid()) {
+      index.Prefetch(oid);
+    }
+  }
+
+  /**
+   * @brief Hints that the oid of the gid will be looked up shortly.
+   */
+  void PrefetchOid(vid_t gid) const {
+    fid_t fid = id_parser_.GetFid(gid);
+    label_id_t label = id_parser_.GetLabelId(gid);
+    int64_t offset = id_parser_.GetOffset(gid);
+    if (fid < fnum_ && label < label_num_ && label >= 0) {
+      auto const& array = oid_arrays_[fid][label];
+      if (offset < array->length()) {
+        __builtin_prefetch(array->raw_value_offsets() + offset);
+      }
+    }
+  }
+
   bool GetGid(fid_t fid, label_id_t label_id, oid_t oid, vid_t& gid) const {
+    auto const& index = o2g_index_[fid][label_id];
+    if (index.valid()) {
+      int64_t offset;
+      if (index.Find(oid, offset)) {
+        gid = id_parser_.GenerateId(fid, label_id, offset);
+        return true;
+      }
+      return false;
+    }
     auto iter = o2g_[fid][label_id].find(oid);
     if (iter != o2g_[fid][label_id].end()) {
       gid = iter->second;
@@ -270,6 +517,49 @@ class ArrowVertexMap<arrow::util::string_view, VID_T>
     return false;
   }
 
+  /**
+   * @brief Resolves the gids of a batch of oids in the fragment `fid`, see
+   * also Note [Batched vertex lookups].
+   */
+  size_t GetGids(fid_t fid, label_id_t label_id, const oid_t* oids,
+                 size_t size, vid_t* gids, bool* found = nullptr,
+                 int concurrency = 1) const {
+    return vertex_map_impl::get_gids(
+        *this, [fid](size_t) { return fid; }, label_id, oids, size, gids,
+        found, concurrency);
+  }
+
+  /**
+   * @brief Resolves the gids of a batch of oids, where the i-th oid belongs
+   * to the fragment `fids[i]`.
+   */
+  size_t GetGids(const fid_t* fids, label_id_t label_id, const oid_t* oids,
+                 size_t size, vid_t* gids, bool* found = nullptr,
+                 int concurrency = 1) const {
+    return vertex_map_impl::get_gids(
+        *this, [fids](size_t i) { return fids[i]; }, label_id, oids, size,
+        gids, found, concurrency);
+  }
+
+  /**
+   * @brief Resolves the gids of a batch of oids in any fragment.
+   */
+  size_t GetGids(label_id_t label_id, const oid_t* oids, size_t size,
+                 vid_t* gids, bool* found = nullptr,
+                 int concurrency = 1) const {
+    return vertex_map_impl::get_gids_in_fragments(
+        *this, fnum_, label_id, oids, size, gids, found, concurrency);
+  }
+
+  /**
+   * @brief Resolves the oids of a batch of gids.
+   */
+  size_t GetOids(const vid_t* gids, size_t size, oid_t* oids,
+                 bool* found = nullptr, int concurrency = 1) const {
+    return vertex_map_impl::get_oids(*this, gids, size, oids, found,
+                                     concurrency);
+  }
+
   std::vector<oid_t> GetOids(fid_t fid, label_id_t label_id) {
     auto array = oid_arrays_[fid][label_id];
     std::vector<oid_t> oids;
@@ -331,6 +621,9 @@ class ArrowVertexMap<arrow::util::string_view, VID_T>
     for (fid_t i = 0; i < fnum_; ++i) {
       o2g_[i].resize(label_num_);
       for (label_id_t j = 0; j < label_num_; ++j) {
+        if (o2g_index_[i][j].valid()) {
+          continue;
+        }
         auto array = oid_arrays_[i][j];
         auto& map = o2g_[i][j];
         {
@@ -352,6 +645,9 @@ class ArrowVertexMap<arrow::util::string_view, VID_T>
 
   // frag->label->oid
   std::vector<std::vector<std::shared_ptr<oid_array_t>>> oid_arrays_;
+  // see Note [Sealed string hash index]
+  std::vector<std::vector<StringHashIndex>> o2g_index_;
+  // only for the labels that have no index
   std::vector<std::vector<ska::flat_hash_map<oid_t, vid_t>>> o2g_;
 
   friend class ArrowVertexMapBuilder<arrow::util::string_view, VID_T>;
@@ -415,8 +711,10 @@ class ArrowVertexMapBuilder<arrow::util::string_view, VID_T>
     fnum_ = fnum;
     label_num_ = label_num;
     oid_arrays_.resize(fnum_);
+    o2g_index_.resize(fnum_);
     for (fid_t i = 0; i < fnum_; ++i) {
       oid_arrays_[i].resize(label_num_);
+      o2g_index_[i].resize(label_num_);
     }
   }
 
@@ -426,6 +724,11 @@ class ArrowVertexMapBuilder<arrow::util::string_view, VID_T>
     oid_arrays_[fid][label] = array;
   }
 
+  void set_o2g_index(fid_t fid, label_id_t label,
+                     const NumericArray<uint64_t>& index) {
+    o2g_index_[fid][label] = index;
+  }
+
   std::shared_ptr<vineyard::Object> _Seal(vineyard::Client& client);
 
  private:
@@ -434,6 +737,7 @@ class ArrowVertexMapBuilder<arrow::util::string_view, VID_T>
 
   std::vector<std::vector<typename InternalType<oid_t>::vineyard_array_type>>
       oid_arrays_;
+  std::vector<std::vector<NumericArray<uint64_t>>> o2g_index_;
 };
 
 template <typename OID_T, typename VID_T>
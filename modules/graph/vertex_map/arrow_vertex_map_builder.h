@@ -36,6 +36,7 @@ limitations under the License.
 #include "graph/fragment/property_graph_utils.h"
 #include "graph/utils/thread_group.h"
 #include "graph/vertex_map/arrow_vertex_map.h"
+#include "graph/vertex_map/string_hash_index.h"
 
 namespace vineyard {
 
@@ -180,21 +181,34 @@ ObjectID ArrowVertexMap<arrow::util::string_view, VID_T>::AddNewVertexLabels(
 
   std::vector<std::vector<typename InternalType<oid_t>::vineyard_array_type>>
       vy_oid_arrays;
+  std::vector<std::vector<NumericArray<uint64_t>>> vy_o2g_index;
   int total_label_num = label_num_ + extra_label_num;
   vy_oid_arrays.resize(fnum_);
+  vy_o2g_index.resize(fnum_);
   for (fid_t i = 0; i < fnum_; ++i) {
     vy_oid_arrays[i].resize(extra_label_num);
+    vy_o2g_index[i].resize(extra_label_num);
   }
 
+  int concurrency = std::max(
+      1, static_cast<int>(std::thread::hardware_concurrency()) /
+             std::max(1, static_cast<int>(fnum_ * extra_label_num)));
   ThreadGroup tg;
-  auto builder_fn = [&client, &oid_arrays, &vy_oid_arrays](
-                        fid_t const fid, label_id_t const vlabel_id) -> Status {
+  auto builder_fn = [&client, &oid_arrays, &vy_oid_arrays, &vy_o2g_index,
+                     concurrency](fid_t const fid,
+                                  label_id_t const vlabel_id) -> Status {
     auto& array = oid_arrays[vlabel_id][fid];
     typename InternalType<oid_t>::vineyard_builder_type array_builder(client,
                                                                       array);
     vy_oid_arrays[fid][vlabel_id] = *std::dynamic_pointer_cast<
         typename InternalType<oid_t>::vineyard_array_type>(
         array_builder.Seal(client));
+
+    std::shared_ptr<Object> index;
+    RETURN_ON_ERROR(
+        StringHashIndex::Build(client, array, concurrency, index));
+    vy_o2g_index[fid][vlabel_id] =
+        *std::dynamic_pointer_cast<NumericArray<uint64_t>>(index);
     return Status::OK();
   };
 
@@ -203,7 +217,9 @@ ObjectID ArrowVertexMap<arrow::util::string_view, VID_T>::AddNewVertexLabels(
       tg.AddTask(builder_fn, fid, vlabel_id);
     }
   }
-  tg.TakeResults();
+  for (auto const& status : tg.TakeResults()) {
+    VINEYARD_CHECK_OK(status);
+  }
 
   vineyard::ObjectMeta old_meta, new_meta;
   VINEYARD_CHECK_OK(client.GetMetaData(this->id(), old_meta));
@@ -218,13 +234,24 @@ ObjectID ArrowVertexMap<arrow::util::string_view, VID_T>::AddNewVertexLabels(
     for (label_id_t j = 0; j < total_label_num; ++j) {
       std::string array_name =
           "oid_arrays_" + std::to_string(i) + "_" + std::to_string(j);
+      std::string index_name =
+          "o2g_index_" + std::to_string(i) + "_" + std::to_string(j);
       if (j < label_num_) {
         auto array_meta = old_meta.GetMemberMeta(array_name);
         new_meta.AddMember(array_name, array_meta);
         nbytes += array_meta.GetNBytes();
+
+        if (old_meta.Haskey(index_name)) {
+          auto index_meta = old_meta.GetMemberMeta(index_name);
+          new_meta.AddMember(index_name, index_meta);
+          nbytes += index_meta.GetNBytes();
+        }
       } else {
         new_meta.AddMember(array_name, vy_oid_arrays[i][j - label_num_].meta());
         nbytes += vy_oid_arrays[i][j - label_num_].nbytes();
+
+        new_meta.AddMember(index_name, vy_o2g_index[i][j - label_num_].meta());
+        nbytes += vy_o2g_index[i][j - label_num_].nbytes();
       }
     }
   }
@@ -311,6 +338,16 @@ ArrowVertexMapBuilder<arrow::util::string_view, VID_T>::_Seal(
     }
   }
 
+  vertex_map->o2g_index_.resize(fnum_);
+  for (fid_t i = 0; i < fnum_; ++i) {
+    auto& index = vertex_map->o2g_index_[i];
+    index.resize(label_num_);
+    for (label_id_t j = 0; j < label_num_; ++j) {
+      index[j] = StringHashIndex(vertex_map->oid_arrays_[i][j],
+                                 o2g_index_[i][j].GetArray());
+    }
+  }
+
   vertex_map->meta_.SetTypeName(type_name<ArrowVertexMap<oid_t, vid_t>>());
 
   vertex_map->meta_.AddKeyValue("fnum", fnum_);
@@ -323,6 +360,11 @@ ArrowVertexMapBuilder<arrow::util::string_view, VID_T>::_Seal(
           "oid_arrays_" + std::to_string(i) + "_" + std::to_string(j),
           oid_arrays_[i][j].meta());
       nbytes += oid_arrays_[i][j].nbytes();
+
+      vertex_map->meta_.AddMember(
+          "o2g_index_" + std::to_string(i) + "_" + std::to_string(j),
+          o2g_index_[i][j].meta());
+      nbytes += o2g_index_[i][j].nbytes();
     }
   }
 
@@ -439,10 +481,14 @@ BasicArrowVertexMapBuilder<arrow::util::string_view, VID_T>::Build(
     vineyard::Client& client) {
   this->set_fnum_label_num(fnum_, label_num_);
 
+  // the index is built once here, see Note [Sealed string hash index]
+  int concurrency = std::max(
+      1, static_cast<int>(std::thread::hardware_concurrency()) /
+             std::max(1, static_cast<int>(fnum_ * label_num_)));
   ThreadGroup tg;
 
-  auto builder_fn = [this, &client](fid_t const fid,
-                                    label_id_t const vlabel_id) -> Status {
+  auto builder_fn = [this, &client, concurrency](
+                        fid_t const fid, label_id_t const vlabel_id) -> Status {
     auto& array = oid_arrays_[vlabel_id][fid];
     typename InternalType<oid_t>::vineyard_builder_type array_builder(client,
                                                                       array);
@@ -450,6 +496,13 @@ BasicArrowVertexMapBuilder<arrow::util::string_view, VID_T>::Build(
                         *std::dynamic_pointer_cast<
                             typename InternalType<oid_t>::vineyard_array_type>(
                             array_builder.Seal(client)));
+
+    std::shared_ptr<Object> index;
+    RETURN_ON_ERROR(
+        StringHashIndex::Build(client, array, concurrency, index));
+    this->set_o2g_index(
+        fid, vlabel_id,
+        *std::dynamic_pointer_cast<NumericArray<uint64_t>>(index));
     return Status::OK();
   };
 
@@ -458,7 +511,9 @@ BasicArrowVertexMapBuilder<arrow::util::string_view, VID_T>::Build(
       tg.AddTask(builder_fn, fid, vlabel_id);
     }
   }
-  tg.TakeResults();
+  for (auto const& status : tg.TakeResults()) {
+    RETURN_ON_ERROR(status);
+  }
   return vineyard::Status::OK();
 }
 
@@ -0,0 +1,214 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef MODULES_GRAPH_VERTEX_MAP_STRING_HASH_INDEX_H_
+#define MODULES_GRAPH_VERTEX_MAP_STRING_HASH_INDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "arrow/api.h"
+
+#include "basic/ds/arrow.h"
+#include "client/client.h"
+#include "client/ds/blob.h"
+
+namespace vineyard {
+
+/**
+ * Note [Sealed string hash index]
+ *
+ * The string oids of a vertex map are looked up with an open addressing hash
+ * table that refers to the rows of the `LargeStringArray` of oids, rather
+ * than a `ska::flat_hash_map` of string views that must be rebuilt from the
+ * oids in every process that gets the vertex map.
+ *
+ * The table is a power-of-two array of `uint64_t` slots, sealed as a
+ * `NumericArray<uint64_t>` along with the oid array, hence opening the vertex
+ * map maps the table zero-copy. A slot is 0 when empty, otherwise the high
+ * `kTagBits` bits keep the high bits of the hash of the oid, to skip most of
+ * the string comparisons on collisions, and the low bits keep the row of the
+ * oid plus one. The table is filled by linear probing, with a compare-and-swap
+ * per slot so that the rows can be inserted in parallel, and is at most 2/3
+ * full.
+ *
+ * The hash is computed by `StringHashIndex::Hash()` rather than `std::hash`,
+ * as the processes that seal and open the index may use different standard
+ * libraries.
+ */
+class StringHashIndex {
+ public:
+  static constexpr int kTagBits = 24;
+  static constexpr int kRowBits = 64 - kTagBits;
+  static constexpr uint64_t kRowMask = (static_cast<uint64_t>(1) << kRowBits) -
+                                       static_cast<uint64_t>(1);
+
+  StringHashIndex() {}
+
+  StringHashIndex(const std::shared_ptr<arrow::LargeStringArray>& oids,
+                  const std::shared_ptr<arrow::UInt64Array>& slots)
+      : oids_(oids),
+        slots_(slots),
+        slots_ptr_(slots->raw_values()),
+        mask_(static_cast<uint64_t>(slots->length()) - 1) {}
+
+  bool valid() const { return slots_ptr_ != nullptr; }
+
+  /**
+   * @brief Finds the row of the given oid in the oid array.
+   */
+  bool Find(const arrow::util::string_view& oid, int64_t& row) const {
+    uint64_t hash = Hash(oid.data(), oid.size());
+    uint64_t tag = hash >> kRowBits;
+    for (uint64_t pos = hash & mask_;; pos = (pos + 1) & mask_) {
+      uint64_t slot = slots_ptr_[pos];
+      if (slot == 0) {
+        return false;
+      }
+      if ((slot >> kRowBits) == tag) {
+        int64_t candidate = static_cast<int64_t>((slot & kRowMask) - 1);
+        if (oids_->GetView(candidate) == oid) {
+          row = candidate;
+          return true;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Prefetches the first slot that `Find()` would probe for the oid.
+   */
+  void Prefetch(const arrow::util::string_view& oid) const {
+    __builtin_prefetch(slots_ptr_ + (Hash(oid.data(), oid.size()) & mask_));
+  }
+
+  /**
+   * @brief Builds and seals the index of the given oids with `concurrency`
+   * threads, see also Note [Sealed string hash index].
+   */
+  static Status Build(Client& client,
+                      const std::shared_ptr<arrow::LargeStringArray>& oids,
+                      int concurrency, std::shared_ptr<Object>& index) {
+    int64_t length = oids->length();
+    if (static_cast<uint64_t>(length) >= kRowMask) {
+      return Status::Invalid("Too many oids for the string hash index: " +
+                             std::to_string(length));
+    }
+    int64_t capacity = 2;
+    while (capacity < length + length / 2 + 1) {
+      capacity *= 2;
+    }
+    std::unique_ptr<BlobWriter> writer;
+    RETURN_ON_ERROR(client.CreateBlob(capacity * sizeof(uint64_t), writer));
+    uint64_t* slots = reinterpret_cast<uint64_t*>(writer->data());
+    memset(slots, 0, capacity * sizeof(uint64_t));
+
+    uint64_t mask = static_cast<uint64_t>(capacity) - 1;
+    auto insert = [&oids, slots, mask](int64_t begin, int64_t end) {
+      for (int64_t row = begin; row < end; ++row) {
+        auto oid = oids->GetView(row);
+        uint64_t hash = Hash(oid.data(), oid.size());
+        uint64_t slot = ((hash >> kRowBits) << kRowBits) |
+                        static_cast<uint64_t>(row + 1);
+        uint64_t pos = hash & mask;
+        while (__atomic_load_n(slots + pos, __ATOMIC_RELAXED) != 0 ||
+               !__sync_bool_compare_and_swap(slots + pos, 0, slot)) {
+          pos = (pos + 1) & mask;
+        }
+      }
+    };
+    concurrency = static_cast<int>(
+        std::max(static_cast<int64_t>(1),
+                 std::min(static_cast<int64_t>(concurrency), length / 4096)));
+    if (concurrency == 1) {
+      insert(0, length);
+    } else {
+      std::vector<std::thread> threads;
+      int64_t chunk = (length + concurrency - 1) / concurrency;
+      for (int i = 0; i < concurrency; ++i) {
+        threads.emplace_back(insert, std::min(chunk * i, length),
+                             std::min(chunk * (i + 1), length));
+      }
+      for (auto& thrd : threads) {
+        thrd.join();
+      }
+    }
+
+    NumericArrayBaseBuilder<uint64_t> builder(client);
+    builder.set_length_(capacity);
+    builder.set_null_count_(0);
+    builder.set_offset_(0);
+    builder.set_buffer_(std::shared_ptr<BlobWriter>(std::move(writer)));
+    builder.set_null_bitmap_(Blob::MakeEmpty(client));
+    index = builder.Seal(client);
+    return Status::OK();
+  }
+
+  /**
+   * @brief A 64-bit hash of strings (MurmurHash64A), which is stable across
+   * platforms and processes.
+   */
+  static uint64_t Hash(const char* data, size_t length) {
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = 0x9747b28c5bd1e995ULL ^ (length * m);
+
+    const char* end = data + (length / 8) * 8;
+    for (; data != end; data += 8) {
+      uint64_t k;
+      memcpy(&k, data, sizeof(uint64_t));
+      k *= m;
+      k ^= k >> r;
+      k *= m;
+      h ^= k;
+      h *= m;
+    }
+    switch (length & 7) {
+    case 7:
+      h ^= static_cast<uint64_t>(static_cast<uint8_t>(data[6])) << 48;
+    case 6:
+      h ^= static_cast<uint64_t>(static_cast<uint8_t>(data[5])) << 40;
+    case 5:
+      h ^= static_cast<uint64_t>(static_cast<uint8_t>(data[4])) << 32;
+    case 4:
+      h ^= static_cast<uint64_t>(static_cast<uint8_t>(data[3])) << 24;
+    case 3:
+      h ^= static_cast<uint64_t>(static_cast<uint8_t>(data[2])) << 16;
+    case 2:
+      h ^= static_cast<uint64_t>(static_cast<uint8_t>(data[1])) << 8;
+    case 1:
+      h ^= static_cast<uint64_t>(static_cast<uint8_t>(data[0]));
+      h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+  }
+
+ private:
+  std::shared_ptr<arrow::LargeStringArray> oids_;
+  std::shared_ptr<arrow::UInt64Array> slots_;
+  const uint64_t* slots_ptr_ = nullptr;
+  uint64_t mask_ = 0;
+};
+
+}  // namespace vineyard
+
+#endif  // MODULES_GRAPH_VERTEX_MAP_STRING_HASH_INDEX_H_
@@ -418,6 +418,9 @@ void bind_client(py::module& mod) {
       .def_property_readonly(
           "memory_limit",
           [](InstanceStatus* status) { return status->memory_limit; })
+      .def_property_readonly(
+          "memory_reserved",
+          [](InstanceStatus* status) { return status->memory_reserved; })
       .def_property_readonly(
           "deferred_requests",
           [](InstanceStatus* status) { return status->deferred_requests; })
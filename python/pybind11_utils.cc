@@ -138,6 +138,11 @@ void bind_utils(py::module& mod) {
       },
       "dst"_a, "offset"_a, "src"_a, py::arg("size") = 0 /* not checked */);
 
+  // see also Note [Compact encoding of containers in metadata]
+  mod.def("compact_container_encoding", &compact_container_encoding);
+  mod.def("set_compact_container_encoding", &set_compact_container_encoding,
+          "enabled"_a);
+
   PyModule_AddFunctions(mod.ptr(), vineyard_utils_methods);
 }
 
@@ -16,8 +16,6 @@
 # limitations under the License.
 #
 
-import json
-
 import numpy as np
 import pandas as pd
 
@@ -29,6 +27,7 @@ from dask.distributed import Client
 import vineyard
 from vineyard.data.dataframe import make_global_dataframe
 from vineyard.data.tensor import make_global_tensor
+from vineyard.data.utils import from_json
 
 
 def dask_array_builder(client, value, builder, **kw):
@@ -73,7 +72,7 @@ def dask_array_resolver(obj, resolver, **kw):
         ts = meta.get_member('partitions_-%d' % i)
         instance_id = int(ts.meta['instance_id'])
 
-        partition_index = json.loads(ts.meta['partition_index_'])
+        partition_index = from_json(ts.meta['partition_index_'])
         if partition_index:
             indices.append((partition_index[0], partition_index[1], i))
         else:
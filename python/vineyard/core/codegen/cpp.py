@@ -21,6 +21,7 @@ import os
 import textwrap
 
 from .parsing import check_class
+from .parsing import check_serialize_attribute
 from .parsing import dump_ast
 from .parsing import find_distributed_field
 from .parsing import find_fields
@@ -170,6 +171,13 @@ construct_dict_tpl = '''
     }}'''
 
 
+# the members annotated with "[[shared(optional)]]" are left empty when they
+# are missing in the metadata, e.g., the objects sealed by older versions.
+construct_optional_tpl = '''
+    if (meta.Haskey("{key}")) {{{body}
+    }}'''
+
+
 def codegen_construct(
     class_header, class_name, class_name_elaborated, fields, has_post_ctor, meth=False
 ):
@@ -206,15 +214,22 @@ def codegen_construct(
             key_type = None
             value_type = None
 
-        body.append(
-            tpl.format(
-                name=name,
-                element_type=spec.element_type,
-                key_type=key_type,
-                value_type=value_type,
-                deref=spec.deref,
-            )
+        field_body = tpl.format(
+            name=name,
+            element_type=spec.element_type,
+            key_type=key_type,
+            value_type=value_type,
+            deref=spec.deref,
         )
+        if check_serialize_attribute(field) == 'shared(optional)':
+            if spec.is_meta or spec.is_plain:
+                key = name
+            else:
+                key = '__%s-size' % name
+            field_body = construct_optional_tpl.format(
+                key=key, body=textwrap.indent(field_body, ' ' * 4)
+            )
+        body.append(field_body)
 
     if meth:
         function_tpl = construct_meth_tpl
@@ -47,6 +47,8 @@ except ImportError:
 #
 #   __attribute__((annotate("vineyard"))): vineyard classes
 #   __attribute__((annotate("shared"))): shared member/method
+#   __attribute__((annotate("shared(optional)"))): shared member, may be
+#                                                  missing in the metadata
 #   __attribute__((annotate("streamable"))): shared member/method
 #   __attribute__((annotate("distributed"))): shared member/method
 #
@@ -460,7 +462,7 @@ def find_fields(definition):
 
         if child.kind == CursorKind.FIELD_DECL:
             attribute = check_serialize_attribute(child)
-            if attribute in ['shared', 'distributed']:
+            if attribute in ['shared', 'shared(optional)', 'distributed']:
                 fields.append(child)
             continue
 
@@ -565,7 +567,13 @@ def validate_and_strip_input_file(source):
     content = '\n'.join(content)
 
     # pass: rewrite `[[...]]` with `__attribute__((annotate(...)))`
-    attributes = ['vineyard', 'vineyard(streamable)', 'shared', 'distributed']
+    attributes = [
+        'vineyard',
+        'vineyard(streamable)',
+        'shared',
+        'shared(optional)',
+        'distributed',
+    ]
     for attr in attributes:
         content = content.replace(
             '[[%s]]' % attr, '__attribute__((annotate("%s")))' % attr
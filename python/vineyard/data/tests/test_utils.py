@@ -0,0 +1,109 @@
+#! /usr/bin/env python
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2021 Alibaba Group Holding Limited.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+import base64
+import struct
+
+import numpy as np
+
+import pytest
+
+import vineyard
+from vineyard._C import compact_container_encoding
+from vineyard._C import set_compact_container_encoding
+from vineyard.data.utils import _decode_compact_container
+from vineyard.data.utils import from_json
+
+# see also `kCompactContainerThreshold` in common/util/json.h
+THRESHOLD = 256
+
+
+@pytest.fixture
+def compact_encoding():
+    enabled = compact_container_encoding()
+    set_compact_container_encoding(True)
+    yield
+    set_compact_container_encoding(enabled)
+
+
+def _zigzag_varint(values):
+    payload, previous = bytearray(), 0
+    for value in values:
+        delta = (value - previous) & 0xFFFFFFFFFFFFFFFF
+        delta = delta - (1 << 64) if delta >> 63 else delta
+        zigzag = ((delta << 1) ^ (delta >> 63)) & 0xFFFFFFFFFFFFFFFF
+        while zigzag >= 0x80:
+            payload.append((zigzag & 0x7F) | 0x80)
+            zigzag >>= 7
+        payload.append(zigzag)
+        previous = value
+    return base64.b64encode(bytes(payload)).decode('ascii')
+
+
+def test_decode_compact_integers():
+    values = [i * i - 1024 for i in range(THRESHOLD * 2)]
+    assert _decode_compact_container('int64', _zigzag_varint(values)) == values
+
+    # decreasing and wrapping-around values
+    values = [2**64 - 1, 0, 2**63, 1, 7]
+    assert _decode_compact_container('uint64', _zigzag_varint(values)) == values
+    values = [-(2**31), 2**31 - 1, -1, 0]
+    assert _decode_compact_container('int32', _zigzag_varint(values)) == values
+    values = [255, 0, 128]
+    assert _decode_compact_container('uint8', _zigzag_varint(values)) == values
+
+
+def test_decode_compact_floats():
+    values = [i / 4.0 for i in range(THRESHOLD * 2)]
+    payload = base64.b64encode(struct.pack('<%dd' % len(values), *values))
+    assert _decode_compact_container('float64', payload) == values
+    payload = base64.b64encode(struct.pack('<%df' % len(values), *values))
+    assert _decode_compact_container('float32', payload) == values
+
+
+def test_compact_container_is_opt_in():
+    meta = vineyard.ObjectMeta()
+    values = list(range(THRESHOLD * 2))
+    meta['values'] = values
+    if not compact_container_encoding():
+        assert not meta['values'].startswith('base64:')
+    assert from_json(meta['values']) == values
+
+
+def test_compact_container_round_trip(compact_encoding):
+    meta = vineyard.ObjectMeta()
+
+    # encoded by the C++ writer, i.e., `ObjectMeta::AddKeyValue()`
+    int32_values = [i * 7 - 1024 for i in range(THRESHOLD * 2)]
+    int64_values = [i * 2**40 - 2**50 for i in range(THRESHOLD * 2)]
+    float_values = [i / 4.0 for i in range(THRESHOLD * 2)]
+    small_values = [1, 2, 3]
+    meta['int32_values'] = int32_values
+    meta['int64_values'] = int64_values
+    meta['float_values'] = float_values
+    meta['small_values'] = small_values
+
+    assert meta['int32_values'].startswith('base64:int32:')
+    assert meta['int64_values'].startswith('base64:int64:')
+    assert meta['float_values'].startswith('base64:float')
+    assert not meta['small_values'].startswith('base64:')
+
+    assert from_json(meta['int32_values']) == int32_values
+    assert from_json(meta['int64_values']) == int64_values
+    assert np.allclose(from_json(meta['float_values']), float_values)
+    assert from_json(meta['small_values']) == small_values
@@ -16,6 +16,7 @@
 # limitations under the License.
 #
 
+import base64
 import json
 import pickle
 import platform
@@ -141,7 +142,31 @@ def to_json(value):
     return json.dumps(value, default=default_json_encoder)
 
 
+def _decode_compact_container(dtype, payload):
+    '''Decode the compact encoding of large containers in metadata, see also
+    Note [Compact encoding of containers in metadata] in common/util/json.h.
+    '''
+    dtype = np.dtype(dtype)
+    payload = base64.b64decode(payload)
+    if dtype.kind == 'f':
+        return np.frombuffer(payload, dtype=dtype.newbyteorder('<')).tolist()
+    values, previous, zigzag, shift = [], 0, 0, 0
+    for byte in payload:
+        zigzag |= (byte & 0x7F) << shift
+        shift += 7
+        if byte & 0x80:
+            continue
+        previous = (previous + ((zigzag >> 1) ^ -(zigzag & 1))) & 0xFFFFFFFFFFFFFFFF
+        values.append(previous)
+        zigzag, shift = 0, 0
+    # truncate to the width of dtype, like `static_cast` in C++
+    return np.array(values, dtype='uint64').astype(dtype).tolist()
+
+
 def from_json(string):
+    if isinstance(string, str) and string.startswith('base64:'):
+        _, dtype, payload = string.split(':', 2)
+        return _decode_compact_container(dtype, payload)
     return json.loads(string)
 
 
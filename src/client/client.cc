@@ -24,9 +24,12 @@ limitations under the License.
 #include <map>
 #include <mutex>
 #include <set>
+#include <sstream>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "boost/range/combine.hpp"
 
@@ -85,6 +88,12 @@ Status BasicIPCClient::Connect(const std::string& ipc_socket,
 
 Status BasicIPCClient::Open(std::string const& ipc_socket,
                             StoreType const& bulk_store_type) {
+  return Open(ipc_socket, bulk_store_type, 0, 0);
+}
+
+Status BasicIPCClient::Open(std::string const& ipc_socket,
+                            StoreType const& bulk_store_type,
+                            size_t const reserved_size, size_t const size) {
   RETURN_ON_ASSERT(!this->connected_,
                    "The client has already been connected to vineyard server");
   std::string socket_path;
@@ -93,7 +102,7 @@ Status BasicIPCClient::Open(std::string const& ipc_socket,
   {
     std::lock_guard<std::recursive_mutex> guard(client_mutex_);
     std::string message_out;
-    WriteNewSessionRequest(message_out, bulk_store_type);
+    WriteNewSessionRequest(message_out, bulk_store_type, reserved_size, size);
     RETURN_ON_ERROR(doWrite(message_out));
     json message_in;
     RETURN_ON_ERROR(doRead(message_in));
@@ -105,6 +114,10 @@ Status BasicIPCClient::Open(std::string const& ipc_socket,
   return Status::OK();
 }
 
+Status BasicIPCClient::connectPipeline(int& conn) {
+  return connect_ipc_socket_retry(ipc_socket_, conn);
+}
+
 Client::~Client() { Disconnect(); }
 
 Status Client::Connect() {
@@ -130,6 +143,12 @@ Status Client::Open(std::string const& ipc_socket) {
   return BasicIPCClient::Open(ipc_socket, StoreType::kDefault);
 }
 
+Status Client::Open(std::string const& ipc_socket, size_t const reserved_size,
+                    size_t const size) {
+  return BasicIPCClient::Open(ipc_socket, StoreType::kDefault, reserved_size,
+                              size);
+}
+
 Status Client::Fork(Client& client) {
   RETURN_ON_ASSERT(!client.Connected(),
                    "The client has already been connected to vineyard server");
@@ -194,13 +213,81 @@ Status Client::GetMetaData(const std::vector<ObjectID>& ids,
   return Status::OK();
 }
 
+Status Client::GetMetaData(const ObjectID id, ObjectMeta& meta,
+                           const bool sync_remote, const bool lazy) {
+  if (!lazy) {
+    return GetMetaData(id, meta, sync_remote);
+  }
+  ENSURE_CONNECTED(this);
+  json tree;
+  RETURN_ON_ERROR(GetData(id, tree, sync_remote));
+  meta.Reset();
+  meta.SetMetaData(this, tree);
+  meta.SetLazy(true);
+  return Status::OK();
+}
+
+Status Client::GetMetaData(const ObjectID id,
+                           std::vector<std::string> const& projection,
+                           std::vector<ObjectMeta>& members,
+                           const bool sync_remote) {
+  ENSURE_CONNECTED(this);
+  json tree;
+  RETURN_ON_ERROR(GetData(id, tree, sync_remote));
+  RETURN_ON_ASSERT(!tree.empty(),
+                   "object not exists: " + ObjectIDToString(id));
+  ObjectMeta meta;
+  meta.SetMetaData(this, tree);
+
+  members.clear();
+  members.reserve(projection.size());
+  std::set<ObjectID> blob_ids;
+  for (auto const& path : projection) {
+    ObjectMeta member = meta;
+    std::stringstream ss(path);
+    std::string name;
+    while (std::getline(ss, name, '/')) {
+      if (name.empty()) {
+        continue;
+      }
+      auto const& node = member.MetaData();
+      if (!node.contains(name) || !node[name].is_object()) {
+        return Status::Invalid("No such member '" + name + "' in path '" +
+                               path + "' of object " + ObjectIDToString(id));
+      }
+      member = member.GetMemberMeta(name);
+    }
+    for (auto const& blob_id : member.GetBufferSet()->AllBufferIds()) {
+      blob_ids.emplace(blob_id);
+    }
+    members.emplace_back(member);
+  }
+
+  std::map<ObjectID, std::shared_ptr<arrow::Buffer>> buffers;
+  RETURN_ON_ERROR(GetBuffers(blob_ids, buffers));
+  for (auto& member : members) {
+    for (auto const& blob_id : member.GetBufferSet()->AllBufferIds()) {
+      const auto& buffer = buffers.find(blob_id);
+      if (buffer != buffers.end()) {
+        member.SetBuffer(blob_id, buffer->second);
+      }
+    }
+  }
+  return Status::OK();
+}
+
 Status Client::CreateBlob(size_t size, std::unique_ptr<BlobWriter>& blob) {
+  return CreateBlob(size, -1, blob);
+}
+
+Status Client::CreateBlob(size_t size, int numa_node,
+                          std::unique_ptr<BlobWriter>& blob) {
   ENSURE_CONNECTED(this);
 
   ObjectID object_id = InvalidObjectID();
   Payload object;
   std::shared_ptr<arrow::MutableBuffer> buffer = nullptr;
-  RETURN_ON_ERROR(CreateBuffer(size, object_id, object, buffer));
+  RETURN_ON_ERROR(CreateBuffer(size, numa_node, object_id, object, buffer));
   blob.reset(new BlobWriter(object_id, object, buffer));
   return Status::OK();
 }
@@ -348,6 +435,24 @@ std::vector<std::shared_ptr<Object>> Client::GetObjects(
   return objects;
 }
 
+Status Client::GetObject(const ObjectID id,
+                         std::vector<std::string> const& projection,
+                         std::vector<std::shared_ptr<Object>>& members) {
+  std::vector<ObjectMeta> metas;
+  RETURN_ON_ERROR(this->GetMetaData(id, projection, metas, true));
+  members.clear();
+  members.reserve(metas.size());
+  for (auto const& meta : metas) {
+    auto object = ObjectFactory::Create(meta.GetTypeName());
+    if (object == nullptr) {
+      object = std::unique_ptr<Object>(new Object());
+    }
+    object->Construct(meta);
+    members.emplace_back(std::shared_ptr<Object>(object.release()));
+  }
+  return Status::OK();
+}
+
 std::vector<ObjectMeta> Client::ListObjectMeta(std::string const& pattern,
                                                const bool regex,
                                                size_t const limit,
@@ -497,9 +602,15 @@ Status Client::ReleaseArena(const int fd, std::vector<size_t> const& offsets,
 
 Status Client::CreateBuffer(const size_t size, ObjectID& id, Payload& payload,
                             std::shared_ptr<arrow::MutableBuffer>& buffer) {
+  return CreateBuffer(size, -1, id, payload, buffer);
+}
+
+Status Client::CreateBuffer(const size_t size, const int numa_node,
+                            ObjectID& id, Payload& payload,
+                            std::shared_ptr<arrow::MutableBuffer>& buffer) {
   ENSURE_CONNECTED(this);
   std::string message_out;
-  WriteCreateBufferRequest(size, message_out);
+  WriteCreateBufferRequest(size, numa_node, message_out);
   RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   int fd_sent = -1, fd_recv = -1;
@@ -906,6 +1017,61 @@ Status Client::IsSpilled(ObjectID const& id, bool& is_spilled) {
   return Status::OK();
 }
 
+Status Client::IsSpilled(ObjectID const& id, bool& is_spilled,
+                         SpillPriority& priority, bool& is_pinned) {
+  ENSURE_CONNECTED(this);
+
+  std::string message_out;
+  WriteIsSpilledRequest(id, message_out);
+  RETURN_ON_ERROR(doWrite(message_out));
+
+  json message_in;
+  RETURN_ON_ERROR(doRead(message_in));
+  RETURN_ON_ERROR(
+      ReadIsSpilledReply(message_in, is_spilled, priority, is_pinned));
+  return Status::OK();
+}
+
+Status Client::Pin(ObjectID const& id) { return PinBlobs(id, true); }
+
+Status Client::Unpin(ObjectID const& id) { return PinBlobs(id, false); }
+
+Status Client::PinBlobs(ObjectID const& id, const bool pinned) {
+  ENSURE_CONNECTED(this);
+  std::set<ObjectID> bids{id};
+  if (!IsBlob(id)) {
+    RETURN_ON_ERROR(GetDependency(id, bids));
+  }
+
+  std::string message_out;
+  WritePinBlobsRequest(std::vector<ObjectID>(bids.begin(), bids.end()),
+                       pinned, message_out);
+  RETURN_ON_ERROR(doWrite(message_out));
+
+  json message_in;
+  RETURN_ON_ERROR(doRead(message_in));
+  RETURN_ON_ERROR(ReadPinBlobsReply(message_in));
+  return Status::OK();
+}
+
+Status Client::SetSpillPriority(ObjectID const& id, SpillPriority priority) {
+  ENSURE_CONNECTED(this);
+  std::set<ObjectID> bids{id};
+  if (!IsBlob(id)) {
+    RETURN_ON_ERROR(GetDependency(id, bids));
+  }
+
+  std::string message_out;
+  WriteSetSpillPriorityRequest(std::vector<ObjectID>(bids.begin(), bids.end()),
+                               priority, message_out);
+  RETURN_ON_ERROR(doWrite(message_out));
+
+  json message_in;
+  RETURN_ON_ERROR(doRead(message_in));
+  RETURN_ON_ERROR(ReadSetSpillPriorityReply(message_in));
+  return Status::OK();
+}
+
 PlasmaClient::~PlasmaClient() {}
 
 // dummy implementation
@@ -279,7 +279,25 @@ class BasicIPCClient : public ClientBase {
    */
   Status Open(std::string const& ipc_socket, StoreType const& bulk_store_type);
 
+  /**
+   * @brief Create a new anonymous session in vineyardd with a memory quota,
+   * and connect to it.
+   *
+   * @param ipc_socket Location of the UNIX domain socket.
+   * @param bulk_store_type The name of the bulk store.
+   * @param reserved_size The shared memory guaranteed to the session, 0 to
+   * use the default of vineyardd (`--session_reserved_size`).
+   * @param size The maximum shared memory of the session, 0 to use the
+   * default of vineyardd (`--session_size`).
+   *
+   * @return Status that indicates whether the connection of has succeeded.
+   */
+  Status Open(std::string const& ipc_socket, StoreType const& bulk_store_type,
+              size_t const reserved_size, size_t const size);
+
  protected:
+  Status connectPipeline(int& conn) override;
+
   std::shared_ptr<detail::SharedMemoryManager> shm_;
 };
 
@@ -330,6 +348,19 @@ class Client : public BasicIPCClient,
    */
   Status Open(std::string const& ipc_socket);
 
+  /**
+   * @brief Create a new anonymous session in vineyardd with a memory quota,
+   * and connect to it.
+   *
+   * @param ipc_socket Location of the UNIX domain socket.
+   * @param reserved_size The shared memory guaranteed to the session.
+   * @param size The maximum shared memory of the session.
+   *
+   * @return Status that indicates whether the connection of has succeeded.
+   */
+  Status Open(std::string const& ipc_socket, size_t const reserved_size,
+              size_t const size);
+
   /**
    * @brief Create a new client using self UNIX domain socket.
    */
@@ -371,6 +402,48 @@ class Client : public BasicIPCClient,
   Status GetMetaData(const std::vector<ObjectID>& id, std::vector<ObjectMeta>&,
                      const bool sync_remote = false);
 
+  /**
+   * @brief Obtain the metadata from vineyard server, optionally without
+   * mapping the blobs of the object.
+   *
+   * When `lazy` is true, no blob is requested up front, the blobs are mapped
+   * (and reloaded, if spilled) on their first access through
+   * `ObjectMeta::GetBuffer()`, e.g., when the members are constructed by
+   * `ObjectMeta::GetMember()`.
+   *
+   * @param id The object id to get.
+   * @param meta_data The result metadata will be store in `meta_data` as return
+   * value.
+   * @param sync_remote Whether to trigger an immediate remote metadata
+   *        synchronization before get specific metadata.
+   * @param lazy Whether to map the blobs on demand.
+   *
+   * @return Status that indicates whether the get action has succeeded.
+   */
+  Status GetMetaData(const ObjectID id, ObjectMeta& meta_data,
+                     const bool sync_remote, const bool lazy);
+
+  /**
+   * @brief Obtain the metadata of the members at the given paths of the
+   * object, only the blobs of these members are mapped.
+   *
+   * A path is a sequence of member names separated by '/', e.g.,
+   * "__batches_-0/__columns_-2" is the third column of the first record batch
+   * of a `vineyard::Table`, and an empty path refers to the object itself.
+   *
+   * @param id The object id to get.
+   * @param projection The paths of the members to get.
+   * @param members The metadata of the members, in the order of `projection`.
+   * @param sync_remote Whether to trigger an immediate remote metadata
+   *        synchronization before get specific metadata. Default is false.
+   *
+   * @return Status that indicates whether the get action has succeeded.
+   */
+  Status GetMetaData(const ObjectID id,
+                     std::vector<std::string> const& projection,
+                     std::vector<ObjectMeta>& members,
+                     const bool sync_remote = false);
+
   /**
    * @brief Create a blob in vineyard server. When creating a blob, vineyard
    * server's bulk allocator will prepare a block of memory of the requested
@@ -383,6 +456,21 @@ class Client : public BasicIPCClient,
    */
   Status CreateBlob(size_t size, std::unique_ptr<BlobWriter>& blob);
 
+  /**
+   * @brief Create a blob on the given NUMA node of the vineyard server's host.
+   * The hint is best-effort: when NUMA is unavailable or the sub-arena of the
+   * node is exhausted the blob is allocated as usual, see
+   * `BlobWriter::numa_node()`.
+   *
+   * @param size The size of requested blob.
+   * @param numa_node The preferred NUMA node, -1 means no preference.
+   * @param blob The result mutable blob will be set in `blob`.
+   *
+   * @return Status that indicates whether the create action has succeeded.
+   */
+  Status CreateBlob(size_t size, int numa_node,
+                    std::unique_ptr<BlobWriter>& blob);
+
   /**
    * @brief Get a blob from vineyard server.
    *
@@ -536,6 +624,26 @@ class Client : public BasicIPCClient,
   std::vector<std::shared_ptr<Object>> GetObjects(
       const std::vector<ObjectID>& ids);
 
+  /**
+   * @brief Get the members at the given paths of an object from vineyard,
+   * without mapping the blobs of the other members. See also
+   * `GetMetaData(id, projection, members)` for the format of the paths.
+   *
+   * \code{.cpp}
+   *    std::vector<std::shared_ptr<Object>> columns;
+   *    client.GetObject(table_id, {"__batches_-0/__columns_-2"}, columns);
+   * \endcode
+   *
+   * @param id The object id to get.
+   * @param projection The paths of the members to get.
+   * @param members The result members, in the order of `projection`.
+   *
+   * @return Status that indicates whether the get action has succeeded.
+   */
+  Status GetObject(const ObjectID id,
+                   std::vector<std::string> const& projection,
+                   std::vector<std::shared_ptr<Object>>& members);
+
   /**
    * @brief List object metadatas in vineyard, using the given typename
    * patterns.
@@ -629,6 +737,41 @@ class Client : public BasicIPCClient,
    */
   Status IsSpilled(ObjectID const& id, bool& is_spilled);
 
+  /**
+   * @brief Check if the blob is a spilled blob, and get its spill priority
+   * class and whether it is pinned, see `SetSpillPriority` and `Pin`.
+   */
+  Status IsSpilled(ObjectID const& id, bool& is_spilled,
+                   SpillPriority& priority, bool& is_pinned);
+
+  /**
+   * @brief Pin the object in the shared memory of the connected vineyard
+   * server, i.e., all its member blobs (the object itself if it is a blob).
+   *
+   * The pinned blobs are never spilled under memory pressure, and a blob
+   * that has been spilled is reloaded when it is pinned. Pinning requires
+   * the memory to hold the object, use it for the critical objects only.
+   *
+   * The pins are counted, the blobs stay pinned until every `Pin` (of any
+   * client) has been matched by an `Unpin`.
+   */
+  Status Pin(ObjectID const& id);
+
+  /**
+   * @brief Unpin the object, its member blobs can be spilled again. See also
+   * `Pin`.
+   */
+  Status Unpin(ObjectID const& id);
+
+  /**
+   * @brief Set the spill priority class of all member blobs of the object (the
+   * object itself if it is a blob). Under memory pressure the cold blobs of
+   * `SpillPriority::kLow` (e.g., the scratch intermediates) are spilled first,
+   * and the ones of `SpillPriority::kHigh` last. The blobs are of the
+   * `SpillPriority::kNormal` class by default.
+   */
+  Status SetSpillPriority(ObjectID const& id, SpillPriority priority);
+
   /**
    * Get the allocated size for the given object.
    */
@@ -717,6 +860,10 @@ class Client : public BasicIPCClient,
   Status CreateBuffer(const size_t size, ObjectID& id, Payload& payload,
                       std::shared_ptr<arrow::MutableBuffer>& buffer);
 
+  Status CreateBuffer(const size_t size, const int numa_node, ObjectID& id,
+                      Payload& payload,
+                      std::shared_ptr<arrow::MutableBuffer>& buffer);
+
   /**
    * @brief Get a blob from vineyard server. When obtaining blobs from vineyard
    * server, the memory address in the server process will be mmapped to the
@@ -776,9 +923,12 @@ class Client : public BasicIPCClient,
   Status GetBufferSizes(const std::set<ObjectID>& ids, const bool unsafe,
                         std::map<ObjectID, size_t>& sizes);
 
+  Status PinBlobs(ObjectID const& id, const bool pinned);
+
   friend class Blob;
   friend class BlobWriter;
   friend class ObjectBuilder;
+  friend class ObjectMeta;
   friend class detail::UsageTracker<ObjectID, Payload, Client>;
 };
 
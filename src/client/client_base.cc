@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "client/client.h"
 #include "client/io.h"
+#include "client/pipeline.h"
 #include "client/rpc_client.h"
 #include "client/utils.h"
 #include "common/util/protocols.h"
@@ -33,6 +34,13 @@ ClientBase::ClientBase() : connected_(false), vineyard_conn_(0) {}
 
 Status ClientBase::GetData(const ObjectID id, json& tree,
                            const bool sync_remote, const bool wait) {
+  if (Pipelined()) {
+    std::string message_out;
+    WriteGetDataRequest(id, sync_remote, wait, message_out);
+    return doPipelined(message_out, [&](const json& message_in) {
+      return ReadGetDataReply(message_in, tree);
+    });
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WriteGetDataRequest(id, sync_remote, wait, message_out);
@@ -46,13 +54,25 @@ Status ClientBase::GetData(const ObjectID id, json& tree,
 Status ClientBase::GetData(const std::vector<ObjectID>& ids,
                            std::vector<json>& trees, const bool sync_remote,
                            const bool wait) {
+  std::unordered_map<ObjectID, json> meta_trees;
+  if (Pipelined()) {
+    std::string message_out;
+    WriteGetDataRequest(ids, sync_remote, wait, message_out);
+    RETURN_ON_ERROR(doPipelined(message_out, [&](const json& message_in) {
+      return ReadGetDataReply(message_in, meta_trees);
+    }));
+    trees.reserve(ids.size());
+    for (auto const& id : ids) {
+      trees.emplace_back(meta_trees.at(id));
+    }
+    return Status::OK();
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WriteGetDataRequest(ids, sync_remote, wait, message_out);
   RETURN_ON_ERROR(doWrite(message_out));
   json message_in;
   RETURN_ON_ERROR(doRead(message_in));
-  std::unordered_map<ObjectID, json> meta_trees;
   RETURN_ON_ERROR(ReadGetDataReply(message_in, meta_trees));
   trees.reserve(ids.size());
   for (auto const& id : ids) {
@@ -63,6 +83,13 @@ Status ClientBase::GetData(const std::vector<ObjectID>& ids,
 
 Status ClientBase::CreateData(const json& tree, ObjectID& id,
                               Signature& signature, InstanceID& instance_id) {
+  if (Pipelined()) {
+    std::string message_out;
+    WriteCreateDataRequest(tree, message_out);
+    return doPipelined(message_out, [&](const json& message_in) {
+      return ReadCreateDataReply(message_in, id, signature, instance_id);
+    });
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WriteCreateDataRequest(tree, message_out);
@@ -121,6 +148,13 @@ Status ClientBase::DelData(const ObjectID id, const bool force,
 
 Status ClientBase::DelData(const std::vector<ObjectID>& ids, const bool force,
                            const bool deep) {
+  if (Pipelined()) {
+    std::string message_out;
+    WriteDelDataRequest(ids, force, deep, false, message_out);
+    return doPipelined(message_out, [&](const json& message_in) {
+      return ReadDelDataReply(message_in);
+    });
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WriteDelDataRequest(ids, force, deep, false, message_out);
@@ -220,6 +254,13 @@ Status ClientBase::StopStream(ObjectID const id, const bool failed) {
 }
 
 Status ClientBase::Persist(const ObjectID id) {
+  if (Pipelined()) {
+    std::string message_out;
+    WritePersistRequest(id, message_out);
+    return doPipelined(message_out, [&](const json& message_in) {
+      return ReadPersistReply(message_in);
+    });
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WritePersistRequest(id, message_out);
@@ -242,6 +283,13 @@ Status ClientBase::IfPersist(const ObjectID id, bool& persist) {
 }
 
 Status ClientBase::Exists(const ObjectID id, bool& exists) {
+  if (Pipelined()) {
+    std::string message_out;
+    WriteExistsRequest(id, message_out);
+    return doPipelined(message_out, [&](const json& message_in) {
+      return ReadExistsReply(message_in, exists);
+    });
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WriteExistsRequest(id, message_out);
@@ -310,6 +358,13 @@ Status ClientBase::deepCopyImpl(const ObjectID object_id, ObjectID& target_id,
 }
 
 Status ClientBase::PutName(const ObjectID id, std::string const& name) {
+  if (Pipelined()) {
+    std::string message_out;
+    WritePutNameRequest(id, name, message_out);
+    return doPipelined(message_out, [&](const json& message_in) {
+      return ReadPutNameReply(message_in);
+    });
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WritePutNameRequest(id, name, message_out);
@@ -322,6 +377,13 @@ Status ClientBase::PutName(const ObjectID id, std::string const& name) {
 
 Status ClientBase::GetName(const std::string& name, ObjectID& id,
                            const bool wait) {
+  if (Pipelined()) {
+    std::string message_out;
+    WriteGetNameRequest(name, wait, message_out);
+    return doPipelined(message_out, [&](const json& message_in) {
+      return ReadGetNameReply(message_in, id);
+    });
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WriteGetNameRequest(name, wait, message_out);
@@ -333,6 +395,13 @@ Status ClientBase::GetName(const std::string& name, ObjectID& id,
 }
 
 Status ClientBase::DropName(const std::string& name) {
+  if (Pipelined()) {
+    std::string message_out;
+    WriteDropNameRequest(name, message_out);
+    return doPipelined(message_out, [&](const json& message_in) {
+      return ReadDropNameReply(message_in);
+    });
+  }
   ENSURE_CONNECTED(this);
   std::string message_out;
   WriteDropNameRequest(name, message_out);
@@ -436,6 +505,7 @@ void ClientBase::Disconnect() {
   if (!this->connected_) {
     return;
   }
+  closePipeline();
   std::string message_out;
   WriteExitRequest(message_out);
   VINEYARD_SUPPRESS(doWrite(message_out));
@@ -448,6 +518,7 @@ void ClientBase::CloseSession() {
   if (!Connected()) {
     return;
   }
+  closePipeline();
   std::string message_out;
   WriteDeleteSessionRequest(message_out);
   VINEYARD_SUPPRESS(doWrite(message_out));
@@ -545,13 +616,247 @@ Status ClientBase::Debug(const json& debug, json& result) {
   return Status::OK();
 }
 
+Status ClientBase::EnablePipelining() {
+  std::shared_ptr<PipelinedChannel> channel;
+  return pipeline(channel);
+}
+
+bool ClientBase::Pipelined() const {
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
+  return pipeline_ != nullptr && !pipeline_->Closed();
+}
+
+void ClientBase::GetDataAsync(const ObjectID id, const bool sync_remote,
+                              const bool wait,
+                              callback_t<const json&> callback) {
+  std::string message_out;
+  WriteGetDataRequest(id, sync_remote, wait, message_out);
+  submitPipelined(std::move(message_out),
+                  [callback](const Status& status, const json& message_in) {
+                    json tree;
+                    Status s = status;
+                    if (s.ok()) {
+                      s = ReadGetDataReply(message_in, tree);
+                    }
+                    VINEYARD_DISCARD(callback(s, tree));
+                  });
+}
+
+void ClientBase::GetDataAsync(const std::vector<ObjectID>& ids,
+                              const bool sync_remote, const bool wait,
+                              callback_t<const std::vector<json>&> callback) {
+  std::string message_out;
+  WriteGetDataRequest(ids, sync_remote, wait, message_out);
+  submitPipelined(
+      std::move(message_out),
+      [ids, callback](const Status& status, const json& message_in) {
+        std::vector<json> trees;
+        std::unordered_map<ObjectID, json> meta_trees;
+        Status s = status;
+        if (s.ok()) {
+          s = ReadGetDataReply(message_in, meta_trees);
+        }
+        if (s.ok()) {
+          trees.reserve(ids.size());
+          for (auto const& id : ids) {
+            auto iter = meta_trees.find(id);
+            trees.emplace_back(iter == meta_trees.end() ? json()
+                                                        : iter->second);
+          }
+        }
+        VINEYARD_DISCARD(callback(s, trees));
+      });
+}
+
+void ClientBase::CreateDataAsync(
+    const json& tree,
+    callback_t<const ObjectID, const Signature, const InstanceID> callback) {
+  std::string message_out;
+  WriteCreateDataRequest(tree, message_out);
+  submitPipelined(std::move(message_out),
+                  [callback](const Status& status, const json& message_in) {
+                    ObjectID id = InvalidObjectID();
+                    Signature signature = InvalidSignature();
+                    InstanceID instance_id = UnspecifiedInstanceID();
+                    Status s = status;
+                    if (s.ok()) {
+                      s = ReadCreateDataReply(message_in, id, signature,
+                                              instance_id);
+                    }
+                    VINEYARD_DISCARD(callback(s, id, signature, instance_id));
+                  });
+}
+
+void ClientBase::DelDataAsync(const std::vector<ObjectID>& ids,
+                              const bool force, const bool deep,
+                              callback_t<> callback) {
+  std::string message_out;
+  WriteDelDataRequest(ids, force, deep, false, message_out);
+  submitPipelined(std::move(message_out),
+                  [callback](const Status& status, const json& message_in) {
+                    VINEYARD_DISCARD(callback(
+                        status.ok() ? ReadDelDataReply(message_in) : status));
+                  });
+}
+
+void ClientBase::PersistAsync(const ObjectID id, callback_t<> callback) {
+  std::string message_out;
+  WritePersistRequest(id, message_out);
+  submitPipelined(std::move(message_out),
+                  [callback](const Status& status, const json& message_in) {
+                    VINEYARD_DISCARD(callback(
+                        status.ok() ? ReadPersistReply(message_in) : status));
+                  });
+}
+
+void ClientBase::ExistsAsync(const ObjectID id,
+                             callback_t<const bool> callback) {
+  std::string message_out;
+  WriteExistsRequest(id, message_out);
+  submitPipelined(std::move(message_out),
+                  [callback](const Status& status, const json& message_in) {
+                    bool exists = false;
+                    Status s = status;
+                    if (s.ok()) {
+                      s = ReadExistsReply(message_in, exists);
+                    }
+                    VINEYARD_DISCARD(callback(s, exists));
+                  });
+}
+
+void ClientBase::PutNameAsync(const ObjectID id, std::string const& name,
+                              callback_t<> callback) {
+  std::string message_out;
+  WritePutNameRequest(id, name, message_out);
+  submitPipelined(std::move(message_out),
+                  [callback](const Status& status, const json& message_in) {
+                    VINEYARD_DISCARD(callback(
+                        status.ok() ? ReadPutNameReply(message_in) : status));
+                  });
+}
+
+void ClientBase::GetNameAsync(const std::string& name, const bool wait,
+                              callback_t<const ObjectID> callback) {
+  std::string message_out;
+  WriteGetNameRequest(name, wait, message_out);
+  submitPipelined(std::move(message_out),
+                  [callback](const Status& status, const json& message_in) {
+                    ObjectID id = InvalidObjectID();
+                    Status s = status;
+                    if (s.ok()) {
+                      s = ReadGetNameReply(message_in, id);
+                    }
+                    VINEYARD_DISCARD(callback(s, id));
+                  });
+}
+
+void ClientBase::DropNameAsync(const std::string& name,
+                               callback_t<> callback) {
+  std::string message_out;
+  WriteDropNameRequest(name, message_out);
+  submitPipelined(std::move(message_out),
+                  [callback](const Status& status, const json& message_in) {
+                    VINEYARD_DISCARD(callback(
+                        status.ok() ? ReadDropNameReply(message_in) : status));
+                  });
+}
+
+Status ClientBase::connectPipeline(int& conn) {
+  return Status::NotImplemented(
+      "The client doesn't support pipelined requests");
+}
+
+Status ClientBase::pipeline(std::shared_ptr<PipelinedChannel>& channel) {
+  std::lock_guard<std::mutex> lock(pipeline_mutex_);
+  if (!connected_) {
+    return Status::ConnectionError("Client is not connected");
+  }
+  if (pipeline_ != nullptr && !pipeline_->Closed()) {
+    channel = pipeline_;
+    return Status::OK();
+  }
+  int conn = -1;
+  RETURN_ON_ERROR(connectPipeline(conn));
+  auto status = [&]() -> Status {
+    std::string message_out;
+    WriteRegisterRequest(message_out, StoreType::kDefault);
+    RETURN_ON_ERROR(send_message(conn, message_out));
+    std::string message_in;
+    RETURN_ON_ERROR(recv_message(conn, message_in));
+    json root;
+    RETURN_ON_ERROR(CATCH_JSON_ERROR([&]() -> Status {
+      root = json::parse(message_in);
+      return Status::OK();
+    }()));
+    std::string ipc_socket_value, rpc_endpoint_value, server_version_value;
+    InstanceID instance_id_value;
+    SessionID session_id_value;
+    bool store_match;
+    RETURN_ON_ERROR(ReadRegisterReply(
+        root, ipc_socket_value, rpc_endpoint_value, instance_id_value,
+        session_id_value, server_version_value, store_match));
+    if (session_id_value != session_id_) {
+      return Status::Invalid(
+          "The pipelined connection is connected to a different session");
+    }
+    return Status::OK();
+  }();
+  if (!status.ok()) {
+    close(conn);
+    return status;
+  }
+  pipeline_ = std::make_shared<PipelinedChannel>(conn);
+  channel = pipeline_;
+  return Status::OK();
+}
+
+void ClientBase::closePipeline() {
+  std::shared_ptr<PipelinedChannel> channel;
+  {
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    channel.swap(pipeline_);
+  }
+  // the pending requests fail when the channel is destroyed
+  channel.reset();
+}
+
+void ClientBase::submitPipelined(
+    std::string message_out,
+    std::function<void(const Status&, const json&)> callback) {
+  std::shared_ptr<PipelinedChannel> channel;
+  auto status = pipeline(channel);
+  if (!status.ok()) {
+    callback(status, json());
+    return;
+  }
+  channel->Submit(std::move(message_out), std::move(callback));
+}
+
+Status ClientBase::doPipelined(
+    const std::string& message_out,
+    std::function<Status(const json&)> const& read_reply) {
+  std::promise<Status> promise;
+  auto future = promise.get_future();
+  submitPipelined(message_out,
+                  [&promise, &read_reply](const Status& status,
+                                          const json& message_in) {
+                    promise.set_value(status.ok() ? read_reply(message_in)
+                                                  : status);
+                  });
+  return future.get();
+}
+
 InstanceStatus::InstanceStatus(const json& tree)
     : instance_id(tree["instance_id"].get<InstanceID>()),
       deployment(tree["deployment"].get_ref<const std::string&>()),
       memory_usage(tree["memory_usage"].get<size_t>()),
       memory_limit(tree["memory_limit"].get<size_t>()),
+      memory_reserved(tree.value("memory_reserved", size_t{0})),
       deferred_requests(tree["deferred_requests"].get<size_t>()),
       ipc_connections(tree["ipc_connections"].get<size_t>()),
-      rpc_connections(tree["rpc_connections"].get<size_t>()) {}
+      rpc_connections(tree["rpc_connections"].get<size_t>()),
+      cold_blobs(tree.value("cold_blobs", json::object())),
+      compressed_tier(tree.value("compressed_tier", json::object())),
+      metrics(tree.value("metrics", json::object())) {}
 
 }  // namespace vineyard
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef SRC_CLIENT_CLIENT_BASE_H_
 #define SRC_CLIENT_CLIENT_BASE_H_
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -24,6 +25,7 @@ limitations under the License.
 #include <vector>
 
 #include "client/ds/object_meta.h"
+#include "common/util/callback.h"
 #include "common/util/status.h"
 #include "common/util/uuid.h"
 #include "common/util/version.h"
@@ -36,6 +38,7 @@ enum class StreamOpenMode {
 };
 
 struct InstanceStatus;
+class PipelinedChannel;
 
 /**
  * @brief ClientBase is the base class for vineyard IPC and RPC client.
@@ -526,6 +529,62 @@ class ClientBase {
    */
   Status Debug(const json& debug, json& tree);
 
+  /**
+   * @brief Open a dedicated pipelined connection to the vineyard server, on
+   * which many metadata requests can be in flight at the same time and the
+   * replies may arrive out of order.
+   *
+   * Once the pipelined connection is open, the asynchronous API below and
+   * their synchronous counterparts (`GetData`, `CreateData`, `DelData`,
+   * `Persist`, `Exists`, `PutName`, `GetName` and `DropName`) go through it
+   * without taking the client mutex, thus the requests issued by concurrent
+   * threads overlap rather than queue behind each other. The requests that
+   * transfer buffers or file descriptors still use the main connection.
+   *
+   * The asynchronous API opens the pipelined connection on its first use.
+   *
+   * @return Status that indicates whether the connection has succeeded.
+   */
+  Status EnablePipelining();
+
+  /**
+   * @brief Whether the pipelined connection is open.
+   */
+  bool Pipelined() const;
+
+  /**
+   * @brief The asynchronous variants of the metadata operations.
+   *
+   * The callbacks are invoked on the reader thread of the pipelined
+   * connection, thus they must be short and must not wait for other
+   * requests of the same client, including the synchronous ones.
+   */
+  void GetDataAsync(const ObjectID id, const bool sync_remote,
+                    const bool wait, callback_t<const json&> callback);
+
+  void GetDataAsync(const std::vector<ObjectID>& ids, const bool sync_remote,
+                    const bool wait,
+                    callback_t<const std::vector<json>&> callback);
+
+  void CreateDataAsync(
+      const json& tree,
+      callback_t<const ObjectID, const Signature, const InstanceID> callback);
+
+  void DelDataAsync(const std::vector<ObjectID>& ids, const bool force,
+                    const bool deep, callback_t<> callback);
+
+  void PersistAsync(const ObjectID id, callback_t<> callback);
+
+  void ExistsAsync(const ObjectID id, callback_t<const bool> callback);
+
+  void PutNameAsync(const ObjectID id, std::string const& name,
+                    callback_t<> callback);
+
+  void GetNameAsync(const std::string& name, const bool wait,
+                    callback_t<const ObjectID> callback);
+
+  void DropNameAsync(const std::string& name, callback_t<> callback);
+
  protected:
   Status doWrite(const std::string& message_out);
 
@@ -547,6 +606,34 @@ class ClientBase {
                       std::string const& peer,
                       std::string const& peer_rpc_endpoint);
 
+  /**
+   * @brief Open a new connection to the same vineyard server for the
+   * pipelined requests.
+   */
+  virtual Status connectPipeline(int& conn);
+
+  /**
+   * @brief Get the pipelined channel, open it if required.
+   */
+  Status pipeline(std::shared_ptr<PipelinedChannel>& channel);
+
+  void closePipeline();
+
+  /**
+   * @brief Send the request on the pipelined connection, the callback is
+   * invoked with the reply.
+   */
+  void submitPipelined(
+      std::string message_out,
+      std::function<void(const Status&, const json&)> callback);
+
+  /**
+   * @brief Send the request on the pipelined connection and wait for the
+   * reply.
+   */
+  Status doPipelined(const std::string& message_out,
+                     std::function<Status(const json&)> const& read_reply);
+
   mutable bool connected_;
   std::string ipc_socket_;
   std::string rpc_endpoint_;
@@ -557,6 +644,10 @@ class ClientBase {
 
   // A mutex which protects the client.
   std::recursive_mutex client_mutex_;
+
+  // The connection for pipelined requests, see `EnablePipelining()`.
+  mutable std::mutex pipeline_mutex_;
+  std::shared_ptr<PipelinedChannel> pipeline_;
 };
 
 struct InstanceStatus {
@@ -568,12 +659,27 @@ struct InstanceStatus {
   const size_t memory_usage;
   /// The memory upper bound of this vineyard server, in bytes.
   const size_t memory_limit;
+  /// The memory guaranteed to the session, in bytes.
+  const size_t memory_reserved;
   /// How many requests are deferred in the queue.
   const size_t deferred_requests;
   /// How many Client connects to this vineyard server.
   const size_t ipc_connections;
   /// How many RPCClient connects to this vineyard server.
   const size_t rpc_connections;
+  /// The cold (not in-use) blobs of each spill priority class ("low",
+  /// "normal", "high") and the pinned ones ("pinned"): the number of
+  /// "objects" and "bytes" that are resident, and of "spilled_objects" and
+  /// "spilled_bytes".
+  const json cold_blobs;
+  /// The compressed tier of cold blobs: the number of "objects" in it, their
+  /// "bytes" and "compressed_bytes", and the total number of blobs that have
+  /// been moved into it ("compressed_objects") and back to the shared memory
+  /// ("decompressed_objects").
+  const json compressed_tier;
+  /// The metrics of the vineyard server (see `--metrics`), by name and then
+  /// by labels, empty if the metrics are disabled.
+  const json metrics;
 
   /**
    * @brief Initialize the status value using a json returned from the vineyard
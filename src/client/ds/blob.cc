@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "client/ds/blob.h"
 
+#include <sys/syscall.h>
+#include <unistd.h>
+
 #include <cstring>
 #include <iomanip>
 #include <iostream>
@@ -32,6 +35,22 @@ size_t Blob::size() const { return allocated_size(); }
 
 size_t Blob::allocated_size() const { return size_; }
 
+int Blob::numa_node() const {
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+  if (size_ == 0 || buffer_ == nullptr) {
+    return -1;
+  }
+  // MPOL_F_NODE | MPOL_F_ADDR: query the node of the page at `addr`
+  constexpr unsigned long kMpolFNodeAddr = (1 << 0) | (1 << 1);
+  int node = -1;
+  if (syscall(SYS_get_mempolicy, &node, nullptr, 0,
+              const_cast<uint8_t*>(buffer_->data()), kMpolFNodeAddr) == 0) {
+    return node;
+  }
+#endif
+  return -1;
+}
+
 const char* Blob::data() const {
   if (size_ == 0) {
     return nullptr;
@@ -191,6 +210,8 @@ ObjectID BlobWriter::id() const { return object_id_; }
 
 size_t BlobWriter::size() const { return buffer_ ? buffer_->size() : 0; }
 
+int BlobWriter::numa_node() const { return payload_.numa_node; }
+
 char* BlobWriter::data() {
   return reinterpret_cast<char*>(buffer_->mutable_data());
 }
@@ -290,6 +311,7 @@ Status BufferSet::EmplaceBuffer(ObjectID const id) {
 
 Status BufferSet::EmplaceBuffer(ObjectID const id,
                                 std::shared_ptr<arrow::Buffer> const& buffer) {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto p = buffers_.find(id);
   if (p == buffers_.end()) {
     return Status::Invalid(
@@ -323,6 +345,7 @@ bool BufferSet::Contains(ObjectID const id) const {
 
 bool BufferSet::Get(ObjectID const id,
                     std::shared_ptr<arrow::Buffer>& buffer) const {
+  std::lock_guard<std::mutex> lock(mutex_);
   auto iter = buffers_.find(id);
   if (iter == buffers_.end()) {
     return false;
@@ -332,4 +355,23 @@ bool BufferSet::Get(ObjectID const id,
   }
 }
 
+Status BufferSet::Resolve(
+    ObjectID const id, std::shared_ptr<arrow::Buffer>& buffer,
+    std::function<Status(std::shared_ptr<arrow::Buffer>&)> const& resolver) {
+  std::lock_guard<std::mutex> lock(resolve_mutex_);
+  if (!Get(id, buffer)) {
+    return Status::ObjectNotExists("The target blob " + ObjectIDToString(id) +
+                                   " doesn't exist");
+  }
+  if (buffer != nullptr) {
+    // has been filled by others
+    return Status::OK();
+  }
+  RETURN_ON_ERROR(resolver(buffer));
+  if (buffer != nullptr) {
+    RETURN_ON_ERROR(EmplaceBuffer(id, buffer));
+  }
+  return Status::OK();
+}
+
 }  // namespace vineyard
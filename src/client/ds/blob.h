@@ -17,9 +17,11 @@ limitations under the License.
 #define SRC_CLIENT_DS_BLOB_H_
 
 #include <cstdint>
+#include <functional>
 #include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -70,6 +72,13 @@ class Blob : public Registered<Blob> {
    */
   size_t allocated_size() const;
 
+  /**
+   * @brief Get the NUMA node where the first page of the data payload resides.
+   *
+   * @return The NUMA node, or -1 if it cannot be determined.
+   */
+  int numa_node() const;
+
   /**
    * @brief Get the const data pointer of the data payload in the blob.
    *
@@ -180,6 +189,13 @@ class BlobWriter : public ObjectBuilder {
    */
   size_t size() const;
 
+  /**
+   * @brief Get the NUMA node that the blob is placed on by the server.
+   *
+   * @return The NUMA node, or -1 if the blob is not placed on a specific node.
+   */
+  int numa_node() const;
+
   /**
    * @brief Get the data pointer of the data payload in the blob.
    *
@@ -285,10 +301,26 @@ class BufferSet {
 
   bool Get(ObjectID const id, std::shared_ptr<arrow::Buffer>& buffer) const;
 
+  /**
+   * @brief Fill the buffer of the given blob using the resolver if it hasn't
+   * been filled yet, e.g., the lazily mapped blobs of an ObjectMeta.
+   *
+   * The buffer set is shared by the copies of the metadata, the resolutions
+   * are serialized thus each blob will be filled only once, and `Get()`
+   * and `EmplaceBuffer()` are safe to be used concurrently with it.
+   */
+  Status Resolve(
+      ObjectID const id, std::shared_ptr<arrow::Buffer>& buffer,
+      std::function<Status(std::shared_ptr<arrow::Buffer>&)> const& resolver);
+
  private:
   // blob ids to buffer mapping: local blobs (not null) + remote blobs (null).
   std::set<ObjectID> buffer_ids_;
   std::map<ObjectID, std::shared_ptr<arrow::Buffer>> buffers_;
+
+  // guards the buffers being filled after the set has been shared
+  mutable std::mutex mutex_;
+  std::mutex resolve_mutex_;
 };
 
 }  // namespace vineyard
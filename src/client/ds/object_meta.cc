@@ -32,6 +32,7 @@ ObjectMeta::ObjectMeta(const ObjectMeta& other) {
   this->buffer_set_ = other.buffer_set_;
   this->incomplete_ = other.incomplete_;
   this->force_local_ = other.force_local_;
+  this->lazy_ = other.lazy_;
 }
 
 ObjectMeta& ObjectMeta::operator=(ObjectMeta const& other) {
@@ -40,6 +41,7 @@ ObjectMeta& ObjectMeta::operator=(ObjectMeta const& other) {
   this->buffer_set_ = other.buffer_set_;
   this->incomplete_ = other.incomplete_;
   this->force_local_ = other.force_local_;
+  this->lazy_ = other.lazy_;
   return *this;
 }
 
@@ -190,17 +192,37 @@ ObjectMeta ObjectMeta::GetMemberMeta(const std::string& name) const {
   if (this->force_local_) {
     ret.ForceLocal();
   }
+  ret.SetLazy(this->lazy_);
   return ret;
 }
 
 Status ObjectMeta::GetBuffer(const ObjectID blob_id,
                              std::shared_ptr<arrow::Buffer>& buffer) const {
-  if (buffer_set_->Get(blob_id, buffer)) {
-    return Status::OK();
-  } else {
+  if (!buffer_set_->Get(blob_id, buffer)) {
     return Status::ObjectNotExists(
         "The target blob " + ObjectIDToString(blob_id) + " doesn't exist");
   }
+  if (buffer != nullptr || !lazy_ || !IsLocal()) {
+    return Status::OK();
+  }
+  // resolve the buffer of the local blob on its first access, the buffer set
+  // is shared by the copies of this metadata and the resolution is
+  // serialized inside it.
+  Client* client = dynamic_cast<Client*>(client_);
+  if (client == nullptr) {
+    return Status::OK();
+  }
+  return buffer_set_->Resolve(
+      blob_id, buffer,
+      [client, blob_id](std::shared_ptr<arrow::Buffer>& resolved) -> Status {
+        std::map<ObjectID, std::shared_ptr<arrow::Buffer>> buffers;
+        RETURN_ON_ERROR(client->GetBuffers({blob_id}, buffers));
+        auto iter = buffers.find(blob_id);
+        if (iter != buffers.end()) {
+          resolved = iter->second;
+        }
+        return Status::OK();
+      });
 }
 
 void ObjectMeta::SetBuffer(const ObjectID& id,
@@ -216,6 +238,7 @@ void ObjectMeta::Reset() {
   meta_ = json::object();
   buffer_set_.reset(new BufferSet());
   incomplete_ = false;
+  lazy_ = false;
 }
 
 size_t ObjectMeta::MemoryUsage() const {
@@ -234,6 +257,8 @@ void ObjectMeta::PrintMeta() const { std::clog << meta_.dump(4) << std::endl; }
 
 const bool ObjectMeta::incomplete() const { return incomplete_; }
 
+const bool ObjectMeta::lazy() const { return lazy_; }
+
 const json& ObjectMeta::MetaData() const { return meta_; }
 
 json& ObjectMeta::MutMetaData() { return meta_; }
@@ -301,6 +326,8 @@ void ObjectMeta::SetSignature(const Signature signature) {
   meta_["signature"] = signature;
 }
 
+void ObjectMeta::SetLazy(const bool lazy) { lazy_ = lazy; }
+
 template <>
 const json ObjectMeta::GetKeyValue<json>(const std::string& key) const {
   try {
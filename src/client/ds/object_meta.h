@@ -174,12 +174,14 @@ class ObjectMeta {
    *
    * @param T The type of metadata's value.
    * @param key The name of metadata entry, it will be first convert to JSON
-   * array by `nlohmann::json`.
+   * array by `nlohmann::json`, or the compact binary encoding for large
+   * containers of arithmetic values when enabled, see also
+   * `encode_container`.
    * @param value The value of the metadata entry.
    */
   template <typename T>
   void AddKeyValue(const std::string& key, std::set<T> const& values) {
-    meta_[key] = json_to_string(json(values));
+    meta_[key] = encode_container(values);
   }
 
   /**
@@ -187,12 +189,14 @@ class ObjectMeta {
    *
    * @param T The type of metadata's value.
    * @param key The name of metadata entry, it will be first convert to JSON
-   * array by `nlohmann::json`.
+   * array by `nlohmann::json`, or the compact binary encoding for large
+   * containers of arithmetic values when enabled, see also
+   * `encode_container`.
    * @param value The value of the metadata entry.
    */
   template <typename T>
   void AddKeyValue(const std::string& key, std::vector<T> const& values) {
-    meta_[key] = json_to_string(json(values));
+    meta_[key] = encode_container(values);
   }
 
   /**
@@ -200,12 +204,14 @@ class ObjectMeta {
    *
    * @param T The type of metadata's value.
    * @param key The name of metadata entry, it will be first convert to JSON
-   * array by `nlohmann::json`.
+   * array by `nlohmann::json`, or the compact binary encoding for large
+   * containers of arithmetic values when enabled, see also
+   * `encode_container`.
    * @param value The value of the metadata entry.
    */
   template <typename T>
   void AddKeyValue(const std::string& key, Tuple<T> const& values) {
-    meta_[key] = json_to_string(json(values));
+    meta_[key] = encode_container(values);
   }
 
   /**
@@ -648,6 +654,10 @@ class ObjectMeta {
   /**
    * @brief Get buffer member (directed or indirected) from the metadata. The
    * metadata should has already been initialized.
+   *
+   * For lazy metadata (see `Client::GetMetaData()`), the buffer of a local
+   * blob is mapped from vineyard server on the first access, the mapping is
+   * synchronized by the buffer set thus it is safe to be called concurrently.
    */
   Status GetBuffer(const ObjectID blob_id,
                    std::shared_ptr<arrow::Buffer>& buffer) const;
@@ -671,6 +681,11 @@ class ObjectMeta {
 
   const bool incomplete() const;
 
+  /**
+   * @brief Whether the buffers of the metadata are mapped on demand.
+   */
+  const bool lazy() const;
+
   // FIXME: the following three methods should be `protected`
   const json& MetaData() const;
 
@@ -706,6 +721,8 @@ class ObjectMeta {
 
   void SetSignature(const Signature signature);
 
+  void SetLazy(const bool lazy);
+
   // hold a client_ reference, since we already hold blobs in metadata, which,
   // depends on that the "client_" should be valid.
   ClientBase* client_ = nullptr;
@@ -720,6 +737,10 @@ class ObjectMeta {
   // force local: make it as a local metadata even when no client associated.
   mutable bool force_local_ = false;
 
+  // lazy: the buffers haven't been mapped yet, and will be resolved by the
+  // associated client on the first access.
+  bool lazy_ = false;
+
   friend class ClientBase;
   friend class Client;
   friend class PlasmaClient;
@@ -0,0 +1,141 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "client/pipeline.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "client/io.h"
+
+namespace vineyard {
+
+PipelinedChannel::PipelinedChannel(int conn)
+    : state_(std::make_shared<State>(conn)) {
+  std::shared_ptr<State> state = state_;
+  reader_ = std::thread([state]() { readLoop(state); });
+}
+
+PipelinedChannel::~PipelinedChannel() {
+  // wake up the reader, which fails the pending requests and exits
+  shutdown(state_->conn, SHUT_RDWR);
+  if (reader_.joinable()) {
+    if (reader_.get_id() == std::this_thread::get_id()) {
+      // destroyed inside a callback: the reader keeps the state alive until
+      // it exits
+      reader_.detach();
+    } else {
+      reader_.join();
+    }
+  }
+}
+
+PipelinedChannel::State::~State() { close(conn); }
+
+void PipelinedChannel::Submit(std::string message_out,
+                              reply_callback_t callback) {
+  RequestID req_id = next_req_id_.fetch_add(1);
+  WriteRequestID(req_id, message_out);
+  bool closed = false;
+  {
+    std::lock_guard<std::mutex> lock(state_->pending_mutex);
+    closed = state_->closed;
+    if (!closed) {
+      state_->pending.emplace(req_id, std::move(callback));
+    }
+  }
+  if (closed) {
+    callback(Status::ConnectionError("The pipelined channel is closed"),
+             json());
+    return;
+  }
+  Status status;
+  {
+    std::lock_guard<std::mutex> lock(state_->write_mutex);
+    status = send_message(state_->conn, message_out);
+  }
+  if (!status.ok()) {
+    reply_callback_t failed;
+    {
+      std::lock_guard<std::mutex> lock(state_->pending_mutex);
+      auto iter = state_->pending.find(req_id);
+      if (iter != state_->pending.end()) {
+        failed = std::move(iter->second);
+        state_->pending.erase(iter);
+      }
+    }
+    if (failed) {
+      failed(status, json());
+    }
+  }
+}
+
+bool PipelinedChannel::Closed() const {
+  std::lock_guard<std::mutex> lock(state_->pending_mutex);
+  return state_->closed;
+}
+
+void PipelinedChannel::readLoop(std::shared_ptr<State> state) {
+  while (true) {
+    std::string message_in;
+    auto status = recv_message(state->conn, message_in);
+    json reply;
+    if (status.ok()) {
+      status = CATCH_JSON_ERROR([&]() -> Status {
+        reply = json::parse(message_in);
+        return Status::OK();
+      }());
+    }
+    if (!status.ok()) {
+      failPending(*state, status);
+      return;
+    }
+    RequestID req_id = ReadRequestID(reply);
+    reply_callback_t callback;
+    {
+      std::lock_guard<std::mutex> lock(state->pending_mutex);
+      auto iter = state->pending.find(req_id);
+      if (iter != state->pending.end()) {
+        callback = std::move(iter->second);
+        state->pending.erase(iter);
+      }
+    }
+    if (callback) {
+      callback(Status::OK(), reply);
+    }
+  }
+}
+
+void PipelinedChannel::failPending(State& state, const Status& status) {
+  std::vector<reply_callback_t> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(state.pending_mutex);
+    state.closed = true;
+    for (auto& item : state.pending) {
+      callbacks.emplace_back(std::move(item.second));
+    }
+    state.pending.clear();
+  }
+  for (auto& callback : callbacks) {
+    callback(status, json());
+  }
+}
+
+}  // namespace vineyard
@@ -0,0 +1,96 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_CLIENT_PIPELINE_H_
+#define SRC_CLIENT_PIPELINE_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "common/util/json.h"
+#include "common/util/protocols.h"
+#include "common/util/status.h"
+
+namespace vineyard {
+
+/**
+ * @brief PipelinedChannel multiplexes many in-flight requests over a single
+ * (registered) connection to vineyardd.
+ *
+ * Every request is tagged with a request id, and a reader thread dispatches
+ * the replies, which may arrive out of order, to the callbacks of the
+ * corresponding requests. The callbacks are invoked on the reader thread,
+ * thus they must not block on other requests of the same channel.
+ */
+class PipelinedChannel {
+ public:
+  using reply_callback_t = std::function<void(const Status&, const json&)>;
+
+  /**
+   * @brief Take the ownership of the connection `conn`.
+   */
+  explicit PipelinedChannel(int conn);
+
+  ~PipelinedChannel();
+
+  PipelinedChannel(const PipelinedChannel&) = delete;
+  PipelinedChannel& operator=(const PipelinedChannel&) = delete;
+
+  /**
+   * @brief Send the encoded request, the callback will receive the reply, or
+   * the error if the channel is broken before the reply arrives.
+   */
+  void Submit(std::string message_out, reply_callback_t callback);
+
+  bool Closed() const;
+
+ private:
+  /**
+   * @brief The state shared with the reader thread, which outlives the
+   * channel when the channel is destroyed inside a callback (i.e., on the
+   * reader thread). The connection is closed with the state.
+   */
+  struct State {
+    explicit State(int conn) : conn(conn) {}
+
+    ~State();
+
+    int conn;
+
+    std::mutex write_mutex;
+
+    mutable std::mutex pending_mutex;
+    std::unordered_map<RequestID, reply_callback_t> pending;
+    bool closed = false;
+  };
+
+  static void readLoop(std::shared_ptr<State> state);
+
+  static void failPending(State& state, const Status& status);
+
+  std::atomic<RequestID> next_req_id_{1};
+  std::shared_ptr<State> state_;
+
+  std::thread reader_;
+};
+
+}  // namespace vineyard
+
+#endif  // SRC_CLIENT_PIPELINE_H_
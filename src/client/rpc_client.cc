@@ -93,6 +93,14 @@ Status RPCClient::Connect(const std::string& host, uint32_t port) {
   return Status::OK();
 }
 
+Status RPCClient::connectPipeline(int& conn) {
+  size_t pos = rpc_endpoint_.find(":");
+  RETURN_ON_ASSERT(pos != std::string::npos);
+  return connect_rpc_socket_retry(
+      rpc_endpoint_.substr(0, pos),
+      static_cast<uint32_t>(std::stoul(rpc_endpoint_.substr(pos + 1))), conn);
+}
+
 Status RPCClient::Fork(RPCClient& client) {
   RETURN_ON_ASSERT(!client.Connected(),
                    "The client has already been connected to vineyard server");
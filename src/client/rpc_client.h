@@ -264,6 +264,9 @@ class RPCClient : public ClientBase {
   Status GetRemoteBlobs(std::vector<ObjectID> const& ids, const bool unsafe,
                         std::vector<std::shared_ptr<RemoteBlob>>& remote_blobs);
 
+ protected:
+  Status connectPipeline(int& conn) override;
+
  private:
   InstanceID remote_instance_id_;
 };
@@ -0,0 +1,423 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "client/snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/ds/blob.h"
+#include "common/util/json.h"
+#include "common/util/logging.h"
+
+namespace vineyard {
+
+namespace detail {
+
+static constexpr int kSnapshotVersion = 1;
+static constexpr size_t kSnapshotAlignment = 4096;
+// the largest single read/write, as linux transfers at most 2GB per call
+static constexpr size_t kSnapshotIOSize = static_cast<size_t>(1) << 30;
+
+static const char* kSnapshotMeta = "meta.json";
+static const char* kSnapshotBlobs = "blobs";
+
+struct SnapshotBlob {
+  ObjectID id;
+  size_t offset;
+  size_t size;
+};
+
+static Status errno_to_status(const std::string& what,
+                              const std::string& path) {
+  return Status::IOError(what + " '" + path + "': " + strerror(errno));
+}
+
+static Status find_blobs(const json& tree, const InstanceID instance_id,
+                         std::set<ObjectID>& blobs) {
+  ObjectID id = ObjectIDFromString(tree["id"].get_ref<std::string const&>());
+  if (IsBlob(id)) {
+    if (id != EmptyBlobID() &&
+        tree.value("instance_id", instance_id) != instance_id) {
+      return Status::Invalid(
+          "The blob " + ObjectIDToString(id) +
+          " lives in another instance, the members of a global object that "
+          "spans multiple instances must be snapshotted on their instances");
+    }
+    blobs.emplace(id);
+    return Status::OK();
+  }
+  for (auto& item : tree) {
+    if (item.is_object()) {
+      RETURN_ON_ERROR(find_blobs(item, instance_id, blobs));
+    }
+  }
+  return Status::OK();
+}
+
+// runs `func(i)` for `i` in `[0, size)` with `concurrency` threads, and
+// returns the first error
+template <typename FUNC_T>
+static Status parallel_run(size_t size, int concurrency, const FUNC_T& func) {
+  std::atomic<size_t> next(0);
+  std::vector<Status> statuses(std::max(concurrency, 1));
+  auto worker = [&](int tid) {
+    for (size_t i = next.fetch_add(1); i < size; i = next.fetch_add(1)) {
+      Status status = func(i);
+      if (!status.ok()) {
+        statuses[tid] = status;
+        return;
+      }
+    }
+  };
+  if (statuses.size() == 1) {
+    worker(0);
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t tid = 0; tid < statuses.size(); ++tid) {
+      threads.emplace_back(worker, static_cast<int>(tid));
+    }
+    for (auto& thrd : threads) {
+      thrd.join();
+    }
+  }
+  for (auto const& status : statuses) {
+    RETURN_ON_ERROR(status);
+  }
+  return Status::OK();
+}
+
+static Status write_fully(int fd, const char* data, size_t size, size_t offset,
+                          const std::string& path) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, data, std::min(size, kSnapshotIOSize), offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno_to_status("Failed to write the snapshot", path);
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return Status::OK();
+}
+
+static Status read_fully(int fd, char* data, size_t size, size_t offset,
+                         const std::string& path) {
+  while (size > 0) {
+    ssize_t read = pread(fd, data, std::min(size, kSnapshotIOSize), offset);
+    if (read < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno_to_status("Failed to read the snapshot", path);
+    }
+    if (read == 0) {
+      return Status::IOError("The snapshot '" + path + "' is truncated");
+    }
+    data += read;
+    size -= read;
+    offset += read;
+  }
+  return Status::OK();
+}
+
+// rebuilds the metadata tree bottom up, with the blobs replaced, the members
+// shared in the tree (e.g., a vertex map) are rebuilt only once, and the
+// objects created are recorded in `created` for cleaning up on failures.
+static Status rebuild(Client& client, const json& tree,
+                      const std::map<ObjectID, std::shared_ptr<Blob>>& blobs,
+                      std::map<ObjectID, ObjectMeta>& rebuilt,
+                      std::set<ObjectID>& persisted,
+                      std::vector<ObjectID>& created, ObjectMeta& target) {
+  bool global = tree.value("global", false);
+  for (auto const& item : tree.items()) {
+    auto const& key = item.key();
+    auto const& value = item.value();
+    if (value.is_object()) {
+      ObjectID member_id =
+          ObjectIDFromString(value["id"].get_ref<std::string const&>());
+      if (IsBlob(member_id)) {
+        auto blob = blobs.find(member_id);
+        if (blob == blobs.end()) {
+          return Status::Invalid("The blob " + ObjectIDToString(member_id) +
+                                 " is missing in the snapshot");
+        }
+        target.AddMember(key, blob->second);
+        continue;
+      }
+      auto member = rebuilt.find(member_id);
+      if (member == rebuilt.end()) {
+        ObjectMeta meta;
+        RETURN_ON_ERROR(rebuild(client, value, blobs, rebuilt, persisted,
+                                created, meta));
+        member = rebuilt.emplace(member_id, meta).first;
+      }
+      if (global && persisted.find(member_id) == persisted.end()) {
+        // the members of global objects must be persisted in advance
+        RETURN_ON_ERROR(client.Persist(member->second.GetId()));
+        persisted.emplace(member_id);
+      }
+      target.AddMember(key, member->second);
+    } else if (key == "id" || key == "signature" || key == "instance_id" ||
+               key == "transient") {
+      // assigned when creating the metadata
+      continue;
+    } else if (value.is_string()) {
+      target.AddKeyValue(key, value.get_ref<std::string const&>());
+    } else if (value.is_boolean()) {
+      target.AddKeyValue(key, value.get<bool>());
+    } else if (value.is_number_unsigned()) {
+      target.AddKeyValue(key, value.get<uint64_t>());
+    } else if (value.is_number_integer()) {
+      target.AddKeyValue(key, value.get<int64_t>());
+    } else if (value.is_number_float()) {
+      target.AddKeyValue(key, value.get<double>());
+    } else {
+      target.AddKeyValue(key, value);
+    }
+  }
+  ObjectID target_id = InvalidObjectID();
+  RETURN_ON_ERROR(client.CreateMetaData(target, target_id));
+  target.SetId(target_id);
+  created.push_back(target_id);
+  return Status::OK();
+}
+
+}  // namespace detail
+
+Status SnapshotObject(Client& client, const ObjectID id,
+                      const std::string& path, const int concurrency) {
+  ObjectMeta meta;
+  RETURN_ON_ERROR(client.GetMetaData(id, meta, true));
+  json const& tree = meta.MetaData();
+
+  std::set<ObjectID> blob_ids;
+  RETURN_ON_ERROR(detail::find_blobs(tree, client.instance_id(), blob_ids));
+  blob_ids.erase(EmptyBlobID());
+  std::vector<std::shared_ptr<Blob>> blobs;
+  RETURN_ON_ERROR(client.GetBlobs(
+      std::vector<ObjectID>(blob_ids.begin(), blob_ids.end()), blobs));
+
+  std::vector<detail::SnapshotBlob> layout;
+  size_t offset = 0;
+  for (auto const& blob : blobs) {
+    size_t size = blob->allocated_size();
+    layout.push_back({blob->id(), offset, size});
+    offset += (size + detail::kSnapshotAlignment - 1) /
+              detail::kSnapshotAlignment * detail::kSnapshotAlignment;
+  }
+
+  if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    return detail::errno_to_status("Failed to create the snapshot", path);
+  }
+  // invalidates the previous snapshot in the directory first
+  std::string meta_path = path + "/" + detail::kSnapshotMeta;
+  if (unlink(meta_path.c_str()) != 0 && errno != ENOENT) {
+    return detail::errno_to_status("Failed to replace the snapshot",
+                                   meta_path);
+  }
+  std::string blobs_path = path + "/" + detail::kSnapshotBlobs;
+  int fd = open(blobs_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  if (fd == -1) {
+    return detail::errno_to_status("Failed to open the snapshot", blobs_path);
+  }
+  Status status;
+  if (ftruncate(fd, offset) != 0) {
+    status = detail::errno_to_status("Failed to resize the snapshot",
+                                     blobs_path);
+  }
+  if (status.ok()) {
+    status = detail::parallel_run(
+        blobs.size(), concurrency, [&](size_t i) -> Status {
+          return detail::write_fully(fd, blobs[i]->data(), layout[i].size,
+                                     layout[i].offset, blobs_path);
+        });
+  }
+  if (status.ok() && fsync(fd) != 0) {
+    status = detail::errno_to_status("Failed to sync the snapshot",
+                                     blobs_path);
+  }
+  close(fd);
+  RETURN_ON_ERROR(status);
+
+  json snapshot;
+  snapshot["version"] = detail::kSnapshotVersion;
+  snapshot["metadata"] = tree;
+  json entries = json::array();
+  for (auto const& blob : layout) {
+    entries.push_back({ObjectIDToString(blob.id), blob.offset, blob.size});
+  }
+  snapshot["blobs"] = entries;
+
+  std::string staging_path = meta_path + ".tmp";
+  std::string content = snapshot.dump();
+  fd = open(staging_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  if (fd == -1) {
+    return detail::errno_to_status("Failed to open the snapshot",
+                                   staging_path);
+  }
+  status = detail::write_fully(fd, content.data(), content.size(), 0,
+                               staging_path);
+  if (status.ok() && fsync(fd) != 0) {
+    status = detail::errno_to_status("Failed to sync the snapshot",
+                                     staging_path);
+  }
+  close(fd);
+  RETURN_ON_ERROR(status);
+  if (rename(staging_path.c_str(), meta_path.c_str()) != 0) {
+    return detail::errno_to_status("Failed to commit the snapshot", meta_path);
+  }
+  VLOG(2) << "Snapshot " << ObjectIDToString(id) << " to '" << path << "': "
+          << blobs.size() << " blobs, " << offset << " bytes";
+  return Status::OK();
+}
+
+Status RestoreObject(Client& client, const std::string& path, ObjectID& id,
+                     const SnapshotRestoreMode mode, const int concurrency) {
+  std::string meta_path = path + "/" + detail::kSnapshotMeta;
+  std::ifstream fin(meta_path);
+  if (!fin.is_open()) {
+    return detail::errno_to_status("Failed to open the snapshot", meta_path);
+  }
+  json snapshot;
+  std::vector<detail::SnapshotBlob> layout;
+  size_t file_size = 0;
+  try {
+    snapshot = json::parse(fin);
+    if (snapshot.value("version", 0) != detail::kSnapshotVersion) {
+      return Status::Invalid("Unsupported version of the snapshot '" + path +
+                             "'");
+    }
+    for (auto const& entry : snapshot.at("blobs")) {
+      layout.push_back({ObjectIDFromString(entry.at(0).get<std::string>()),
+                        entry.at(1).get<size_t>(), entry.at(2).get<size_t>()});
+      file_size =
+          std::max(file_size, layout.back().offset + layout.back().size);
+    }
+  } catch (json::exception const& err) {
+    return Status::Invalid("Failed to parse the snapshot '" + meta_path +
+                           "': " + err.what());
+  }
+
+  // allocates all blobs up front, the payloads are filled in parallel
+  std::vector<std::unique_ptr<BlobWriter>> writers(layout.size());
+  auto abort = [&](const Status& status) {
+    for (auto& writer : writers) {
+      if (writer != nullptr) {
+        VINEYARD_DISCARD(writer->Abort(client));
+      }
+    }
+    return status;
+  };
+  for (size_t i = 0; i < layout.size(); ++i) {
+    Status status = client.CreateBlob(layout[i].size, writers[i]);
+    if (!status.ok()) {
+      return abort(status);
+    }
+  }
+
+  std::string blobs_path = path + "/" + detail::kSnapshotBlobs;
+  int fd = open(blobs_path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return abort(
+        detail::errno_to_status("Failed to open the snapshot", blobs_path));
+  }
+  // a truncated file would fault (SIGBUS) when mapped
+  Status status;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    status =
+        detail::errno_to_status("Failed to stat the snapshot", blobs_path);
+  } else if (static_cast<size_t>(st.st_size) < file_size) {
+    status = Status::IOError("The snapshot '" + blobs_path +
+                             "' is truncated, expects " +
+                             std::to_string(file_size) + " bytes but got " +
+                             std::to_string(st.st_size));
+  } else if (mode == SnapshotRestoreMode::kMmapCopy && file_size > 0) {
+    void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      status = detail::errno_to_status("Failed to map the snapshot",
+                                       blobs_path);
+    } else {
+      madvise(mapped, file_size, MADV_SEQUENTIAL);
+      madvise(mapped, file_size, MADV_WILLNEED);
+      const char* base = reinterpret_cast<const char*>(mapped);
+      status = detail::parallel_run(
+          layout.size(), concurrency, [&](size_t i) -> Status {
+            memcpy(writers[i]->data(), base + layout[i].offset,
+                   layout[i].size);
+            return Status::OK();
+          });
+      munmap(mapped, file_size);
+    }
+  } else {
+    status = detail::parallel_run(
+        layout.size(), concurrency, [&](size_t i) -> Status {
+          return detail::read_fully(fd, writers[i]->data(), layout[i].size,
+                                    layout[i].offset, blobs_path);
+        });
+  }
+  close(fd);
+  if (!status.ok()) {
+    return abort(status);
+  }
+
+  std::map<ObjectID, std::shared_ptr<Blob>> blobs;
+  blobs.emplace(EmptyBlobID(), Blob::MakeEmpty(client));
+  for (size_t i = 0; i < layout.size(); ++i) {
+    blobs.emplace(layout[i].id,
+                  std::dynamic_pointer_cast<Blob>(writers[i]->Seal(client)));
+  }
+
+  ObjectMeta target;
+  std::map<ObjectID, ObjectMeta> rebuilt;
+  std::set<ObjectID> persisted;
+  std::vector<ObjectID> created;
+  status = detail::rebuild(client, snapshot["metadata"], blobs, rebuilt,
+                           persisted, created, target);
+  if (!status.ok()) {
+    // drops the partially restored objects and the sealed blobs
+    for (auto const& blob : blobs) {
+      if (blob.first != EmptyBlobID() && blob.second != nullptr) {
+        created.push_back(blob.second->id());
+      }
+    }
+    VINEYARD_DISCARD(client.DelData(created, true, true));
+    return status;
+  }
+  id = target.GetId();
+  VLOG(2) << "Restore '" << path << "' as " << ObjectIDToString(id) << ": "
+          << layout.size() << " blobs, " << file_size << " bytes";
+  return Status::OK();
+}
+
+}  // namespace vineyard
@@ -0,0 +1,99 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_CLIENT_SNAPSHOT_H_
+#define SRC_CLIENT_SNAPSHOT_H_
+
+#include <string>
+
+#include "client/client.h"
+#include "common/util/status.h"
+#include "common/util/uuid.h"
+
+namespace vineyard {
+
+/**
+ * Note [Object snapshots]
+ *
+ * `Persist()` only publishes the metadata of an object to etcd, the blobs
+ * are gone with the vineyard server, hence restarting a service means
+ * rebuilding its objects, e.g., loading a graph from scratch. A snapshot
+ * makes an object durable on the local disk instead, for any type of
+ * objects (e.g., `Table`, `Tensor`, `ArrowFragment` and a single-instance
+ * `ArrowFragmentGroup`), as the snapshot consists of the metadata tree and
+ * the payloads of the blobs, rather than a type-specific format.
+ *
+ * A snapshot is a directory of two files:
+ *
+ * - "blobs", the payloads of the blobs, each starts at a page-aligned offset,
+ *   and
+ * - "meta.json", the metadata tree of the object, and the offset and size of
+ *   every blob in "blobs".
+ *
+ * The "meta.json" is written last (and renamed into place), a directory
+ * without it is an incomplete snapshot.
+ *
+ * Restoring creates the blobs of the recorded sizes, fills the payloads in
+ * parallel either by copying from a read-only mapping of "blobs" or by
+ * `pread()` into the blobs, and then rebuilds the metadata tree with the new
+ * blobs, bottom up. The restored object gets a new id. The cost is bounded
+ * by reading the payloads, as no member is reconstructed from its contents.
+ *
+ * All blobs must live in the instance of the client: the members of a global
+ * object that spans multiple instances are snapshotted on their own
+ * instances.
+ */
+enum class SnapshotRestoreMode {
+  // copies the payloads from a read-only mapping of the snapshot
+  kMmapCopy,
+  // reads the payloads into the blobs by `pread()`
+  kRead,
+};
+
+/**
+ * @brief Writes the object and all its members to the directory `path`, see
+ * also Note [Object snapshots].
+ *
+ * @param client The client connected to the instance that holds the blobs.
+ * @param id The object to snapshot.
+ * @param path The directory of the snapshot, which will be created if not
+ * exists.
+ * @param concurrency The number of threads to write the blobs.
+ *
+ * @return Status that indicates whether the snapshot has succeeded.
+ */
+Status SnapshotObject(Client& client, const ObjectID id,
+                      const std::string& path, const int concurrency = 1);
+
+/**
+ * @brief Restores the object in the snapshot at `path` into the vineyard
+ * server of the client, see also Note [Object snapshots].
+ *
+ * @param client The client connected to the instance to restore into.
+ * @param path The directory of the snapshot.
+ * @param id The id of the restored object.
+ * @param mode How to fill the payloads of the blobs.
+ * @param concurrency The number of threads to fill the blobs.
+ *
+ * @return Status that indicates whether the restore has succeeded.
+ */
+Status RestoreObject(
+    Client& client, const std::string& path, ObjectID& id,
+    const SnapshotRestoreMode mode = SnapshotRestoreMode::kMmapCopy,
+    const int concurrency = 1);
+
+}  // namespace vineyard
+
+#endif  // SRC_CLIENT_SNAPSHOT_H_
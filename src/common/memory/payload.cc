@@ -20,6 +20,19 @@ limitations under the License.
 
 namespace vineyard {
 
+const char* SpillPriorityToString(SpillPriority priority) {
+  switch (priority) {
+  case SpillPriority::kLow:
+    return "low";
+  case SpillPriority::kNormal:
+    return "normal";
+  case SpillPriority::kHigh:
+    return "high";
+  default:
+    return "unknown";
+  }
+}
+
 json Payload::ToJSON() const {
   json payload;
   this->ToJSON(payload);
@@ -35,6 +48,7 @@ void Payload::ToJSON(json& tree) const {
   tree["pointer"] = reinterpret_cast<uintptr_t>(pointer);
   tree["is_sealed"] = is_sealed;
   tree["is_owner"] = is_owner;
+  tree["numa_node"] = numa_node;
 }
 
 void Payload::FromJSON(const json& tree) {
@@ -46,6 +60,7 @@ void Payload::FromJSON(const json& tree) {
   pointer = reinterpret_cast<uint8_t*>(tree["pointer"].get<uintptr_t>());
   is_sealed = tree["is_sealed"].get<bool>();
   is_owner = tree["is_owner"].get<bool>();
+  numa_node = tree.value("numa_node", -1);
 }
 
 Payload Payload::FromJSON1(const json& tree) {
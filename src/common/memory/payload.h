@@ -28,6 +28,22 @@ struct PlasmaPayload;
 
 class BulkStore;
 
+/**
+ * @brief The spill priority classes of blobs. Under memory pressure the cold
+ * blobs of a lower class are spilled before the ones of a higher class, and
+ * the least recently used first within a class. Pinned blobs are never
+ * spilled, regardless of their class.
+ */
+enum class SpillPriority {
+  kLow = 0,     // e.g., scratch intermediates, spilled first
+  kNormal = 1,  // the default
+  kHigh = 2,    // spilled only when nothing else can be
+};
+
+constexpr int kSpillPriorities = 3;
+
+const char* SpillPriorityToString(SpillPriority priority);
+
 struct Payload {
   ObjectID object_id;
   int store_fd;
@@ -40,6 +56,9 @@ struct Payload {
   bool is_sealed;
   bool is_owner;
   bool is_spilled;
+  int numa_node;  // -1 if the blob is not placed on a specific NUMA node
+  SpillPriority spill_priority;
+  int64_t pin_count;  // the blob is pinned by each `Pin` until its `Unpin`
 
   Payload()
       : object_id(EmptyBlobID()),
@@ -52,7 +71,10 @@ struct Payload {
         pointer(nullptr),
         is_sealed(0),
         is_owner(1),
-        is_spilled(0) {}
+        is_spilled(0),
+        numa_node(-1),
+        spill_priority(SpillPriority::kNormal),
+        pin_count(0) {}
 
   Payload(ObjectID object_id, int64_t size, uint8_t* ptr, int fd, int64_t msize,
           ptrdiff_t offset)
@@ -66,7 +88,10 @@ struct Payload {
         pointer(ptr),
         is_sealed(0),
         is_owner(1),
-        is_spilled(0) {}
+        is_spilled(0),
+        numa_node(-1),
+        spill_priority(SpillPriority::kNormal),
+        pin_count(0) {}
 
   Payload(ObjectID object_id, int64_t size, uint8_t* ptr, int fd, int arena_fd,
           int64_t msize, ptrdiff_t offset)
@@ -80,7 +105,10 @@ struct Payload {
         pointer(ptr),
         is_sealed(0),
         is_owner(1),
-        is_spilled(0) {}
+        is_spilled(0),
+        numa_node(-1),
+        spill_priority(SpillPriority::kNormal),
+        pin_count(0) {}
 
   ~Payload() = default;
 
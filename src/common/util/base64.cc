@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include <cstdint>
 #include <iostream>
 
 #include "common/util/base64.h"
@@ -29,15 +30,32 @@ static const char _base64_chars[] =
     "abcdefghijklmnopqrstuvwxyz"
     "0123456789+/";
 
-static inline bool is_base64(unsigned char c) {
-  return (isalnum(c) || (c == '+') || (c == '/'));
+// the reverse mapping of `_base64_chars`, -1 for non-base64 characters.
+struct base64_table_t {
+  base64_table_t() {
+    for (int c = 0; c < 256; ++c) {
+      values[c] = -1;
+    }
+    for (int index = 0; index < 64; ++index) {
+      values[static_cast<unsigned char>(_base64_chars[index])] = index;
+    }
+  }
+  int8_t values[256];
+};
+
+static inline const int8_t* base64_table() {
+  static const base64_table_t table;
+  return table.values;
 }
 
+static inline bool is_base64(unsigned char c) { return base64_table()[c] >= 0; }
+
 std::string base64_encode(const std::string& buffer) {
   const unsigned char* buf = reinterpret_cast<const unsigned char*>(&buffer[0]);
-  std::string base64_chars(_base64_chars);
+  const char* base64_chars = _base64_chars;
   size_t bufLen = buffer.size();
   std::string ret;
+  ret.reserve((bufLen + 2) / 3 * 4);
   int i = 0;
   unsigned char char_array_3[3];
   unsigned char char_array_4[4];
@@ -81,11 +99,12 @@ std::string base64_encode(const std::string& buffer) {
 
 std::string base64_decode(const std::string& encoded_string) {
   auto in_len = encoded_string.size();
-  std::string base64_chars(_base64_chars);
   int i = 0;
-  int in_ = 0;
+  size_t in_ = 0;
   unsigned char char_array_4[4], char_array_3[3];
-  std::vector<unsigned char> ret;
+  const int8_t* table = base64_table();
+  std::string ret;
+  ret.reserve(in_len / 4 * 3 + 3);
 
   while (in_len-- && (encoded_string[in_] != '=') &&
          is_base64(encoded_string[in_])) {
@@ -93,7 +112,7 @@ std::string base64_decode(const std::string& encoded_string) {
     in_++;
     if (i == 4) {
       for (i = 0; i < 4; i++)
-        char_array_4[i] = base64_chars.find(char_array_4[i]);
+        char_array_4[i] = table[char_array_4[i]];
 
       char_array_3[0] =
           (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
@@ -112,7 +131,7 @@ std::string base64_decode(const std::string& encoded_string) {
       char_array_4[j] = 0;
 
     for (int j = 0; j < 4; j++)
-      char_array_4[j] = base64_chars.find(char_array_4[j]);
+      char_array_4[j] = table[char_array_4[j]];
 
     char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
     char_array_3[1] =
@@ -123,7 +142,7 @@ std::string base64_decode(const std::string& encoded_string) {
       ret.push_back(char_array_3[j]);
   }
 
-  return std::string(ret.begin(), ret.end());
+  return ret;
 }
 
 }  // namespace vineyard
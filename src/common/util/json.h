@@ -16,14 +16,21 @@ limitations under the License.
 #ifndef SRC_COMMON_UTIL_JSON_H_
 #define SRC_COMMON_UTIL_JSON_H_
 
+#include <atomic>
+#include <cstring>
 #include <exception>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include "nlohmann/json.hpp"
 
+#include "common/util/base64.h"
+#include "common/util/env.h"
+
 namespace vineyard {
 
 using json = nlohmann::json;
@@ -65,17 +72,247 @@ void print_json_value(std::stringstream& ss, std::string const& value);
 template <>
 void print_json_value(std::stringstream& ss, char const& value);
 
+/**
+ * Note [Compact encoding of containers in metadata]
+ *
+ * Containers (vectors, sets, etc.) in metadata are encoded as a JSON array
+ * string, which is bloated and expensive to parse when the container is large,
+ * e.g., the partition shapes of global tensors.
+ *
+ * Containers of arithmetic values that have at least
+ * `kCompactContainerThreshold` elements are thus encoded as
+ *
+ *    "base64:<dtype>:<base64 of the payload>"
+ *
+ * where `<dtype>` is the numpy name of the value type, e.g., "int64", and the
+ * payload is
+ *
+ *  - for integers: the differences between adjacent values (the first value
+ *    itself), in zigzag varint, as the large integer containers in metadata
+ *    are usually offsets, indices, or other (nearly) sorted values;
+ *  - for floating points: the little-endian raw values.
+ *
+ * Small containers are still encoded as JSON arrays, and `get_container`
+ * accepts both encodings.
+ *
+ * Only the C++ and Python clients can decode it, the encoding is thus opt-in:
+ * enable it with `set_compact_container_encoding(true)`, or by setting the
+ * environment variable `VINEYARD_COMPACT_METADATA=1`, when the metadata won't
+ * be read by the Java, Rust or Go clients.
+ */
+constexpr size_t kCompactContainerThreshold = 256;
+
+namespace detail {
+
+constexpr char kCompactContainerPrefix[] = "base64:";
+
+inline std::atomic<bool>& compact_container_encoding_enabled() {
+  static std::atomic<bool> enabled{[]() {
+    std::string value = read_env("VINEYARD_COMPACT_METADATA");
+    return value == "1" || value == "true" || value == "on";
+  }()};
+  return enabled;
+}
+
+template <typename T>
+inline const char* compact_dtype() {
+  return nullptr;
+}
+
+#define VINEYARD_COMPACT_DTYPE(type, name)   \
+  template <>                                \
+  inline const char* compact_dtype<type>() { \
+    return name;                             \
+  }
+
+VINEYARD_COMPACT_DTYPE(int8_t, "int8")
+VINEYARD_COMPACT_DTYPE(uint8_t, "uint8")
+VINEYARD_COMPACT_DTYPE(int16_t, "int16")
+VINEYARD_COMPACT_DTYPE(uint16_t, "uint16")
+VINEYARD_COMPACT_DTYPE(int32_t, "int32")
+VINEYARD_COMPACT_DTYPE(uint32_t, "uint32")
+VINEYARD_COMPACT_DTYPE(int64_t, "int64")
+VINEYARD_COMPACT_DTYPE(uint64_t, "uint64")
+VINEYARD_COMPACT_DTYPE(float, "float32")
+VINEYARD_COMPACT_DTYPE(double, "float64")
+
+#undef VINEYARD_COMPACT_DTYPE
+
+template <typename Container>
+void encode_compact_values(Container const& container, std::string& payload,
+                           std::true_type /* is_integral */) {
+  payload.reserve(container.size() * 2);
+  uint64_t previous = 0;
+  for (auto const& item : container) {
+    // sign-extends the signed values, the differences wrap around
+    uint64_t value = static_cast<uint64_t>(static_cast<int64_t>(item));
+    int64_t delta = static_cast<int64_t>(value - previous);
+    uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^
+                      static_cast<uint64_t>(delta >> 63);
+    while (zigzag >= 0x80) {
+      payload.push_back(static_cast<char>((zigzag & 0x7f) | 0x80));
+      zigzag >>= 7;
+    }
+    payload.push_back(static_cast<char>(zigzag));
+    previous = value;
+  }
+}
+
+template <typename Container>
+void encode_compact_values(Container const& container, std::string& payload,
+                           std::false_type /* is_integral */) {
+  using T = typename Container::value_type;
+  payload.resize(container.size() * sizeof(T));
+  char* data = &payload[0];
+  for (auto const& item : container) {
+    std::memcpy(data, &item, sizeof(T));
+    data += sizeof(T);
+  }
+}
+
+template <typename T, typename Container>
+void insert_compact_value(Container& container, T const value,
+                          std::true_type /* is_arithmetic */) {
+  container.insert(std::end(container),
+                   static_cast<typename Container::value_type>(value));
+}
+
+template <typename T, typename Container>
+void insert_compact_value(Container&, T const, std::false_type) {
+  throw std::out_of_range(
+      "Cannot decode the compact container into non-arithmetic values");
+}
+
+template <typename S, typename Container>
+void decode_compact_values(std::string const& payload, Container& container,
+                           std::true_type /* is_integral */) {
+  using T = typename Container::value_type;
+  uint64_t previous = 0;
+  size_t offset = 0;
+  while (offset < payload.size()) {
+    uint64_t zigzag = 0;
+    int shift = 0;
+    uint8_t byte = 0;
+    do {
+      if (offset >= payload.size() || shift >= 64) {
+        throw std::out_of_range("Invalid varint in compact container");
+      }
+      byte = static_cast<uint8_t>(payload[offset++]);
+      zigzag |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+    uint64_t delta = (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+    previous += delta;
+    insert_compact_value(container, static_cast<S>(previous),
+                         std::is_arithmetic<T>{});
+  }
+}
+
+template <typename S, typename Container>
+void decode_compact_values(std::string const& payload, Container& container,
+                           std::false_type /* is_integral */) {
+  using T = typename Container::value_type;
+  const char* data = payload.data();
+  for (size_t offset = 0; offset + sizeof(S) <= payload.size();
+       offset += sizeof(S)) {
+    S value;
+    std::memcpy(&value, data + offset, sizeof(S));
+    insert_compact_value(container, value, std::is_arithmetic<T>{});
+  }
+}
+
+template <typename S, typename Container>
+void decode_compact_values(std::string const& payload, Container& container) {
+  decode_compact_values<S>(payload, container, std::is_integral<S>{});
+}
+
+template <typename Container>
+bool decode_compact_container(std::string const& value, Container& container) {
+  constexpr size_t prefix_size = sizeof(kCompactContainerPrefix) - 1;
+  if (value.compare(0, prefix_size, kCompactContainerPrefix) != 0) {
+    return false;
+  }
+  size_t separator = value.find(':', prefix_size);
+  if (separator == std::string::npos) {
+    throw std::out_of_range("Invalid compact container: " + value);
+  }
+  std::string dtype = value.substr(prefix_size, separator - prefix_size);
+  std::string payload = base64_decode(value.substr(separator + 1));
+  if (dtype == "int8") {
+    decode_compact_values<int8_t>(payload, container);
+  } else if (dtype == "uint8") {
+    decode_compact_values<uint8_t>(payload, container);
+  } else if (dtype == "int16") {
+    decode_compact_values<int16_t>(payload, container);
+  } else if (dtype == "uint16") {
+    decode_compact_values<uint16_t>(payload, container);
+  } else if (dtype == "int32") {
+    decode_compact_values<int32_t>(payload, container);
+  } else if (dtype == "uint32") {
+    decode_compact_values<uint32_t>(payload, container);
+  } else if (dtype == "int64") {
+    decode_compact_values<int64_t>(payload, container);
+  } else if (dtype == "uint64") {
+    decode_compact_values<uint64_t>(payload, container);
+  } else if (dtype == "float32") {
+    decode_compact_values<float>(payload, container);
+  } else if (dtype == "float64") {
+    decode_compact_values<double>(payload, container);
+  } else {
+    throw std::out_of_range("Unknown dtype of compact container: " + dtype);
+  }
+  return true;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Whether the large containers are written in the compact encoding,
+ * see also Note [Compact encoding of containers in metadata].
+ */
+inline bool compact_container_encoding() {
+  return detail::compact_container_encoding_enabled().load(
+      std::memory_order_relaxed);
+}
+
+inline void set_compact_container_encoding(bool const enabled) {
+  detail::compact_container_encoding_enabled().store(
+      enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Encode the container as a string in metadata, see also
+ * Note [Compact encoding of containers in metadata].
+ */
+template <typename Container>
+std::string encode_container(Container const& container) {
+  using T = typename Container::value_type;
+  const char* dtype = detail::compact_dtype<T>();
+  if (dtype == nullptr || container.size() < kCompactContainerThreshold ||
+      !compact_container_encoding()) {
+    return json_to_string(json(container));
+  }
+  std::string payload;
+  detail::encode_compact_values(container, payload, std::is_integral<T>{});
+  return detail::kCompactContainerPrefix + std::string(dtype) + ":" +
+         base64_encode(payload);
+}
+
 template <typename Container>
 void put_container(json& tree, std::string const& path,
                    Container const& container) {
-  tree[path] = json_to_string(json(container));
+  tree[path] = encode_container(container);
 }
 
 template <typename Container>
 void get_container(json const& tree, std::string const& path,
                    Container& container) {
+  auto const& value = tree[path].get_ref<std::string const&>();
+  if (detail::decode_compact_container(value, container)) {
+    return;
+  }
   // FIXME: parse the JSON array directly
-  json body = json::parse(tree[path].get_ref<std::string const&>());
+  json body = json::parse(value);
   using T = typename Container::value_type;
   for (auto const& item : body.items()) {
     container.insert(std::end(container), item.value().get<T>());
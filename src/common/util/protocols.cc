@@ -141,6 +141,10 @@ CommandType ParseCommandType(const std::string& str_type) {
     return CommandType::IncreaseReferenceCountRequest;
   } else if (str_type == "is_spilled_request") {
     return CommandType::IsSpilledRequest;
+  } else if (str_type == "pin_blobs_request") {
+    return CommandType::PinBlobsRequest;
+  } else if (str_type == "set_spill_priority_request") {
+    return CommandType::SetSpillPriorityRequest;
   } else {
     return CommandType::NullCommand;
   }
@@ -150,6 +154,26 @@ static inline void encode_msg(const json& root, std::string& msg) {
   msg = json_to_string(root);
 }
 
+void WriteRequestID(RequestID const req_id, std::string& msg) {
+  if (req_id == 0 || msg.empty() || msg[0] != '{') {
+    return;
+  }
+  // splice the field into the encoded object rather than re-encoding it
+  std::string field = "\"req_id\":" + std::to_string(req_id);
+  if (msg.size() > 1 && msg[1] != '}') {
+    field += ",";
+  }
+  msg.insert(1, field);
+}
+
+RequestID ReadRequestID(const json& msg) {
+  auto iter = msg.find("req_id");
+  if (iter == msg.end() || !iter->is_number_unsigned()) {
+    return 0;
+  }
+  return iter->get<RequestID>();
+}
+
 void WriteErrorReply(Status const& status, std::string& msg) {
   encode_msg(status.ToJSON(), msg);
 }
@@ -309,17 +333,22 @@ Status ReadListDataRequest(const json& root, std::string& pattern, bool& regex,
   return Status::OK();
 }
 
-void WriteCreateBufferRequest(const size_t size, std::string& msg) {
+void WriteCreateBufferRequest(const size_t size, const int numa_node,
+                              std::string& msg) {
   json root;
   root["type"] = "create_buffer_request";
   root["size"] = size;
+  if (numa_node >= 0) {
+    root["numa_node"] = numa_node;
+  }
 
   encode_msg(root, msg);
 }
 
-Status ReadCreateBufferRequest(const json& root, size_t& size) {
+Status ReadCreateBufferRequest(const json& root, size_t& size, int& numa_node) {
   RETURN_ON_ASSERT(root["type"] == "create_buffer_request");
   size = root["size"].get<size_t>();
+  numa_node = root.value("numa_node", -1);
   return Status::OK();
 }
 
@@ -1186,18 +1215,23 @@ Status ReadDebugReply(const json& root, json& result) {
   return Status::OK();
 }
 
-void WriteNewSessionRequest(std::string& msg,
-                            StoreType const& bulk_store_type) {
+void WriteNewSessionRequest(std::string& msg, StoreType const& bulk_store_type,
+                            size_t const reserved_size, size_t const size) {
   json root;
   root["type"] = "new_session_request";
   root["bulk_store_type"] = bulk_store_type;
+  root["reserved_size"] = reserved_size;
+  root["size"] = size;
   encode_msg(root, msg);
 }
 
-Status ReadNewSessionRequest(json const& root, StoreType& bulk_store_type) {
+Status ReadNewSessionRequest(json const& root, StoreType& bulk_store_type,
+                             size_t& reserved_size, size_t& size) {
   RETURN_ON_ASSERT(root["type"] == "new_session_request");
   bulk_store_type =
       root.value("bulk_store_type", /* default */ StoreType::kDefault);
+  reserved_size = root.value("reserved_size", /* default */ size_t{0});
+  size = root.value("size", /* default */ size_t{0});
   return Status::OK();
 }
 
@@ -1591,12 +1625,31 @@ void WriteIsSpilledReply(const bool is_spilled, std::string& msg) {
   encode_msg(root, msg);
 }
 
+void WriteIsSpilledReply(const bool is_spilled, const SpillPriority priority,
+                         const bool is_pinned, std::string& msg) {
+  json root;
+  root["type"] = "is_spilled_reply";
+  root["is_spilled"] = is_spilled;
+  root["spill_priority"] = static_cast<int>(priority);
+  root["is_pinned"] = is_pinned;
+  encode_msg(root, msg);
+}
+
 Status ReadIsSpilledReply(json const& root, bool& is_spilled) {
   RETURN_ON_ASSERT(root["type"] == "is_spilled_reply");
   is_spilled = root["is_spilled"].get<bool>();
   return Status::OK();
 }
 
+Status ReadIsSpilledReply(json const& root, bool& is_spilled,
+                          SpillPriority& priority, bool& is_pinned) {
+  RETURN_ON_ERROR(ReadIsSpilledReply(root, is_spilled));
+  priority = static_cast<SpillPriority>(root.value(
+      "spill_priority", static_cast<int>(SpillPriority::kNormal)));
+  is_pinned = root.value("is_pinned", false);
+  return Status::OK();
+}
+
 void WriteIncreaseReferenceCountRequest(const std::vector<ObjectID>& ids,
                                         std::string& msg) {
   json root;
@@ -1623,4 +1676,64 @@ Status ReadIncreaseReferenceCountReply(json const& root) {
   return Status::OK();
 }
 
+void WritePinBlobsRequest(const std::vector<ObjectID>& ids, const bool pinned,
+                          std::string& msg) {
+  json root;
+  root["type"] = "pin_blobs_request";
+  root["ids"] = std::vector<ObjectID>{ids};
+  root["pinned"] = pinned;
+  encode_msg(root, msg);
+}
+
+Status ReadPinBlobsRequest(json const& root, std::vector<ObjectID>& ids,
+                           bool& pinned) {
+  RETURN_ON_ASSERT(root["type"] == "pin_blobs_request");
+  ids = root["ids"].get_to(ids);
+  pinned = root["pinned"].get<bool>();
+  return Status::OK();
+}
+
+void WritePinBlobsReply(std::string& msg) {
+  json root;
+  root["type"] = "pin_blobs_reply";
+  encode_msg(root, msg);
+}
+
+Status ReadPinBlobsReply(json const& root) {
+  RETURN_ON_ASSERT(root["type"] == "pin_blobs_reply");
+  return Status::OK();
+}
+
+void WriteSetSpillPriorityRequest(const std::vector<ObjectID>& ids,
+                                  const SpillPriority priority,
+                                  std::string& msg) {
+  json root;
+  root["type"] = "set_spill_priority_request";
+  root["ids"] = std::vector<ObjectID>{ids};
+  root["spill_priority"] = static_cast<int>(priority);
+  encode_msg(root, msg);
+}
+
+Status ReadSetSpillPriorityRequest(json const& root, std::vector<ObjectID>& ids,
+                                   SpillPriority& priority) {
+  RETURN_ON_ASSERT(root["type"] == "set_spill_priority_request");
+  ids = root["ids"].get_to(ids);
+  int value = root["spill_priority"].get<int>();
+  RETURN_ON_ASSERT(value >= 0 && value < kSpillPriorities,
+                   "invalid spill priority: " + std::to_string(value));
+  priority = static_cast<SpillPriority>(value);
+  return Status::OK();
+}
+
+void WriteSetSpillPriorityReply(std::string& msg) {
+  json root;
+  root["type"] = "set_spill_priority_reply";
+  encode_msg(root, msg);
+}
+
+Status ReadSetSpillPriorityReply(json const& root) {
+  RETURN_ON_ASSERT(root["type"] == "set_spill_priority_reply");
+  return Status::OK();
+}
+
 }  // namespace vineyard
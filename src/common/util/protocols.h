@@ -87,6 +87,8 @@ enum class CommandType {
   IsInUseRequest = 53,
   IncreaseReferenceCountRequest = 54,
   IsSpilledRequest = 55,
+  PinBlobsRequest = 56,
+  SetSpillPriorityRequest = 57,
 };
 
 enum class StoreType {
@@ -96,6 +98,22 @@ enum class StoreType {
 
 CommandType ParseCommandType(const std::string& str_type);
 
+/**
+ * @brief Requests on a pipelined connection carry a non-zero "req_id", which
+ * is echoed in the reply, as replies may arrive out of order.
+ */
+using RequestID = uint64_t;
+
+/**
+ * @brief Tag an encoded request (or reply) with the request id.
+ */
+void WriteRequestID(RequestID const req_id, std::string& msg);
+
+/**
+ * @brief Returns 0 if the message isn't tagged.
+ */
+RequestID ReadRequestID(const json& msg);
+
 void WriteErrorReply(Status const& status, std::string& msg);
 
 void WriteRegisterRequest(std::string& msg, StoreType const& bulk_store_type);
@@ -203,9 +221,10 @@ void WriteInstanceStatusReply(const json& content, std::string& msg);
 
 Status ReadInstanceStatusReply(const json& root, json& content);
 
-void WriteCreateBufferRequest(const size_t size, std::string& msg);
+void WriteCreateBufferRequest(const size_t size, const int numa_node,
+                              std::string& msg);
 
-Status ReadCreateBufferRequest(const json& root, size_t& size);
+Status ReadCreateBufferRequest(const json& root, size_t& size, int& numa_node);
 
 void WriteCreateBufferReply(const ObjectID id,
                             const std::shared_ptr<Payload>& object,
@@ -404,9 +423,11 @@ void WriteDebugReply(const json& result, std::string& msg);
 
 Status ReadDebugReply(const json& root, json& result);
 
-void WriteNewSessionRequest(std::string& msg, StoreType const& bulk_store_type);
+void WriteNewSessionRequest(std::string& msg, StoreType const& bulk_store_type,
+                            size_t const reserved_size, size_t const size);
 
-Status ReadNewSessionRequest(json const& root, StoreType& bulk_store_type);
+Status ReadNewSessionRequest(json const& root, StoreType& bulk_store_type,
+                             size_t& reserved_size, size_t& size);
 
 void WriteNewSessionReply(std::string& msg, std::string const& socket_path);
 
@@ -549,8 +570,14 @@ Status ReadIsSpilledRequest(json const& root, ObjectID& id);
 
 void WriteIsSpilledReply(const bool is_spilled, std::string& msg);
 
+void WriteIsSpilledReply(const bool is_spilled, const SpillPriority priority,
+                         const bool is_pinned, std::string& msg);
+
 Status ReadIsSpilledReply(json const& root, bool& is_spilled);
 
+Status ReadIsSpilledReply(json const& root, bool& is_spilled,
+                          SpillPriority& priority, bool& is_pinned);
+
 void WriteIncreaseReferenceCountRequest(const std::vector<ObjectID>& ids,
                                         std::string& msg);
 
@@ -561,6 +588,27 @@ void WriteIncreaseReferenceCountReply(std::string& msg);
 
 Status ReadIncreaseReferenceCountReply(json const& root);
 
+void WritePinBlobsRequest(const std::vector<ObjectID>& ids, const bool pinned,
+                          std::string& msg);
+
+Status ReadPinBlobsRequest(json const& root, std::vector<ObjectID>& ids,
+                           bool& pinned);
+
+void WritePinBlobsReply(std::string& msg);
+
+Status ReadPinBlobsReply(json const& root);
+
+void WriteSetSpillPriorityRequest(const std::vector<ObjectID>& ids,
+                                  const SpillPriority priority,
+                                  std::string& msg);
+
+Status ReadSetSpillPriorityRequest(json const& root, std::vector<ObjectID>& ids,
+                                   SpillPriority& priority);
+
+void WriteSetSpillPriorityReply(std::string& msg);
+
+Status ReadSetSpillPriorityReply(json const& root);
+
 }  // namespace vineyard
 
 #endif  // SRC_COMMON_UTIL_PROTOCOLS_H_
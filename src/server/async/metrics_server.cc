@@ -0,0 +1,141 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "server/async/metrics_server.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "common/util/logging.h"
+#include "server/util/metrics.h"
+
+namespace vineyard {
+
+namespace {
+
+/**
+ * @brief Reads the request header, and writes the response.
+ */
+class MetricsSession : public std::enable_shared_from_this<MetricsSession> {
+ public:
+  explicit MetricsSession(asio::ip::tcp::socket socket)
+      : socket_(std::move(socket)) {}
+
+  void Start() {
+    auto self(shared_from_this());
+    asio::async_read_until(
+        socket_, request_, "\r\n\r\n",
+        [this, self](boost::system::error_code ec, std::size_t) {
+          if (ec) {
+            return;
+          }
+          std::istream stream(&request_);
+          std::string method, target;
+          stream >> method >> target;
+          if (method != "GET") {
+            respond("405 Method Not Allowed", "");
+          } else if (target != "/metrics" && target != "/") {
+            respond("404 Not Found", "");
+          } else {
+            respond("200 OK", MetricsRegistry::Get().ToPrometheus());
+          }
+        });
+  }
+
+ private:
+  void respond(std::string const& status, std::string const& body) {
+    auto self(shared_from_this());
+    response_ = "HTTP/1.1 " + status +
+                "\r\n"
+                "Content-Type: text/plain; version=0.0.4\r\n"
+                "Content-Length: " +
+                std::to_string(body.size()) +
+                "\r\n"
+                "Connection: close\r\n\r\n" +
+                body;
+    asio::async_write(socket_, asio::buffer(response_),
+                      [this, self](boost::system::error_code, std::size_t) {
+                        boost::system::error_code ignored;
+                        socket_.shutdown(asio::ip::tcp::socket::shutdown_both,
+                                         ignored);
+                      });
+  }
+
+  asio::ip::tcp::socket socket_;
+  asio::streambuf request_;
+  std::string response_;
+};
+
+}  // namespace
+
+#if BOOST_VERSION >= 106600
+MetricsServer::MetricsServer(asio::io_context& context, uint32_t const port)
+#else
+MetricsServer::MetricsServer(asio::io_service& context, uint32_t const port)
+#endif
+    : port_(port), stopped_(false), acceptor_(context) {}
+
+MetricsServer::~MetricsServer() { Stop(); }
+
+Status MetricsServer::Start() {
+  asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port_);
+  boost::system::error_code ec;
+  acceptor_.open(endpoint.protocol(), ec);
+  if (!ec) {
+    acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true), ec);
+  }
+  if (!ec) {
+    acceptor_.bind(endpoint, ec);
+  }
+  if (!ec) {
+    acceptor_.listen(asio::socket_base::max_connections, ec);
+  }
+  if (ec) {
+    boost::system::error_code ignored;
+    acceptor_.close(ignored);
+    return Status::IOError("Failed to serve the metrics on port " +
+                           std::to_string(port_) + ": " + ec.message());
+  }
+  doAccept();
+  LOG(INFO) << "Vineyard will serve the metrics on 0.0.0.0:" << port_
+            << "/metrics";
+  return Status::OK();
+}
+
+void MetricsServer::Stop() {
+  if (stopped_.exchange(true)) {
+    return;
+  }
+  boost::system::error_code ec;
+  acceptor_.close(ec);
+}
+
+void MetricsServer::doAccept() {
+  if (!acceptor_.is_open()) {
+    return;
+  }
+  acceptor_.async_accept([this](boost::system::error_code ec,
+                                asio::ip::tcp::socket socket) {
+    if (!ec) {
+      std::make_shared<MetricsSession>(std::move(socket))->Start();
+    }
+    if (!stopped_.load() && ec != asio::error::operation_aborted) {
+      doAccept();
+    }
+  });
+}
+
+}  // namespace vineyard
@@ -0,0 +1,65 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_SERVER_ASYNC_METRICS_SERVER_H_
+#define SRC_SERVER_ASYNC_METRICS_SERVER_H_
+
+#include <atomic>
+#include <memory>
+
+#include "boost/asio.hpp"
+
+#include "common/util/status.h"
+
+namespace vineyard {
+
+namespace asio = boost::asio;
+
+/**
+ * @brief A minimal HTTP server that serves the metrics in `MetricsRegistry`
+ * in the prometheus text exposition format, on `GET /metrics`.
+ *
+ * Every connection is answered with a single response and then closed, which
+ * is what the prometheus scrapers expect.
+ */
+class MetricsServer {
+ public:
+#if BOOST_VERSION >= 106600
+  MetricsServer(asio::io_context& context, uint32_t const port);
+#else
+  MetricsServer(asio::io_service& context, uint32_t const port);
+#endif
+
+  ~MetricsServer();
+
+  /**
+   * @brief Bind the port and start serving, fails (e.g., when the port is in
+   * use) without affecting the other services of vineyardd.
+   */
+  Status Start();
+
+  void Stop();
+
+ private:
+  void doAccept();
+
+  uint32_t port_;
+  std::atomic<bool> stopped_;
+  asio::ip::tcp::acceptor acceptor_;
+};
+
+}  // namespace vineyard
+
+#endif  // SRC_SERVER_ASYNC_METRICS_SERVER_H_
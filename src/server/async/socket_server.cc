@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "server/async/socket_server.h"
 
+#include <array>
+#include <chrono>
 #include <limits>
 #include <map>
 #include <memory>
@@ -198,6 +200,103 @@ bool SocketConnection::processMessage(const std::string& message_in) {
 
   std::string const& type = root["type"].get_ref<std::string const&>();
   CommandType cmd = ParseCommandType(type);
+  RequestID req_id = ReadRequestID(root);
+  if (MetricsRegistry::Enabled()) {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    int64_t since =
+        std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+    MetricHistogram* histogram = latencyHistogram(cmd, type);
+    if (req_id != 0) {
+      std::lock_guard<std::mutex> lock(tagged_pending_mutex_);
+      tagged_pending_[req_id] = PendingLatency{histogram, since};
+    } else {
+      pending_since_.store(since, std::memory_order_relaxed);
+      pending_histogram_.store(histogram, std::memory_order_relaxed);
+    }
+  }
+  if (req_id != 0) {
+    return processTaggedMessage(cmd, req_id, std::move(root));
+  }
+  return dispatchMessage(cmd, root);
+}
+
+namespace {
+
+/**
+ * @brief The tagged request being dispatched by the current thread, the
+ * replies that its handler writes synchronously (e.g., the errors) are
+ * tagged with its request id.
+ */
+struct DispatchingRequest {
+  const void* connection = nullptr;
+  RequestID req_id = 0;
+};
+
+thread_local DispatchingRequest dispatching_request;
+
+class DispatchingRequestGuard {
+ public:
+  DispatchingRequestGuard(const void* connection, RequestID const req_id)
+      : saved_(dispatching_request) {
+    dispatching_request.connection = connection;
+    dispatching_request.req_id = req_id;
+  }
+
+  ~DispatchingRequestGuard() { dispatching_request = saved_; }
+
+ private:
+  DispatchingRequest saved_;
+};
+
+}  // namespace
+
+bool SocketConnection::processTaggedMessage(CommandType const cmd,
+                                            RequestID const req_id,
+                                            json&& root) {
+  if (!isPipelinable(cmd)) {
+    std::string message_out;
+    WriteErrorReply(
+        Status::Invalid("The command '" + root.value("type", "") +
+                        "' cannot be pipelined, issue it without 'req_id'"),
+        message_out);
+    doReply(req_id, message_out);
+    return false;
+  }
+  auto self(shared_from_this());
+  auto request = std::make_shared<json>(std::move(root));
+  server_ptr_->GetContext().post([self, cmd, req_id, request]() {
+    if (!self->running_.load()) {
+      return;
+    }
+    DispatchingRequestGuard guard(self.get(), req_id);
+    self->dispatchMessage(cmd, *request);
+  });
+  return false;
+}
+
+bool SocketConnection::isPipelinable(CommandType const cmd) {
+  switch (cmd) {
+  case CommandType::GetDataRequest:
+  case CommandType::ListDataRequest:
+  case CommandType::CreateDataRequest:
+  case CommandType::PersistRequest:
+  case CommandType::IfPersistRequest:
+  case CommandType::ExistsRequest:
+  case CommandType::ShallowCopyRequest:
+  case CommandType::DelDataRequest:
+  case CommandType::PutNameRequest:
+  case CommandType::GetNameRequest:
+  case CommandType::DropNameRequest:
+  case CommandType::ClusterMetaRequest:
+  case CommandType::InstanceStatusRequest:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool SocketConnection::dispatchMessage(CommandType const cmd,
+                                       json const& root) {
   switch (cmd) {
   case CommandType::RegisterRequest: {
     return doRegister(root);
@@ -337,8 +436,14 @@ bool SocketConnection::processMessage(const std::string& message_in) {
   case CommandType::IsSpilledRequest: {
     return doIsSpilled(root);
   }
+  case CommandType::PinBlobsRequest: {
+    return doPinBlobs(root);
+  }
+  case CommandType::SetSpillPriorityRequest: {
+    return doSetSpillPriority(root);
+  }
   default: {
-    LOG(ERROR) << "Got unexpected command: " << type;
+    LOG(ERROR) << "Got unexpected command: " << root.value("type", "");
     return false;
   }
   }
@@ -490,12 +595,13 @@ bool SocketConnection::doGetRemoteBuffers(const json& root) {
 bool SocketConnection::doCreateBuffer(const json& root) {
   auto self(shared_from_this());
   size_t size;
+  int numa_node;
   std::shared_ptr<Payload> object;
   std::string message_out;
 
-  TRY_READ_REQUEST(ReadCreateBufferRequest, root, size);
+  TRY_READ_REQUEST(ReadCreateBufferRequest, root, size, numa_node);
   ObjectID object_id;
-  RESPONSE_ON_ERROR(bulk_store_->Create(size, object_id, object));
+  RESPONSE_ON_ERROR(bulk_store_->Create(size, numa_node, object_id, object));
 
   int fd_to_send = -1;
   if (object->data_size > 0 &&
@@ -569,6 +675,7 @@ bool SocketConnection::doDropBuffer(const json& root) {
 
 bool SocketConnection::doGetData(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   std::vector<ObjectID> ids;
   bool sync_remote = false, wait = false;
   double startTime = GetCurrentTime();
@@ -576,7 +683,7 @@ bool SocketConnection::doGetData(const json& root) {
   json tree;
   RESPONSE_ON_ERROR(server_ptr_->GetData(
       ids, sync_remote, wait, [self]() { return self->running_.load(); },
-      [self, startTime](const Status& status, const json& tree) {
+      [self, req_id, startTime](const Status& status, const json& tree) {
         std::string message_out;
         if (status.ok()) {
           WriteGetDataReply(tree, message_out);
@@ -584,7 +691,7 @@ bool SocketConnection::doGetData(const json& root) {
           LOG(ERROR) << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         double endTime = GetCurrentTime();
         LOG_SUMMARY("data_request_duration_microseconds", "get",
                     (endTime - startTime) * 1000000);
@@ -596,12 +703,14 @@ bool SocketConnection::doGetData(const json& root) {
 
 bool SocketConnection::doListData(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   std::string pattern;
   bool regex;
   size_t limit;
   TRY_READ_REQUEST(ReadListDataRequest, root, pattern, regex, limit);
   RESPONSE_ON_ERROR(server_ptr_->ListData(
-      pattern, regex, limit, [self](const Status& status, const json& tree) {
+      pattern, regex, limit,
+      [self, req_id](const Status& status, const json& tree) {
         std::string message_out;
         if (status.ok()) {
           WriteGetDataReply(tree, message_out);
@@ -609,7 +718,7 @@ bool SocketConnection::doListData(const json& root) {
           LOG(ERROR) << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         return Status::OK();
       }));
   return false;
@@ -617,13 +726,15 @@ bool SocketConnection::doListData(const json& root) {
 
 bool SocketConnection::doCreateData(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   json tree;
   double startTime = GetCurrentTime();
   TRY_READ_REQUEST(ReadCreateDataRequest, root, tree);
   RESPONSE_ON_ERROR(server_ptr_->CreateData(
-      tree, [tree, self, startTime](const Status& status, const ObjectID id,
-                                    const Signature signature,
-                                    const InstanceID instance_id) {
+      tree, [tree, self, req_id, startTime](const Status& status,
+                                            const ObjectID id,
+                                            const Signature signature,
+                                            const InstanceID instance_id) {
         std::string message_out;
         if (status.ok()) {
           WriteCreateDataReply(id, signature, instance_id, message_out);
@@ -631,7 +742,7 @@ bool SocketConnection::doCreateData(const json& root) {
           LOG(ERROR) << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         double endTime = GetCurrentTime();
         LOG_SUMMARY("data_request_duration_microseconds", "create",
                     (endTime - startTime) * 1000000);
@@ -647,28 +758,31 @@ bool SocketConnection::doCreateData(const json& root) {
 
 bool SocketConnection::doPersist(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   ObjectID id;
   TRY_READ_REQUEST(ReadPersistRequest, root, id);
-  RESPONSE_ON_ERROR(server_ptr_->Persist(id, [self](const Status& status) {
-    std::string message_out;
-    if (status.ok()) {
-      WritePersistReply(message_out);
-    } else {
-      LOG(ERROR) << status.ToString();
-      WriteErrorReply(status, message_out);
-    }
-    self->doWrite(message_out);
-    return Status::OK();
-  }));
+  RESPONSE_ON_ERROR(
+      server_ptr_->Persist(id, [self, req_id](const Status& status) {
+        std::string message_out;
+        if (status.ok()) {
+          WritePersistReply(message_out);
+        } else {
+          LOG(ERROR) << status.ToString();
+          WriteErrorReply(status, message_out);
+        }
+        self->doReply(req_id, message_out);
+        return Status::OK();
+      }));
   return false;
 }
 
 bool SocketConnection::doIfPersist(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   ObjectID id;
   TRY_READ_REQUEST(ReadIfPersistRequest, root, id);
   RESPONSE_ON_ERROR(server_ptr_->IfPersist(
-      id, [self](const Status& status, bool const persist) {
+      id, [self, req_id](const Status& status, bool const persist) {
         std::string message_out;
         if (status.ok()) {
           WriteIfPersistReply(persist, message_out);
@@ -676,7 +790,7 @@ bool SocketConnection::doIfPersist(const json& root) {
           LOG(ERROR) << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         return Status::OK();
       }));
   return false;
@@ -684,10 +798,11 @@ bool SocketConnection::doIfPersist(const json& root) {
 
 bool SocketConnection::doExists(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   ObjectID id;
   TRY_READ_REQUEST(ReadExistsRequest, root, id);
-  RESPONSE_ON_ERROR(
-      server_ptr_->Exists(id, [self](const Status& status, bool const exists) {
+  RESPONSE_ON_ERROR(server_ptr_->Exists(
+      id, [self, req_id](const Status& status, bool const exists) {
         std::string message_out;
         if (status.ok()) {
           WriteExistsReply(exists, message_out);
@@ -695,7 +810,7 @@ bool SocketConnection::doExists(const json& root) {
           LOG(ERROR) << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         return Status::OK();
       }));
   return false;
@@ -703,11 +818,13 @@ bool SocketConnection::doExists(const json& root) {
 
 bool SocketConnection::doShallowCopy(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   ObjectID id;
   json extra_metadata;
   TRY_READ_REQUEST(ReadShallowCopyRequest, root, id, extra_metadata);
   RESPONSE_ON_ERROR(server_ptr_->ShallowCopy(
-      id, extra_metadata, [self](const Status& status, const ObjectID target) {
+      id, extra_metadata,
+      [self, req_id](const Status& status, const ObjectID target) {
         std::string message_out;
         if (status.ok()) {
           WriteShallowCopyReply(target, message_out);
@@ -715,7 +832,7 @@ bool SocketConnection::doShallowCopy(const json& root) {
           LOG(ERROR) << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         return Status::OK();
       }));
   return false;
@@ -745,12 +862,14 @@ bool SocketConnection::doDeepCopy(const json& root) {
 
 bool SocketConnection::doDelData(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   std::vector<ObjectID> ids;
   bool force, deep, fastpath;
   double startTime = GetCurrentTime();
   TRY_READ_REQUEST(ReadDelDataRequest, root, ids, force, deep, fastpath);
   RESPONSE_ON_ERROR(server_ptr_->DelData(
-      ids, force, deep, fastpath, [self, startTime](const Status& status) {
+      ids, force, deep, fastpath,
+      [self, req_id, startTime](const Status& status) {
         std::string message_out;
         if (status.ok()) {
           WriteDelDataReply(message_out);
@@ -758,7 +877,7 @@ bool SocketConnection::doDelData(const json& root) {
           LOG(ERROR) << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         double endTime = GetCurrentTime();
         LOG_SUMMARY("data_request_duration_microseconds", "delete",
                     (endTime - startTime) * 1000000);
@@ -894,11 +1013,12 @@ bool SocketConnection::doStopStream(const json& root) {
 
 bool SocketConnection::doPutName(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   ObjectID object_id;
   std::string name;
   TRY_READ_REQUEST(ReadPutNameRequest, root, object_id, name);
-  RESPONSE_ON_ERROR(
-      server_ptr_->PutName(object_id, name, [self](const Status& status) {
+  RESPONSE_ON_ERROR(server_ptr_->PutName(
+      object_id, name, [self, req_id](const Status& status) {
         std::string message_out;
         if (status.ok()) {
           WritePutNameReply(message_out);
@@ -906,7 +1026,7 @@ bool SocketConnection::doPutName(const json& root) {
           LOG(ERROR) << "Failed to put name: " << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         return Status::OK();
       }));
   return false;
@@ -914,12 +1034,13 @@ bool SocketConnection::doPutName(const json& root) {
 
 bool SocketConnection::doGetName(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   std::string name;
   bool wait;
   TRY_READ_REQUEST(ReadGetNameRequest, root, name, wait);
   RESPONSE_ON_ERROR(server_ptr_->GetName(
       name, wait, [self]() { return self->running_.load(); },
-      [self](const Status& status, const ObjectID& object_id) {
+      [self, req_id](const Status& status, const ObjectID& object_id) {
         std::string message_out;
         if (status.ok()) {
           WriteGetNameReply(object_id, message_out);
@@ -927,7 +1048,7 @@ bool SocketConnection::doGetName(const json& root) {
           LOG(ERROR) << "Failed to get name: " << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         return Status::OK();
       }));
   return false;
@@ -935,20 +1056,22 @@ bool SocketConnection::doGetName(const json& root) {
 
 bool SocketConnection::doDropName(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   std::string name;
   TRY_READ_REQUEST(ReadDropNameRequest, root, name);
-  RESPONSE_ON_ERROR(server_ptr_->DropName(name, [self](const Status& status) {
-    std::string message_out;
-    LOG(INFO) << "drop name callback: " << status;
-    if (status.ok()) {
-      WriteDropNameReply(message_out);
-    } else {
-      LOG(ERROR) << "Failed to drop name: " << status.ToString();
-      WriteErrorReply(status, message_out);
-    }
-    self->doWrite(message_out);
-    return Status::OK();
-  }));
+  RESPONSE_ON_ERROR(
+      server_ptr_->DropName(name, [self, req_id](const Status& status) {
+        std::string message_out;
+        LOG(INFO) << "drop name callback: " << status;
+        if (status.ok()) {
+          WriteDropNameReply(message_out);
+        } else {
+          LOG(ERROR) << "Failed to drop name: " << status.ToString();
+          WriteErrorReply(status, message_out);
+        }
+        self->doReply(req_id, message_out);
+        return Status::OK();
+      }));
   return false;
 }
 
@@ -995,9 +1118,10 @@ bool SocketConnection::doMigrateObject(const json& root) {
 
 bool SocketConnection::doClusterMeta(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   TRY_READ_REQUEST(ReadClusterMetaRequest, root);
-  RESPONSE_ON_ERROR(
-      server_ptr_->ClusterInfo([self](const Status& status, const json& tree) {
+  RESPONSE_ON_ERROR(server_ptr_->ClusterInfo(
+      [self, req_id](const Status& status, const json& tree) {
         std::string message_out;
         if (status.ok()) {
           WriteClusterMetaReply(tree, message_out);
@@ -1005,7 +1129,7 @@ bool SocketConnection::doClusterMeta(const json& root) {
           LOG(ERROR) << "Check cluster meta: " << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         return Status::OK();
       }));
   return false;
@@ -1013,9 +1137,10 @@ bool SocketConnection::doClusterMeta(const json& root) {
 
 bool SocketConnection::doInstanceStatus(const json& root) {
   auto self(shared_from_this());
+  RequestID req_id = ReadRequestID(root);
   TRY_READ_REQUEST(ReadInstanceStatusRequest, root);
   RESPONSE_ON_ERROR(server_ptr_->InstanceStatus(
-      [self](const Status& status, const json& tree) {
+      [self, req_id](const Status& status, const json& tree) {
         std::string message_out;
         if (status.ok()) {
           WriteInstanceStatusReply(tree, message_out);
@@ -1023,7 +1148,7 @@ bool SocketConnection::doInstanceStatus(const json& root) {
           LOG(ERROR) << "Check instance status: " << status.ToString();
           WriteErrorReply(status, message_out);
         }
-        self->doWrite(message_out);
+        self->doReply(req_id, message_out);
         return Status::OK();
       }));
   return false;
@@ -1121,9 +1246,11 @@ bool SocketConnection::doDebug(const json& root) {
 bool SocketConnection::doNewSession(const json& root) {
   auto self(shared_from_this());
   StoreType bulk_store_type;
-  TRY_READ_REQUEST(ReadNewSessionRequest, root, bulk_store_type);
-  VINEYARD_CHECK_OK(server_ptr_->GetRunner()->CreateNewSession(
-      bulk_store_type,
+  size_t reserved_size = 0, size = 0;
+  TRY_READ_REQUEST(ReadNewSessionRequest, root, bulk_store_type, reserved_size,
+                   size);
+  RESPONSE_ON_ERROR(server_ptr_->GetRunner()->CreateNewSession(
+      bulk_store_type, reserved_size, size,
       [self](Status const& status, std::string const& ipc_socket) {
         std::string message_out;
         if (status.ok()) {
@@ -1403,10 +1530,40 @@ bool SocketConnection::doIsSpilled(json const& root) {
   auto self(shared_from_this());
   ObjectID id;  // Must be a blob id.
   TRY_READ_REQUEST(ReadIsSpilledRequest, root, id);
-  bool is_spilled = false;
-  RESPONSE_ON_ERROR(bulk_store_->IsSpilled(id, is_spilled));
+  bool is_spilled = false, is_pinned = false;
+  SpillPriority priority = SpillPriority::kNormal;
+  RESPONSE_ON_ERROR(
+      bulk_store_->IsSpilled(id, is_spilled, priority, is_pinned));
+  std::string message_out;
+  WriteIsSpilledReply(is_spilled, priority, is_pinned, message_out);
+  this->doWrite(message_out);
+  return false;
+}
+
+bool SocketConnection::doPinBlobs(json const& root) {
+  auto self(shared_from_this());
+  std::vector<ObjectID> ids;  // Must be blob ids.
+  bool pinned = false;
+  TRY_READ_REQUEST(ReadPinBlobsRequest, root, ids, pinned);
+  for (auto const& id : ids) {
+    RESPONSE_ON_ERROR(bulk_store_->Pin(id, pinned));
+  }
+  std::string message_out;
+  WritePinBlobsReply(message_out);
+  this->doWrite(message_out);
+  return false;
+}
+
+bool SocketConnection::doSetSpillPriority(json const& root) {
+  auto self(shared_from_this());
+  std::vector<ObjectID> ids;  // Must be blob ids.
+  SpillPriority priority = SpillPriority::kNormal;
+  TRY_READ_REQUEST(ReadSetSpillPriorityRequest, root, ids, priority);
+  for (auto const& id : ids) {
+    RESPONSE_ON_ERROR(bulk_store_->SetSpillPriority(id, priority));
+  }
   std::string message_out;
-  WriteIsSpilledReply(is_spilled, message_out);
+  WriteSetSpillPriorityReply(message_out);
   this->doWrite(message_out);
   return false;
 }
@@ -1423,18 +1580,73 @@ bool SocketConnection::doIncreaseReferenceCount(json const& root) {
   return false;
 }
 
+MetricHistogram* SocketConnection::latencyHistogram(CommandType cmd,
+                                                    std::string const& type) {
+  static constexpr int kMaxCommands = 64;
+  // the registry lookup takes a lock, cache the histograms per command type
+  static std::array<std::atomic<MetricHistogram*>, kMaxCommands> histograms{};
+
+  int slot = static_cast<int>(cmd);
+  if (slot <= 0 || slot >= kMaxCommands) {
+    // unknown commands share the first slot
+    slot = 0;
+  }
+  MetricHistogram* histogram = histograms[slot].load();
+  if (histogram == nullptr) {
+    histogram = MetricsRegistry::Get().Histogram(
+        "request_duration_microseconds",
+        MetricsRegistry::Label("command", slot == 0 ? "unknown" : type));
+    histograms[slot].store(histogram);
+  }
+  return histogram;
+}
+
+void SocketConnection::observeLatency() {
+  // on the path of every reply, keep it cheap when metrics are disabled
+  if (!MetricsRegistry::Enabled() ||
+      pending_histogram_.load(std::memory_order_relaxed) == nullptr) {
+    return;
+  }
+  MetricHistogram* histogram =
+      pending_histogram_.exchange(nullptr, std::memory_order_relaxed);
+  if (histogram == nullptr) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  int64_t elapsed =
+      std::chrono::duration_cast<std::chrono::microseconds>(now).count() -
+      pending_since_.load(std::memory_order_relaxed);
+  histogram->Observe(static_cast<double>(elapsed));
+}
+
+void SocketConnection::observeLatency(RequestID const req_id) {
+  PendingLatency pending;
+  {
+    std::lock_guard<std::mutex> lock(tagged_pending_mutex_);
+    auto iter = tagged_pending_.find(req_id);
+    if (iter == tagged_pending_.end()) {
+      return;
+    }
+    pending = iter->second;
+    tagged_pending_.erase(iter);
+  }
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  int64_t elapsed =
+      std::chrono::duration_cast<std::chrono::microseconds>(now).count() -
+      pending.since;
+  pending.histogram->Observe(static_cast<double>(elapsed));
+}
+
 void SocketConnection::doWrite(const std::string& buf) {
-  std::string to_send;
-  size_t length = buf.size();
-  to_send.resize(length + sizeof(size_t));
-  char* ptr = &to_send[0];
-  memcpy(ptr, &length, sizeof(size_t));
-  ptr += sizeof(size_t);
-  memcpy(ptr, buf.data(), length);
-  doAsyncWrite(std::move(to_send));
+  doWrite(buf, nullptr);
 }
 
 void SocketConnection::doWrite(const std::string& buf, callback_t<> callback) {
+  if (dispatching_request.connection == this) {
+    doReply(dispatching_request.req_id, buf, callback);
+    return;
+  }
+  observeLatency();
   std::string to_send;
   size_t length = buf.size();
   to_send.resize(length + sizeof(size_t));
@@ -1446,9 +1658,33 @@ void SocketConnection::doWrite(const std::string& buf, callback_t<> callback) {
 }
 
 void SocketConnection::doWrite(std::string&& buf) {
+  if (dispatching_request.connection == this) {
+    doReply(dispatching_request.req_id, buf);
+    return;
+  }
+  observeLatency();
   doAsyncWrite(std::move(buf));
 }
 
+void SocketConnection::doReply(RequestID const req_id, const std::string& buf,
+                               callback_t<> callback) {
+  if (req_id == 0) {
+    observeLatency();
+  } else {
+    observeLatency(req_id);
+  }
+  std::string message = buf;
+  WriteRequestID(req_id, message);
+  std::string to_send;
+  size_t length = message.size();
+  to_send.resize(length + sizeof(size_t));
+  char* ptr = &to_send[0];
+  memcpy(ptr, &length, sizeof(size_t));
+  ptr += sizeof(size_t);
+  memcpy(ptr, message.data(), length);
+  doAsyncWrite(std::move(to_send), callback);
+}
+
 void SocketConnection::doStop() {
   if (this->Stop()) {
     // drop connection
@@ -1457,37 +1693,61 @@ void SocketConnection::doStop() {
 }
 
 void SocketConnection::doAsyncWrite(std::string&& buf) {
-  std::shared_ptr<std::string> payload =
-      std::make_shared<std::string>(std::move(buf));
+  doAsyncWrite(std::move(buf), nullptr);
+}
+
+void SocketConnection::doAsyncWrite(std::string&& buf, callback_t<> callback) {
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    write_queue_.emplace_back(PendingWrite{
+        std::make_shared<std::string>(std::move(buf)), std::move(callback)});
+    if (writing_) {
+      return;
+    }
+    writing_ = true;
+  }
+  doWriteNext();
+}
+
+void SocketConnection::doWriteNext() {
+  std::shared_ptr<std::string> payload;
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (write_queue_.empty()) {
+      writing_ = false;
+      return;
+    }
+    payload = write_queue_.front().payload;
+  }
   auto self(shared_from_this());
   asio::async_write(
       socket_, boost::asio::buffer(payload->data(), payload->length()),
       [this, self, payload](boost::system::error_code ec, std::size_t) {
-        if (ec) {
+        callback_t<> callback;
+        {
+          std::lock_guard<std::mutex> lock(write_mutex_);
+          callback = std::move(write_queue_.front().callback);
+          write_queue_.pop_front();
+        }
+        // the callback (e.g., sending fds after the reply) must finish
+        // before the next message is written.
+        bool failed = static_cast<bool>(ec);
+        if (!failed && callback) {
+          failed = !callback(Status::OK()).ok();
+        }
+        if (failed) {
+          {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            write_queue_.clear();
+            writing_ = false;
+          }
           doStop();
+          return;
         }
+        doWriteNext();
       });
 }
 
-void SocketConnection::doAsyncWrite(std::string&& buf, callback_t<> callback) {
-  std::shared_ptr<std::string> payload =
-      std::make_shared<std::string>(std::move(buf));
-  auto self(shared_from_this());
-  asio::async_write(socket_,
-                    boost::asio::buffer(payload->data(), payload->length()),
-                    [this, self, payload, callback](
-                        boost::system::error_code ec, std::size_t) {
-                      if (!ec) {
-                        auto status = callback(Status::OK());
-                        if (!status.ok()) {
-                          doStop();
-                        }
-                      } else {
-                        doStop();
-                      }
-                    });
-}
-
 SocketServer::SocketServer(vs_ptr_t vs_ptr)
     : vs_ptr_(vs_ptr), next_conn_id_(0) {}
 
@@ -42,6 +42,7 @@ class SocketServer;
 class BulkStore;
 class PlasmaBulkStore;
 class VineyardServer;
+class MetricHistogram;
 using vs_ptr_t = std::shared_ptr<VineyardServer>;
 
 using socket_message_queue_t = std::deque<std::string>;
@@ -161,6 +162,10 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
 
   bool doIsSpilled(json const& root);
 
+  bool doPinBlobs(json const& root);
+
+  bool doSetSpillPriority(json const& root);
+
  protected:
   template <typename FROM, typename TO>
   Status MoveBuffers(std::map<FROM, TO> mapping, vs_ptr_t& source_session);
@@ -178,16 +183,43 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
    */
   bool processMessage(const std::string& message_in);
 
+  bool dispatchMessage(CommandType const cmd, json const& root);
+
+  /**
+   * @brief Requests tagged with a request id are dispatched concurrently
+   * (in the io context) while the connection keeps reading the following
+   * requests, their replies are tagged with the same request id and may be
+   * written out of order.
+   *
+   * Only the metadata commands can be pipelined, the commands that pass file
+   * descriptors or raw buffers along with the reply must be issued untagged.
+   */
+  bool processTaggedMessage(CommandType const cmd, RequestID const req_id,
+                            json&& root);
+
+  static bool isPipelinable(CommandType const cmd);
+
   void doReadHeader();
 
   void doReadBody();
 
+  /**
+   * @brief Write a reply, the replies written while dispatching a tagged
+   * request go through `doReply()` with its request id.
+   */
   void doWrite(const std::string& buf);
 
   void doWrite(std::string&& buf);
 
   void doWrite(const std::string& buf, callback_t<> callback);
 
+  /**
+   * @brief Write the reply of the given request, tagged with the request id
+   * if it isn't 0, the callback runs once the reply has been written.
+   */
+  void doReply(RequestID const req_id, const std::string& buf,
+               callback_t<> callback = nullptr);
+
   /**
    * Being called when the encounter a socket error (in read/write), or by
    * plasma "conn->Stop()".
@@ -200,6 +232,28 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
 
   void doAsyncWrite(std::string&& buf, callback_t<> callback);
 
+  /**
+   * @brief Start writing the head of the write queue, if there's no write in
+   * progress.
+   */
+  void doWriteNext();
+
+  /**
+   * @brief Observe the latency of the pending command, i.e., the time from
+   * the request being dispatched to the reply being written, when metrics
+   * are enabled.
+   */
+  void observeLatency();
+
+  /**
+   * @brief Observe the latency of the given tagged request, whose replies
+   * may be written out of order.
+   */
+  void observeLatency(RequestID const req_id);
+
+  static MetricHistogram* latencyHistogram(CommandType cmd,
+                                           std::string const& type);
+
   void sendRemoteBufferHelper(
       std::vector<std::shared_ptr<Payload>> const& objects, size_t index,
       boost::system::error_code const ec, callback_t<> callback_after_finish);
@@ -219,6 +273,19 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
   int conn_id_;
   std::atomic_bool running_;
 
+  // the latency histogram of the command that waits for the reply, and when
+  // it was dispatched, used for the request latency metrics.
+  std::atomic<MetricHistogram*> pending_histogram_{nullptr};
+  std::atomic<int64_t> pending_since_{0};
+
+  // the same for the tagged requests in flight, keyed by the request id.
+  struct PendingLatency {
+    MetricHistogram* histogram;
+    int64_t since;
+  };
+  std::mutex tagged_pending_mutex_;
+  std::unordered_map<RequestID, PendingLatency> tagged_pending_;
+
   asio::streambuf buf_;
 
   std::unordered_set<int> used_fds_;
@@ -227,6 +294,16 @@ class SocketConnection : public std::enable_shared_from_this<SocketConnection> {
 
   size_t read_msg_header_;
   std::string read_msg_body_;
+
+  // replies of pipelined requests may be written concurrently, the queue
+  // serializes the writes (and the callbacks after the writes).
+  struct PendingWrite {
+    std::shared_ptr<std::string> payload;
+    callback_t<> callback;
+  };
+  std::mutex write_mutex_;
+  std::deque<PendingWrite> write_queue_;
+  bool writing_ = false;
 };
 
 /**
@@ -52,8 +52,8 @@ https://github.com/apache/arrow/blob/master/cpp/src/plasma/plasma_allocator.cc
 
 namespace vineyard {
 
-int64_t BulkAllocator::footprint_limit_ = 0;
-int64_t BulkAllocator::allocated_ = 0;
+std::atomic<int64_t> BulkAllocator::footprint_limit_{0};
+std::atomic<int64_t> BulkAllocator::allocated_{0};
 
 #if defined(WITH_JEMALLOC)
 BulkAllocator::Allocator BulkAllocator::allocator_{};
@@ -99,8 +99,18 @@ void* BulkAllocator::Init(const size_t size) {
 #endif
 }
 
+bool BulkAllocator::Reserve(const size_t bytes) {
+  int64_t size = static_cast<int64_t>(bytes);
+  int64_t allocated = allocated_.fetch_add(size, std::memory_order_relaxed);
+  if (allocated + size > footprint_limit_.load(std::memory_order_relaxed)) {
+    allocated_.fetch_sub(size, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
 void* BulkAllocator::Memalign(const size_t bytes, const size_t alignment) {
-  if (allocated_ + static_cast<int64_t>(bytes) > footprint_limit_) {
+  if (!Reserve(bytes)) {
     return nullptr;
   }
 
@@ -110,12 +120,62 @@ void* BulkAllocator::Memalign(const size_t bytes, const size_t alignment) {
 #if defined(WITH_JEMALLOC)
   void* mem = allocator_.Allocate(bytes, alignment);
 #endif
-  if (mem != nullptr) {
-    allocated_ += bytes;
+  if (mem == nullptr) {
+    allocated_.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+  return mem;
+}
+
+void* BulkAllocator::Memalign(const size_t bytes, const size_t alignment,
+                              const int numa_node) {
+  if (numa_node < 0) {
+    return Memalign(bytes, alignment);
+  }
+  if (!Reserve(bytes)) {
+    return nullptr;
+  }
+
+#if defined(WITH_DLMALLOC)
+  void* mem = Allocator::Allocate(bytes, alignment, numa_node);
+#endif
+#if defined(WITH_JEMALLOC)
+  // there are no NUMA sub-arenas with jemalloc, see `InitNumaArenas()`
+  void* mem = allocator_.Allocate(bytes, alignment);
+#endif
+  if (mem == nullptr) {
+    allocated_.fetch_sub(bytes, std::memory_order_relaxed);
   }
   return mem;
 }
 
+int BulkAllocator::InitShards(const size_t shards, const size_t size) {
+#if defined(WITH_DLMALLOC)
+  return Allocator::InitShards(shards, size);
+#endif
+#if defined(WITH_JEMALLOC)
+  // jemalloc already maintains per-thread caches and multiple arenas.
+  return 0;
+#endif
+}
+
+int BulkAllocator::InitNumaArenas(const size_t size) {
+#if defined(WITH_DLMALLOC)
+  return Allocator::InitNumaArenas(size);
+#endif
+#if defined(WITH_JEMALLOC)
+  return -1;
+#endif
+}
+
+int BulkAllocator::NumaNodeOf(void* mem) {
+#if defined(WITH_DLMALLOC)
+  return Allocator::NumaNodeOf(mem);
+#endif
+#if defined(WITH_JEMALLOC)
+  return -1;
+#endif
+}
+
 void BulkAllocator::Free(void* mem, size_t bytes) {
 #if defined(WITH_DLMALLOC)
   Allocator::Free(mem);
@@ -123,15 +183,33 @@ void BulkAllocator::Free(void* mem, size_t bytes) {
 #if defined(WITH_JEMALLOC)
   allocator_.Free(mem);
 #endif
-  allocated_ -= bytes;
+  allocated_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void BulkAllocator::Charge(int64_t bytes) {
+  allocated_.fetch_add(bytes, std::memory_order_relaxed);
 }
 
 void BulkAllocator::SetFootprintLimit(size_t bytes) {
-  footprint_limit_ = static_cast<int64_t>(bytes);
+  footprint_limit_.store(static_cast<int64_t>(bytes),
+                         std::memory_order_relaxed);
 }
 
-int64_t BulkAllocator::GetFootprintLimit() { return footprint_limit_; }
+int64_t BulkAllocator::GetFootprintLimit() {
+  return footprint_limit_.load(std::memory_order_relaxed);
+}
+
+int64_t BulkAllocator::Allocated() {
+  return allocated_.load(std::memory_order_relaxed);
+}
 
-int64_t BulkAllocator::Allocated() { return allocated_; }
+int64_t BulkAllocator::SystemFootprint() {
+#if defined(WITH_DLMALLOC)
+  return static_cast<int64_t>(Allocator::Footprint());
+#endif
+#if defined(WITH_JEMALLOC)
+  return -1;
+#endif
+}
 
 }  // namespace vineyard
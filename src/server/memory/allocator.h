@@ -29,6 +29,7 @@
 #ifndef SRC_SERVER_MEMORY_ALLOCATOR_H_
 #define SRC_SERVER_MEMORY_ALLOCATOR_H_
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 
@@ -52,6 +53,33 @@ class BulkAllocator {
   /// \return Pointer to allocated memory.
   static void* Memalign(size_t bytes, size_t alignment);
 
+  /// Like `Memalign(bytes, alignment)`, but allocates from the sub-arena of
+  /// the given NUMA node, see also `InitNumaArenas()`.
+  ///
+  /// \param numa_node The preferred NUMA node, -1 means no preference.
+  static void* Memalign(size_t bytes, size_t alignment, int numa_node);
+
+  /// Reserves a sub-arena on each NUMA node. The sub-arenas share the
+  /// footprint limit with the default arena.
+  ///
+  /// \param size The (virtual) size of each sub-arena.
+  /// \return The number of sub-arenas, 0 if NUMA is unavailable, and -1 if
+  /// the allocator doesn't support sub-arenas (jemalloc).
+  static int InitNumaArenas(const size_t size);
+
+  /// Reserves `shards` sub-arenas with their own locks for small allocations,
+  /// to let the allocator scale with the number of IPC worker threads. The
+  /// sub-arenas share the footprint limit with the default arena.
+  ///
+  /// \param shards The number of sub-arenas.
+  /// \param size The (virtual) total size of the sub-arenas.
+  /// \return The number of sub-arenas, 0 if sharding is not supported.
+  static int InitShards(const size_t shards, const size_t size);
+
+  /// Get the NUMA node of the allocated memory.
+  /// \return The NUMA node, or -1 if the memory is not from any sub-arena.
+  static int NumaNodeOf(void* mem);
+
   /// Frees the memory space pointed to by mem, which must have been returned by
   /// a previous call to Memalign()
   ///
@@ -69,10 +97,22 @@ class BulkAllocator {
   /// \return Plasma memory footprint limit in bytes.
   static int64_t GetFootprintLimit();
 
+  /// Accounts `bytes` of memory that isn't allocated by the allocator, e.g.,
+  /// the blobs reattached by a warm restart, in `Allocated()`. A negative
+  /// `bytes` gives them back.
+  static void Charge(int64_t bytes);
+
   /// Get the number of bytes allocated by Plasma so far.
   /// \return Number of bytes allocated by Plasma so far.
   static int64_t Allocated();
 
+  /// Get the number of bytes that the allocator holds from the system,
+  /// including the free chunks, i.e., `1 - Allocated() / SystemFootprint()`
+  /// is the fragmentation of the allocator.
+  ///
+  /// \return The footprint, or -1 if not supported by the allocator.
+  static int64_t SystemFootprint();
+
 #if defined(WITH_DLMALLOC)
   using Allocator = vineyard::memory::DLmallocAllocator;
 #endif
@@ -82,8 +122,12 @@ class BulkAllocator {
 #endif
 
  private:
-  static int64_t allocated_;
-  static int64_t footprint_limit_;
+  /// Accounts `bytes` in `allocated_` if it won't exceed the footprint limit.
+  static bool Reserve(size_t bytes);
+
+  // updated from the IPC worker threads concurrently
+  static std::atomic<int64_t> allocated_;
+  static std::atomic<int64_t> footprint_limit_;
 
 #if defined(WITH_JEMALLOC)
   static Allocator allocator_;
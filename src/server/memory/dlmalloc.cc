@@ -55,6 +55,7 @@ int fake_munmap(void*, int64_t);
 #define DEFAULT_MMAP_THRESHOLD MAX_SIZE_T
 #define DEFAULT_GRANULARITY ((size_t) 128U * 1024U)
 #define USE_LOCKS 1 /* makes the dlmalloc thread safe (but is not scalable) */
+#define MSPACES 1   /* for the per-NUMA-node sub-arenas */
 
 #include "dlmalloc/dlmalloc.c"  // NOLINT
 
@@ -66,6 +67,7 @@ int fake_munmap(void*, int64_t);
 #undef HAVE_MORECORE
 #undef DEFAULT_GRANULARITY
 #undef USE_LOCKS
+#undef MSPACES
 
 // dlmalloc.c defined DEBUG which will conflict with ARROW_LOG(DEBUG).
 #ifdef DEBUG
@@ -80,6 +82,17 @@ constexpr int64_t kMmapRegionsGap = sizeof(size_t);
 
 constexpr int GRANULARITY_MULTIPLIER = 2;
 
+std::vector<DLmallocAllocator::NumaArena> DLmallocAllocator::numa_arenas_;
+
+void* DLmallocAllocator::shards_base_ = nullptr;
+size_t DLmallocAllocator::shard_size_ = 0;
+std::vector<void*> DLmallocAllocator::shards_;
+std::atomic<size_t> DLmallocAllocator::next_shard_{0};
+
+/// Allocations that are larger than `shard_size_ / kShardedAllocationRatio`
+/// always go to the global heap, to keep the fragmentation of the shards low.
+constexpr size_t kShardedAllocationRatio = 16;
+
 // Fine-grained control for whether we need pre-populate the shared memory.
 //
 // Usually it causes a long wait time at the start up, but it could improved
@@ -103,7 +116,8 @@ void* fake_mmap(size_t size) {
   // fake_mmap are never contiguous.
   size += kMmapRegionsGap;
 
-  int fd = create_buffer(size);
+  std::string path;
+  int fd = create_buffer(size, path);
   CHECK_GE(fd, 0) << "Failed to create buffer during mmap";
   // MAP_POPULATE can be used to pre-populate the page tables for this memory
   // region
@@ -124,12 +138,12 @@ void* fake_mmap(size_t size) {
     return pointer;
   }
 
+  advise_buffer(pointer, size);
+
   // Increase dlmalloc's allocation granularity directly.
   mparams.granularity *= GRANULARITY_MULTIPLIER;
 
-  MmapRecord& record = mmap_records[pointer];
-  record.fd = fd;
-  record.size = size;
+  register_mmap_record(pointer, fd, size, path);
 
   // We lie to dlmalloc about where mapped memory actually lives.
   pointer = pointer_advance(pointer, kMmapRegionsGap);
@@ -140,9 +154,8 @@ int fake_munmap(void* addr, int64_t size) {
   addr = pointer_retreat(addr, kMmapRegionsGap);
   size += kMmapRegionsGap;
 
-  auto entry = mmap_records.find(addr);
-
-  if (entry == mmap_records.end() || entry->second.size != size) {
+  MmapRecord record;
+  if (!unregister_mmap_record(addr, size, &record)) {
     // Reject requests to munmap that don't directly match previous
     // calls to mmap, to prevent dlmalloc from trimming.
     return -1;
@@ -150,10 +163,11 @@ int fake_munmap(void* addr, int64_t size) {
 
   int r = munmap(addr, size);
   if (r == 0) {
-    close(entry->second.fd);
+    close(record.fd);
+    if (!record.path.empty()) {
+      unlink(record.path.c_str());
+    }
   }
-
-  mmap_records.erase(entry);
   return r;
 }
 
@@ -170,10 +184,141 @@ void* DLmallocAllocator::Init(const size_t size) {
 }
 
 void* DLmallocAllocator::Allocate(const size_t bytes, const size_t alignment) {
+  if (!shards_.empty() && bytes <= shard_size_ / kShardedAllocationRatio) {
+    void* pointer = AllocateFromShard(bytes, alignment);
+    if (pointer != nullptr) {
+      return pointer;
+    }
+  }
   return dlmemalign(alignment, bytes);
 }
 
-void DLmallocAllocator::Free(void* pointer, size_t) { dlfree(pointer); }
+void* DLmallocAllocator::AllocateFromShard(const size_t bytes,
+                                           const size_t alignment) {
+  // threads are assigned to shards in a round-robin manner on their first
+  // allocation, the IPC worker threads of vineyardd are long-living.
+  static thread_local size_t shard = next_shard_.fetch_add(1) % shards_.size();
+  return mspace_memalign(shards_[shard], alignment, bytes);
+}
+
+void DLmallocAllocator::Free(void* pointer, size_t) {
+  if (pointer >= shards_base_ &&
+      pointer < pointer_advance(shards_base_, shard_size_ * shards_.size())) {
+    size_t shard = (reinterpret_cast<uintptr_t>(pointer) -
+                    reinterpret_cast<uintptr_t>(shards_base_)) /
+                   shard_size_;
+    mspace_free(shards_[shard], pointer);
+    return;
+  }
+  for (auto const& arena : numa_arenas_) {
+    if (pointer >= arena.base &&
+        pointer < pointer_advance(arena.base, arena.size)) {
+      mspace_free(arena.space, pointer);
+      return;
+    }
+  }
+  dlfree(pointer);
+}
+
+int DLmallocAllocator::InitNumaArenas(const size_t size) {
+  int nodes = numa_node_count();
+  if (nodes <= 1) {
+    return 0;
+  }
+  for (int node = 0; node < nodes; ++node) {
+    std::string path;
+    int fd = create_buffer(size, path);
+    if (fd == -1) {
+      break;
+    }
+    void* pointer =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (pointer == MAP_FAILED) {
+      LOG(ERROR) << "mmap failed with error: " << strerror(errno);
+      close(fd);
+      break;
+    }
+    advise_buffer(pointer, size);
+    // bind before `create_mspace_with_base` touches the first page.
+    if (!bind_numa_node(pointer, size, node)) {
+      munmap(pointer, size);
+      close(fd);
+      break;
+    }
+    register_mmap_record(pointer, fd, size, path);
+
+    mspace space = create_mspace_with_base(pointer, size, 1 /* locked */);
+    // never grow beyond the bound pages.
+    mspace_set_footprint_limit(space, size);
+    numa_arenas_.emplace_back(
+        NumaArena{.base = pointer, .size = size, .space = space});
+  }
+  return numa_arenas_.size();
+}
+
+void* DLmallocAllocator::Allocate(const size_t bytes, const size_t alignment,
+                                  const int numa_node) {
+  if (numa_node < 0 || numa_node >= static_cast<int>(numa_arenas_.size())) {
+    return Allocate(bytes, alignment);
+  }
+  return mspace_memalign(numa_arenas_[numa_node].space, alignment, bytes);
+}
+
+int DLmallocAllocator::NumaNodeOf(void* pointer) {
+  for (size_t node = 0; node < numa_arenas_.size(); ++node) {
+    auto const& arena = numa_arenas_[node];
+    if (pointer >= arena.base &&
+        pointer < pointer_advance(arena.base, arena.size)) {
+      return node;
+    }
+  }
+  return -1;
+}
+
+int DLmallocAllocator::InitShards(const size_t shards, const size_t size) {
+  if (shards == 0 || size / shards == 0 || !shards_.empty()) {
+    return 0;
+  }
+  // keep the base of each shard page aligned
+  size_t shard_size = size / shards / 4096 * 4096;
+  size_t segment_size = shard_size * shards;
+  std::string path;
+  int fd = create_buffer(segment_size, path);
+  if (fd == -1) {
+    return 0;
+  }
+  void* pointer =
+      mmap(NULL, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (pointer == MAP_FAILED) {
+    LOG(ERROR) << "mmap failed with error: " << strerror(errno);
+    close(fd);
+    return 0;
+  }
+  advise_buffer(pointer, segment_size);
+  register_mmap_record(pointer, fd, segment_size, path);
+
+  for (size_t index = 0; index < shards; ++index) {
+    mspace space = create_mspace_with_base(
+        pointer_advance(pointer, index * shard_size), shard_size,
+        1 /* locked */);
+    mspace_set_footprint_limit(space, shard_size);
+    shards_.emplace_back(space);
+  }
+  shards_base_ = pointer;
+  shard_size_ = shard_size;
+  return shards_.size();
+}
+
+size_t DLmallocAllocator::Footprint() {
+  size_t footprint = dlmalloc_footprint();
+  for (auto const& arena : numa_arenas_) {
+    footprint += mspace_footprint(arena.space);
+  }
+  for (auto const& space : shards_) {
+    footprint += mspace_footprint(space);
+  }
+  return footprint;
+}
 
 void DLmallocAllocator::SetMallocGranularity(int value) {
   change_mparam(M_GRANULARITY, value);
@@ -18,6 +18,9 @@ limitations under the License.
 
 #if defined(WITH_DLMALLOC)
 
+#include <atomic>
+#include <vector>
+
 #include "common/util/status.h"
 
 namespace vineyard {
@@ -33,6 +36,61 @@ class DLmallocAllocator {
   static void Free(void* pointer, size_t = 0);
 
   static void SetMallocGranularity(int value);
+
+  /**
+   * @brief Reserve a sub-arena of `size` bytes for each NUMA node, whose pages
+   * are bound to the node.
+   *
+   * @return The number of reserved sub-arenas, 0 on non-NUMA machines.
+   */
+  static int InitNumaArenas(const size_t size);
+
+  /**
+   * @brief Allocate from the sub-arena of the given NUMA node, or from the
+   * default arena if `numa_node` is -1.
+   */
+  static void* Allocate(const size_t bytes, const size_t alignment,
+                        const int numa_node);
+
+  /**
+   * @brief The NUMA node of the sub-arena that `pointer` belongs to, -1 if it
+   * is allocated from the default arena.
+   */
+  static int NumaNodeOf(void* pointer);
+
+  /**
+   * @brief Carve a shared memory segment of `size` bytes into `shards`
+   * sub-arenas, each with its own lock. Small allocations of a thread are
+   * served by the sub-arena that the thread is assigned to, to avoid the
+   * contention on the global lock of dlmalloc.
+   *
+   * @return The number of sub-arenas, 0 if failed.
+   */
+  static int InitShards(const size_t shards, const size_t size);
+
+  /**
+   * @brief The bytes obtained from the system by the default arena and all
+   * sub-arenas, including the free chunks.
+   */
+  static size_t Footprint();
+
+ private:
+  static void* AllocateFromShard(const size_t bytes, const size_t alignment);
+
+  struct NumaArena {
+    void* base;
+    size_t size;
+    void* space;  // the dlmalloc mspace
+  };
+
+  static std::vector<NumaArena> numa_arenas_;
+
+  // the sharded sub-arenas are carved from a single segment, thus the shard
+  // of a pointer can be computed directly.
+  static void* shards_base_;
+  static size_t shard_size_;
+  static std::vector<void*> shards_;  // the dlmalloc mspaces
+  static std::atomic<size_t> next_shard_;
 };
 
 }  // namespace memory
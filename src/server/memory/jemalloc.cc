@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <sys/mman.h>
 
+#include <string>
+
 #include "server/memory/jemalloc.h"
 #include "server/memory/malloc.h"
 
@@ -26,15 +28,16 @@ namespace memory {
 
 void* JemallocAllocator::Init(const size_t size) {
   // create memory using mmap
-  int fd = create_buffer(size);
+  std::string path;
+  int fd = create_buffer(size, path);
   void* space = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
   if (space == nullptr) {
     return space;
   }
 
-  MmapRecord& record = mmap_records[space];
-  record.fd = fd;
-  record.size = size;
+  advise_buffer(space, size);
+
+  register_mmap_record(space, fd, size, path);
 
   return Jemalloc::Init(space, size);
 }
@@ -29,30 +29,77 @@
 #include "server/memory/malloc.h"
 
 #include <stddef.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#include <unistd.h>
 
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
+#ifdef __APPLE__
+#include "boost/thread/shared_mutex.hpp"
+#endif
+
 #include "common/util/logging.h"
 
 namespace vineyard {
 
 namespace memory {
 
-std::unordered_map<void*, MmapRecord> mmap_records;
+namespace {
 
-static void* pointer_advance(void* p, ptrdiff_t n) {
-  return (unsigned char*) p + n;
-}
+// Ordered by the base address, thus the segment that contains an address can
+// be found with `upper_bound`.
+std::map<uintptr_t, MmapRecord> mmap_records;
 
-static ptrdiff_t pointer_distance(void const* pfrom, void const* pto) {
-  return (unsigned char const*) pto - (unsigned char const*) pfrom;
-}
+#if __APPLE__
+boost::shared_mutex mmap_records_mutex;
+#else
+std::shared_timed_mutex mmap_records_mutex;
+#endif
+
+// Bumped whenever a segment is unregistered, to invalidate the per-thread
+// lookup caches.
+std::atomic<uint64_t> mmap_records_generation{0};
+
+// The segment found by the last `GetMallocMapinfo` of this thread. Almost all
+// blobs come from the few segments of the allocator, thus it makes the lookup
+// O(1) in the common case.
+struct MmapRecordCache {
+  uintptr_t base = 0;
+  int64_t size = 0;
+  int fd = -1;
+  uint64_t generation = 0;
+};
+
+thread_local MmapRecordCache mmap_record_cache;
+
+}  // namespace
+
+bool keep_buffers = false;
+
+std::string hugetlbfs_path;
+
+bool transparent_hugepage = false;
 
 // Create a buffer. This is creating a temporary file and then
 // immediately unlinking it so we do not leave traces in the system.
 int create_buffer(int64_t size) {
+  std::string path;
+  return create_buffer(size, path);
+}
+
+int create_buffer(int64_t size, std::string& path) {
   int fd = -1;
+  path.clear();
 #ifdef _WIN32
   if (!CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
                          (DWORD)((uint64_t) size >> (CHAR_BIT * sizeof(DWORD))),
@@ -63,6 +110,9 @@ int create_buffer(int64_t size) {
   // directory where to create the memory-backed file
 #ifdef __linux__
   std::string file_template = "/dev/shm/vineyard-bulk-XXXXXX";
+  if (!hugetlbfs_path.empty()) {
+    file_template = hugetlbfs_path + "/vineyard-bulk-XXXXXX";
+  }
 #else
   std::string file_template = "/tmp/vineyard-bulk-XXXXXX";
 #endif
@@ -73,11 +123,24 @@ int create_buffer(int64_t size) {
     LOG(FATAL) << "create_buffer failed to open file " << &file_name[0];
     return -1;
   }
-  // Immediately unlink the file so we do not leave traces in the system.
-  if (unlink(&file_name[0]) != 0) {
+  if (keep_buffers) {
+    // Keep the file, to let a restarted vineyardd reattach the memory.
+    path = &file_name[0];
+  } else if (unlink(&file_name[0]) != 0) {
+    // Immediately unlink the file so we do not leave traces in the system.
     LOG(FATAL) << "failed to unlink file " << &file_name[0];
     return -1;
   }
+#ifdef __linux__
+  if (!hugetlbfs_path.empty()) {
+    // files on hugetlbfs can only be truncated to multiples of the huge page
+    // size, while mmap() rounds up the length itself.
+    struct statfs fs;
+    if (fstatfs(fd, &fs) == 0 && fs.f_bsize > 0) {
+      size = (size + fs.f_bsize - 1) / fs.f_bsize * fs.f_bsize;
+    }
+  }
+#endif
   if (true) {
     // Increase the size of the file to the desired size. This seems not to be
     // needed for files that are backed by the huge page fs, see also
@@ -91,16 +154,118 @@ int create_buffer(int64_t size) {
   return fd;
 }
 
+void advise_buffer(void* pointer, int64_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (transparent_hugepage && hugetlbfs_path.empty()) {
+    // for shared memory, it requires "advise" (or "always") in
+    // /sys/kernel/mm/transparent_hugepage/shmem_enabled.
+    if (madvise(pointer, size, MADV_HUGEPAGE) != 0) {
+      LOG(WARNING) << "madvise(MADV_HUGEPAGE) failed: " << strerror(errno);
+    }
+  }
+#endif
+}
+
+int numa_node_count() {
+#ifdef __linux__
+  // the format is like "0" or "0-1", see also `man 7 numa`.
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string nodes;
+  if (online.is_open() && std::getline(online, nodes) && !nodes.empty()) {
+    auto sep = nodes.find_last_of("-,");
+    return std::stoi(sep == std::string::npos ? nodes
+                                              : nodes.substr(sep + 1)) +
+           1;
+  }
+#endif
+  return 1;
+}
+
+bool bind_numa_node(void* pointer, int64_t size, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  constexpr int kMPolBind = 2;  // MPOL_BIND in <linux/mempolicy.h>
+  unsigned long nodemask = 1UL << node;  // NOLINT(runtime/int)
+  if (syscall(SYS_mbind, pointer, size, kMPolBind, &nodemask,
+              sizeof(nodemask) * 8, 0) != 0) {
+    LOG(WARNING) << "mbind to NUMA node " << node
+                 << " failed: " << strerror(errno);
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void register_mmap_record(void* base, int fd, int64_t size,
+                          std::string const& path) {
+  std::unique_lock<decltype(mmap_records_mutex)> lock(mmap_records_mutex);
+  MmapRecord& record = mmap_records[reinterpret_cast<uintptr_t>(base)];
+  record.fd = fd;
+  record.size = size;
+  record.path = path;
+}
+
+bool unregister_mmap_record(void* base, int64_t size, MmapRecord* record) {
+  std::unique_lock<decltype(mmap_records_mutex)> lock(mmap_records_mutex);
+  auto entry = mmap_records.find(reinterpret_cast<uintptr_t>(base));
+  if (entry == mmap_records.end() || entry->second.size != size) {
+    return false;
+  }
+  *record = std::move(entry->second);
+  mmap_records.erase(entry);
+  mmap_records_generation.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+bool lookup_mmap_record(void* base, MmapRecord* record) {
+  std::shared_lock<decltype(mmap_records_mutex)> lock(mmap_records_mutex);
+  auto entry = mmap_records.find(reinterpret_cast<uintptr_t>(base));
+  if (entry == mmap_records.end()) {
+    return false;
+  }
+  *record = entry->second;
+  return true;
+}
+
+void unlink_named_buffers() {
+  std::shared_lock<decltype(mmap_records_mutex)> lock(mmap_records_mutex);
+  for (auto const& entry : mmap_records) {
+    if (!entry.second.path.empty() &&
+        unlink(entry.second.path.c_str()) != 0 && errno != ENOENT) {
+      LOG(WARNING) << "Failed to remove " << entry.second.path << ": "
+                   << strerror(errno);
+    }
+  }
+}
+
 void GetMallocMapinfo(void* addr, int* fd, int64_t* map_size,
                       ptrdiff_t* offset) {
-  // About the efficiences: the records size usually small, thus linear search
-  // is enough.
-  for (const auto& entry : mmap_records) {
-    if (addr >= entry.first &&
-        addr < pointer_advance(entry.first, entry.second.size)) {
-      *fd = entry.second.fd;
-      *map_size = entry.second.size;
-      *offset = pointer_distance(entry.first, addr);
+  uintptr_t address = reinterpret_cast<uintptr_t>(addr);
+  MmapRecordCache& cache = mmap_record_cache;
+  uint64_t generation =
+      mmap_records_generation.load(std::memory_order_acquire);
+  if (cache.fd != -1 && cache.generation == generation &&
+      address >= cache.base &&
+      address < cache.base + static_cast<uintptr_t>(cache.size)) {
+    *fd = cache.fd;
+    *map_size = cache.size;
+    *offset = address - cache.base;
+    return;
+  }
+
+  std::shared_lock<decltype(mmap_records_mutex)> lock(mmap_records_mutex);
+  auto entry = mmap_records.upper_bound(address);
+  if (entry != mmap_records.begin()) {
+    --entry;
+    if (address < entry->first + static_cast<uintptr_t>(entry->second.size)) {
+      *fd = entry->second.fd;
+      *map_size = entry->second.size;
+      *offset = address - entry->first;
+      cache.base = entry->first;
+      cache.size = entry->second.size;
+      cache.fd = entry->second.fd;
+      cache.generation = generation;
       return;
     }
   }
@@ -32,7 +32,7 @@
 #include <inttypes.h>
 #include <stddef.h>
 
-#include <unordered_map>
+#include <string>
 
 namespace vineyard {
 
@@ -47,12 +47,42 @@ void GetMallocMapinfo(void* addr, int* fd, int64_t* map_length,
 struct MmapRecord {
   int fd = -1;
   int64_t size = -1;
+  std::string path;  // non-empty only for named (persistent) buffers
 };
 
-/// Hashtable that contains one entry per segment that we got from the OS
-/// via mmap. Associates the address of that segment with its file descriptor
-/// and size.
-extern std::unordered_map<void*, MmapRecord> mmap_records;
+/// Registers a segment that we got from the OS via mmap, i.e., associates the
+/// address of that segment with its file descriptor and size, to let
+/// `GetMallocMapinfo` find the segment of an address.
+///
+/// The records are guarded by a readers-writer lock, thus the functions that
+/// access the records are safe to be called from multiple threads.
+void register_mmap_record(void* base, int fd, int64_t size,
+                          std::string const& path);
+
+/// Unregisters the segment that starts at `base`, if its size matches `size`.
+///
+/// \return Whether the segment is unregistered, the removed record will be
+/// stored into `record`.
+bool unregister_mmap_record(void* base, int64_t size, MmapRecord* record);
+
+/// Finds the record of the segment that starts at `base`.
+bool lookup_mmap_record(void* base, MmapRecord* record);
+
+/// Removes the backing files of the registered named (persistent) segments
+/// from the file system, the mappings are kept.
+void unlink_named_buffers();
+
+/// Whether `create_buffer` keeps the backing file in the file system, rather
+/// than unlinking it. Enabled for warm restart, see also `BulkStore::Recover`.
+extern bool keep_buffers;
+
+/// The mount point of a hugetlbfs. If set, `create_buffer` backs the buffers
+/// with explicit huge pages, rather than the tmpfs in `/dev/shm`.
+extern std::string hugetlbfs_path;
+
+/// Whether to advise the kernel to back the mapped buffers with transparent
+/// huge pages, see `advise_buffer`.
+extern bool transparent_hugepage;
 
 // Create a buffer. This is creating a temporary file and then
 // immediately unlinking it so we do not leave traces in the system.
@@ -60,6 +90,21 @@ extern std::unordered_map<void*, MmapRecord> mmap_records;
 // Returns a fd as expected.
 int create_buffer(int64_t size);
 
+// Like `create_buffer(size)`, but returns the path of the backing file if
+// `keep_buffers` is set, otherwise the path will be empty.
+int create_buffer(int64_t size, std::string& path);
+
+// Apply the page-level advises (e.g., transparent huge pages) on a newly
+// mapped buffer.
+void advise_buffer(void* pointer, int64_t size);
+
+// The number of NUMA nodes, 1 when NUMA is not available.
+int numa_node_count();
+
+// Bind the pages in the given range to the NUMA node, must be called before
+// the pages are touched.
+bool bind_numa_node(void* pointer, int64_t size, int node);
+
 }  // namespace memory
 
 }  // namespace vineyard
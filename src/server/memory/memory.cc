@@ -28,7 +28,9 @@
 
 #include "server/memory/memory.h"
 
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <cstdint>
@@ -43,6 +45,13 @@
 #include "common/util/status.h"
 #include "server/memory/allocator.h"
 #include "server/memory/malloc.h"
+#include "server/util/journal.h"
+
+// Introduced in Linux 4.17, and older kernels treat it as a hint address
+// (without MAP_FIXED), thus the returned address must be checked anyway.
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
 
 namespace vineyard {
 
@@ -126,6 +135,20 @@ static void recycle_arena(const uintptr_t base, const size_t size,
     head = next;
   }
 }
+
+// The shared memory pool is initialized by the first bulk store (i.e., the
+// one of the root session), and then shared by the bulk stores of the other
+// sessions.
+struct PoolSegment {
+  void* pointer = nullptr;
+  int fd = -1;
+  int64_t map_size = 0;
+  ptrdiff_t offset = 0;
+};
+
+static std::mutex pool_segment_mutex;
+static PoolSegment pool_segment;
+
 }  // namespace memory
 
 template <typename ID, typename P>
@@ -133,6 +156,21 @@ std::set<ID> BulkStoreBase<ID, P>::Arena::spans{};
 
 template <typename ID, typename P>
 BulkStoreBase<ID, P>::~BulkStoreBase() {
+  if (has_quota_) {
+    MemoryPool::Get().Unregister(session_);
+    has_quota_ = false;
+  }
+  if (journal_) {
+    std::lock_guard<std::mutex> guard(journal_mutex_);
+    if (!journaled_.empty()) {
+      // keep the payloads alive for the next vineyardd process: freeing them
+      // would let the allocator overwrite the blob contents.
+      return;
+    }
+    // nothing to reattach: don't leave the segments behind in /dev/shm
+    VINEYARD_DISCARD(journal_->Destroy());
+    memory::unlink_named_buffers();
+  }
   std::vector<ID> object_ids;
   object_ids.reserve(objects_.size());
   for (auto iter = objects_.begin(); iter != objects_.end(); iter++) {
@@ -148,16 +186,45 @@ template <typename ID, typename P>
 uint8_t* BulkStoreBase<ID, P>::AllocateMemory(size_t size, int* fd,
                                               int64_t* map_size,
                                               ptrdiff_t* offset) {
-  // Try to evict objects until there is enough space.
+  if (has_quota_ && !MemoryPool::Get().Acquire(session_, size)) {
+    return nullptr;
+  }
   uint8_t* pointer = nullptr;
   pointer =
       reinterpret_cast<uint8_t*>(BulkAllocator::Memalign(size, kBlockSize));
   if (pointer) {
     GetMallocMapinfo(pointer, fd, map_size, offset);
+  } else if (has_quota_) {
+    MemoryPool::Get().Release(session_, size);
+  }
+  return pointer;
+}
+
+template <typename ID, typename P>
+uint8_t* BulkStoreBase<ID, P>::AllocateMemory(size_t size, int numa_node,
+                                              int* fd, int64_t* map_size,
+                                              ptrdiff_t* offset) {
+  if (has_quota_ && !MemoryPool::Get().Acquire(session_, size)) {
+    return nullptr;
+  }
+  uint8_t* pointer = reinterpret_cast<uint8_t*>(
+      BulkAllocator::Memalign(size, kBlockSize, numa_node));
+  if (pointer) {
+    GetMallocMapinfo(pointer, fd, map_size, offset);
+  } else if (has_quota_) {
+    MemoryPool::Get().Release(session_, size);
   }
   return pointer;
 }
 
+template <typename ID, typename P>
+void BulkStoreBase<ID, P>::FreeMemory(uint8_t* pointer, size_t size) {
+  BulkAllocator::Free(pointer, size);
+  if (has_quota_) {
+    MemoryPool::Get().Release(session_, size);
+  }
+}
+
 template <typename ID, typename P>
 Status BulkStoreBase<ID, P>::Seal(ID const& id) {
   if (id == EmptyBlobID<ID>()) {
@@ -167,6 +234,7 @@ Status BulkStoreBase<ID, P>::Seal(ID const& id) {
     if (objects_.find(accessor, id)) {
       auto object = accessor->second;
       object->MarkAsSealed();
+      JournalSeal(id, object);
       return Status::OK();
     } else {
       return Status::ObjectNotExists("get: id = " + IDToString<ID>(id));
@@ -247,6 +315,10 @@ Status BulkStoreBase<ID, P>::Delete(ID const& object_id) {
     return Status::OK();
   }
 
+  if (object->IsSealed()) {
+    JournalRelease(object_id);
+  }
+
   if (object->IsSpilled()) {
     objects_.erase(accessor);
     return Status::OK();
@@ -254,10 +326,19 @@ Status BulkStoreBase<ID, P>::Delete(ID const& object_id) {
 
   if (object->arena_fd == -1) {
     auto buff_size = object->data_size;
-    BulkAllocator::Free(object->pointer, buff_size);
+    FreeMemory(object->pointer, buff_size);
     DVLOG(10) << "after free: " << IDToString(object_id) << ": " << Footprint()
               << "(" << FootprintLimit() << ")";
   } else {
+    if (journal_) {
+      std::lock_guard<std::mutex> guard(journal_mutex_);
+      if (recovered_.erase(object_id)) {
+        BulkAllocator::Charge(-object->data_size);
+        if (has_quota_) {
+          MemoryPool::Get().Release(session_, object->data_size);
+        }
+      }
+    }
     static size_t page_size = memory::system_page_size();
     uintptr_t pointer = reinterpret_cast<uintptr_t>(object->pointer);
     uintptr_t lower = memory::align_down(pointer, page_size),
@@ -309,53 +390,140 @@ bool BulkStoreBase<ID, P>::Exists(const ID& object_id) {
 
 template <typename ID, typename P>
 size_t BulkStoreBase<ID, P>::Footprint() const {
+  if (has_quota_) {
+    return MemoryPool::Get().Usage(session_);
+  }
   return BulkAllocator::Allocated();
 }
 
 template <typename ID, typename P>
 size_t BulkStoreBase<ID, P>::FootprintLimit() const {
+  if (has_quota_) {
+    return MemoryPool::Get().Limit(session_);
+  }
   return BulkAllocator::GetFootprintLimit();
 }
 
 template <typename ID, typename P>
 Status BulkStoreBase<ID, P>::MakeArena(size_t const size, int& fd,
                                        uintptr_t& base) {
-  fd = memory::create_buffer(size);
+  std::string path;
+  fd = memory::create_buffer(size, path);
   if (fd == -1) {
     return Status::NotEnoughMemory("Failed to allocate a new arena of size " +
                                    std::to_string(size));
   }
   void* space = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  memory::advise_buffer(space, size);
   base = reinterpret_cast<uintptr_t>(space);
   arenas_.emplace(fd, Arena{.fd = fd,
                             .size = size,
-                            .base = reinterpret_cast<uintptr_t>(space)});
+                            .base = reinterpret_cast<uintptr_t>(space),
+                            .path = path});
   return Status::OK();
 }
 
 template <typename ID, typename P>
 Status BulkStoreBase<ID, P>::PreAllocate(const size_t size) {
-  BulkAllocator::SetFootprintLimit(size);
-  void* pointer = BulkAllocator::Init(size);
-
-  if (pointer == nullptr) {
-    return Status::NotEnoughMemory("mmap failed, size = " +
-                                   std::to_string(size));
+  memory::PoolSegment segment;
+  {
+    std::lock_guard<std::mutex> lock(memory::pool_segment_mutex);
+    if (memory::pool_segment.pointer == nullptr) {
+      BulkAllocator::SetFootprintLimit(size);
+      void* pointer = BulkAllocator::Init(size);
+      if (pointer == nullptr) {
+        return Status::NotEnoughMemory("mmap failed, size = " +
+                                       std::to_string(size));
+      }
+      memory::pool_segment.pointer = pointer;
+      GetMallocMapinfo(pointer, &memory::pool_segment.fd,
+                       &memory::pool_segment.map_size,
+                       &memory::pool_segment.offset);
+      MemoryPool::Get().SetCapacity(size);
+    } else if (static_cast<int64_t>(size) !=
+               BulkAllocator::GetFootprintLimit()) {
+      LOG(INFO) << "The shared memory pool has already been initialized with "
+                << BulkAllocator::GetFootprintLimit()
+                << " bytes, the requested size " << size << " is ignored";
+    }
+    segment = memory::pool_segment;
   }
 
   // insert a special marker for obtaining the whole shared memory range
   ID object_id = GenerateBlobID<ID>(std::numeric_limits<uintptr_t>::max());
-  int fd = -1;
-  int64_t map_size = 0;
-  ptrdiff_t offset = 0;
-  GetMallocMapinfo(pointer, &fd, &map_size, &offset);
-  objects_.emplace(
-      object_id,
-      std::make_shared<P>(object_id, size, static_cast<uint8_t*>(pointer), fd,
-                          map_size, offset));
+  objects_.emplace(object_id,
+                   std::make_shared<P>(
+                       object_id, BulkAllocator::GetFootprintLimit(),
+                       static_cast<uint8_t*>(segment.pointer), segment.fd,
+                       segment.map_size, segment.offset));
+  return Status::OK();
+}
+
+template <typename ID, typename P>
+Status BulkStoreBase<ID, P>::SetQuota(
+    SessionID const session, size_t const reserved, size_t const limit,
+    MemoryPool::reclaimer_t const& reclaimer) {
+  RETURN_ON_ERROR(
+      MemoryPool::Get().Register(session, reserved, limit, reclaimer));
+  session_ = session;
+  has_quota_ = true;
+  // the reattached blobs (see `BulkStore::Recover()`) count to the usage of
+  // the session, as the allocated ones do
+  size_t recovered = 0;
+  {
+    std::lock_guard<std::mutex> guard(journal_mutex_);
+    for (auto const& object_id : recovered_) {
+      typename object_map_t::const_accessor accessor;
+      if (objects_.find(accessor, object_id)) {
+        recovered += accessor->second->data_size;
+      }
+    }
+  }
+  if (recovered > 0) {
+    MemoryPool::Get().Charge(session, recovered);
+  }
+  return Status::OK();
+}
+
+template <typename ID, typename P>
+Status BulkStoreBase<ID, P>::PreAllocateNumaArenas(const size_t size) {
+  int nodes = BulkAllocator::InitNumaArenas(size);
+  if (nodes == -1) {
+    return Status::NotImplemented(
+        "NUMA sub-arenas (--numa_arena_size) are not supported by the jemalloc "
+        "allocator, build vineyardd with '-DWITH_ALLOCATOR=dlmalloc' instead");
+  }
+  if (nodes == 0) {
+    LOG(WARNING) << "NUMA is not available, the NUMA node hints of blobs will "
+                    "be ignored";
+  } else {
+    LOG(INFO) << "Reserved shared memory sub-arenas on " << nodes
+              << " NUMA nodes";
+  }
+  return Status::OK();
+}
+
+template <typename ID, typename P>
+Status BulkStoreBase<ID, P>::PreAllocateShards(const size_t shards) {
+  // the shards are sparse: they share the footprint limit with the default
+  // arena, and only the touched pages are backed by memory.
+  int reserved = BulkAllocator::InitShards(
+      shards, static_cast<size_t>(BulkAllocator::GetFootprintLimit()));
+  if (reserved == 0) {
+    LOG(WARNING) << "Sharded allocation is not supported by the allocator";
+  } else {
+    LOG(INFO) << "Reserved " << reserved << " shared memory shards";
+  }
   return Status::OK();
 }
 
+template <typename ID, typename P>
+void BulkStoreBase<ID, P>::SetHugePages(std::string const& hugetlbfs_path,
+                                        bool const transparent_hugepage) {
+  memory::hugetlbfs_path = hugetlbfs_path;
+  memory::transparent_hugepage = transparent_hugepage;
+}
+
 template <typename ID, typename P>
 Status BulkStoreBase<ID, P>::FinalizeArena(const int fd,
                                            std::vector<size_t> const& offsets,
@@ -390,10 +558,8 @@ Status BulkStoreBase<ID, P>::FinalizeArena(const int fd,
   { memory::recycle_arena(mmap_base, mmap_size, offsets, sizes); }
   // make it available for mmap record
   {
-    memory::MmapRecord& record =
-        memory::mmap_records[reinterpret_cast<void*>(mmap_base)];
-    record.fd = fd;
-    record.size = mmap_size;
+    memory::register_mmap_record(reinterpret_cast<void*>(mmap_base), fd,
+                                 mmap_size, arena->second.path);
     arenas_.erase(arena);
   }
   return Status::OK();
@@ -411,6 +577,11 @@ Status BulkStoreBase<ID, P>::MoveOwnership(
     }
     auto object = std::make_shared<P>(item.second);
     object->MarkAsSealed();
+    if (has_quota_ && object->IsOwner() && object->arena_fd == -1 &&
+        !object->IsSpilled()) {
+      // the memory is charged to the new owner
+      MemoryPool::Get().Charge(session_, object->data_size);
+    }
     objects_.emplace(id, object);
   }
   return Status::OK();
@@ -430,12 +601,70 @@ Status BulkStoreBase<ID, P>::RemoveOwnership(
       continue;
     } else {
       successed_id_to_size.emplace(id, *(accessor->second));
-      accessor->second->RemoveOwner();
+      auto& object = accessor->second;
+      if (has_quota_ && object->IsOwner() && object->arena_fd == -1 &&
+          !object->IsSpilled()) {
+        MemoryPool::Get().Release(session_, object->data_size);
+      }
+      object->RemoveOwner();
     }
   }
   return Status::OK();
 }
 
+template <typename ID, typename P>
+void BulkStoreBase<ID, P>::JournalSeal(ID const& object_id,
+                                       std::shared_ptr<P> const& object) {
+  if (!journal_ || object->pointer == nullptr) {
+    return;
+  }
+  void* segment = object->pointer - object->data_offset;
+  memory::MmapRecord record;
+  if (!memory::lookup_mmap_record(segment, &record) || record.path.empty()) {
+    // anonymous segment, can't be reattached after restart
+    return;
+  }
+  json entry;
+  entry["op"] = "seal";
+  entry["id"] = IDToString<ID>(object_id);
+  entry["segment"] = record.path;
+  entry["base"] = reinterpret_cast<uintptr_t>(segment);
+  entry["segment_size"] = record.size;
+  entry["offset"] = object->data_offset;
+  entry["size"] = object->data_size;
+
+  std::lock_guard<std::mutex> guard(journal_mutex_);
+  VINEYARD_LOG_ERROR(journal_->Append(entry));
+  journaled_[object_id] = std::move(entry);
+}
+
+template <typename ID, typename P>
+void BulkStoreBase<ID, P>::JournalRelease(ID const& object_id) {
+  if (!journal_) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(journal_mutex_);
+  auto iter = journaled_.find(object_id);
+  if (iter == journaled_.end()) {
+    return;
+  }
+  journaled_.erase(iter);
+  json entry;
+  entry["op"] = "release";
+  entry["id"] = IDToString<ID>(object_id);
+  VINEYARD_LOG_ERROR(journal_->Append(entry));
+
+  // compact the log when it is dominated by dead entries
+  if (journal_->Appended() > 2 * journaled_.size() + 4096) {
+    std::vector<json> live;
+    live.reserve(journaled_.size());
+    for (auto const& item : journaled_) {
+      live.emplace_back(item.second);
+    }
+    VINEYARD_LOG_ERROR(journal_->Compact(live));
+  }
+}
+
 template class BulkStoreBase<ObjectID, Payload>;
 
 template class BulkStoreBase<PlasmaID, PlasmaPayload>;
@@ -469,9 +698,143 @@ Status BulkStore::Create(const size_t data_size, ObjectID& object_id,
   return Status::OK();
 }
 
+Status BulkStore::Create(const size_t data_size, const int numa_node,
+                         ObjectID& object_id,
+                         std::shared_ptr<Payload>& object) {
+  if (data_size == 0 || numa_node < 0) {
+    return Create(data_size, object_id, object);
+  }
+  int fd = -1;
+  int64_t map_size = 0;
+  ptrdiff_t offset = 0;
+  uint8_t* pointer =
+      AllocateMemory(data_size, numa_node, &fd, &map_size, &offset);
+  if (pointer == nullptr) {
+    // the sub-arena is exhausted, or NUMA is unavailable
+    return Create(data_size, object_id, object);
+  }
+  object_id = GenerateBlobID<ObjectID>(pointer);
+  object = std::make_shared<Payload>(object_id, data_size, pointer, fd,
+                                     map_size, offset);
+  object->numa_node = BulkAllocator::NumaNodeOf(pointer);
+  objects_.emplace(object_id, object);
+  return Status::OK();
+}
+
+Status BulkStore::SetQuota(SessionID const session, size_t const reserved,
+                           size_t const limit) {
+  MemoryPool::reclaimer_t reclaimer = nullptr;
+  if (SpillEnabled()) {
+    std::weak_ptr<BulkStore> store(shared_from_this());
+    reclaimer = [store](size_t const bytes) -> size_t {
+      auto self = store.lock();
+      return self ? self->Reclaim(bytes) : 0;
+    };
+  }
+  return BulkStoreBase<ObjectID, Payload>::SetQuota(session, reserved, limit,
+                                                    reclaimer);
+}
+
+Status BulkStore::Recover(std::string const& state_path) {
+  size_t recovered = 0;
+  memory::keep_buffers = true;
+  journal_.reset(new Journal(state_path + "/payloads"));
+
+  std::map<std::string, json> live;
+  std::set<std::string> segments_seen;
+  RETURN_ON_ERROR(journal_->Replay([&](json const& entry) {
+    auto const& id = entry["id"].get_ref<std::string const&>();
+    if (entry["op"] == "seal") {
+      segments_seen.emplace(entry["segment"].get<std::string>());
+      live[id] = entry;
+    } else {
+      live.erase(id);
+    }
+  }));
+
+  std::map<std::string, std::vector<json>> segments;
+  for (auto const& item : live) {
+    segments[item.second["segment"].get<std::string>()].emplace_back(
+        item.second);
+  }
+  for (auto const& path : segments_seen) {
+    if (segments.find(path) == segments.end()) {
+      // no live blobs on this segment anymore
+      unlink(path.c_str());
+    }
+  }
+
+  for (auto const& segment : segments) {
+    std::string const& path = segment.first;
+    auto const& entries = segment.second;
+    void* base = reinterpret_cast<void*>(entries[0]["base"].get<uintptr_t>());
+    int64_t size = entries[0]["segment_size"].get<int64_t>();
+
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd == -1) {
+      LOG(WARNING) << "Failed to reattach shared memory " << path << ": "
+                   << strerror(errno) << ", " << entries.size()
+                   << " blobs are lost";
+      continue;
+    }
+    void* space = mmap(base, size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+    if (space != base) {
+      LOG(WARNING) << "Failed to map shared memory " << path << " at " << base
+                   << ", " << entries.size() << " blobs are lost";
+      if (space != MAP_FAILED) {
+        munmap(space, size);
+      }
+      close(fd);
+      unlink(path.c_str());
+      continue;
+    }
+
+    std::vector<size_t> offsets, sizes;
+    for (auto const& entry : entries) {
+      ObjectID object_id =
+          ObjectIDFromString(entry["id"].get_ref<std::string const&>());
+      ptrdiff_t offset = entry["offset"].get<ptrdiff_t>();
+      int64_t data_size = entry["size"].get<int64_t>();
+      // reattached blobs are managed as arenas: they are not owned by the
+      // allocator, and deleting them recycles the pages only.
+      auto object = std::make_shared<Payload>(
+          object_id, data_size, static_cast<uint8_t*>(space) + offset, fd, fd,
+          size, offset);
+      object->MarkAsSealed();
+      objects_.emplace(object_id, object);
+      Arena::spans.emplace(object_id);
+      journaled_.emplace(object_id, entry);
+      recovered_.emplace(object_id);
+      // the blobs occupy the memory as allocated ones do, see `--size`
+      BulkAllocator::Charge(data_size);
+      offsets.emplace_back(offset);
+      sizes.emplace_back(data_size);
+      recovered += data_size;
+    }
+    memory::recycle_arena(reinterpret_cast<uintptr_t>(space), size, offsets,
+                          sizes);
+    memory::register_mmap_record(space, fd, size, path);
+  }
+
+  std::vector<json> entries;
+  entries.reserve(journaled_.size());
+  for (auto const& item : journaled_) {
+    entries.emplace_back(item.second);
+  }
+  RETURN_ON_ERROR(journal_->Compact(entries));
+  LOG(INFO) << "Reattached " << journaled_.size() << " blobs (" << recovered
+            << " bytes) from " << segments.size() << " shared memory segments";
+  return Status::OK();
+}
+
 Status BulkStore::OnRelease(ObjectID const& id) {
   typename object_map_t::const_accessor accessor;
   if (objects_.find(accessor, id)) {
+    if (accessor->second->arena_fd != -1) {
+      // arena blobs are not owned by the allocator, thus cannot be spilled
+      return Status::OK();
+    }
     RETURN_ON_ERROR(this->MarkAsCold(id, accessor->second));
   }
   return Status::OK();
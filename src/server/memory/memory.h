@@ -33,7 +33,9 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -43,7 +45,10 @@
 #include "common/memory/payload.h"
 #include "common/util/logging.h"
 #include "common/util/status.h"
+#include "common/util/uuid.h"
+#include "server/memory/pool.h"
 #include "server/memory/usage.h"
+#include "server/util/journal.h"
 
 namespace vineyard {
 
@@ -79,13 +84,58 @@ class BulkStoreBase {
 
   object_map_t const& List() const { return objects_; }
 
+  /**
+   * @brief The memory usage of this bulk store, i.e., of its session if it
+   * has a quota, otherwise of the whole shared memory pool.
+   */
   size_t Footprint() const;
   size_t FootprintLimit() const;
 
   Status MakeArena(size_t const size, int& fd, uintptr_t& base);
 
+  /**
+   * @brief Initialize the shared memory pool of `size` bytes. The pool is
+   * shared by the bulk stores of all sessions and only the first call takes
+   * effect, the following calls attach to the existing pool.
+   */
   Status PreAllocate(size_t const size);
 
+  /**
+   * @brief Charge the memory usage of this bulk store to `session` in the
+   * shared memory pool, with a guaranteed reservation and a limit (0 means
+   * the whole pool), see also `MemoryPool`. Must be called after
+   * `PreAllocate()`.
+   *
+   * @param reclaimer Used to take back the memory that the session borrows
+   * from the reservations of other sessions, nullptr if the session cannot
+   * spill.
+   */
+  Status SetQuota(SessionID const session, size_t const reserved,
+                  size_t const limit,
+                  MemoryPool::reclaimer_t const& reclaimer = nullptr);
+
+  /**
+   * @brief Reserve a sub-arena of `size` bytes on each NUMA node, for blobs
+   * that are created with a NUMA node hint. Must be called after
+   * `PreAllocate()`.
+   */
+  Status PreAllocateNumaArenas(size_t const size);
+
+  /**
+   * @brief Reserve `shards` sub-arenas for the small blobs, to let concurrent
+   * allocations from IPC worker threads proceed without contending on a
+   * single lock. Must be called after `PreAllocate()`.
+   */
+  Status PreAllocateShards(size_t const shards);
+
+  /**
+   * @brief Back the shared memory with huge pages, either with explicit huge
+   * pages from a mounted hugetlbfs, or with transparent huge pages. Must be
+   * called before `PreAllocate()`.
+   */
+  static void SetHugePages(std::string const& hugetlbfs_path,
+                           bool const transparent_hugepage);
+
   Status FinalizeArena(int const fd, std::vector<size_t> const& offsets,
                        std::vector<size_t> const& sizes);
 
@@ -104,10 +154,33 @@ class BulkStoreBase {
  protected:
   uint8_t* AllocateMemory(size_t size, int* fd, int64_t* map_size,
                           ptrdiff_t* offset);
+
+  uint8_t* AllocateMemory(size_t size, int numa_node, int* fd,
+                          int64_t* map_size, ptrdiff_t* offset);
+
+  /**
+   * @brief Free the memory from `AllocateMemory()` and give it back to the
+   * quota of the session.
+   */
+  void FreeMemory(uint8_t* pointer, size_t size);
+
+  /**
+   * @brief Record a sealed payload to the payload journal (if enabled), to
+   * make it recoverable after vineyardd restarts.
+   */
+  void JournalSeal(ID const& object_id, std::shared_ptr<P> const& object);
+
+  /**
+   * @brief Record that the memory of a payload has been released (deleted or
+   * spilled).
+   */
+  void JournalRelease(ID const& object_id);
+
   struct Arena {
     int fd;
     size_t size;
     uintptr_t base;
+    std::string path;
     static std::set<ID> spans;
   };
 
@@ -115,9 +188,21 @@ class BulkStoreBase {
 
   object_map_t objects_;
 
+  // the payload journal for warm restart, see `BulkStore::Recover()`.
+  std::unique_ptr<Journal> journal_;
+  std::map<ID, json> journaled_;
+  // the reattached blobs, charged to the allocator (and to the session once
+  // `SetQuota()` is called) until they are deleted
+  std::set<ID> recovered_;
+  std::mutex journal_mutex_;
+
   size_t mem_spill_upper_bound_;
 
   size_t mem_spill_lower_bound_;
+
+  // the session that the memory usage is charged to, see `SetQuota()`.
+  SessionID session_ = RootSessionID();
+  bool has_quota_ = false;
 };
 
 class BulkStore
@@ -131,12 +216,41 @@ class BulkStore
   Status Create(const size_t size, ObjectID& object_id,
                 std::shared_ptr<Payload>& object);
 
+  /*
+   * @brief Allocate space for a new blob on the given NUMA node, falls back to
+   * `Create(size, object_id, object)` if `numa_node` is -1 or the sub-arena of
+   * the node is exhausted.
+   */
+  Status Create(const size_t size, const int numa_node, ObjectID& object_id,
+                std::shared_ptr<Payload>& object);
+
   /*
    * @brief Decrease the reference count of a blob, when its reference count
    * reaches zero. It will trigger `OnRelease` behavior. See ColdObjectTracker
    */
   Status Release(ObjectID const& id, int conn);
 
+  /**
+   * @brief Reattach the blobs that are left by a previous vineyardd process
+   * according to the payload journal under `state_path`, and start
+   * journaling the payloads of this process for the next restart.
+   *
+   * The shared memory segments are mapped at exactly the same addresses as
+   * before, thus the blob ids (derived from the addresses) stay unchanged.
+   * Segments that cannot be reattached are discarded with a warning.
+   *
+   * Must be called before `PreAllocate()`.
+   */
+  Status Recover(std::string const& state_path);
+
+  /**
+   * @brief Like `BulkStoreBase::SetQuota()`, the memory borrowed by the
+   * session is taken back by spilling its cold objects, if spilling is
+   * enabled. Must be called after `SetSpillPath()`.
+   */
+  Status SetQuota(SessionID const session, size_t const reserved,
+                  size_t const limit);
+
  protected:
   /**
    * @brief change the reference count of the object on the client-side cache.
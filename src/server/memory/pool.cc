@@ -0,0 +1,211 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "server/memory/pool.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/util/logging.h"
+
+namespace vineyard {
+
+MemoryPool& MemoryPool::Get() {
+  static MemoryPool pool;
+  return pool;
+}
+
+void MemoryPool::SetCapacity(size_t const capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  capacity_ = capacity;
+}
+
+size_t MemoryPool::Capacity() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return capacity_;
+}
+
+Status MemoryPool::Register(SessionID const session, size_t const reserved,
+                            size_t const limit, reclaimer_t const& reclaimer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capacity_ == 0) {
+    return Status::Invalid("The shared memory pool hasn't been initialized");
+  }
+  if (accounts_.find(session) != accounts_.end()) {
+    return Status::Invalid("The session " + SessionIDToString(session) +
+                           " has already been registered");
+  }
+  size_t session_limit = limit == 0 ? capacity_ : std::min(limit, capacity_);
+  if (reserved > session_limit) {
+    return Status::Invalid("The reservation (" + std::to_string(reserved) +
+                           ") exceeds the limit (" +
+                           std::to_string(session_limit) + ") of the session");
+  }
+  if (reserved_ + reserved > capacity_) {
+    return Status::NotEnoughMemory(
+        "Cannot reserve " + std::to_string(reserved) +
+        " bytes for the session, " + std::to_string(reserved_) + " of " +
+        std::to_string(capacity_) + " bytes have been reserved");
+  }
+  accounts_.emplace(session, Account{reserved, session_limit, 0, reclaimer});
+  reserved_ += reserved;
+  idle_ += reserved;
+  return Status::OK();
+}
+
+void MemoryPool::Unregister(SessionID const session) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = accounts_.find(session);
+  if (iter == accounts_.end()) {
+    return;
+  }
+  used_ -= iter->second.used;
+  idle_ -= iter->second.idle();
+  reserved_ -= iter->second.reserved;
+  accounts_.erase(iter);
+}
+
+bool MemoryPool::Acquire(SessionID const session, size_t const bytes) {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    std::vector<std::pair<reclaimer_t, size_t>> borrowers;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto iter = accounts_.find(session);
+      if (iter == accounts_.end()) {
+        // the session is not accounted, e.g., in tests
+        return true;
+      }
+      size_t shortage = 0;
+      if (tryAcquire(iter->second, bytes, shortage)) {
+        return true;
+      }
+      if (shortage == 0 || attempt > 0) {
+        return false;
+      }
+      for (auto const& item : accounts_) {
+        if (item.first == session || !item.second.reclaimer ||
+            item.second.borrowed() == 0) {
+          continue;
+        }
+        size_t amount = std::min(shortage, item.second.borrowed());
+        borrowers.emplace_back(item.second.reclaimer, amount);
+        shortage -= amount;
+        if (shortage == 0) {
+          break;
+        }
+      }
+    }
+    // spill outside the lock, the borrowers release the memory through
+    // `Release()`.
+    for (auto const& borrower : borrowers) {
+      size_t released = borrower.first(borrower.second);
+      DVLOG(10) << "Reclaimed " << released << " bytes for session "
+                << SessionIDToString(session);
+    }
+  }
+  return false;
+}
+
+void MemoryPool::Charge(SessionID const session, size_t const bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = accounts_.find(session);
+  if (iter != accounts_.end()) {
+    updateUsage(iter->second, iter->second.used + bytes);
+  }
+}
+
+void MemoryPool::Release(SessionID const session, size_t const bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = accounts_.find(session);
+  if (iter != accounts_.end()) {
+    updateUsage(iter->second,
+                iter->second.used - std::min(iter->second.used, bytes));
+  }
+}
+
+size_t MemoryPool::Usage(SessionID const session) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = accounts_.find(session);
+  return iter == accounts_.end() ? 0 : iter->second.used;
+}
+
+size_t MemoryPool::Reserved(SessionID const session) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = accounts_.find(session);
+  return iter == accounts_.end() ? 0 : iter->second.reserved;
+}
+
+size_t MemoryPool::Limit(SessionID const session) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = accounts_.find(session);
+  return iter == accounts_.end() ? 0 : iter->second.limit;
+}
+
+json MemoryPool::ToJSON() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  json pool;
+  pool["capacity"] = capacity_;
+  pool["reserved"] = reserved_;
+  pool["used"] = used_;
+  json sessions = json::object();
+  for (auto const& item : accounts_) {
+    json account;
+    account["reserved"] = item.second.reserved;
+    account["limit"] = item.second.limit;
+    account["used"] = item.second.used;
+    sessions[SessionIDToString(item.first)] = account;
+  }
+  pool["sessions"] = sessions;
+  return pool;
+}
+
+bool MemoryPool::tryAcquire(Account& account, size_t const bytes,
+                            size_t& shortage) {
+  shortage = 0;
+  if (account.used + bytes > account.limit) {
+    return false;
+  }
+  size_t free = capacity_ > used_ ? capacity_ - used_ : 0;
+  size_t own_idle = account.idle();
+  size_t others_idle = idle_ - own_idle;
+  // the capacity that is neither used nor reserved, becomes "negative" when
+  // the idle reservations have been lent.
+  size_t unreserved = free > idle_ ? free - idle_ : 0;
+  size_t entitled = own_idle + unreserved;
+  if (account.reclaimer) {
+    // the memory can be taken back from the session later
+    entitled += others_idle;
+  }
+  if (bytes > entitled) {
+    return false;
+  }
+  if (bytes > free) {
+    shortage = bytes - free;
+    return false;
+  }
+  updateUsage(account, account.used + bytes);
+  return true;
+}
+
+void MemoryPool::updateUsage(Account& account, size_t const used) {
+  idle_ -= account.idle();
+  used_ = used_ - account.used + used;
+  account.used = used;
+  idle_ += account.idle();
+}
+
+}  // namespace vineyard
@@ -0,0 +1,132 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_SERVER_MEMORY_POOL_H_
+#define SRC_SERVER_MEMORY_POOL_H_
+
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "common/util/json.h"
+#include "common/util/status.h"
+#include "common/util/uuid.h"
+
+namespace vineyard {
+
+/**
+ * @brief MemoryPool shares the shared memory of the (process-wide) bulk
+ * allocator among the sessions of vineyardd.
+ *
+ * Each session has a reservation, which is guaranteed to be available to it,
+ * and a limit, which caps its usage. Beyond its reservation, a session
+ * borrows the idle capacity of the pool:
+ *
+ * - the capacity that isn't reserved by any session, and
+ * - if the session is able to spill, the idle reservations of the other
+ *   sessions. The owner of a reservation takes the lent memory back by
+ *   asking the borrowers to spill when it needs the memory.
+ *
+ * When a session reaches its limit, or there is nothing left to borrow, its
+ * allocation fails and only the session itself is expected to spill.
+ */
+class MemoryPool {
+ public:
+  /**
+   * @brief Spill (at least) the given number of bytes, returns the number of
+   * bytes that have been released.
+   */
+  using reclaimer_t = std::function<size_t(size_t)>;
+
+  static MemoryPool& Get();
+
+  /**
+   * @brief Set the capacity of the pool, i.e., the footprint limit of the
+   * bulk allocator.
+   */
+  void SetCapacity(size_t const capacity);
+
+  size_t Capacity() const;
+
+  /**
+   * @brief Register a session with its reservation and limit, fails if the
+   * reservations of all sessions would exceed the capacity of the pool.
+   *
+   * @param reclaimer Used to take the borrowed memory back from the session,
+   * nullptr if the session cannot spill. It is called from the threads of
+   * other sessions, and must not block on the locks of its session, see
+   * `BulkStore::Reclaim()`.
+   */
+  Status Register(SessionID const session, size_t const reserved,
+                  size_t const limit, reclaimer_t const& reclaimer);
+
+  void Unregister(SessionID const session);
+
+  /**
+   * @brief Charge `bytes` to the session, the memory lent to other sessions
+   * will be reclaimed if required to honor the reservation of the session.
+   *
+   * @return false if the session is not entitled to `bytes` more bytes.
+   */
+  bool Acquire(SessionID const session, size_t const bytes);
+
+  /**
+   * @brief Like `Acquire()`, but never fails, used when the ownership of
+   * blobs is moved between sessions.
+   */
+  void Charge(SessionID const session, size_t const bytes);
+
+  void Release(SessionID const session, size_t const bytes);
+
+  size_t Usage(SessionID const session) const;
+
+  size_t Reserved(SessionID const session) const;
+
+  size_t Limit(SessionID const session) const;
+
+  json ToJSON() const;
+
+ private:
+  struct Account {
+    size_t reserved;
+    size_t limit;
+    size_t used;
+    reclaimer_t reclaimer;
+
+    size_t idle() const { return used < reserved ? reserved - used : 0; }
+
+    size_t borrowed() const { return used > reserved ? used - reserved : 0; }
+  };
+
+  /**
+   * @brief Try to charge `bytes` to the account, returns the number of bytes
+   * that need to be reclaimed from other sessions first if the account is
+   * entitled to the memory but the memory is lent.
+   */
+  bool tryAcquire(Account& account, size_t const bytes, size_t& shortage);
+
+  void updateUsage(Account& account, size_t const used);
+
+  mutable std::mutex mutex_;
+  size_t capacity_ = 0;
+  size_t reserved_ = 0;  // sum of the reservations
+  size_t used_ = 0;      // sum of the usages
+  size_t idle_ = 0;      // sum of the idle part of the reservations
+  std::map<SessionID, Account> accounts_;
+};
+
+}  // namespace vineyard
+
+#endif  // SRC_SERVER_MEMORY_POOL_H_
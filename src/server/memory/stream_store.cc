@@ -319,6 +319,15 @@ Status StreamStore::Drop(ObjectID const stream_id) {
   return Status::OK();
 }
 
+void StreamStore::QueueDepth(size_t& streams, size_t& ready_chunks) {
+  std::lock_guard<std::recursive_mutex> __guard(this->mutex_);
+  streams = streams_.size();
+  ready_chunks = 0;
+  for (auto const& item : streams_) {
+    ready_chunks += item.second->ready_chunks_.size();
+  }
+}
+
 bool StreamStore::allocatable(std::shared_ptr<StreamHolder> stream,
                               size_t size) {
   if (store_->Footprint() + size <
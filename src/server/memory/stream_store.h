@@ -96,6 +96,12 @@ class StreamStore {
    */
   Status Drop(ObjectID const stream_id);
 
+  /**
+   * @brief The number of streams and the total number of ready chunks that
+   * haven't been pulled by the consumers.
+   */
+  void QueueDepth(size_t& streams, size_t& ready_chunks);
+
  private:
   bool allocatable(std::shared_ptr<StreamHolder> stream, size_t size);
 
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef SRC_SERVER_MEMORY_USAGE_H_
 #define SRC_SERVER_MEMORY_USAGE_H_
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <list>
 #include <map>
 #include <memory>
@@ -29,10 +31,6 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
-#ifdef __APPLE__
-#include "boost/thread/shared_mutex.hpp"
-#endif
-
 #include "oneapi/tbb/concurrent_hash_map.h"
 
 #include "common/memory/payload.h"
@@ -41,7 +39,9 @@ limitations under the License.
 #include "common/util/logging.h"
 #include "common/util/status.h"
 #include "server/memory/allocator.h"
+#include "server/util/compressed_blob.h"
 #include "server/util/file_io_adaptor.h"
+#include "server/util/metrics.h"
 #include "server/util/spill_file.h"
 
 namespace vineyard {
@@ -195,6 +195,9 @@ class ColdObjectTracker
    * - `PopLeastUsed()` Get the least used blob id. If no object in structure,
    * then statu will be Invalids.
    * - `CheckExist(ID id)` Check the existence of id.
+   *
+   * The blobs are kept in one list per spill priority class, and the pinned
+   * ones in a separate list that is never spilled, see `SpillPriority`.
    */
   class LRU {
    public:
@@ -207,20 +210,32 @@ class ColdObjectTracker
     ~LRU() = default;
 
     void Ref(ID id, std::shared_ptr<P> payload) {
-      std::unique_lock<decltype(mu_)> locked;
+      std::lock_guard<decltype(mu_)> locked(mu_);
       auto it = map_.find(id);
       if (it == map_.end()) {
-        list_.emplace_front(id, payload);
-        map_.emplace(id, list_.begin());
+        ListOf(payload).emplace_front(id, payload);
+        map_.emplace(id, ListOf(payload).begin());
       } else {
-        list_.erase(it->second);
-        list_.emplace_front(id, payload);
-        it->second = list_.begin();
+        ListOf(it->second->second).erase(it->second);
+        ListOf(payload).emplace_front(id, payload);
+        it->second = ListOf(payload).begin();
       }
     }
 
+    /**
+     * @brief Locks the lists as a whole, e.g., to spill on behalf of another
+     * session, see `Reclaim()`.
+     */
+    std::unique_lock<std::recursive_mutex> Lock() const {
+      return std::unique_lock<std::recursive_mutex>(mu_);
+    }
+
+    std::unique_lock<std::recursive_mutex> TryLock() const {
+      return std::unique_lock<std::recursive_mutex>(mu_, std::try_to_lock);
+    }
+
     bool CheckExist(ID id) const {
-      std::shared_lock<decltype(mu_)> shared_locked;
+      std::lock_guard<decltype(mu_)> locked(mu_);
       auto it = map_.find(id);
       if (it == map_.end()) {
         return false;
@@ -239,48 +254,113 @@ class ColdObjectTracker
      */
     Status Unref(const ID& id, bool fast_delete,
                  std::shared_ptr<Der> store_ptr) {
-      std::unique_lock<decltype(mu_)> locked;
+      std::lock_guard<decltype(mu_)> locked(mu_);
       auto it = map_.find(id);
       if (it == map_.end()) {
         auto it = spilled_obj_.find(id);
         if (it == spilled_obj_.end()) {
           return Status::OK();
         }
-        if (!fast_delete) {
-          RETURN_ON_ERROR(store_ptr->ReloadPayload(id, it->second));
-        } else {
-          RETURN_ON_ERROR(store_ptr->DeletePayloadFile(id));
-        }
+        auto payload = it->second;
+        // erased before reloading, as the reloading may spill other blobs
         spilled_obj_.erase(it);
-        return Status::OK();
+        auto status = fast_delete ? store_ptr->DeletePayloadFile(id)
+                                  : store_ptr->ReloadPayload(id, payload);
+        if (!status.ok()) {
+          spilled_obj_.emplace(id, payload);
+        }
+        return status;
       }
-      list_.erase(it->second);
+      ListOf(it->second->second).erase(it->second);
       map_.erase(it);
       return Status::OK();
     }
 
+    /**
+     * @brief Changes the spill priority class of the blob, and adds `pins`
+     * (negative to unpin) to its pin count, which never drops below zero. A
+     * cold blob is moved to the list of its new class, and a spilled blob
+     * that gets pinned is reloaded, as pinned blobs must be resident.
+     */
+    Status Update(const ID& id, std::shared_ptr<P> payload,
+                  SpillPriority priority, int64_t pins,
+                  std::shared_ptr<Der> store_ptr) {
+      std::lock_guard<decltype(mu_)> locked(mu_);
+      int64_t pin_count = std::max<int64_t>(payload->pin_count + pins, 0);
+      auto it = map_.find(id);
+      if (it != map_.end()) {
+        ListOf(it->second->second).erase(it->second);
+        payload->spill_priority = priority;
+        payload->pin_count = pin_count;
+        ListOf(payload).emplace_front(id, payload);
+        it->second = ListOf(payload).begin();
+        return Status::OK();
+      }
+      auto spilled = spilled_obj_.find(id);
+      if (pin_count > 0 && spilled != spilled_obj_.end()) {
+        // erased before reloading, as the reloading may spill other blobs
+        spilled_obj_.erase(spilled);
+        auto status = store_ptr->ReloadPayload(id, payload);
+        if (!status.ok()) {
+          spilled_obj_.emplace(id, payload);
+          return status;
+        }
+        payload->spill_priority = priority;
+        payload->pin_count = pin_count;
+        ListOf(payload).emplace_front(id, payload);
+        map_.emplace(id, ListOf(payload).begin());
+        return Status::OK();
+      }
+      // in-use (or spilled and stays spilled), takes effect when it becomes
+      // cold (or is reloaded) again
+      payload->spill_priority = priority;
+      payload->pin_count = pin_count;
+      return Status::OK();
+    }
+
+    /**
+     * @brief Whether the blob is pinned, read under the lock of `Update()`.
+     */
+    bool IsPinned(const std::shared_ptr<P>& payload) const {
+      std::lock_guard<decltype(mu_)> locked(mu_);
+      return payload->pin_count > 0;
+    }
+
     Status Spill(size_t sz, std::shared_ptr<Der> bulk_store_ptr) {
-      std::unique_lock<decltype(mu_)> locked;
+      std::lock_guard<decltype(mu_)> locked(mu_);
       size_t spilled_sz = 0;
+      bool exhausted = false;
       auto st = Status::OK();
-      auto it = list_.rbegin();
-      while (it != list_.rend()) {
-        st = bulk_store_ptr->SpillPayload(it->second);
-        if (!st.ok()) {
-          LOG(ERROR) << st.ToString();
-          break;
+      // from the lowest priority class and the least recently used, the
+      // blobs that can be neither compressed nor spilled to disk are skipped,
+      // and the pinned blobs are never visited
+      for (int priority = 0; priority < kSpillPriorities && st.ok() &&
+                             !exhausted && spilled_sz < sz;
+           ++priority) {
+        auto& list = lists_[priority];
+        auto it = list.end();
+        while (it != list.begin() && spilled_sz < sz) {
+          --it;
+          bool skipped = false;
+          st = bulk_store_ptr->SpillPayload(it->second, skipped);
+          if (!st.ok()) {
+            LOG(ERROR) << st.ToString();
+            break;
+          }
+          if (skipped) {
+            // stops the scan once the compressed tier is full, if nothing can
+            // be spilled to disk
+            exhausted = bulk_store_ptr->SpillExhausted();
+            if (exhausted) {
+              break;
+            }
+            continue;
+          }
+          spilled_sz += it->second->data_size;
+          spilled_obj_.emplace(it->first, it->second);
+          map_.erase(it->first);
+          it = list.erase(it);
         }
-        spilled_sz += it->second->data_size;
-        spilled_obj_.emplace(it->first, it->second);
-        map_.erase(it->first);
-        it++;
-        if (sz <= spilled_sz) {
-          break;
-        }
-      }
-      auto poped_size = std::distance(list_.rbegin(), it);
-      while (poped_size-- > 0) {
-        list_.pop_back();
       }
       if (st.ok() && spilled_sz == 0) {
         return Status::NotEnoughMemory("Nothing spilled");
@@ -289,19 +369,55 @@ class ColdObjectTracker
     }
 
     bool CheckSpilled(const ID& id) {
-      std::shared_lock<decltype(mu_)> lock;
+      std::lock_guard<decltype(mu_)> locked(mu_);
       return spilled_obj_.find(id) != spilled_obj_.end();
     }
 
+    /**
+     * @brief The number and the sizes of the cold blobs of each spill
+     * priority class, resident and spilled, and of the pinned cold blobs.
+     */
+    void Usage(json& usage) const {
+      std::lock_guard<decltype(mu_)> locked(mu_);
+      // resident and spilled objects and bytes, per class and then pinned
+      int64_t stats[kSpillPriorities + 1][4] = {};
+      for (int priority = 0; priority <= kSpillPriorities; ++priority) {
+        stats[priority][0] = lists_[priority].size();
+        for (auto const& item : lists_[priority]) {
+          stats[priority][1] += item.second->data_size;
+        }
+      }
+      for (auto const& item : spilled_obj_) {
+        int priority = static_cast<int>(item.second->spill_priority);
+        stats[priority][2] += 1;
+        stats[priority][3] += item.second->data_size;
+      }
+      usage = json::object();
+      for (int priority = 0; priority <= kSpillPriorities; ++priority) {
+        std::string key = priority == kSpillPriorities
+                              ? "pinned"
+                              : SpillPriorityToString(
+                                    static_cast<SpillPriority>(priority));
+        usage[key]["objects"] = stats[priority][0];
+        usage[key]["bytes"] = stats[priority][1];
+        usage[key]["spilled_objects"] = stats[priority][2];
+        usage[key]["spilled_bytes"] = stats[priority][3];
+      }
+    }
+
    private:
-#if __APPLE__
-    mutable boost::shared_mutex mu_;
-#else
-    mutable std::shared_timed_mutex mu_;
-#endif
+    // the pinned blobs are in the last list
+    lru_list_t& ListOf(const std::shared_ptr<P>& payload) {
+      return lists_[payload->pin_count > 0
+                        ? kSpillPriorities
+                        : static_cast<int>(payload->spill_priority)];
+    }
+
+    // recursive: reloading a blob may allocate, and spill other blobs
+    mutable std::recursive_mutex mu_;
     // protected by mu_
     lru_map_t map_;
-    lru_list_t list_;
+    lru_list_t lists_[kSpillPriorities + 1];
     std::unordered_map<ID, std::shared_ptr<P>> spilled_obj_;
   };
 
@@ -310,6 +426,10 @@ class ColdObjectTracker
   using base_t = DependencyTracker<ID, P, ColdObjectTracker<ID, P, Der>>;
   using lru_t = LRU;
 
+  // blobs that don't compress to at least half of their size are spilled to
+  // disk instead
+  static constexpr double kCompressedTierMinRatio = 2.0;
+
   ColdObjectTracker() {}
   ~ColdObjectTracker() {
     if (!spill_path_.empty()) {
@@ -374,7 +494,8 @@ class ColdObjectTracker
   }
 
   /**
-   * @brief check if a blob is spilled out. Return true if it is spilled.
+   * @brief check if a blob is spilled out, i.e., spilled to disk or kept
+   * compressed in the compressed tier. Return true if it is spilled.
    */
   Status IsSpilled(ID const& id, bool& is_spilled) {
     if (cold_obj_lru_.CheckSpilled(id)) {
@@ -385,6 +506,61 @@ class ColdObjectTracker
     return Status::OK();
   }
 
+  /**
+   * @brief check if a blob is spilled out, and get its spill priority class
+   * and whether it is pinned (the defaults if the blob doesn't exist).
+   */
+  Status IsSpilled(ID const& id, bool& is_spilled, SpillPriority& priority,
+                   bool& is_pinned) {
+    RETURN_ON_ERROR(IsSpilled(id, is_spilled));
+    std::shared_ptr<P> payload;
+    if (Self().Get(id, payload).ok()) {
+      priority = payload->spill_priority;
+      is_pinned = cold_obj_lru_.IsPinned(payload);
+    } else {
+      priority = SpillPriority::kNormal;
+      is_pinned = false;
+    }
+    return Status::OK();
+  }
+
+  /**
+   * @brief Set the spill priority class of a blob, see `SpillPriority`.
+   */
+  Status SetSpillPriority(ID const& id, SpillPriority priority) {
+    std::shared_ptr<P> payload;
+    RETURN_ON_ERROR(Self().Get(id, payload));
+    if (id == EmptyBlobID<ID>()) {
+      return Status::OK();
+    }
+    return cold_obj_lru_.Update(id, payload, priority, 0,
+                                Self().shared_from_this());
+  }
+
+  /**
+   * @brief Pin (or unpin) a blob, the pinned blobs are never spilled. A
+   * spilled blob is reloaded into the shared memory when it is pinned.
+   *
+   * The pins are counted, the blob stays pinned until it has been unpinned
+   * as many times as it has been pinned, e.g., by each of the clients that
+   * pin it.
+   */
+  Status Pin(ID const& id, bool pinned) {
+    std::shared_ptr<P> payload;
+    RETURN_ON_ERROR(Self().Get(id, payload));
+    if (id == EmptyBlobID<ID>()) {
+      return Status::OK();
+    }
+    return cold_obj_lru_.Update(id, payload, payload->spill_priority,
+                                pinned ? 1 : -1, Self().shared_from_this());
+  }
+
+  /**
+   * @brief The usage of the cold blobs per spill priority class, see
+   * `LRU::Usage()`.
+   */
+  void ColdObjectUsage(json& usage) const { cold_obj_lru_.Usage(usage); }
+
   /**
    * @brief Only triggered when detected OOM, this function will spill cold-obj
    * to disk till memory usage back to allowed watermark.
@@ -405,31 +581,52 @@ class ColdObjectTracker
    * whatever we got
    *  - If spill is allowed, then we shall conduct spilling and trying to give a
    * non-nullptr pointer
+   *
+   * @param numa_node If not nullptr and not -1, the memory is allocated on
+   * the given NUMA node, e.g., when a blob is reloaded to its former node, or
+   * set to -1 if the sub-arena of the node cannot hold it.
    */
   uint8_t* AllocateMemoryWithSpill(size_t size, int* fd, int64_t* map_size,
-                                   ptrdiff_t* offset) {
-    uint8_t* pointer = nullptr;
-    pointer = Self().AllocateMemory(size, fd, map_size, offset);
+                                   ptrdiff_t* offset,
+                                   int* numa_node = nullptr) {
+    int node = numa_node != nullptr ? *numa_node : -1;
+    auto allocate = [&]() -> uint8_t* {
+      if (node >= 0) {
+        uint8_t* pointer =
+            Self().AllocateMemory(size, node, fd, map_size, offset);
+        if (pointer != nullptr) {
+          return pointer;
+        }
+      }
+      uint8_t* pointer = Self().AllocateMemory(size, fd, map_size, offset);
+      if (pointer != nullptr && node >= 0) {
+        // the sub-arena is exhausted, or NUMA is unavailable
+        *numa_node = -1;
+      }
+      return pointer;
+    };
+    uint8_t* pointer = allocate();
     // no spill will be conducted
-    if (spill_path_.empty()) {
+    if (!SpillEnabled()) {
       return pointer;
     }
+    // the watermarks are of the session, other sessions are not affected
     if (pointer == nullptr ||
-        BulkAllocator::Allocated() >=
-            static_cast<int64_t>(Self().mem_spill_upper_bound_)) {
+        Self().Footprint() >= Self().mem_spill_upper_bound_) {
+      // the cold list is locked before `spill_mu_`, as blobs are reloaded
+      // (and thus allocated) with the cold list locked
+      auto lru_locked = cold_obj_lru_.Lock();
       std::unique_lock<std::mutex> locked(spill_mu_);
       // if already got someone spilled, then we should allocate normally
       if (pointer == nullptr)
-        pointer = Self().AllocateMemory(size, fd, map_size, offset);
+        pointer = allocate();
 
       if (pointer == nullptr ||
-          BulkAllocator::Allocated() >=
-              static_cast<int64_t>(Self().mem_spill_upper_bound_)) {
-        int64_t spill_size =
-            BulkAllocator::Allocated() - Self().mem_spill_lower_bound_;
+          Self().Footprint() >= Self().mem_spill_upper_bound_) {
+        int64_t spill_size = static_cast<int64_t>(Self().Footprint()) -
+                             Self().mem_spill_lower_bound_;
         if (SpillColdObject(spill_size).ok()) {
-          pointer = pointer ? pointer
-                            : Self().AllocateMemory(size, fd, map_size, offset);
+          pointer = pointer ? pointer : allocate();
         }
       }
     }
@@ -445,27 +642,99 @@ class ColdObjectTracker
 
   Status OnDelete(ID const& id) { return Self().OnDelete(id); }
 
+  /**
+   * @brief The number of blobs in the compressed tier, and their sizes before
+   * and after compression.
+   */
+  void CompressedTierUsage(size_t& objects, size_t& bytes,
+                           size_t& compressed_bytes) {
+    std::lock_guard<std::mutex> locked(compressed_mu_);
+    objects = compressed_.size();
+    bytes = compressed_tier_bytes_;
+    compressed_bytes = compressed_tier_compressed_bytes_;
+  }
+
+  /**
+   * @brief The usage of the compressed tier, as well as the number of blobs
+   * that have been compressed into and decompressed out of it.
+   */
+  void CompressedTierUsage(json& usage) {
+    std::lock_guard<std::mutex> locked(compressed_mu_);
+    usage["objects"] = compressed_.size();
+    usage["bytes"] = compressed_tier_bytes_;
+    usage["compressed_bytes"] = compressed_tier_compressed_bytes_;
+    usage["compressed_objects"] = compressed_objects_;
+    usage["decompressed_objects"] = decompressed_objects_;
+  }
+
  protected:
-  Status SpillPayload(std::shared_ptr<P>& payload) {
+  /**
+   * @brief Takes the cold blob out of the shared memory, into the compressed
+   * tier if it is enabled and the blob compresses well, or to disk if the
+   * spill path is set. Otherwise the blob is `skipped` and stays.
+   */
+  Status SpillPayload(std::shared_ptr<P>& payload, bool& skipped) {
     assert(payload->is_sealed);
-    util::SpillWriteFile write_file(spill_path_);
-    RETURN_ON_ERROR(write_file.Write(payload));
-    RETURN_ON_ERROR(write_file.Sync());
-    BulkAllocator::Free(payload->pointer, payload->data_size);
+    skipped = false;
+    bool compressed = false;
+    RETURN_ON_ERROR(CompressPayload(payload, compressed));
+    if (!compressed) {
+      if (spill_path_.empty()) {
+        skipped = true;
+        return Status::OK();
+      }
+      util::SpillWriteFile write_file(spill_path_);
+      RETURN_ON_ERROR(write_file.Write(payload));
+      RETURN_ON_ERROR(write_file.Sync());
+      METRIC_COUNTER_INC("spilled_objects_total", "", 1);
+      METRIC_COUNTER_INC("spilled_bytes_total", "", payload->data_size);
+    }
+    Self().JournalRelease(payload->object_id);
+    Self().FreeMemory(payload->pointer, payload->data_size);
     payload->store_fd = -1;
     payload->pointer = nullptr;
     payload->is_spilled = true;
     return Status::OK();
   }
 
+  /**
+   * @brief Whether no more blobs can be taken out of the shared memory, i.e.,
+   * the compressed tier is full and the spill path is not set.
+   */
+  bool SpillExhausted() {
+    if (!spill_path_.empty()) {
+      return false;
+    }
+    std::lock_guard<std::mutex> locked(compressed_mu_);
+    return compressed_tier_compressed_bytes_ >= compressed_tier_limit_;
+  }
+
   Status ReloadPayload(const ID& id, std::shared_ptr<P>& payload) {
     assert(payload->is_spilled == true);
-    util::SpillReadFile read_file(spill_path_);
-    RETURN_ON_ERROR(read_file.Read(payload, Self().shared_from_this()));
+    bool decompressed = false;
+    RETURN_ON_ERROR(DecompressPayload(id, payload, decompressed));
+    if (!decompressed) {
+      util::SpillReadFile read_file(spill_path_);
+      RETURN_ON_ERROR(read_file.Read(payload, Self().shared_from_this()));
+    }
+    payload->is_spilled = false;
+    Self().JournalSeal(id, payload);
+    METRIC_COUNTER_INC("reloaded_objects_total", "", 1);
+    METRIC_COUNTER_INC("reloaded_bytes_total", "", payload->data_size);
     return Status::OK();
   }
 
   Status DeletePayloadFile(const ID& id) {
+    {
+      std::lock_guard<std::mutex> locked(compressed_mu_);
+      auto iter = compressed_.find(id);
+      if (iter != compressed_.end()) {
+        compressed_tier_bytes_ -= iter->second->size();
+        compressed_tier_compressed_bytes_ -= iter->second->compressed_size();
+        compressed_.erase(iter);
+        return Status::OK();
+      }
+    }
     util::FileIOAdaptor io_adaptor(spill_path_);
     RETURN_ON_ERROR(io_adaptor.RemoveFile(spill_path_ + std::to_string(id)));
     return Status::OK();
@@ -491,11 +760,160 @@ class ColdObjectTracker
     }
   }
 
+  /**
+   * @brief Keeps up to `size` bytes of compressed cold blobs in the private
+   * memory of vineyardd, between the shared memory and the disk spilling.
+   * Cold blobs are compressed into the tier first, and only the blobs that
+   * don't compress well, or don't fit, are spilled to disk. The blobs are
+   * decompressed back into the shared memory when they are accessed again.
+   */
+  void SetCompressedTierSize(size_t size) { compressed_tier_limit_ = size; }
+
+  bool SpillEnabled() const {
+    return !spill_path_.empty() || compressed_tier_limit_ > 0;
+  }
+
+  /**
+   * @brief Spill cold objects to give (at least) `sz` bytes back to the
+   * shared memory pool, skipped if the store is spilling already.
+   *
+   * It is called from the threads of other sessions, see
+   * `MemoryPool::Acquire()`. It takes the same locks as the allocations of
+   * this store, the cold list and then `spill_mu_`, but never waits for them:
+   * that session may be reclaiming from the caller's session at the same
+   * time.
+   *
+   * @return The number of bytes released.
+   */
+  size_t Reclaim(size_t sz) {
+    auto lru_locked = cold_obj_lru_.TryLock();
+    if (!lru_locked.owns_lock()) {
+      return 0;
+    }
+    std::unique_lock<std::mutex> locked(spill_mu_, std::try_to_lock);
+    if (!locked.owns_lock() || !SpillEnabled()) {
+      return 0;
+    }
+    size_t footprint = Self().Footprint();
+    VINEYARD_DISCARD(SpillColdObject(sz));
+    return footprint - std::min(footprint, Self().Footprint());
+  }
+
  private:
+  Status CompressPayload(std::shared_ptr<P>& payload, bool& compressed) {
+    compressed = false;
+    if (compressed_tier_limit_ == 0) {
+      return Status::OK();
+    }
+    // the blobs that won't fit in the space left are rejected by the sample,
+    // rather than compressed as a whole and then dropped
+    size_t available = 0;
+    {
+      std::lock_guard<std::mutex> locked(compressed_mu_);
+      if (compressed_tier_compressed_bytes_ >= compressed_tier_limit_) {
+        return Status::OK();
+      }
+      available = compressed_tier_limit_ - compressed_tier_compressed_bytes_;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<CompressedBlob> blob;
+    RETURN_ON_ERROR(CompressedBlob::Compress(
+        payload->pointer, payload->data_size, kCompressedTierMinRatio,
+        static_cast<int64_t>(available), blob));
+    METRIC_HISTOGRAM_OBSERVE(
+        "compression_microseconds", "",
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+    if (blob == nullptr) {
+      return Status::OK();
+    }
+    size_t compressed_size = blob->compressed_size();
+    {
+      std::lock_guard<std::mutex> locked(compressed_mu_);
+      if (compressed_tier_compressed_bytes_ + compressed_size >
+          compressed_tier_limit_) {
+        return Status::OK();
+      }
+      compressed_tier_bytes_ += payload->data_size;
+      compressed_tier_compressed_bytes_ += compressed_size;
+      compressed_[payload->object_id] = std::move(blob);
+      compressed_objects_ += 1;
+    }
+    compressed = true;
+    METRIC_COUNTER_INC("compressed_objects_total", "", 1);
+    METRIC_COUNTER_INC("compressed_input_bytes_total", "", payload->data_size);
+    METRIC_COUNTER_INC("compressed_output_bytes_total", "", compressed_size);
+    return Status::OK();
+  }
+
+  Status DecompressPayload(const ID& id, std::shared_ptr<P>& payload,
+                           bool& decompressed) {
+    decompressed = false;
+    std::unique_ptr<CompressedBlob> blob;
+    {
+      std::lock_guard<std::mutex> locked(compressed_mu_);
+      auto iter = compressed_.find(id);
+      if (iter == compressed_.end()) {
+        return Status::OK();
+      }
+      blob = std::move(iter->second);
+      compressed_.erase(iter);
+      compressed_tier_bytes_ -= blob->size();
+      compressed_tier_compressed_bytes_ -= blob->compressed_size();
+    }
+    auto restore = [this, &id, &blob]() {
+      std::lock_guard<std::mutex> locked(compressed_mu_);
+      compressed_tier_bytes_ += blob->size();
+      compressed_tier_compressed_bytes_ += blob->compressed_size();
+      compressed_[id] = std::move(blob);
+    };
+    payload->pointer = AllocateMemoryWithSpill(
+        payload->data_size, &payload->store_fd, &payload->map_size,
+        &payload->data_offset, &payload->numa_node);
+    if (payload->pointer == nullptr) {
+      restore();
+      return Status::NotEnoughMemory("Failed to allocate memory of size " +
+                                     std::to_string(payload->data_size) +
+                                     " while decompressing the blob");
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto status = blob->Decompress(payload->pointer);
+    if (!status.ok()) {
+      Self().FreeMemory(payload->pointer, payload->data_size);
+      payload->store_fd = -1;
+      payload->pointer = nullptr;
+      restore();
+      return status;
+    }
+    METRIC_HISTOGRAM_OBSERVE(
+        "decompression_microseconds", "",
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+    METRIC_COUNTER_INC("decompressed_objects_total", "", 1);
+    {
+      std::lock_guard<std::mutex> locked(compressed_mu_);
+      decompressed_objects_ += 1;
+    }
+    decompressed = true;
+    return Status::OK();
+  }
+
   inline Der& Self() { return static_cast<Der&>(*this); }
   lru_t cold_obj_lru_;
   std::string spill_path_;
   std::mutex spill_mu_;
+
+  // the compressed tier, see `SetCompressedTierSize()`
+  size_t compressed_tier_limit_ = 0;
+  std::mutex compressed_mu_;
+  // protected by compressed_mu_
+  std::unordered_map<ID, std::unique_ptr<CompressedBlob>> compressed_;
+  size_t compressed_tier_bytes_ = 0;
+  size_t compressed_tier_compressed_bytes_ = 0;
+  size_t compressed_objects_ = 0;
+  size_t decompressed_objects_ = 0;
 };
 
 }  // namespace detail
@@ -89,8 +89,20 @@ Status VineyardRunner::GetRootSession(vs_ptr_t& vs_ptr) {
 
 Status VineyardRunner::CreateNewSession(
     StoreType const& bulk_store_type, callback_t<std::string const&> callback) {
+  return CreateNewSession(bulk_store_type, 0, 0, callback);
+}
+
+Status VineyardRunner::CreateNewSession(
+    StoreType const& bulk_store_type, size_t const reserved_size,
+    size_t const size, callback_t<std::string const&> callback) {
   SessionID session_id = GenerateSessionID();
   json spec(spec_template_);
+  if (reserved_size > 0) {
+    spec["bulkstore_spec"]["session_reserved_size"] = reserved_size;
+  }
+  if (size > 0) {
+    spec["bulkstore_spec"]["session_size"] = size;
+  }
 
   std::string default_ipc_socket =
       spec["ipc_spec"]["socket"].get<std::string>();
@@ -103,7 +115,12 @@ Status VineyardRunner::CreateNewSession(
   sessions_.emplace(session_id, vs_ptr);
   LOG(INFO) << "Vineyard creates a new session with SessionID = "
             << SessionIDToString(session_id) << std::endl;
-  return vs_ptr->Serve(bulk_store_type);
+  auto status = vs_ptr->Serve(bulk_store_type);
+  if (!status.ok()) {
+    // e.g., the memory quota of the session cannot be reserved
+    VINEYARD_DISCARD(Delete(session_id));
+  }
+  return status;
 }
 
 Status VineyardRunner::Delete(SessionID const& sid) {
@@ -52,6 +52,14 @@ class VineyardRunner : public std::enable_shared_from_this<VineyardRunner> {
   Status GetRootSession(vs_ptr_t& vs_ptr);
   Status CreateNewSession(StoreType const& bulk_store_type,
                           callback_t<std::string const&> callback);
+
+  /**
+   * @brief Create a new session with the given memory quota, 0 means the
+   * default of vineyardd (`--session_reserved_size` and `--session_size`).
+   */
+  Status CreateNewSession(StoreType const& bulk_store_type,
+                          size_t const reserved_size, size_t const size,
+                          callback_t<std::string const&> callback);
   Status Delete(SessionID const& sid);
   Status Get(SessionID const& sid, vs_ptr_t& session);
   bool Exists(SessionID const& sid);
@@ -27,7 +27,9 @@ limitations under the License.
 #include "common/util/json.h"
 #include "common/util/logging.h"
 #include "server/async/ipc_server.h"
+#include "server/async/metrics_server.h"
 #include "server/async/rpc_server.h"
+#include "server/memory/allocator.h"
 #include "server/services/meta_service.h"
 #include "server/util/kubectl.h"
 #include "server/util/meta_tree.h"
@@ -103,14 +105,26 @@ Status VineyardServer::Serve(StoreType const& bulk_store_type) {
     rpc_server_ptr_ =
         std::unique_ptr<RPCServer>(new RPCServer(shared_from_this()));
   }
+  if (session_id_ == RootSessionID() && spec_.value("metrics_port", 0) > 0) {
+    metrics_server_ptr_ = std::unique_ptr<MetricsServer>(
+        new MetricsServer(context_, spec_["metrics_port"].get<uint32_t>()));
+  }
 
-  this->meta_service_ptr_ = IMetaService::Get(shared_from_this());
-  RETURN_ON_ERROR(this->meta_service_ptr_->Start());
+  // the root session may use the whole shared memory pool, the other
+  // sessions are bounded by their quotas.
+  size_t reserved_size = 0, limit_size = 0;
+  if (session_id_ != RootSessionID()) {
+    reserved_size =
+        spec_["bulkstore_spec"].value("session_reserved_size", size_t{0});
+    limit_size = spec_["bulkstore_spec"].value("session_size", size_t{0});
+  }
 
   if (bulk_store_type_ == StoreType::kPlasma) {
     plasma_bulk_store_ = std::make_shared<PlasmaBulkStore>();
     RETURN_ON_ERROR(plasma_bulk_store_->PreAllocate(
         spec_["bulkstore_spec"]["memory_size"].get<size_t>()));
+    RETURN_ON_ERROR(
+        plasma_bulk_store_->SetQuota(session_id_, reserved_size, limit_size));
 
     // TODO(mengke.mk): Currently we do not allow streamming in plasma
     // bulkstore, anyway, we can templatize stream store to solve this.
@@ -122,16 +136,52 @@ Status VineyardServer::Serve(StoreType const& bulk_store_type) {
         spec_["bulkstore_spec"]["spill_lower_bound_rate"].get<double>();
     auto spill_upper_bound_rate =
         spec_["bulkstore_spec"]["spill_upper_bound_rate"].get<double>();
+    BulkStore::SetHugePages(
+        spec_["bulkstore_spec"].value("hugetlbfs_path", std::string("")),
+        spec_["bulkstore_spec"].value("transparent_hugepage", false));
+    auto state_path =
+        spec_["bulkstore_spec"].value("state_path", std::string(""));
+    if (!state_path.empty() && session_id_ == RootSessionID()) {
+      // reattach blobs before the allocator reserves its own address range.
+      RETURN_ON_ERROR(bulk_store_->Recover(state_path));
+    }
     RETURN_ON_ERROR(bulk_store_->PreAllocate(mem_limit));
-    bulk_store_->SetMemSpillUpBound(mem_limit * spill_upper_bound_rate);
-    bulk_store_->SetMemSpillLowBound(mem_limit * spill_lower_bound_rate);
+    // the sub-arenas belong to the shared memory pool, which is initialized
+    // by the root session.
+    auto numa_arena_size =
+        spec_["bulkstore_spec"].value("numa_arena_size", size_t{0});
+    if (numa_arena_size > 0 && session_id_ == RootSessionID()) {
+      RETURN_ON_ERROR(bulk_store_->PreAllocateNumaArenas(numa_arena_size));
+    }
+    auto allocator_shards =
+        spec_["bulkstore_spec"].value("allocator_shards", 0);
+    if (allocator_shards > 0 && session_id_ == RootSessionID()) {
+      RETURN_ON_ERROR(bulk_store_->PreAllocateShards(allocator_shards));
+    }
     bulk_store_->SetSpillPath(
         spec_["bulkstore_spec"]["spill_path"].get<std::string>());
+    bulk_store_->SetCompressedTierSize(
+        spec_["bulkstore_spec"].value("compressed_tier_size", size_t{0}));
+    RETURN_ON_ERROR(
+        bulk_store_->SetQuota(session_id_, reserved_size, limit_size));
+    // spilling is triggered by the usage of the session
+    mem_limit = bulk_store_->FootprintLimit();
+    bulk_store_->SetMemSpillUpBound(mem_limit * spill_upper_bound_rate);
+    bulk_store_->SetMemSpillLowBound(mem_limit * spill_lower_bound_rate);
     stream_store_ = std::make_shared<StreamStore>(
         shared_from_this(), bulk_store_,
         spec_["bulkstore_spec"]["stream_threshold"].get<size_t>());
   }
 
+  // The metadata service starts after the bulk store, as replaying the local
+  // metadata journal (for warm restart) may refer to the reattached blobs.
+  this->meta_service_ptr_ = IMetaService::Get(shared_from_this());
+  RETURN_ON_ERROR(this->meta_service_ptr_->Start());
+
+  if (session_id_ == RootSessionID() && MetricsRegistry::Enabled()) {
+    registerMetricCollectors();
+  }
+
   BulkReady();
 
   serve_status_ = Status::OK();
@@ -174,6 +224,15 @@ void VineyardServer::BackendReady() {
     context_.stop();
     return;
   }
+
+  if (metrics_server_ptr_) {
+    // the metrics are optional, vineyardd keeps serving without them
+    auto status = metrics_server_ptr_->Start();
+    if (!status.ok()) {
+      LOG(ERROR) << status.ToString();
+      metrics_server_ptr_.reset(nullptr);
+    }
+  }
 }
 
 void VineyardServer::MetaReady() {
@@ -982,6 +1041,12 @@ Status VineyardServer::InstanceStatus(callback_t<const json&> callback) {
   status["deployment"] = GetDeployment();
   status["memory_usage"] = bulk_store_->Footprint();
   status["memory_limit"] = bulk_store_->FootprintLimit();
+  status["memory_reserved"] = MemoryPool::Get().Reserved(session_id_);
+  if (session_id_ == RootSessionID()) {
+    status["memory_pool"] = MemoryPool::Get().ToJSON();
+  }
+  bulk_store_->ColdObjectUsage(status["cold_blobs"]);
+  bulk_store_->CompressedTierUsage(status["compressed_tier"]);
   status["deferred_requests"] = deferred_.size();
   if (ipc_server_ptr_) {
     status["ipc_connections"] = ipc_server_ptr_->AliveConnections();
@@ -993,6 +1058,9 @@ Status VineyardServer::InstanceStatus(callback_t<const json&> callback) {
   } else {
     status["rpc_connections"] = 0;
   }
+  if (MetricsRegistry::Enabled()) {
+    status["metrics"] = MetricsRegistry::Get().ToJSON();
+  }
 
   return callback(Status::OK(), status);
 }
@@ -1036,13 +1104,20 @@ void VineyardServer::Stop() {
   if (this->rpc_server_ptr_) {
     this->rpc_server_ptr_->Stop();
   }
+  if (this->metrics_server_ptr_) {
+    this->metrics_server_ptr_->Stop();
+  }
   if (this->meta_service_ptr_) {
     this->meta_service_ptr_->Stop();
   }
+  if (session_id_ == RootSessionID() && MetricsRegistry::Enabled()) {
+    unregisterMetricCollectors();
+  }
 
   // cleanup
   this->ipc_server_ptr_.reset(nullptr);
   this->rpc_server_ptr_.reset(nullptr);
+  this->metrics_server_ptr_.reset(nullptr);
   this->meta_service_ptr_.reset();
   this->stream_store_.reset();
   this->bulk_store_.reset();
@@ -1053,4 +1128,68 @@ bool VineyardServer::Running() const { return !stopped_.load(); }
 
 VineyardServer::~VineyardServer() { this->Stop(); }
 
+void VineyardServer::registerMetricCollectors() {
+  auto& registry = MetricsRegistry::Get();
+  std::weak_ptr<StreamStore> stream_store = stream_store_;
+  // of the whole shared memory pool, rather than of the root session
+  registry.RegisterCollector("memory_usage_bytes", "", []() {
+    return static_cast<double>(BulkAllocator::Allocated());
+  });
+  registry.RegisterCollector("memory_limit_bytes", "", []() {
+    return static_cast<double>(BulkAllocator::GetFootprintLimit());
+  });
+  registry.RegisterCollector("allocator_footprint_bytes", "", []() {
+    return static_cast<double>(BulkAllocator::SystemFootprint());
+  });
+  registry.RegisterCollector("allocator_fragmentation_ratio", "", []() {
+    int64_t footprint = BulkAllocator::SystemFootprint();
+    if (footprint <= 0) {
+      return 0.0;
+    }
+    return 1.0 - static_cast<double>(BulkAllocator::Allocated()) / footprint;
+  });
+  std::weak_ptr<BulkStore> bulk_store = bulk_store_;
+  auto compressed_tier_usage = [bulk_store](int index) {
+    size_t usage[3] = {0, 0, 0};
+    if (auto store = bulk_store.lock()) {
+      store->CompressedTierUsage(usage[0], usage[1], usage[2]);
+    }
+    return static_cast<double>(usage[index]);
+  };
+  registry.RegisterCollector(
+      "compressed_tier_objects", "",
+      [compressed_tier_usage]() { return compressed_tier_usage(0); });
+  registry.RegisterCollector(
+      "compressed_tier_bytes", "",
+      [compressed_tier_usage]() { return compressed_tier_usage(1); });
+  registry.RegisterCollector(
+      "compressed_tier_compressed_bytes", "",
+      [compressed_tier_usage]() { return compressed_tier_usage(2); });
+  registry.RegisterCollector("streams", "", [stream_store]() {
+    size_t streams = 0, ready_chunks = 0;
+    if (auto store = stream_store.lock()) {
+      store->QueueDepth(streams, ready_chunks);
+    }
+    return static_cast<double>(streams);
+  });
+  registry.RegisterCollector("stream_ready_chunks", "", [stream_store]() {
+    size_t streams = 0, ready_chunks = 0;
+    if (auto store = stream_store.lock()) {
+      store->QueueDepth(streams, ready_chunks);
+    }
+    return static_cast<double>(ready_chunks);
+  });
+}
+
+void VineyardServer::unregisterMetricCollectors() {
+  auto& registry = MetricsRegistry::Get();
+  for (auto const& name :
+       {"memory_usage_bytes", "memory_limit_bytes", "allocator_footprint_bytes",
+        "allocator_fragmentation_ratio", "compressed_tier_objects",
+        "compressed_tier_bytes", "compressed_tier_compressed_bytes", "streams",
+        "stream_ready_chunks"}) {
+    registry.UnregisterCollector(name, "");
+  }
+}
+
 }  // namespace vineyard
@@ -44,6 +44,7 @@ class IMetaService;
 
 class IPCServer;
 class RPCServer;
+class MetricsServer;
 
 /**
  * @brief DeferredReq aims to defer a socket request such that the request
@@ -207,6 +208,12 @@ class VineyardServer : public std::enable_shared_from_this<VineyardServer> {
   ~VineyardServer();
 
  private:
+  // register the gauges that are evaluated on export, e.g., the memory usage
+  // and stream queue depths, to the metrics registry.
+  void registerMetricCollectors();
+
+  void unregisterMetricCollectors();
+
   json spec_;
   SessionID session_id_;
 
@@ -222,6 +229,7 @@ class VineyardServer : public std::enable_shared_from_this<VineyardServer> {
   std::shared_ptr<IMetaService> meta_service_ptr_;
   std::unique_ptr<IPCServer> ipc_server_ptr_;
   std::unique_ptr<RPCServer> rpc_server_ptr_;
+  std::unique_ptr<MetricsServer> metrics_server_ptr_;
 
   std::list<DeferredReq> deferred_;
 
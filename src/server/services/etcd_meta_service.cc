@@ -44,6 +44,7 @@ void EtcdWatchHandler::operator()(etcd::Response const& resp) {
   if (this->meta_service_ptr_->stopped()) {
     return;
   }
+  auto received = std::chrono::steady_clock::now();
 
   // NB: the head rev is not the latest rev in those events.
   unsigned head_rev = static_cast<unsigned>(resp.index());
@@ -101,10 +102,17 @@ void EtcdWatchHandler::operator()(etcd::Response const& resp) {
   // NB: update the `handled_rev_` after we have truely applied the update ops.
   ctx_.post(boost::bind(
       callback_, status, ops, head_rev,
-      [this, status](Status const&, unsigned rev) -> Status {
+      [this, status, received](Status const&, unsigned rev) -> Status {
         if (this->meta_service_ptr_->stopped()) {
           return Status::AlreadyStopped("etcd metadata service");
         }
+        // the lag between receiving the events and finishing applying them
+        // to the meta tree, including the time waiting in the meta context.
+        METRIC_HISTOGRAM_OBSERVE(
+            "meta_sync_lag_microseconds", "",
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - received)
+                .count());
         std::lock_guard<std::mutex> scope_lock(
             this->registered_callbacks_mutex_);
         this->handled_rev_.store(rev);
@@ -198,10 +206,11 @@ void EtcdMetaService::commitUpdates(
   //
   // The first n segments will be performed synchronously while the last
   // txn will still be executed in a asynchronous manner.
+  size_t const max_txn_ops = maxTxnOps();
   size_t offset = 0;
-  while (offset + 127 < changes.size()) {
+  while (offset + max_txn_ops < changes.size()) {
     etcdv3::Transaction tx;
-    for (size_t idx = offset; idx < offset + 127; ++idx) {
+    for (size_t idx = offset; idx < offset + max_txn_ops; ++idx) {
       auto const& op = changes[idx];
       if (op.op == op_t::kPut) {
         tx.setup_put(prefix_ + op.kv.key, op.kv.value);
@@ -211,7 +220,7 @@ void EtcdMetaService::commitUpdates(
     }
     auto resp = etcd_->txn(tx).get();
     if (resp.is_ok()) {
-      offset += 127;
+      offset += max_txn_ops;
       LOG_SUMMARY("etcd_request_duration_microseconds", "txn",
                   resp.duration().count());
     } else {
@@ -154,6 +154,10 @@ class EtcdMetaService : public IMetaService {
   void commitUpdates(const std::vector<op_t>&,
                      callback_t<unsigned> callback_after_updated) override;
 
+  // etcd limits the number of ops in a txn by `--max-txn-ops`, which is 128
+  // by default.
+  size_t maxTxnOps() const override { return 127; }
+
   void startDaemonWatch(
       const std::string& prefix, unsigned since_rev,
       callback_t<const std::vector<op_t>&, unsigned, callback_t<unsigned>>
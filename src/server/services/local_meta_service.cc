@@ -13,14 +13,27 @@ limitations under the License.
 #include "server/services/local_meta_service.h"
 
 #include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "boost/algorithm/string/predicate.hpp"
+
 #include "common/util/boost.h"
 #include "common/util/logging.h"
 
 namespace vineyard {
 
+// compact the metadata journal into a snapshot every such many updates.
+static constexpr size_t kLocalMetaSnapshotInterval = 4096;
+
+// The instance registry is not journaled, to let the restarted vineyardd take
+// the same instance id, to which the restored objects belong.
+static inline bool isInstanceKey(std::string const& key) {
+  return boost::algorithm::starts_with(key, "/instances/") ||
+         boost::algorithm::starts_with(key, "/next_instance_id");
+}
+
 inline void LocalMetaService::Stop() {
   if (stopped_.exchange(true)) {
     return;
@@ -28,6 +41,56 @@ inline void LocalMetaService::Stop() {
   IMetaService::Stop();
 }
 
+Status LocalMetaService::preStart() {
+  auto const& spec = server_ptr_->GetSpec()["metastore_spec"];
+  std::string state_path = spec.value("state_path", "");
+  if (!state_path.empty() && server_ptr_->session_id() == RootSessionID()) {
+    journal_.reset(new Journal(state_path + "/metadata"));
+  }
+  return Status::OK();
+}
+
+void LocalMetaService::journalUpdates(const std::vector<op_t>& ops) {
+  if (!journal_ || ops.empty()) {
+    return;
+  }
+  if (journal_->Appended() >= kLocalMetaSnapshotInterval) {
+    // the ops haven't been applied yet, thus the snapshot of current meta tree
+    // together with the following log exactly reflects the latest state.
+    std::vector<op_t> snapshot;
+    snapshotOps(meta_, "", snapshot);
+    std::vector<json> records;
+    for (auto const& op : snapshot) {
+      records.emplace_back(json::array({op.op, op.kv.key, op.kv.value}));
+    }
+    VINEYARD_LOG_ERROR(journal_->Compact(records));
+  }
+  json record = json::array();
+  for (auto const& op : ops) {
+    if (!isInstanceKey(op.kv.key)) {
+      record.push_back(json::array({op.op, op.kv.key, op.kv.value}));
+    }
+  }
+  if (!record.empty()) {
+    VINEYARD_LOG_ERROR(journal_->Append(record));
+  }
+}
+
+void LocalMetaService::snapshotOps(json const& tree, std::string const& prefix,
+                                   std::vector<op_t>& ops) {
+  for (auto const& item : tree.items()) {
+    std::string key = prefix + "/" + item.key();
+    if (isInstanceKey(key)) {
+      continue;
+    }
+    if (item.value().is_object() && !item.value().empty()) {
+      snapshotOps(item.value(), key, ops);
+    } else {
+      ops.emplace_back(op_t::Put(key, json_to_string(item.value()), 0));
+    }
+  }
+}
+
 void LocalMetaService::requestLock(
     std::string lock_name,
     callback_t<std::shared_ptr<ILock>> callback_after_locked) {
@@ -46,6 +109,47 @@ void LocalMetaService::commitUpdates(
 void LocalMetaService::requestAll(
     const std::string& prefix, unsigned base_rev,
     callback_t<const std::vector<op_t>&, unsigned> callback) {
+  if (journal_) {
+    // replay the journal as local updates, to restore the dependency graph
+    // (including blobs) as well.
+    //
+    // Records in the snapshot are single ops, and are replayed as one batch,
+    // while records in the log are batches of ops.
+    size_t batches = 0;
+    std::vector<op_t> ops;
+    auto add_op = [&ops](json const& item) {
+      ops.emplace_back(
+          op_t{.op = static_cast<op_t::op_type_t>(item[0].get<unsigned>()),
+               .kv = kv_t{.key = item[1].get<std::string>(),
+                          .value = item[2].get<std::string>(),
+                          .rev = 0}});
+    };
+    auto flush = [this, &ops, &batches]() {
+      if (!ops.empty()) {
+        replayUpdates(ops);
+        ops.clear();
+        batches += 1;
+      }
+    };
+    auto s = journal_->Replay([&](json const& record) {
+      if (record.size() == 3 && record[0].is_number()) {
+        add_op(record);
+      } else {
+        flush();
+        for (auto const& item : record) {
+          add_op(item);
+        }
+        flush();
+      }
+    });
+    flush();
+    if (s.ok()) {
+      LOG(INFO) << "Restored metadata from " << batches << " journal batches";
+    } else {
+      LOG(ERROR) << "Failed to restore metadata from the journal: "
+                 << s.ToString();
+    }
+  }
   server_ptr_->GetMetaContext().post(
       boost::bind(callback, Status::OK(), std::vector<op_t>{}, 0));
 }
@@ -18,6 +18,7 @@ limitations under the License.
 #include <vector>
 
 #include "server/services/meta_service.h"
+#include "server/util/journal.h"
 
 namespace vineyard {
 
@@ -75,7 +76,19 @@ class LocalMetaService : public IMetaService {
 
   Status probe() override { return Status::OK(); }
 
+  void journalUpdates(const std::vector<op_t>& ops) override;
+
  private:
+  Status preStart() override;
+
+  // flatten the meta tree to put operations, for snapshotting the journal.
+  void snapshotOps(json const& tree, std::string const& prefix,
+                   std::vector<op_t>& ops);
+
+  // the write-ahead log and snapshots of metadata for warm restart, enabled
+  // when `--state_path` is specified.
+  std::unique_ptr<Journal> journal_;
+
   std::shared_ptr<LocalMetaService> shared_from_base() {
     return std::static_pointer_cast<LocalMetaService>(shared_from_this());
   }
@@ -16,7 +16,11 @@ limitations under the License.
 #include "server/services/meta_service.h"
 
 #include <algorithm>
+#include <deque>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "glog/logging.h"
 
@@ -40,10 +44,233 @@ std::shared_ptr<IMetaService> IMetaService::Get(vs_ptr_t server_ptr) {
   return nullptr;
 }
 
+IMetaService::key_path_t::key_path_t(std::string const& key) {
+  if (boost::algorithm::trim_copy(key).empty()) {
+    return;
+  }
+  auto status = CATCH_JSON_ERROR([&]() -> Status {
+    pointer = json::json_pointer(key);
+    return Status::OK();
+  }());
+  if (!status.ok()) {
+    LOG(ERROR) << "Invalid key in metadata: " << key;
+    return;
+  }
+  boost::algorithm::split(segments, key, [](const char c) { return c == '/'; });
+  if (!segments.empty() && segments[0].empty()) {
+    segments.erase(segments.begin());
+  }
+  if (segments.empty()) {
+    category = kOther;
+  } else if (segments[0] == "data") {
+    category = kData;
+    if (segments.size() >= 2) {
+      object_id = ObjectIDFromString(segments[1]);
+    }
+  } else if (segments[0] == "signatures") {
+    category = kSignature;
+  } else if (segments[0] == "names") {
+    category = kName;
+  } else if (segments[0] == "instances") {
+    category = kInstance;
+  } else {
+    category = kOther;
+  }
+}
+
 IMetaService::~IMetaService() { this->Stop(); }
 
 void IMetaService::Stop() { LOG(INFO) << "meta service is stopping ..."; }
 
+/** Note [Group commit of metadata updates]
+ *
+ * Every `RequestToPersist` needs the distributed `meta_sync_lock_` and a
+ * transaction to etcd, which makes etcd the bottleneck when many clients
+ * persist objects at the same time.
+ *
+ * The requests are thus queued on the meta context, and committed in batches:
+ * a batch takes the lock once, runs the `callback_after_ready` of its requests
+ * one by one (the ops of each request are applied to the local meta tree
+ * before running the next one, as if they were executed sequentially), and
+ * commits the ops of all requests in a single transaction.
+ *
+ * - Only one batch is in flight, the requests arrive in the meantime will be
+ *   coalesced into the next batch;
+ * - with `--meta_group_commit_window`, a batch waits for a while before
+ *   taking the lock, to collect more requests when the load is light;
+ * - a batch stops taking more requests once its ops reach the txn ops limit
+ *   of the backend (127 in etcd), the rest are left to the next batch;
+ * - the ops of a request are never split across the transactions of other
+ *   requests: a request that doesn't fit in the rest of the batch ends the
+ *   batch and is committed alone after it, still holding the lock. A single
+ *   request that exceeds the limit is committed in many transactions, the
+ *   same as before.
+ *
+ * A request that fails in `callback_after_ready` doesn't affect others in the
+ * same batch, but a failed commit fails the whole batch.
+ */
+void IMetaService::schedulePersist() {
+  if (persist_in_flight_ || persist_scheduled_ || persist_queue_.empty()) {
+    return;
+  }
+  persist_scheduled_ = true;
+  auto self(shared_from_this());
+  if (group_commit_window_ <= 0) {
+    // still go through the context, to coalesce requests that have already
+    // been posted.
+    server_ptr_->GetMetaContext().post([self]() {
+      self->persist_scheduled_ = false;
+      self->flushPersist();
+    });
+    return;
+  }
+  group_commit_timer_.reset(new asio::steady_timer(
+      server_ptr_->GetMetaContext(),
+      std::chrono::microseconds(group_commit_window_)));
+  group_commit_timer_->async_wait(
+      [self](const boost::system::error_code& error) {
+        self->persist_scheduled_ = false;
+        if (error) {
+          LOG(ERROR) << "group commit timer error: " << error << ", "
+                     << error.message();
+        }
+        self->flushPersist();
+      });
+}
+
+void IMetaService::flushPersist() {
+  if (persist_in_flight_ || persist_queue_.empty()) {
+    return;
+  }
+  if (stopped_.load()) {
+    for (auto const& request : persist_queue_) {
+      VINEYARD_DISCARD(
+          request.second(Status::AlreadyStopped("etcd metadata service")));
+    }
+    persist_queue_.clear();
+    return;
+  }
+  persist_in_flight_ = true;
+  std::deque<persist_request_t> batch;
+  batch.swap(persist_queue_);
+
+  auto self(shared_from_this());
+  this->requestLock(meta_sync_lock_, [self, batch](
+                                         const Status& status,
+                                         std::shared_ptr<ILock> lock) {
+    if (self->stopped_.load()) {
+      return Status::AlreadyStopped("etcd metadata service");
+    }
+    std::vector<std::pair<callback_t<>, Status>> finished;
+    if (!status.ok()) {
+      LOG(ERROR) << status.ToString();
+      for (auto const& request : batch) {
+        finished.emplace_back(request.second, status);
+      }
+      self->finishPersist(finished, Status::OK());
+      return Status::OK();
+    }
+    self->requestValues("", [self, batch, lock](const Status& status,
+                                                const json& meta,
+                                                unsigned rev) mutable {
+      if (self->stopped_.load()) {
+        return Status::AlreadyStopped("etcd metadata service");
+      }
+      std::vector<std::pair<callback_t<>, Status>> finished;
+      std::vector<op_t> ops;
+      // the request that doesn't fit in the batch, committed alone
+      std::vector<std::pair<callback_t<>, Status>> alone;
+      std::vector<op_t> alone_ops;
+      size_t const max_txn_ops = self->maxTxnOps();
+      size_t index = 0;
+      for (; index < batch.size(); ++index) {
+        if (!ops.empty() && ops.size() >= max_txn_ops) {
+          break;
+        }
+        std::vector<op_t> request_ops;
+        auto s = batch[index].first(status, meta, request_ops);
+        if (s.ok() && !request_ops.empty()) {
+          // apply changes locally before committing to etcd, to make them
+          // visible to the following requests in the batch
+          self->metaUpdate(request_ops, false);
+          if (!ops.empty() && ops.size() + request_ops.size() > max_txn_ops) {
+            alone.emplace_back(batch[index].second, s);
+            alone_ops.swap(request_ops);
+            ++index;
+            break;
+          }
+          ops.insert(ops.end(), request_ops.begin(), request_ops.end());
+        }
+        finished.emplace_back(batch[index].second, s);
+      }
+      // leave the rest to the next batch, in the original order
+      for (size_t rest = batch.size(); rest > index; --rest) {
+        self->persist_queue_.emplace_front(std::move(batch[rest - 1]));
+      }
+      METRIC_HISTOGRAM_OBSERVE("meta_group_commit_batch_size", "",
+                               finished.size() + alone.size());
+      METRIC_HISTOGRAM_OBSERVE("meta_group_commit_ops", "",
+                               ops.size() + alone_ops.size());
+
+      if (ops.empty()) {
+        unsigned rev_after_unlock = 0;
+        VINEYARD_DISCARD(lock->Release(rev_after_unlock));
+        self->finishPersist(finished, Status::OK());
+        return Status::OK();
+      }
+      // commit to etcd
+      self->commitUpdates(ops, [self, finished, alone, alone_ops, lock](
+                                   const Status& status,
+                                   unsigned rev) mutable {
+        if (self->stopped_.load()) {
+          return Status::AlreadyStopped("etcd metadata service");
+        }
+        if (status.ok() && !alone_ops.empty()) {
+          self->commitUpdates(alone_ops, [self, finished, alone, lock](
+                                             const Status& status,
+                                             unsigned rev) mutable {
+            if (self->stopped_.load()) {
+              return Status::AlreadyStopped("etcd metadata service");
+            }
+            // the batch has been committed, only the request left alone
+            // sees the status of its own commit
+            for (auto& item : alone) {
+              finished.emplace_back(item.first,
+                                    item.second.ok() ? status : item.second);
+            }
+            unsigned rev_after_unlock = 0;
+            VINEYARD_DISCARD(lock->Release(rev_after_unlock));
+            self->finishPersist(finished, Status::OK());
+            return Status::OK();
+          });
+          return Status::OK();
+        }
+        // on failures, the request left alone fails as well, as its ops have
+        // been generated on top of the batch
+        finished.insert(finished.end(), alone.begin(), alone.end());
+        // update rev_ to the revision after unlock.
+        unsigned rev_after_unlock = 0;
+        VINEYARD_DISCARD(lock->Release(rev_after_unlock));
+        self->finishPersist(finished, status);
+        return Status::OK();
+      });
+      return Status::OK();
+    });
+    return Status::OK();
+  });
+}
+
+void IMetaService::finishPersist(
+    std::vector<std::pair<callback_t<>, Status>>& finished,
+    Status const& status) {
+  persist_in_flight_ = false;
+  for (auto& item : finished) {
+    // the error of a request takes precedence over the error of the commit
+    VINEYARD_DISCARD(item.first(item.second.ok() ? status : item.second));
+  }
+  schedulePersist();
+}
+
 /** Note [Deleting objects and blobs]
  *
  * Blob is special: suppose A -> B and A -> C, where A is an object, B is an
@@ -92,18 +319,19 @@ void IMetaService::Stop() { LOG(INFO) << "meta service is stopping ..."; }
 void IMetaService::IncRef(std::string const& instance_name,
                           std::string const& key, std::string const& value,
                           const bool from_remote) {
-  std::vector<std::string> vs;
-  boost::algorithm::split(vs, key, [](const char c) { return c == '/'; });
-  if (vs[0].empty()) {
-    vs.erase(vs.begin());
-  }
-  if (vs.size() < 2 || vs[0] != "data") {
+  key_path_t path(key);
+  if (path.category != key_path_t::kData || path.segments.size() < 2) {
     // The key is not an object id: data.id
     return;
   }
-  ObjectID key_obj, value_obj;
+  IncRef(instance_name, path.object_id, value, from_remote);
+}
+
+void IMetaService::IncRef(std::string const& instance_name,
+                          ObjectID const key_obj, std::string const& value,
+                          const bool from_remote) {
+  ObjectID value_obj;
   if (meta_tree::DecodeObjectID(meta_, instance_name, value, value_obj).ok()) {
-    key_obj = ObjectIDFromString(vs[1]);
     if (from_remote && IsBlob(value_obj)) {
       // don't put remote blob refs into deps graph, since two blobs may share
       // the same object id.
@@ -325,22 +553,25 @@ void IMetaService::printDepsGraph() {
             << ss.str();
 }
 
-void IMetaService::putVal(const kv_t& kv, bool const from_remote) {
+void IMetaService::putVal(const kv_t& kv, const key_path_t& path,
+                          bool const from_remote) {
   // don't crash the server for any reason (any potential garbage value)
   auto upsert_to_meta = [&]() -> Status {
     json value = json::parse(kv.value);
-    if (value.is_string()) {
-      IncRef(server_ptr_->instance_name(), kv.key,
-             value.get_ref<std::string const&>(), from_remote);
-    } else if (value.is_object() && !value.empty()) {
-      for (auto const& item : value.items()) {
-        if (item.value().is_string()) {
-          IncRef(server_ptr_->instance_name(), kv.key,
-                 item.value().get_ref<std::string const&>(), from_remote);
+    if (path.category == key_path_t::kData && path.segments.size() >= 2) {
+      if (value.is_string()) {
+        IncRef(server_ptr_->instance_name(), path.object_id,
+               value.get_ref<std::string const&>(), from_remote);
+      } else if (value.is_object() && !value.empty()) {
+        for (auto const& item : value.items()) {
+          if (item.value().is_string()) {
+            IncRef(server_ptr_->instance_name(), path.object_id,
+                   item.value().get_ref<std::string const&>(), from_remote);
+          }
         }
       }
     }
-    meta_[json::json_pointer(kv.key)] = value;
+    meta_[path.pointer] = std::move(value);
     return Status::OK();
   };
 
@@ -361,8 +592,8 @@ void IMetaService::putVal(const kv_t& kv, bool const from_remote) {
   };
 
   // update signatures
-  if (boost::algorithm::starts_with(kv.key, "/signatures/")) {
-    if (!from_remote || !meta_.contains(json::json_pointer(kv.key))) {
+  if (path.category == key_path_t::kSignature) {
+    if (!from_remote || !meta_.contains(path.pointer)) {
       VINEYARD_LOG_ERROR(CATCH_JSON_ERROR(upsert_to_meta()));
     }
     VINEYARD_LOG_ERROR(CATCH_JSON_ERROR(upsert_sig_to_meta()));
@@ -370,8 +601,8 @@ void IMetaService::putVal(const kv_t& kv, bool const from_remote) {
   }
 
   // update names
-  if (boost::algorithm::starts_with(kv.key, "/names/")) {
-    if (!from_remote && meta_.contains(json::json_pointer(kv.key))) {
+  if (path.category == key_path_t::kName) {
+    if (!from_remote && meta_.contains(path.pointer)) {
       LOG(WARNING) << "Warning: name got overwritten: " << kv.key;
     }
     VINEYARD_LOG_ERROR(CATCH_JSON_ERROR(upsert_to_meta()));
@@ -383,7 +614,10 @@ void IMetaService::putVal(const kv_t& kv, bool const from_remote) {
 }
 
 void IMetaService::delVal(std::string const& key) {
-  auto path = json::json_pointer(key);
+  delVal(json::json_pointer(key));
+}
+
+void IMetaService::delVal(json::json_pointer const& path) {
   if (meta_.contains(path)) {
     auto ppath = path.parent_pointer();
     meta_[ppath].erase(path.back());
@@ -18,11 +18,15 @@ limitations under the License.
 
 #include <chrono>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "boost/asio.hpp"
@@ -117,6 +121,23 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     }
   };
 
+  /**
+   * @brief The parsed key of an op, to avoid splitting the key and parsing the
+   * json pointer again and again while applying the op to the meta tree.
+   */
+  struct key_path_t {
+    enum category_t { kData, kSignature, kName, kInstance, kOther, kInvalid };
+
+    explicit key_path_t(std::string const& key);
+
+    json::json_pointer pointer;
+    // segments of the key, without the leading empty one
+    std::vector<std::string> segments;
+    category_t category = kInvalid;
+    // the object id of keys like "/data/<object id>/..."
+    ObjectID object_id = InvalidObjectID();
+  };
+
   struct watcher_t {
     watcher_t(callback_t<const json&, const std::string&> w,
               const std::string& t)
@@ -128,6 +149,8 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
   explicit IMetaService(vs_ptr_t& server_ptr)
       : server_ptr_(server_ptr), rev_(0), meta_sync_lock_("/meta_sync_lock") {
     stopped_.store(false);
+    group_commit_window_ = server_ptr_->GetSpec()["metastore_spec"].value(
+        "group_commit_window", static_cast<int64_t>(0));
   }
 
   virtual ~IMetaService();
@@ -202,55 +225,20 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
       callback_t<> callback_after_finish) {
     // NB: when persist local meta to etcd, we needs the meta_sync_lock_ to
     // avoid contention between other vineyard instances.
+    //
+    // Concurrent requests are coalesced, see also Note [Group commit of
+    // metadata updates].
     auto self(shared_from_this());
-    this->requestLock(
-        meta_sync_lock_,
-        [self, callback_after_ready, callback_after_finish](
-            const Status& status, std::shared_ptr<ILock> lock) {
+    server_ptr_->GetMetaContext().post(
+        [self, callback_after_ready, callback_after_finish]() {
           if (self->stopped_.load()) {
-            return Status::AlreadyStopped("etcd metadata service");
-          }
-          if (status.ok()) {
-            self->requestValues(
-                "", [self, callback_after_ready, callback_after_finish, lock](
-                        const Status& status, const json& meta, unsigned rev) {
-                  if (self->stopped_.load()) {
-                    return Status::AlreadyStopped("etcd metadata service");
-                  }
-                  std::vector<op_t> ops;
-                  auto s = callback_after_ready(status, meta, ops);
-                  if (s.ok()) {
-                    if (ops.empty()) {
-                      unsigned rev_after_unlock = 0;
-                      VINEYARD_DISCARD(lock->Release(rev_after_unlock));
-                      return callback_after_finish(Status::OK());
-                    }
-                    // apply changes locally before committing to etcd
-                    self->metaUpdate(ops, false);
-                    // commit to etcd
-                    self->commitUpdates(ops, [self, callback_after_finish,
-                                              lock](const Status& status,
-                                                    unsigned rev) {
-                      if (self->stopped_.load()) {
-                        return Status::AlreadyStopped("etcd metadata service");
-                      }
-                      // update rev_ to the revision after unlock.
-                      unsigned rev_after_unlock = 0;
-                      VINEYARD_DISCARD(lock->Release(rev_after_unlock));
-                      return callback_after_finish(status);
-                    });
-                    return Status::OK();
-                  } else {
-                    unsigned rev_after_unlock = 0;
-                    VINEYARD_DISCARD(lock->Release(rev_after_unlock));
-                    return callback_after_finish(s);  // propogate the error
-                  }
-                });
-            return Status::OK();
-          } else {
-            LOG(ERROR) << status.ToString();
-            return callback_after_finish(status);  // propogate the error
+            VINEYARD_DISCARD(callback_after_finish(
+                Status::AlreadyStopped("etcd metadata service")));
+            return;
           }
+          self->persist_queue_.emplace_back(callback_after_ready,
+                                            callback_after_finish);
+          self->schedulePersist();
         });
   }
 
@@ -397,6 +385,9 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
   void IncRef(std::string const& instance_name, std::string const& key,
               std::string const& value, const bool from_remote);
 
+  void IncRef(std::string const& instance_name, ObjectID const key_obj,
+              std::string const& value, const bool from_remote);
+
   void CloneRef(ObjectID const target, ObjectID const mirror);
 
   bool stopped() const { return this->stopped_.load(); }
@@ -613,13 +604,16 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     // long-running and no compact Etcd, watching from revision 0 may
     // lead to a super huge amount of events, which is unacceptable.
     auto self(shared_from_this());
+    auto start = std::chrono::steady_clock::now();
     if (rev_ == 0) {
       requestAll(prefix, rev_,
-                 [self, callback](const Status& status,
-                                  const std::vector<op_t>& ops, unsigned rev) {
+                 [self, callback, start](const Status& status,
+                                         const std::vector<op_t>& ops,
+                                         unsigned rev) {
                    if (self->stopped_.load()) {
                      return Status::AlreadyStopped("etcd metadata service");
                    }
+                   observeSyncDuration(true, start);
                    if (status.ok()) {
                      self->metaUpdate(ops, true);
                      self->rev_ = rev;
@@ -629,11 +623,12 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     } else {
       requestUpdates(
           prefix, rev_,
-          [self, callback](const Status& status, const std::vector<op_t>& ops,
-                           unsigned rev) {
+          [self, callback, start](const Status& status,
+                                  const std::vector<op_t>& ops, unsigned rev) {
             if (self->stopped_.load()) {
               return Status::AlreadyStopped("etcd metadata service");
             }
+            observeSyncDuration(false, start);
             if (status.ok()) {
               self->metaUpdate(ops, true);
               self->rev_ = rev;
@@ -643,10 +638,32 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     }
   }
 
+  // the duration of a full ("all") or an incremental ("updates") sync
+  static void observeSyncDuration(
+      bool const full, std::chrono::steady_clock::time_point const& start) {
+    int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    if (full) {
+      METRIC_HISTOGRAM_OBSERVE("meta_sync_duration_microseconds",
+                               MetricsRegistry::Label("kind", "all"), micros);
+    } else {
+      METRIC_HISTOGRAM_OBSERVE("meta_sync_duration_microseconds",
+                               MetricsRegistry::Label("kind", "updates"),
+                               micros);
+    }
+  }
+
   virtual void requestLock(
       std::string lock_name,
       callback_t<std::shared_ptr<ILock>> callback_after_locked) = 0;
 
+  // the maximum number of ops that can be committed in a single transaction
+  // of the backend.
+  virtual size_t maxTxnOps() const {
+    return std::numeric_limits<size_t>::max();
+  }
+
   virtual void requestAll(
       const std::string& prefix, unsigned base_rev,
       callback_t<const std::vector<op_t>&, unsigned> callback) = 0;
@@ -663,6 +680,18 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
   // validate the liveness of the underlying meta service.
   virtual Status probe() = 0;
 
+  // persist the local updates before applying them to the meta tree, used by
+  // the local meta service for warm restart.
+  virtual void journalUpdates(const std::vector<op_t>& ops) {}
+
+  // apply the (journaled) updates as local updates, without journaling them
+  // again.
+  void replayUpdates(const std::vector<op_t>& ops) {
+    replaying_ = true;
+    metaUpdate(ops, false);
+    replaying_ = false;
+  }
+
   void printDepsGraph();
 
   std::atomic<bool> stopped_;
@@ -674,9 +703,21 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
 
   std::string meta_sync_lock_;
 
+  bool replaying_ = false;
+
  private:
   virtual Status preStart() { return Status::OK(); }
 
+  using persist_request_t =
+      std::pair<callback_t<const json&, std::vector<op_t>&>, callback_t<>>;
+
+  void schedulePersist();
+
+  void flushPersist();
+
+  void finishPersist(std::vector<std::pair<callback_t<>, Status>>& finished,
+                     Status const& status);
+
   bool deleteable(ObjectID const object_id);
 
   void traverseToDelete(std::set<ObjectID>& initial_delete_set,
@@ -693,21 +734,38 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
                             const std::map<ObjectID, int32_t>& depthes,
                             std::vector<ObjectID>& delete_objects);
 
-  void putVal(const kv_t& kv, bool const from_remote);
+  void putVal(const kv_t& kv, const key_path_t& path, bool const from_remote);
   void delVal(std::string const& key);
+  void delVal(json::json_pointer const& path);
   void delVal(const kv_t& kv);
   void delVal(ObjectID const& target, std::set<ObjectID>& blobs);
 
   template <class RangeT>
   void metaUpdate(const RangeT& ops, bool const from_remote) {
+    if (!from_remote && !replaying_) {
+      journalUpdates(ops);
+    }
+
     std::set<ObjectID> blobs_to_delete;
+    applyUpdates(std::begin(ops), std::end(ops), from_remote, blobs_to_delete);
+    finishUpdates(blobs_to_delete);
+  }
 
-    std::vector<op_t> add_sigs, drop_sigs;
-    std::vector<op_t> add_datas, drop_datas;
-    std::vector<op_t> add_others, drop_others;
+  // apply the ops to the meta tree and the dependency graph, the deletion of
+  // blobs is deferred to `finishUpdates()`, so that many batches of remote
+  // updates can be applied at once.
+  template <class IterT>
+  void applyUpdates(IterT begin, IterT end, bool const from_remote,
+                    std::set<ObjectID>& blobs_to_delete) {
+    using parsed_op_t = std::pair<const op_t*, key_path_t>;
+
+    std::vector<parsed_op_t> add_sigs, drop_sigs;
+    std::vector<parsed_op_t> add_datas, drop_datas;
+    std::vector<parsed_op_t> add_others, drop_others;
 
     // group-by all changes
-    for (const op_t& op : ops) {
+    for (IterT iter = begin; iter != end; ++iter) {
+      const op_t& op = *iter;
       if (op.kv.rev != 0 && op.kv.rev <= rev_) {
 #ifndef NDEBUG
         if (from_remote && op.kv.rev <= rev_) {
@@ -718,18 +776,19 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
         // the revision value 0 means local update ops.
         continue;
       }
-      if (boost::algorithm::trim_copy(op.kv.key).empty()) {
-        // skip unprintable keys
-        continue;
-      }
       if (boost::algorithm::starts_with(op.kv.key, meta_sync_lock_)) {
         // skip the update of etcd lock
         continue;
       }
+      key_path_t path(op.kv.key);
+      if (path.category == key_path_t::kInvalid) {
+        // skip unprintable keys
+        continue;
+      }
 
       // update instance status
-      if (boost::algorithm::starts_with(op.kv.key, "/instances/")) {
-        instanceUpdate(op);
+      if (path.category == key_path_t::kInstance) {
+        instanceUpdate(op, path);
       }
 
 #ifndef NDEBUG
@@ -738,46 +797,37 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
       }
 #endif
 
-      if (boost::algorithm::starts_with(op.kv.key, "/signatures/")) {
-        if (op.op == op_t::op_type_t::kPut) {
-          add_sigs.emplace_back(op);
-        } else if (op.op == op_t::op_type_t::kDel) {
-          drop_sigs.emplace_back(op);
-        } else {
-          LOG(ERROR) << "warn: unknown op type for signatures: " << op.op;
-        }
-      } else if (boost::algorithm::starts_with(op.kv.key, "/data/")) {
-        if (op.op == op_t::op_type_t::kPut) {
-          add_datas.emplace_back(op);
-        } else if (op.op == op_t::op_type_t::kDel) {
-          drop_datas.emplace_back(op);
-        } else {
-          LOG(ERROR) << "warn: unknown op type for datas: " << op.op;
-        }
+      std::vector<parsed_op_t>* adds = &add_others;
+      std::vector<parsed_op_t>* drops = &drop_others;
+      if (path.category == key_path_t::kSignature) {
+        adds = &add_sigs;
+        drops = &drop_sigs;
+      } else if (path.category == key_path_t::kData) {
+        adds = &add_datas;
+        drops = &drop_datas;
+      }
+      if (op.op == op_t::op_type_t::kPut) {
+        adds->emplace_back(&op, std::move(path));
+      } else if (op.op == op_t::op_type_t::kDel) {
+        drops->emplace_back(&op, std::move(path));
       } else {
-        if (op.op == op_t::op_type_t::kPut) {
-          add_others.emplace_back(op);
-        } else if (op.op == op_t::op_type_t::kDel) {
-          drop_others.emplace_back(op);
-        } else {
-          LOG(ERROR) << "warn: unknown op type for others: " << op.op;
-        }
+        LOG(ERROR) << "warn: unknown op type: " << op.op;
       }
     }
 
     // apply adding signature mappings first.
-    for (const op_t& op : add_sigs) {
-      putVal(op.kv, from_remote);
+    for (const parsed_op_t& op : add_sigs) {
+      putVal(op.first->kv, op.second, from_remote);
     }
 
     // apply adding others
-    for (const op_t& op : add_others) {
-      putVal(op.kv, from_remote);
+    for (const parsed_op_t& op : add_others) {
+      putVal(op.first->kv, op.second, from_remote);
     }
 
     // apply adding datas
-    for (const op_t& op : add_datas) {
-      putVal(op.kv, from_remote);
+    for (const parsed_op_t& op : add_datas) {
+      putVal(op.first->kv, op.second, from_remote);
     }
 
     // apply drop datas
@@ -785,21 +835,15 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     {
       // 1. collect all ids
       std::set<ObjectID> initial_delete_set;
-      std::vector<std::string> vs;
-      for (const op_t& op : drop_datas) {
-        vs.clear();
-        boost::algorithm::split(vs, op.kv.key,
-                                [](const char c) { return c == '/'; });
-        if (vs[0].empty()) {
-          vs.erase(vs.begin());
-        }
+      for (parsed_op_t& op : drop_datas) {
+        auto const& segments = op.second.segments;
         // `__name` is our injected properties, and will be erased during
         // `DropName`.
-        if (vs.size() >= 3 && vs[2] == "__name") {
+        if (segments.size() >= 3 && segments[2] == "__name") {
           // move the key to `drop_others` to drop
-          drop_others.emplace_back(op);
+          drop_others.emplace_back(std::move(op));
         } else {
-          initial_delete_set.emplace(ObjectIDFromString(vs[1]));
+          initial_delete_set.emplace(op.second.object_id);
         }
       }
       std::vector<ObjectID> object_ids{initial_delete_set.begin(),
@@ -825,15 +869,17 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     }
 
     // apply drop others
-    for (const op_t& op : drop_others) {
-      delVal(op.kv);
+    for (const parsed_op_t& op : drop_others) {
+      delVal(op.second.pointer);
     }
 
     // apply drop signatures
-    for (const op_t& op : drop_sigs) {
-      delVal(op.kv);
+    for (const parsed_op_t& op : drop_sigs) {
+      delVal(op.second.pointer);
     }
+  }
 
+  void finishUpdates(std::set<ObjectID> const& blobs_to_delete) {
 #ifndef NDEBUG
     // debugging
     printDepsGraph();
@@ -846,13 +892,9 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     VINEYARD_SUPPRESS(server_ptr_->ProcessDeferred(meta_));
   }
 
-  void instanceUpdate(const op_t& op) {
-    std::vector<std::string> key_segments;
-    boost::split(key_segments, op.kv.key, boost::is_any_of("/"));
-    if (key_segments[0].empty()) {
-      key_segments.erase(key_segments.begin());
-    }
-    if (key_segments[2] == "hostid") {
+  void instanceUpdate(const op_t& op, const key_path_t& path) {
+    auto const& key_segments = path.segments;
+    if (key_segments.size() >= 3 && key_segments[2] == "hostid") {
       uint64_t instance_id = std::stoul(key_segments[1].substr(1));
       if (op.op == op_t::op_type_t::kPut) {
         LOG(INFO) << "Instance join: " << instance_id;
@@ -888,23 +930,33 @@ class IMetaService : public std::enable_shared_from_this<IMetaService> {
     if (ops.empty()) {
       return callback_after_update(Status::OK(), rev);
     }
-    // process events grouped by revision
-    size_t idx = 0;
-    std::vector<op_t> op_batch;
-    while (idx < ops.size()) {
-      unsigned head_index = ops[idx].kv.rev;
-      while (idx < ops.size() && ops[idx].kv.rev == head_index) {
-        op_batch.emplace_back(ops[idx]);
-        idx += 1;
+    // process events grouped by revision, and delete the blobs and notify
+    // the deferred requests once for all events.
+    std::set<ObjectID> blobs_to_delete;
+    auto begin = ops.begin();
+    while (begin != ops.end()) {
+      unsigned head_index = begin->kv.rev;
+      auto end = begin;
+      while (end != ops.end() && end->kv.rev == head_index) {
+        ++end;
       }
-      self->metaUpdate(op_batch, true);
-      op_batch.clear();
+      self->applyUpdates(begin, end, true, blobs_to_delete);
       self->rev_ = head_index;
+      begin = end;
     }
+    self->finishUpdates(blobs_to_delete);
+    METRIC_GAUGE_SET("meta_sync_revision", "", self->rev_);
     return callback_after_update(Status::OK(), rev);
   }
 
   std::unique_ptr<asio::steady_timer> heartbeat_timer_;
+
+  // group commit of persist requests, only accessed on the meta context
+  int64_t group_commit_window_ = 0;  // in microseconds
+  std::deque<persist_request_t> persist_queue_;
+  bool persist_scheduled_ = false;
+  bool persist_in_flight_ = false;
+  std::unique_ptr<asio::steady_timer> group_commit_timer_;
   std::set<InstanceID> instances_list_;
   int64_t target_latest_time_ = 0;
   size_t timeout_count_ = 0;
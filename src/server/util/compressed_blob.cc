@@ -0,0 +1,129 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "server/util/compressed_blob.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "common/util/arrow.h"
+
+namespace vineyard {
+
+namespace {
+
+// the head of the blob that decides the codec
+constexpr int64_t kSampleSize = 64 * 1024;
+
+// LZ4 is good enough when it compresses the sample by at least 4x
+constexpr double kLZ4Ratio = 4.0;
+
+Status CreateCodec(arrow::Compression::type type,
+                   std::unique_ptr<arrow::util::Codec>& codec) {
+  RETURN_ON_ARROW_ERROR_AND_ASSIGN(codec, arrow::util::Codec::Create(type));
+  return Status::OK();
+}
+
+// compresses into `buffer`, which is reallocated if too small
+Status CompressWith(arrow::util::Codec* codec, const uint8_t* data,
+                    int64_t size, std::unique_ptr<uint8_t[]>& buffer,
+                    int64_t& capacity, int64_t& compressed_size) {
+  int64_t bound = codec->MaxCompressedLen(size, data);
+  if (capacity < bound) {
+    buffer.reset(new uint8_t[bound]);
+    capacity = bound;
+  }
+  RETURN_ON_ARROW_ERROR_AND_ASSIGN(
+      compressed_size, codec->Compress(size, data, capacity, buffer.get()));
+  return Status::OK();
+}
+
+}  // namespace
+
+Status CompressedBlob::Compress(const uint8_t* data, int64_t size,
+                                double min_ratio,
+                                int64_t max_compressed_size,
+                                std::unique_ptr<CompressedBlob>& blob) {
+  blob = nullptr;
+  if (size <= 0 || max_compressed_size <= 0) {
+    return Status::OK();
+  }
+  std::unique_ptr<arrow::util::Codec> lz4, zstd;
+  // the codecs are optional components of arrow
+  bool has_lz4 = CreateCodec(arrow::Compression::LZ4_FRAME, lz4).ok();
+  bool has_zstd = CreateCodec(arrow::Compression::ZSTD, zstd).ok();
+  if (!has_lz4 && !has_zstd) {
+    return Status::OK();
+  }
+
+  std::unique_ptr<uint8_t[]> buffer;
+  int64_t capacity = 0, compressed_size = 0;
+  int64_t sample_size = std::min(size, kSampleSize);
+  arrow::util::Codec* codec = nullptr;
+  arrow::Compression::type type = arrow::Compression::UNCOMPRESSED;
+  if (has_lz4) {
+    RETURN_ON_ERROR(CompressWith(lz4.get(), data, sample_size, buffer,
+                                 capacity, compressed_size));
+    if (!has_zstd || compressed_size * kLZ4Ratio <= sample_size) {
+      codec = lz4.get();
+      type = arrow::Compression::LZ4_FRAME;
+    }
+  }
+  if (codec == nullptr) {
+    RETURN_ON_ERROR(CompressWith(zstd.get(), data, sample_size, buffer,
+                                 capacity, compressed_size));
+    codec = zstd.get();
+    type = arrow::Compression::ZSTD;
+  }
+  if (compressed_size * min_ratio > sample_size ||
+      static_cast<double>(compressed_size) * size / sample_size >
+          max_compressed_size) {
+    return Status::OK();
+  }
+
+  if (sample_size < size) {
+    RETURN_ON_ERROR(
+        CompressWith(codec, data, size, buffer, capacity, compressed_size));
+    if (compressed_size * min_ratio > size ||
+        compressed_size > max_compressed_size) {
+      return Status::OK();
+    }
+  }
+  // shrinks the buffer to the compressed size
+  std::unique_ptr<uint8_t[]> compressed(new uint8_t[compressed_size]);
+  memcpy(compressed.get(), buffer.get(), compressed_size);
+  blob.reset(
+      new CompressedBlob(type, size, std::move(compressed), compressed_size));
+  return Status::OK();
+}
+
+Status CompressedBlob::Decompress(uint8_t* data) const {
+  std::unique_ptr<arrow::util::Codec> codec;
+  RETURN_ON_ERROR(CreateCodec(codec_, codec));
+  int64_t size = 0;
+  RETURN_ON_ARROW_ERROR_AND_ASSIGN(
+      size, codec->Decompress(compressed_size_, buffer_.get(), size_, data));
+  if (size != size_) {
+    return Status::IOError("Corrupted compressed blob: expect " +
+                           std::to_string(size_) + " bytes, but got " +
+                           std::to_string(size));
+  }
+  return Status::OK();
+}
+
+}  // namespace vineyard
@@ -0,0 +1,83 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_SERVER_UTIL_COMPRESSED_BLOB_H_
+#define SRC_SERVER_UTIL_COMPRESSED_BLOB_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "arrow/util/compression.h"
+
+#include "common/util/status.h"
+
+namespace vineyard {
+
+/**
+ * @brief The compressed copy of a cold blob, kept in the private memory of
+ * vineyardd by the compressed tier, see `ColdObjectTracker`.
+ *
+ * The codec is chosen per blob from a sample of its head: LZ4 when the
+ * sample compresses well with it already (e.g., sorted ids), otherwise ZSTD,
+ * which trades more CPU time for a better ratio. Blobs that compress worse
+ * than `min_ratio` are left to the disk spilling.
+ */
+class CompressedBlob {
+ public:
+  /**
+   * @brief Compresses the blob, `blob` is left nullptr if the blob doesn't
+   * compress to at most 1 / `min_ratio` of its size or to at most
+   * `max_compressed_size` bytes, or no codec is available in the linked
+   * arrow library.
+   *
+   * Both bounds are first checked against the sample, extrapolated to the
+   * whole blob, so that the blobs that won't fit are rejected without being
+   * compressed as a whole.
+   */
+  static Status Compress(const uint8_t* data, int64_t size, double min_ratio,
+                         int64_t max_compressed_size,
+                         std::unique_ptr<CompressedBlob>& blob);
+
+  /**
+   * @brief Decompresses the blob into `data`, which must hold `size()` bytes.
+   */
+  Status Decompress(uint8_t* data) const;
+
+  /// The size of the blob before compression.
+  int64_t size() const { return size_; }
+
+  /// The size of the compressed blob.
+  int64_t compressed_size() const { return compressed_size_; }
+
+  arrow::Compression::type codec() const { return codec_; }
+
+ private:
+  CompressedBlob(arrow::Compression::type codec, int64_t size,
+                 std::unique_ptr<uint8_t[]> buffer, int64_t compressed_size)
+      : codec_(codec),
+        size_(size),
+        buffer_(std::move(buffer)),
+        compressed_size_(compressed_size) {}
+
+  arrow::Compression::type codec_;
+  int64_t size_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  int64_t compressed_size_;
+};
+
+}  // namespace vineyard
+
+#endif  // SRC_SERVER_UTIL_COMPRESSED_BLOB_H_
@@ -0,0 +1,136 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "server/util/journal.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "common/util/logging.h"
+
+namespace vineyard {
+
+Journal::Journal(std::string const& path)
+    : snapshot_path_(path + ".snapshot"), log_path_(path + ".wal") {}
+
+Journal::~Journal() {
+  if (log_.is_open()) {
+    log_.close();
+  }
+}
+
+Status Journal::Replay(std::function<void(json const&)> const& fn) {
+  auto replay_file = [&fn](std::string const& path,
+                           bool const tolerate_tail) -> Status {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+      return Status::OK();
+    }
+    std::string line;
+    size_t lineno = 0;
+    while (std::getline(in, line)) {
+      lineno += 1;
+      if (line.empty()) {
+        continue;
+      }
+      json record;
+      try {
+        record = json::parse(line);
+      } catch (json::exception const& ex) {
+        if (tolerate_tail && in.peek() == std::char_traits<char>::eof()) {
+          LOG(WARNING) << "Ignoring the truncated tail of journal " << path
+                       << " at line " << lineno;
+          break;
+        }
+        return Status::IOError("Failed to parse journal " + path +
+                               " at line " + std::to_string(lineno) + ": " +
+                               ex.what());
+      }
+      fn(record);
+    }
+    return Status::OK();
+  };
+  RETURN_ON_ERROR(replay_file(snapshot_path_, false));
+  RETURN_ON_ERROR(replay_file(log_path_, true));
+  return Status::OK();
+}
+
+Status Journal::Append(json const& record) {
+  if (!log_.is_open()) {
+    RETURN_ON_ERROR(openLog(false));
+  }
+  log_ << json_to_string(record) << '\n';
+  log_.flush();
+  if (!log_.good()) {
+    return Status::IOError("Failed to append to journal " + log_path_);
+  }
+  appended_ += 1;
+  return Status::OK();
+}
+
+Status Journal::Compact(std::vector<json> const& records) {
+  std::string staging_path = snapshot_path_ + ".tmp";
+  {
+    std::ofstream out(staging_path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+      return Status::IOError("Failed to open " + staging_path);
+    }
+    for (auto const& record : records) {
+      out << json_to_string(record) << '\n';
+    }
+    out.flush();
+    if (!out.good()) {
+      return Status::IOError("Failed to write snapshot " + staging_path);
+    }
+  }
+  // `rename` is atomic: a crash leaves either the old or the new snapshot,
+  // and replaying the old log on top of the new snapshot is idempotent.
+  if (std::rename(staging_path.c_str(), snapshot_path_.c_str()) != 0) {
+    return Status::IOError("Failed to install snapshot " + snapshot_path_ +
+                           ": " + strerror(errno));
+  }
+  return openLog(true);
+}
+
+Status Journal::Destroy() {
+  if (log_.is_open()) {
+    log_.close();
+  }
+  std::remove(snapshot_path_.c_str());
+  std::remove(log_path_.c_str());
+  appended_ = 0;
+  return Status::OK();
+}
+
+Status Journal::openLog(bool const truncate) {
+  if (log_.is_open()) {
+    log_.close();
+  }
+  log_.open(log_path_,
+            std::ios::out | (truncate ? std::ios::trunc : std::ios::app));
+  if (!log_.is_open()) {
+    return Status::IOError("Failed to open journal " + log_path_);
+  }
+  if (truncate) {
+    appended_ = 0;
+  }
+  return Status::OK();
+}
+
+}  // namespace vineyard
@@ -0,0 +1,82 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef SRC_SERVER_UTIL_JOURNAL_H_
+#define SRC_SERVER_UTIL_JOURNAL_H_
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "common/util/json.h"
+#include "common/util/status.h"
+
+namespace vineyard {
+
+/**
+ * @brief An append-only journal of json records, backed by a write-ahead log
+ * file `<path>.wal` and a snapshot file `<path>.snapshot`.
+ *
+ * Records are appended to the log one per line and flushed immediately, thus
+ * the journal survives a crash of vineyardd (but not the crash of the host).
+ * `Compact()` atomically replaces the snapshot and truncates the log.
+ *
+ * The journal itself is not thread-safe, callers are responsible for the
+ * synchronization.
+ */
+class Journal {
+ public:
+  explicit Journal(std::string const& path);
+
+  ~Journal();
+
+  /**
+   * @brief Feed every record in the snapshot and then in the log to `fn`.
+   *
+   * A truncated tail in the log (e.g., left by a crash in the middle of a
+   * write) is ignored.
+   */
+  Status Replay(std::function<void(json const&)> const& fn);
+
+  Status Append(json const& record);
+
+  /**
+   * @brief Replace the snapshot with `records`, and truncate the log.
+   */
+  Status Compact(std::vector<json> const& records);
+
+  /**
+   * @brief Remove both the snapshot and the log.
+   */
+  Status Destroy();
+
+  /**
+   * @brief Number of records appended to the log since the last compaction.
+   */
+  size_t Appended() const { return appended_; }
+
+ private:
+  Status openLog(bool const truncate);
+
+  std::string snapshot_path_;
+  std::string log_path_;
+  std::ofstream log_;
+  size_t appended_ = 0;
+};
+
+}  // namespace vineyard
+
+#endif  // SRC_SERVER_UTIL_JOURNAL_H_
@@ -0,0 +1,231 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "server/util/metrics.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace vineyard {
+
+constexpr size_t MetricHistogram::kBuckets;
+
+void MetricHistogram::Observe(double const micros) {
+  size_t index = 0;
+  if (micros > 1) {
+    index = static_cast<size_t>(std::ceil(std::log2(micros)));
+  }
+  if (index > kBuckets) {
+    index = kBuckets;
+  }
+  buckets_[index].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  double sum = sum_.load(std::memory_order_relaxed);
+  while (!sum_.compare_exchange_weak(sum, sum + micros,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+json MetricHistogram::ToJSON() const {
+  json summary;
+  uint64_t total = count();
+  summary["count"] = total;
+  summary["sum_us"] = sum();
+  if (total == 0) {
+    return summary;
+  }
+  summary["mean_us"] = sum() / total;
+  auto percentile = [this, total](double const p) -> double {
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p * total));
+    uint64_t accumulated = 0;
+    for (size_t index = 0; index < kBuckets; ++index) {
+      accumulated += bucket(index);
+      if (accumulated >= rank) {
+        return UpperBound(index);
+      }
+    }
+    return std::numeric_limits<double>::infinity();
+  };
+  summary["p50_us"] = percentile(0.50);
+  summary["p90_us"] = percentile(0.90);
+  summary["p99_us"] = percentile(0.99);
+  return summary;
+}
+
+std::atomic<bool> MetricsRegistry::enabled_{false};
+
+MetricsRegistry& MetricsRegistry::Get() {
+  static MetricsRegistry* registry = new MetricsRegistry();
+  return *registry;
+}
+
+std::string MetricsRegistry::Label(std::string const& key,
+                                   std::string const& value) {
+  std::string label = key + "=\"";
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      label.push_back('\\');
+      label.push_back(c);
+    } else if (c == '\n') {
+      label += "\\n";
+    } else {
+      label.push_back(c);
+    }
+  }
+  label.push_back('"');
+  return label;
+}
+
+MetricCounter* MetricsRegistry::Counter(std::string const& name,
+                                        std::string const& labels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& metric = counters_[name][labels];
+  if (metric == nullptr) {
+    metric.reset(new MetricCounter());
+  }
+  return metric.get();
+}
+
+MetricGauge* MetricsRegistry::Gauge(std::string const& name,
+                                    std::string const& labels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& metric = gauges_[name][labels];
+  if (metric == nullptr) {
+    metric.reset(new MetricGauge());
+  }
+  return metric.get();
+}
+
+MetricHistogram* MetricsRegistry::Histogram(std::string const& name,
+                                            std::string const& labels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& metric = histograms_[name][labels];
+  if (metric == nullptr) {
+    metric.reset(new MetricHistogram());
+  }
+  return metric.get();
+}
+
+void MetricsRegistry::RegisterCollector(
+    std::string const& name, std::string const& labels,
+    std::function<double()> const& collector) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  collectors_[name][labels] = collector;
+}
+
+void MetricsRegistry::UnregisterCollector(std::string const& name,
+                                          std::string const& labels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto family = collectors_.find(name);
+  if (family != collectors_.end()) {
+    family->second.erase(labels);
+    if (family->second.empty()) {
+      collectors_.erase(family);
+    }
+  }
+}
+
+json MetricsRegistry::ToJSON() const {
+  // the labels are used as keys, "" for the unlabeled metric
+  json tree = json::object();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto const& family : counters_) {
+    for (auto const& metric : family.second) {
+      tree[family.first][metric.first] = metric.second->value();
+    }
+  }
+  for (auto const& family : gauges_) {
+    for (auto const& metric : family.second) {
+      tree[family.first][metric.first] = metric.second->value();
+    }
+  }
+  for (auto const& family : collectors_) {
+    for (auto const& metric : family.second) {
+      tree[family.first][metric.first] = metric.second();
+    }
+  }
+  for (auto const& family : histograms_) {
+    for (auto const& metric : family.second) {
+      tree[family.first][metric.first] = metric.second->ToJSON();
+    }
+  }
+  return tree;
+}
+
+namespace {
+
+std::string PrometheusName(std::string const& name,
+                           std::string const& labels) {
+  if (labels.empty()) {
+    return "vineyard_" + name;
+  }
+  return "vineyard_" + name + "{" + labels + "}";
+}
+
+}  // namespace
+
+std::string MetricsRegistry::ToPrometheus() const {
+  std::ostringstream out;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto const& family : counters_) {
+    out << "# TYPE vineyard_" << family.first << " counter\n";
+    for (auto const& metric : family.second) {
+      out << PrometheusName(family.first, metric.first) << " "
+          << metric.second->value() << "\n";
+    }
+  }
+  for (auto const& family : gauges_) {
+    out << "# TYPE vineyard_" << family.first << " gauge\n";
+    for (auto const& metric : family.second) {
+      out << PrometheusName(family.first, metric.first) << " "
+          << metric.second->value() << "\n";
+    }
+  }
+  for (auto const& family : collectors_) {
+    out << "# TYPE vineyard_" << family.first << " gauge\n";
+    for (auto const& metric : family.second) {
+      out << PrometheusName(family.first, metric.first) << " "
+          << metric.second() << "\n";
+    }
+  }
+  for (auto const& family : histograms_) {
+    out << "# TYPE vineyard_" << family.first << " histogram\n";
+    for (auto const& metric : family.second) {
+      std::string const& labels = metric.first;
+      std::string prefix = labels.empty() ? "" : labels + ",";
+      uint64_t accumulated = 0;
+      for (size_t index = 0; index <= MetricHistogram::kBuckets; ++index) {
+        accumulated += metric.second->bucket(index);
+        std::string le =
+            index == MetricHistogram::kBuckets
+                ? "+Inf"
+                : std::to_string(static_cast<uint64_t>(
+                      MetricHistogram::UpperBound(index)));
+        out << PrometheusName(family.first + "_bucket",
+                              prefix + "le=\"" + le + "\"")
+            << " " << accumulated << "\n";
+      }
+      out << PrometheusName(family.first + "_sum", labels) << " "
+          << metric.second->sum() << "\n";
+      out << PrometheusName(family.first + "_count", labels) << " "
+          << metric.second->count() << "\n";
+    }
+  }
+  return out.str();
+}
+
+}  // namespace vineyard
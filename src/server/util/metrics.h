@@ -16,14 +16,190 @@ limitations under the License.
 #ifndef SRC_SERVER_UTIL_METRICS_H_
 #define SRC_SERVER_UTIL_METRICS_H_
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 
 #include "common/util/env.h"
+#include "common/util/json.h"
 #include "common/util/logging.h"
 #include "server/util/spec_resolvers.h"
 
 namespace vineyard {
 
+/**
+ * @brief A monotonically increasing counter.
+ */
+class MetricCounter {
+ public:
+  void Increase(int64_t const delta = 1) {
+    value_.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @brief A value that can go up and down.
+ */
+class MetricGauge {
+ public:
+  void Set(double const value) {
+    value_.store(value, std::memory_order_relaxed);
+  }
+
+  double value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<double> value_{0};
+};
+
+/**
+ * @brief A latency histogram (in microseconds) with exponential buckets, i.e.,
+ * the upper bounds of the buckets are 1us, 2us, 4us, ..., 2^kBuckets-1 us
+ * (~8s) and +Inf, the same layout as prometheus histograms.
+ */
+class MetricHistogram {
+ public:
+  static constexpr size_t kBuckets = 24;
+
+  void Observe(double const micros);
+
+  /**
+   * @brief The summary of the histogram, where the percentiles are estimated
+   * with the upper bounds of buckets.
+   */
+  json ToJSON() const;
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+  double sum() const { return sum_.load(std::memory_order_relaxed); }
+
+  uint64_t bucket(size_t const index) const {
+    return buckets_[index].load(std::memory_order_relaxed);
+  }
+
+  static double UpperBound(size_t const index) {
+    return static_cast<double>(uint64_t{1} << index);
+  }
+
+ private:
+  std::atomic<uint64_t> buckets_[kBuckets + 1] = {};  // the last is +Inf
+  std::atomic<uint64_t> count_{0};
+  std::atomic<double> sum_{0};
+};
+
+/**
+ * @brief The in-process registry of metrics of vineyardd, exported through
+ * the `InstanceStatusRequest` and the prometheus endpoint (`--metrics_port`).
+ *
+ * Metrics are identified by the name and the (prometheus-formatted) labels,
+ * e.g., `command="get_data_request"`. The registered metrics live as long as
+ * the process, thus the returned pointers can be cached by the callers.
+ *
+ * When disabled, the instrumented code paths only pay for a relaxed atomic
+ * load, see also `MetricsRegistry::Enabled()` and the `METRIC_*` macros.
+ */
+class MetricsRegistry {
+ public:
+  static MetricsRegistry& Get();
+
+  static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  static void SetEnabled(bool const enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Format a label pair as `key="value"`.
+   */
+  static std::string Label(std::string const& key, std::string const& value);
+
+  MetricCounter* Counter(std::string const& name,
+                         std::string const& labels = "");
+
+  MetricGauge* Gauge(std::string const& name, std::string const& labels = "");
+
+  MetricHistogram* Histogram(std::string const& name,
+                             std::string const& labels = "");
+
+  /**
+   * @brief Register a gauge that is evaluated when the metrics are exported,
+   * for values that are cheap to compute on demand but expensive to track,
+   * e.g., the fragmentation of the allocator. The callback must not outlive
+   * the objects it refers to, see also `UnregisterCollector()`.
+   */
+  void RegisterCollector(std::string const& name, std::string const& labels,
+                         std::function<double()> const& collector);
+
+  void UnregisterCollector(std::string const& name, std::string const& labels);
+
+  json ToJSON() const;
+
+  /**
+   * @brief Export the metrics in the prometheus text exposition format, all
+   * metric names are prefixed with "vineyard_".
+   */
+  std::string ToPrometheus() const;
+
+ private:
+  MetricsRegistry() = default;
+
+  template <typename T>
+  using family_t = std::map<std::string, std::map<std::string, T>>;
+
+  static std::atomic<bool> enabled_;
+
+  mutable std::mutex mutex_;
+  family_t<std::unique_ptr<MetricCounter>> counters_;
+  family_t<std::unique_ptr<MetricGauge>> gauges_;
+  family_t<std::unique_ptr<MetricHistogram>> histograms_;
+  family_t<std::function<double()>> collectors_;
+};
+
+// The metric of a call site is looked up in the registry once and then
+// cached, thus the name and the labels must be the same every time the call
+// site is reached.
+#ifndef METRIC_COUNTER_INC
+#define METRIC_COUNTER_INC(name, labels, delta)                     \
+  do {                                                              \
+    if (::vineyard::MetricsRegistry::Enabled()) {                   \
+      static ::vineyard::MetricCounter* __metric =                  \
+          ::vineyard::MetricsRegistry::Get().Counter(name, labels); \
+      __metric->Increase(delta);                                    \
+    }                                                               \
+  } while (0)
+#endif
+
+#ifndef METRIC_GAUGE_SET
+#define METRIC_GAUGE_SET(name, labels, value)                     \
+  do {                                                            \
+    if (::vineyard::MetricsRegistry::Enabled()) {                 \
+      static ::vineyard::MetricGauge* __metric =                  \
+          ::vineyard::MetricsRegistry::Get().Gauge(name, labels); \
+      __metric->Set(value);                                       \
+    }                                                             \
+  } while (0)
+#endif
+
+#ifndef METRIC_HISTOGRAM_OBSERVE
+#define METRIC_HISTOGRAM_OBSERVE(name, labels, micros)                \
+  do {                                                                \
+    if (::vineyard::MetricsRegistry::Enabled()) {                     \
+      static ::vineyard::MetricHistogram* __metric =                  \
+          ::vineyard::MetricsRegistry::Get().Histogram(name, labels); \
+      __metric->Observe(micros);                                      \
+    }                                                                 \
+  } while (0)
+#endif
+
 #ifndef LOG_COUNTER
 #define LOG_COUNTER(metric_name, label)                                   \
   do {                                                                    \
@@ -32,16 +32,49 @@ DEFINE_string(meta, "etcd", "Metadata storage, can be one of: etcd, local");
 DEFINE_string(etcd_endpoint, "http://127.0.0.1:2379", "endpoint of etcd");
 DEFINE_string(etcd_prefix, "vineyard", "path prefix in etcd");
 DEFINE_string(etcd_cmd, "", "path of etcd executable");
+DEFINE_int64(meta_group_commit_window, 0,
+             "time window (in microseconds) to wait for more metadata updates "
+             "before committing them to the metadata storage together, "
+             "requests that arrive during a commit are always grouped");
 DEFINE_string(spill_path, "", "path of spilling temporary files");
 DEFINE_double(spill_lower_rate, 0.3, "low watermark of spilling memory");
 DEFINE_double(spill_upper_rate, 0.8, "high watermark of triggering spiling");
+DEFINE_string(compressed_tier_size, "0",
+              "memory of vineyardd to keep the cold blobs compressed in, "
+              "before spilling them to disk, disabled by default");
+
+// warm restart
+DEFINE_string(state_path, "",
+              "directory to keep the journals of shared memory and local "
+              "metadata, to let a restarted vineyardd reattach the blobs and "
+              "objects, disabled by default");
 
 // share memory
 DEFINE_string(size, "256Mi",
               "shared memory size for vineyardd, the format could be 1024M, "
               "1024000, 1G, or 1Gi");
+DEFINE_string(session_reserved_size, "0",
+              "shared memory guaranteed to each session created by clients, "
+              "which is reserved from the memory of vineyardd (--size)");
+DEFINE_string(session_size, "",
+              "maximum shared memory of each session created by clients, "
+              "defaults to the memory of vineyardd (--size)");
 DEFINE_int64(stream_threshold, 80,
              "memory threshold of streams (percentage of total memory)");
+DEFINE_string(hugetlbfs_path, "",
+              "mount point of a hugetlbfs, if set the shared memory is backed "
+              "by explicit huge pages allocated from it");
+DEFINE_bool(transparent_hugepage, false,
+            "advise the kernel to back the shared memory with transparent "
+            "huge pages, ignored when --hugetlbfs_path is set");
+DEFINE_int32(allocator_shards, 0,
+             "number of sub-arenas for small blobs to let concurrent "
+             "allocations scale with the IPC worker threads, disabled by "
+             "default");
+DEFINE_string(numa_arena_size, "0",
+              "size of the sub-arena reserved on each NUMA node for blobs "
+              "created with a NUMA node hint, disabled by default (requires "
+              "the dlmalloc allocator)");
 
 // ipc
 DEFINE_string(socket, "/var/run/vineyard.sock", "IPC socket file location");
@@ -58,6 +91,9 @@ DEFINE_bool(prometheus, false,
             "Whether to print metrics for prometheus or not");
 DEFINE_bool(metrics, false,
             "Alias for --prometheus, and takes precedence over --prometheus");
+DEFINE_int32(metrics_port, 0,
+             "port of the http endpoint that serves the metrics in prometheus "
+             "format (at /metrics), implies --metrics, disabled by default");
 
 const Resolver& Resolver::get(std::string name) {
   static auto server_resolver = ServerSpecResolver();
@@ -90,6 +126,8 @@ json MetaStoreSpecResolver::resolve() const {
   spec["etcd_prefix"] = FLAGS_etcd_prefix;
   spec["etcd_endpoint"] = FLAGS_etcd_endpoint;
   spec["etcd_cmd"] = FLAGS_etcd_cmd;
+  spec["group_commit_window"] = FLAGS_meta_group_commit_window;
+  spec["state_path"] = FLAGS_state_path;
   return spec;
 }
 
@@ -101,6 +139,15 @@ json BulkstoreSpecResolver::resolve() const {
   spec["spill_path"] = FLAGS_spill_path;
   spec["spill_lower_bound_rate"] = FLAGS_spill_lower_rate;
   spec["spill_upper_bound_rate"] = FLAGS_spill_upper_rate;
+  spec["compressed_tier_size"] = parseMemoryLimit(FLAGS_compressed_tier_size);
+  spec["state_path"] = FLAGS_state_path;
+  spec["hugetlbfs_path"] = FLAGS_hugetlbfs_path;
+  spec["transparent_hugepage"] = FLAGS_transparent_hugepage;
+  spec["numa_arena_size"] = parseMemoryLimit(FLAGS_numa_arena_size);
+  spec["allocator_shards"] = FLAGS_allocator_shards;
+  spec["session_reserved_size"] = parseMemoryLimit(FLAGS_session_reserved_size);
+  spec["session_size"] =
+      FLAGS_session_size.empty() ? 0 : parseMemoryLimit(FLAGS_session_size);
   return spec;
 }
 
@@ -169,6 +216,7 @@ json ServerSpecResolver::resolve() const {
   spec["bulkstore_spec"] = Resolver::get("bulkstore").resolve();
   spec["ipc_spec"] = Resolver::get("ipcserver").resolve();
   spec["rpc_spec"] = Resolver::get("rpcserver").resolve();
+  spec["metrics_port"] = FLAGS_metrics_port;
   return spec;
 }
 
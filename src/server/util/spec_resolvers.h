@@ -26,6 +26,8 @@ namespace vineyard {
 // Whether to print metrics for prometheus or not, default value is false.
 DECLARE_bool(prometheus);
 DECLARE_bool(metrics);
+// The port of the http endpoint that serves the metrics in prometheus format.
+DECLARE_int32(metrics_port);
 
 /**
  * @brief Resolver is the base class of different kinds of
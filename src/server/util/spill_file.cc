@@ -101,9 +101,10 @@ Status SpillReadFile::Read(std::shared_ptr<Payload>& payload,
                              std::to_string(payload->object_id));
     }
   }
+  // back to the NUMA node where the blob was placed, if any
   payload->pointer = bulk_store_ptr->AllocateMemoryWithSpill(
       payload->data_size, &payload->store_fd, &payload->map_size,
-      &payload->data_offset);
+      &payload->data_offset, &payload->numa_node);
   if (payload->pointer == nullptr) {
     return Status::NotEnoughMemory("Failed to allocate memory of size " +
                                    std::to_string(payload->data_size) +
@@ -30,6 +30,7 @@ limitations under the License.
 #include "common/util/logging.h"
 #include "common/util/version.h"
 #include "server/server/vineyard_runner.h"
+#include "server/util/metrics.h"
 #include "server/util/spec_resolvers.h"
 
 DECLARE_bool(help);
@@ -87,6 +88,8 @@ int main(int argc, char* argv[]) {
   if (vineyard::FLAGS_metrics) {
     vineyard::FLAGS_prometheus = true;
   }
+  vineyard::MetricsRegistry::SetEnabled(vineyard::FLAGS_prometheus ||
+                                        vineyard::FLAGS_metrics_port > 0);
 
   LOG(INFO) << "Hello vineyard v" << vineyard::vineyard_version() << "!";
 
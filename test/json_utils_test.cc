@@ -14,8 +14,10 @@ limitations under the License.
 */
 
 #include <memory>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "basic/ds/types.h"
 #include "common/util/json.h"
@@ -62,5 +64,51 @@ int main(int argc, char** argv) {
 
   LOG(INFO) << "Passed IdType in json tests...";
 
+  // large containers use the compact encoding, when enabled
+  std::vector<int64_t> value6;
+  std::set<uint32_t> value7;
+  std::vector<double> value8;
+  for (size_t i = 0; i < kCompactContainerThreshold * 4; ++i) {
+    value6.emplace_back(static_cast<int64_t>(i * i) - 1024);
+    value7.emplace(static_cast<uint32_t>(i * 7));
+    value8.emplace_back(static_cast<double>(i) / 3.0);
+  }
+  put_container(tree, "value6", value6);
+  CHECK_EQ(tree["value6"].get_ref<std::string const&>().rfind("[", 0), 0);
+
+  set_compact_container_encoding(true);
+  put_container(tree, "value6", value6);
+  put_container(tree, "value7", value7);
+  put_container(tree, "value8", value8);
+  set_compact_container_encoding(false);
+  CHECK_EQ(tree["value6"].get_ref<std::string const&>().rfind("base64:", 0),
+           0);
+  CHECK_LT(tree["value6"].get_ref<std::string const&>().size(),
+           json_to_string(json(value6)).size());
+
+  std::vector<int64_t> value6_get;
+  std::set<uint32_t> value7_get;
+  std::vector<double> value8_get;
+  get_container(tree, "value6", value6_get);
+  get_container(tree, "value7", value7_get);
+  get_container(tree, "value8", value8_get);
+  CHECK(value6 == value6_get);
+  CHECK(value7 == value7_get);
+  CHECK(value8 == value8_get);
+
+  // the value type can be converted when decoding
+  std::vector<uint64_t> value7_as_uint64;
+  get_container(tree, "value7", value7_as_uint64);
+  CHECK_EQ(value7_as_uint64.size(), value7.size());
+  CHECK_EQ(value7_as_uint64.back(), *value7.rbegin());
+
+  // the json array encoding is still accepted
+  tree["value9"] = json_to_string(json(value6));
+  std::vector<int64_t> value9_get;
+  get_container(tree, "value9", value9_get);
+  CHECK(value6 == value9_get);
+
+  LOG(INFO) << "Passed compact containers in json tests...";
+
   return 0;
 }
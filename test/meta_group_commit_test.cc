@@ -0,0 +1,156 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "basic/ds/array.h"
+#include "basic/ds/sequence.h"
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+#include "common/util/typename.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+constexpr int kWorkers = 8;
+constexpr int kPersistsPerWorker = 16;
+// far more ops than a single etcd transaction can take (127)
+constexpr size_t kLargeSequenceSize = 160;
+
+std::shared_ptr<Array<double>> CreateArray(Client& client, double value) {
+  std::vector<double> double_array = {1.0, value};
+  ArrayBuilder<double> builder(client, double_array);
+  return std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+}
+
+// waits until the object has been synced to the other instance, i.e., it has
+// been committed to etcd
+ObjectMeta WaitRemote(Client& client, ObjectID const id) {
+  ObjectMeta meta;
+  for (int retries = 0; retries < 100; ++retries) {
+    if (client.GetMetaData(id, meta, true, true).ok()) {
+      return meta;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  LOG(FATAL) << "The object " << ObjectIDToString(id)
+             << " isn't visible on the other instance";
+  return meta;
+}
+
+// The test runs against two vineyardd instances on the same etcd, with the
+// `--metrics_port` on the first one.
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf(
+        "usage ./meta_group_commit_test <ipc_socket> <other_ipc_socket> "
+        "[window]");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  std::string other_ipc_socket = std::string(argv[2]);
+  // with `--meta_group_commit_window`, the concurrent requests must be
+  // grouped
+  bool with_window = argc > 3 && std::string(argv[3]) == "window";
+
+  std::vector<std::vector<ObjectID>> persisted(kWorkers);
+  ObjectID large_id = InvalidObjectID();
+  std::vector<std::thread> threads;
+  for (int worker = 0; worker < kWorkers; ++worker) {
+    threads.emplace_back([&, worker]() {
+      Client client;
+      VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+      for (int index = 0; index < kPersistsPerWorker; ++index) {
+        auto array = CreateArray(client, worker * kPersistsPerWorker + index);
+        VINEYARD_CHECK_OK(client.Persist(array->id()));
+        persisted[worker].emplace_back(array->id());
+      }
+      client.Disconnect();
+    });
+  }
+  // a request that exceeds the txn ops limit, committed alone in many
+  // transactions, while the others are being grouped
+  threads.emplace_back([&]() {
+    Client client;
+    VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+    SequenceBuilder builder(client);
+    builder.SetSize(kLargeSequenceSize);
+    for (size_t index = 0; index < kLargeSequenceSize; ++index) {
+      std::vector<double> double_array = {2.0, static_cast<double>(index)};
+      builder.SetValue(
+          index, std::make_shared<ArrayBuilder<double>>(client, double_array));
+    }
+    auto sequence = builder.Seal(client);
+    VINEYARD_CHECK_OK(client.Persist(sequence->id()));
+    large_id = sequence->id();
+    client.Disconnect();
+  });
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  Client client, other_client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  VINEYARD_CHECK_OK(other_client.Connect(other_ipc_socket));
+  for (auto const& ids : persisted) {
+    CHECK_EQ(ids.size(), kPersistsPerWorker);
+    for (auto const& id : ids) {
+      bool persist = false;
+      VINEYARD_CHECK_OK(client.IfPersist(id, persist));
+      CHECK(persist);
+      auto meta = WaitRemote(other_client, id);
+      CHECK_EQ(meta.GetTypeName(), type_name<Array<double>>());
+    }
+  }
+  LOG(INFO) << "Passed concurrent persist test...";
+
+  {
+    auto meta = WaitRemote(other_client, large_id);
+    CHECK_EQ(meta.GetTypeName(), type_name<Sequence>());
+    CHECK_EQ(meta.GetKeyValue<size_t>("size_"), kLargeSequenceSize);
+    // the members are committed by the last transactions
+    for (size_t index = 0; index < kLargeSequenceSize; ++index) {
+      auto member = meta.GetMemberMeta("__elements_-" + std::to_string(index));
+      CHECK_EQ(member.GetTypeName(), type_name<Array<double>>());
+    }
+    LOG(INFO) << "Passed large persist test...";
+  }
+
+  {
+    size_t requests = kWorkers * kPersistsPerWorker + 1;
+    std::shared_ptr<InstanceStatus> status;
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    auto const& batches =
+        status->metrics.at("meta_group_commit_batch_size").at("");
+    // the histogram observes the number of requests of each batch
+    CHECK_GE(batches.at("sum_us").get<double>(), requests);
+    if (with_window) {
+      CHECK_LT(batches.at("count").get<size_t>(), requests);
+    }
+    LOG(INFO) << "Passed group commit batches test: "
+              << batches.at("count").get<size_t>() << " batches";
+  }
+
+  LOG(INFO) << "Passed meta group commit tests...";
+
+  client.Disconnect();
+  other_client.Disconnect();
+
+  return 0;
+}
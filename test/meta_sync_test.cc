@@ -0,0 +1,155 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "basic/ds/array.h"
+#include "basic/ds/sequence.h"
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+#include "common/util/typename.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+// the updates are synced through the watch of etcd, in the background
+void WaitFor(std::function<bool()> const& predicate, std::string const& what) {
+  for (int retries = 0; retries < 100; ++retries) {
+    if (predicate()) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  LOG(FATAL) << "Timeout waiting for " << what;
+}
+
+bool Exists(Client& client, ObjectID const id) {
+  ObjectMeta meta;
+  // never sync explicitly, the update must come from the watch
+  return client.GetMetaData(id, meta, false, true).ok();
+}
+
+int64_t SyncRevision(Client& client) {
+  std::shared_ptr<InstanceStatus> status;
+  VINEYARD_CHECK_OK(client.InstanceStatus(status));
+  return status->metrics.at("meta_sync_revision").at("").get<int64_t>();
+}
+
+size_t MemoryUsage(Client& client) {
+  std::shared_ptr<InstanceStatus> status;
+  VINEYARD_CHECK_OK(client.InstanceStatus(status));
+  return status->memory_usage;
+}
+
+// The test runs against two vineyardd instances on the same etcd, with the
+// `--metrics_port` on the second one.
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf("usage ./meta_sync_test <ipc_socket> <other_ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  std::string other_ipc_socket = std::string(argv[2]);
+
+  Client client, other_client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  VINEYARD_CHECK_OK(other_client.Connect(other_ipc_socket));
+  LOG(INFO) << "Connected to IPCServers: " << ipc_socket << ", "
+            << other_ipc_socket;
+
+  {  // a remote put, of nested key paths
+    int64_t revision = SyncRevision(other_client);
+
+    SequenceBuilder builder(client);
+    builder.SetSize(3);
+    for (size_t index = 0; index < 3; ++index) {
+      std::vector<double> double_array = {1.0, static_cast<double>(index)};
+      builder.SetValue(
+          index, std::make_shared<ArrayBuilder<double>>(client, double_array));
+    }
+    auto sequence = builder.Seal(client);
+    VINEYARD_CHECK_OK(client.Persist(sequence->id()));
+    std::string name = "meta_sync_test_" + ObjectIDToString(sequence->id());
+    VINEYARD_CHECK_OK(client.PutName(sequence->id(), name));
+
+    ObjectID id = sequence->id();
+    WaitFor([&]() { return Exists(other_client, id); }, "the remote put");
+    ObjectMeta meta;
+    VINEYARD_CHECK_OK(other_client.GetMetaData(id, meta, false, true));
+    CHECK_EQ(meta.GetTypeName(), type_name<Sequence>());
+    CHECK_EQ(meta.GetKeyValue<size_t>("size_"), 3);
+    CHECK(!meta.IsLocal());
+    for (size_t index = 0; index < 3; ++index) {
+      auto member = meta.GetMemberMeta("__elements_-" + std::to_string(index));
+      CHECK_EQ(member.GetTypeName(), type_name<Array<double>>());
+      CHECK_EQ(member.GetKeyValue<size_t>("size_"), 2);
+    }
+    ObjectID named = InvalidObjectID();
+    WaitFor([&]() { return other_client.GetName(name, named).ok(); },
+            "the remote name");
+    CHECK_EQ(named, id);
+    CHECK_GT(SyncRevision(other_client), revision);
+    LOG(INFO) << "Passed remote put test...";
+
+    // a remote delete, of the object and all its members
+    revision = SyncRevision(other_client);
+    VINEYARD_CHECK_OK(client.DelData(id, true, true));
+    WaitFor([&]() { return !Exists(other_client, id); }, "the remote delete");
+    for (size_t index = 0; index < 3; ++index) {
+      auto member = meta.GetMemberMeta("__elements_-" + std::to_string(index));
+      CHECK(!Exists(other_client, member.GetId()));
+    }
+    CHECK_GT(SyncRevision(other_client), revision);
+    LOG(INFO) << "Passed remote delete test...";
+  }
+
+  {  // the local blobs of an object deleted by the other instance
+    std::vector<double> double_array(1024 * 1024, 1.0);
+    size_t const array_bytes = double_array.size() * sizeof(double);
+    size_t usage = MemoryUsage(other_client);
+    ObjectID id = InvalidObjectID();
+    {
+      Client creator;
+      VINEYARD_CHECK_OK(creator.Connect(other_ipc_socket));
+      ArrayBuilder<double> builder(creator, double_array);
+      auto array = builder.Seal(creator);
+      VINEYARD_CHECK_OK(creator.Persist(array->id()));
+      id = array->id();
+      // drops the references to the blob
+      creator.Disconnect();
+    }
+    CHECK_GE(MemoryUsage(other_client), usage + array_bytes);
+
+    WaitFor([&]() { return Exists(client, id); }, "the remote put");
+    VINEYARD_CHECK_OK(client.DelData(id, true, true));
+    // the blob is freed by the other instance once the delete is synced
+    WaitFor([&]() { return MemoryUsage(other_client) < usage + array_bytes; },
+            "the blob to be deleted");
+    CHECK(!Exists(other_client, id));
+    LOG(INFO) << "Passed remote blob deletion test...";
+  }
+
+  LOG(INFO) << "Passed meta sync tests...";
+
+  client.Disconnect();
+  other_client.Disconnect();
+
+  return 0;
+}
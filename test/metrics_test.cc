@@ -0,0 +1,141 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "basic/ds/array.h"
+#include "client/client.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+// the blob of the array
+ObjectID BufferOf(const std::shared_ptr<Array<double>>& array) {
+  return ObjectIDFromString(array->meta()
+                                .MetaData()["buffer_"]["id"]
+                                .get_ref<std::string const&>());
+}
+
+std::shared_ptr<Array<double>> CreateColdArray(Client& client) {
+  std::vector<double> double_array(200, 1.0);
+  ArrayBuilder<double> builder(client, double_array);
+  auto array = std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+  VINEYARD_CHECK_OK(client.Release({array->id(), BufferOf(array)}));
+  return array;
+}
+
+// sends `GET /metrics` and returns the response, including the headers
+std::string Scrape(int const port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  CHECK_GE(fd, 0);
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = inet_addr("127.0.0.1");
+  CHECK_EQ(connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                   sizeof(address)),
+           0);
+  std::string request =
+      "GET /metrics HTTP/1.1\r\nHost: localhost\r\nAccept: */*\r\n\r\n";
+  CHECK_EQ(write(fd, request.data(), request.size()),
+           static_cast<ssize_t>(request.size()));
+  // the server closes the connection after the response
+  std::string response;
+  char buffer[4096];
+  ssize_t nread = 0;
+  while ((nread = read(fd, buffer, sizeof(buffer))) > 0) {
+    response.append(buffer, nread);
+  }
+  close(fd);
+  return response;
+}
+
+bool HasLine(std::string const& text, std::string const& prefix) {
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, prefix.size(), prefix) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// The test runs against a vineyardd with a small memory, the `--spill_path`
+// and the `--metrics_port`.
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf("usage ./metrics_test <ipc_socket> <metrics_port>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  int metrics_port = std::stoi(argv[2]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  // the second array spills the first, which is then reloaded
+  auto array = CreateColdArray(client);
+  CreateColdArray(client);
+  bool is_spilled = false;
+  VINEYARD_CHECK_OK(client.IsSpilled(BufferOf(array), is_spilled));
+  CHECK(is_spilled);
+  auto reloaded = client.GetObject<Array<double>>(array->id());
+  CHECK_EQ((*reloaded)[0], 1.0);
+
+  {
+    std::shared_ptr<InstanceStatus> status;
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    auto const& metrics = status->metrics;
+    CHECK_GE(metrics.at("spilled_objects_total").at("").get<int64_t>(), 1);
+    CHECK_GE(metrics.at("reloaded_objects_total").at("").get<int64_t>(), 1);
+    std::string label = "command=\"create_buffer_request\"";
+    auto const& latency = metrics.at("request_duration_microseconds").at(label);
+    CHECK_GE(latency.at("count").get<int64_t>(), 2);
+    CHECK(latency.contains("p99_us"));
+    LOG(INFO) << "Passed metrics in instance status...";
+  }
+
+  {
+    std::string response = Scrape(metrics_port);
+    CHECK(HasLine(response, "HTTP/1.1 200 OK"));
+    CHECK(HasLine(response, "# TYPE vineyard_spilled_objects_total counter"));
+    CHECK(HasLine(response, "vineyard_spilled_objects_total "));
+    CHECK(HasLine(response,
+                  "# TYPE vineyard_request_duration_microseconds histogram"));
+    std::string series = "vineyard_request_duration_microseconds";
+    std::string label = "command=\"create_buffer_request\"";
+    CHECK(HasLine(response, series + "_bucket{" + label + ",le=\"1\"} "));
+    CHECK(HasLine(response, series + "_bucket{" + label + ",le=\"+Inf\"} "));
+    CHECK(HasLine(response, series + "_sum{" + label + "} "));
+    CHECK(HasLine(response, series + "_count{" + label + "} "));
+    LOG(INFO) << "Passed metrics on the prometheus endpoint...";
+  }
+
+  LOG(INFO) << "Passed metrics test...";
+
+  client.Disconnect();
+
+  return 0;
+}
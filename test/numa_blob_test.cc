@@ -0,0 +1,86 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+// the number of NUMA nodes, e.g., "0-1" in /sys/devices/system/node/online
+int NumaNodeCount() {
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string nodes;
+  if (online.is_open() && std::getline(online, nodes) && !nodes.empty()) {
+    auto sep = nodes.find_last_of("-,");
+    return std::stoi(sep == std::string::npos ? nodes
+                                              : nodes.substr(sep + 1)) +
+           1;
+  }
+  return 1;
+}
+
+std::shared_ptr<Blob> CreateBlob(Client& client, int node) {
+  std::unique_ptr<BlobWriter> blob_writer;
+  VINEYARD_CHECK_OK(client.CreateBlob(4096, node, blob_writer));
+  memset(blob_writer->data(), 'x', blob_writer->size());
+  blob_writer->Seal(client);
+
+  std::shared_ptr<Blob> blob;
+  VINEYARD_CHECK_OK(client.GetBlob(blob_writer->id(), blob));
+  CHECK_EQ(blob->allocated_size(), 4096);
+  CHECK_EQ(blob->data()[4095], 'x');
+  CHECK_EQ(blob->numa_node(), blob_writer->numa_node());
+  LOG(INFO) << "blob " << ObjectIDToString(blob->id()) << " with hint " << node
+            << " is placed on NUMA node " << blob->numa_node();
+  return blob;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./numa_blob_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  // the blobs without a (valid) hint are not placed on a specific node
+  CHECK_EQ(CreateBlob(client, -1)->numa_node(), -1);
+  CHECK_EQ(CreateBlob(client, 1024)->numa_node(), -1);
+
+  int nodes = NumaNodeCount();
+  if (nodes <= 1) {
+    LOG(INFO) << "Skipped the placement checks of numa blob test, as there is "
+                 "only one NUMA node";
+  } else {
+    for (int node = 0; node < nodes; ++node) {
+      CHECK_EQ(CreateBlob(client, node)->numa_node(), node);
+    }
+  }
+
+  LOG(INFO) << "Passed numa blob test ...";
+
+  client.Disconnect();
+
+  return 0;
+}
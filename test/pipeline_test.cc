@@ -0,0 +1,137 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "basic/ds/scalar.h"
+#include "client/client.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./pipeline_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  CHECK(!client.Pipelined());
+  VINEYARD_CHECK_OK(client.EnablePipelining());
+  CHECK(client.Pipelined());
+
+  const int object_count = 32;
+  std::vector<ObjectID> ids;
+  for (int i = 0; i < object_count; ++i) {
+    ScalarBuilder<int32_t> scalar_builder(client);
+    scalar_builder.SetValue(i);
+    ids.emplace_back(scalar_builder.Seal(client)->id());
+  }
+
+  // many requests in flight
+  {
+    std::atomic<int> finished{0};
+    std::promise<void> done;
+    for (auto const& id : ids) {
+      client.GetDataAsync(
+          id, false, false,
+          [&, id](const Status& status, const json& tree) {
+            VINEYARD_CHECK_OK(status);
+            CHECK_EQ(ObjectIDFromString(tree["id"].get<std::string>()), id);
+            if (finished.fetch_add(1) + 1 == object_count) {
+              done.set_value();
+            }
+            return Status::OK();
+          });
+    }
+    done.get_future().wait();
+    LOG(INFO) << "Passed async get data test...";
+  }
+
+  // replies arrive out of order: the blocking get-name doesn't hold back the
+  // requests behind it
+  {
+    VINEYARD_CHECK_OK(client.Persist(ids[0]));
+    std::promise<ObjectID> named;
+    client.GetNameAsync("pipeline_test_name", true,
+                        [&](const Status& status, const ObjectID id) {
+                          VINEYARD_CHECK_OK(status);
+                          named.set_value(id);
+                          return Status::OK();
+                        });
+    std::promise<bool> exists;
+    client.ExistsAsync(ids[1], [&](const Status& status, const bool result) {
+      VINEYARD_CHECK_OK(status);
+      exists.set_value(result);
+      return Status::OK();
+    });
+    CHECK(exists.get_future().get());
+
+    VINEYARD_CHECK_OK(client.PutName(ids[0], "pipeline_test_name"));
+    CHECK_EQ(named.get_future().get(), ids[0]);
+    VINEYARD_CHECK_OK(client.DropName("pipeline_test_name"));
+    LOG(INFO) << "Passed out-of-order reply test...";
+  }
+
+  // the synchronous API from many threads
+  {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+      threads.emplace_back([&]() {
+        for (auto const& id : ids) {
+          bool exists = false;
+          VINEYARD_CHECK_OK(client.Exists(id, exists));
+          CHECK(exists);
+          ObjectMeta meta;
+          VINEYARD_CHECK_OK(client.GetMetaData(id, meta));
+          CHECK_EQ(meta.GetId(), id);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    LOG(INFO) << "Passed concurrent synchronous requests test...";
+  }
+
+  // errors are delivered to the callbacks
+  {
+    std::promise<Status> failed;
+    client.PutNameAsync(GenerateObjectID(), "pipeline_test_name",
+                        [&](const Status& status) {
+                          failed.set_value(status);
+                          return Status::OK();
+                        });
+    CHECK(failed.get_future().get().IsObjectNotExists());
+  }
+
+  VINEYARD_CHECK_OK(client.DelData(ids, true, true));
+
+  client.Disconnect();
+  CHECK(!client.Pipelined());
+
+  LOG(INFO) << "Passed pipeline test...";
+
+  return 0;
+}
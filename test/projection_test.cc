@@ -0,0 +1,114 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "basic/ds/array.h"
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "client/ds/object_meta.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./projection_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  std::vector<double> first = {1.0, 7.0, 3.0, 4.0, 2.0};
+  std::vector<double> second = {5.0, 6.0};
+  ArrayBuilder<double> first_builder(client, first);
+  ArrayBuilder<double> second_builder(client, second);
+  auto first_array = first_builder.Seal(client);
+  auto second_array = second_builder.Seal(client);
+
+  ObjectMeta pair_meta;
+  pair_meta.SetTypeName("vineyard::ProjectionTestPair");
+  pair_meta.AddMember("first_", first_array);
+  pair_meta.AddMember("second_", second_array);
+  pair_meta.SetNBytes(first_array->nbytes() + second_array->nbytes());
+  ObjectID id = InvalidObjectID();
+  VINEYARD_CHECK_OK(client.CreateMetaData(pair_meta, id));
+
+  auto blob_of = [](std::shared_ptr<Object> const& array) {
+    return array->meta().GetMemberMeta("buffer_").GetId();
+  };
+
+  // projection: only the blobs of the projected members are mapped
+  {
+    std::vector<ObjectMeta> members;
+    VINEYARD_CHECK_OK(client.GetMetaData(id, {"second_"}, members));
+    CHECK_EQ(members.size(), 1);
+    CHECK_EQ(members[0].GetId(), second_array->id());
+    std::shared_ptr<arrow::Buffer> buffer;
+    VINEYARD_CHECK_OK(members[0].GetBuffer(blob_of(second_array), buffer));
+    CHECK(buffer != nullptr);
+
+    std::vector<std::shared_ptr<Object>> objects;
+    VINEYARD_CHECK_OK(client.GetObject(id, {"first_", ""}, objects));
+    CHECK_EQ(objects.size(), 2);
+    auto array = std::dynamic_pointer_cast<Array<double>>(objects[0]);
+    CHECK(array != nullptr);
+    CHECK_EQ(array->size(), first.size());
+    for (size_t i = 0; i < first.size(); ++i) {
+      CHECK_EQ((*array)[i], first[i]);
+    }
+    CHECK_EQ(objects[1]->id(), id);
+
+    CHECK(client.GetMetaData(id, {"first_/no_such_member"}, members)
+              .IsInvalid());
+    LOG(INFO) << "Passed projection tests...";
+  }
+
+  // lazy: the blobs are mapped on the first access
+  {
+    ObjectMeta meta;
+    VINEYARD_CHECK_OK(client.GetMetaData(id, meta, false, true));
+    CHECK(meta.lazy());
+    for (auto const& item : meta.GetBufferSet()->AllBuffers()) {
+      CHECK(item.second == nullptr);
+    }
+
+    auto array = std::dynamic_pointer_cast<Array<double>>(
+        meta.GetMember("second_"));
+    CHECK(array != nullptr);
+    CHECK_EQ(array->size(), second.size());
+    for (size_t i = 0; i < second.size(); ++i) {
+      CHECK_EQ((*array)[i], second[i]);
+    }
+
+    std::shared_ptr<arrow::Buffer> buffer;
+    VINEYARD_CHECK_OK(meta.GetBuffer(blob_of(first_array), buffer));
+    CHECK(buffer != nullptr);
+    LOG(INFO) << "Passed lazy metadata tests...";
+  }
+
+  VINEYARD_CHECK_OK(client.DelData(id, true, true));
+
+  LOG(INFO) << "Passed projection test...";
+
+  client.Disconnect();
+
+  return 0;
+}
@@ -118,6 +118,10 @@ def start_vineyardd(
     spill_path="",
     spill_upper_rate=0.8,
     spill_lower_rate=0.3,
+    compressed_tier_size=0,
+    numa_arena_size=0,
+    meta='etcd',
+    state_path='',
     **kw,
 ):
     rpc_socket_port = find_port()
@@ -144,6 +148,14 @@ def start_vineyardd(
             str(spill_lower_rate),
             '--spill_upper_rate',
             str(spill_upper_rate),
+            '--compressed_tier_size',
+            str(compressed_tier_size),
+            '--numa_arena_size',
+            str(numa_arena_size),
+            '--meta',
+            meta,
+            '--state_path',
+            state_path,
             verbose=True,
             **kw,
         )
@@ -351,6 +363,8 @@ def run_single_vineyardd_tests(tests):
         run_test(tests, 'mutable_blob_test')
         run_test(tests, 'name_test')
         run_test(tests, 'persist_test')
+        run_test(tests, 'pipeline_test')
+        run_test(tests, 'projection_test')
         run_test(tests, 'plasma_test')
         run_test(tests, 'release_test')
         run_test(tests, 'remote_buffer_test', '127.0.0.1:%d' % rpc_socket_port)
@@ -361,7 +375,9 @@ def run_single_vineyardd_tests(tests):
         run_test(tests, 'sequence_test')
         run_test(tests, 'server_status_test')
         run_test(tests, 'session_test')
+        run_test(tests, 'session_quota_test')
         run_test(tests, 'signature_test')
+        run_test(tests, 'snapshot_test')
         run_test(tests, 'shallow_copy_test')
         run_test(tests, 'shared_memory_test')
         run_test(tests, 'stream_test')
@@ -380,6 +396,111 @@ def run_single_vineyardd_tests(tests):
         spill_path='/tmp/spill_path',
     ):
         run_test(tests, 'spill_test')
+    # the sessions borrow the idle reservations, and spill to give them back
+    with start_vineyardd(
+        'http://localhost:%d' % etcd_port,
+        'vineyard_test_%s' % time.time(),
+        256 * 1024 * 1024,
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        spill_path='/tmp/spill_path',
+    ):
+        run_test(tests, 'session_quota_test', 'reclaim')
+    # exports the metrics through the instance status and the prometheus
+    # endpoint
+    metrics_port = find_port()
+    with start_vineyardd(
+        'http://localhost:%d' % etcd_port,
+        'vineyard_test_%s' % time.time(),
+        2048,
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        spill_path='/tmp/spill_path',
+        metrics_port=metrics_port,
+    ):
+        run_test(tests, 'metrics_test', metrics_port)
+    # exercises the per-node sub-arenas
+    with start_vineyardd(
+        'http://localhost:%d' % etcd_port,
+        'vineyard_test_%s' % time.time(),
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        numa_arena_size=64 * 1024 * 1024,
+    ):
+        run_test(tests, 'numa_blob_test')
+    # the cold blobs that compress well are kept in the compressed tier
+    with start_vineyardd(
+        'http://localhost:%d' % etcd_port,
+        'vineyard_test_%s' % time.time(),
+        2048,
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        spill_path='/tmp/spill_path',
+        compressed_tier_size=1024 * 1024,
+    ):
+        # checks that blobs are compressed into, and restored from, the tier
+        run_test(tests, 'spill_test', 'compressed')
+
+    # concurrent persist requests are committed in batches, with or without
+    # the group commit window
+    for window in [0, 20000]:
+        etcd_prefix = 'vineyard_test_%s' % time.time()
+        metrics_port = find_port()
+        with start_vineyardd(
+            'http://localhost:%d' % etcd_port,
+            etcd_prefix,
+            default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+            idx=0,
+            meta_group_commit_window=window,
+            metrics_port=metrics_port,
+        ), start_vineyardd(
+            'http://localhost:%d' % etcd_port,
+            etcd_prefix,
+            default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+            idx=1,
+        ):
+            run_test(
+                tests,
+                'meta_group_commit_test',
+                '%s.1' % VINEYARD_CI_IPC_SOCKET,
+                'window' if window > 0 else 'no-window',
+                vineyard_ipc_socket='%s.0' % VINEYARD_CI_IPC_SOCKET,
+            )
+
+    # the updates of the other instance are synced incrementally
+    etcd_prefix = 'vineyard_test_%s' % time.time()
+    with start_vineyardd(
+        'http://localhost:%d' % etcd_port,
+        etcd_prefix,
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        idx=0,
+    ), start_vineyardd(
+        'http://localhost:%d' % etcd_port,
+        etcd_prefix,
+        default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+        idx=1,
+        metrics_port=find_port(),
+    ):
+        run_test(
+            tests,
+            'meta_sync_test',
+            '%s.1' % VINEYARD_CI_IPC_SOCKET,
+            vineyard_ipc_socket='%s.0' % VINEYARD_CI_IPC_SOCKET,
+        )
+
+    # restart vineyardd between the two phases, stopped gracefully (SIGTERM)
+    # or killed (SIGKILL)
+    for kill in [False, True]:
+        state_path = '/tmp/vineyard_state_%s' % time.time()
+        os.makedirs(state_path, exist_ok=True)
+        for phase in ['put', 'get']:
+            with start_vineyardd(
+                'http://localhost:%d' % etcd_port,
+                'vineyard_test_%s' % time.time(),
+                default_ipc_socket=VINEYARD_CI_IPC_SOCKET,
+                meta='local',
+                state_path=state_path,
+            ) as (proc, _):
+                run_test(tests, 'warm_restart_test', phase)
+                if kill and phase == 'put':
+                    proc.kill()
+                    proc.wait()
 
 
 def run_scale_in_out_tests(etcd_endpoints, instance_size=4):
@@ -0,0 +1,155 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "client/client.h"
+#include "client/ds/blob.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+constexpr size_t kMiB = 1024 * 1024;
+
+// session A borrows the idle reservation of session B, and gives it back by
+// spilling its cold blobs once B allocates into the reservation.
+void TestReclaim(std::string const& ipc_socket) {
+  Client client_a, client_b;
+  VINEYARD_CHECK_OK(client_b.Open(ipc_socket, 128 * kMiB, 128 * kMiB));
+  VINEYARD_CHECK_OK(client_a.Open(ipc_socket, 32 * kMiB, 256 * kMiB));
+
+  // 160MiB: 32MiB of its own, the 96MiB unreserved, and 32MiB borrowed from
+  // the reservation of B
+  std::vector<ObjectID> blobs_a;
+  for (int i = 0; i < 10; ++i) {
+    std::unique_ptr<BlobWriter> blob;
+    VINEYARD_CHECK_OK(client_a.CreateBlob(16 * kMiB, blob));
+    blobs_a.emplace_back(blob->id());
+    blob->Seal(client_a);
+  }
+  std::shared_ptr<InstanceStatus> status;
+  VINEYARD_CHECK_OK(client_a.InstanceStatus(status));
+  CHECK_EQ(status->memory_usage, 160 * kMiB);
+  // the blobs of A become cold
+  VINEYARD_CHECK_OK(client_a.Release(blobs_a));
+
+  // 88MiB fit in the free shared memory, the last 12MiB (in the reservation
+  // of B) don't and are reclaimed from A
+  for (int i = 0; i < 11; ++i) {
+    std::unique_ptr<BlobWriter> blob;
+    VINEYARD_CHECK_OK(client_b.CreateBlob(8 * kMiB, blob));
+    blob->Seal(client_b);
+  }
+  std::unique_ptr<BlobWriter> blob;
+  VINEYARD_CHECK_OK(client_b.CreateBlob(12 * kMiB, blob));
+  VINEYARD_CHECK_OK(client_b.InstanceStatus(status));
+  CHECK_EQ(status->memory_usage, 100 * kMiB);
+
+  size_t spilled = 0;
+  for (auto const& id : blobs_a) {
+    bool is_spilled = false;
+    VINEYARD_CHECK_OK(client_a.IsSpilled(id, is_spilled));
+    spilled += is_spilled ? 1 : 0;
+  }
+  CHECK_GE(spilled, 1);
+  VINEYARD_CHECK_OK(client_a.InstanceStatus(status));
+  CHECK_EQ(status->memory_usage, (10 - spilled) * 16 * kMiB);
+  LOG(INFO) << "Passed session reclaim test...";
+
+  client_a.CloseSession();
+  client_b.CloseSession();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./session_quota_test <ipc_socket> [reclaim]");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  if (argc > 2 && std::string(argv[2]) == "reclaim") {
+    // requires a vineyardd of 256MiB with spilling enabled
+    TestReclaim(ipc_socket);
+    LOG(INFO) << "Passed session reclaim tests...";
+    return 0;
+  }
+
+  {  // test the limit of a session
+    Client client;
+    VINEYARD_CHECK_OK(client.Open(ipc_socket, 16 * kMiB, 64 * kMiB));
+    LOG(INFO) << "Connected to IPCServer: " << client.IPCSocket();
+
+    std::shared_ptr<InstanceStatus> status;
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    CHECK_EQ(status->memory_reserved, 16 * kMiB);
+    CHECK_EQ(status->memory_limit, 64 * kMiB);
+
+    std::vector<ObjectID> blobs;
+    while (true) {
+      std::unique_ptr<BlobWriter> blob;
+      auto s = client.CreateBlob(8 * kMiB, blob);
+      if (!s.ok()) {
+        CHECK(s.IsNotEnoughMemory());
+        break;
+      }
+      blobs.emplace_back(blob->id());
+      blob->Seal(client);
+    }
+    CHECK_EQ(blobs.size(), 8);
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    CHECK_EQ(status->memory_usage, 64 * kMiB);
+
+    // the memory goes back to the quota of the session
+    VINEYARD_CHECK_OK(client.DelData(blobs));
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    CHECK_EQ(status->memory_usage, 0);
+    std::unique_ptr<BlobWriter> blob;
+    VINEYARD_CHECK_OK(client.CreateBlob(32 * kMiB, blob));
+    LOG(INFO) << "Passed session limit test...";
+
+    client.CloseSession();
+  }
+
+  {  // test sessions don't starve each other
+    Client client1, client2;
+    VINEYARD_CHECK_OK(client1.Open(ipc_socket, 0, 32 * kMiB));
+    VINEYARD_CHECK_OK(client2.Open(ipc_socket, 0, 32 * kMiB));
+
+    std::unique_ptr<BlobWriter> blob1, blob2;
+    VINEYARD_CHECK_OK(client1.CreateBlob(32 * kMiB, blob1));
+    CHECK(client1.CreateBlob(kMiB, blob2).IsNotEnoughMemory());
+    VINEYARD_CHECK_OK(client2.CreateBlob(32 * kMiB, blob2));
+    LOG(INFO) << "Passed session isolation test...";
+
+    client1.CloseSession();
+    client2.CloseSession();
+  }
+
+  {  // test the reservations cannot exceed the shared memory
+    Client client;
+    auto s = client.Open(ipc_socket, std::numeric_limits<size_t>::max() / 2,
+                         std::numeric_limits<size_t>::max() / 2);
+    CHECK(!s.ok());
+    // vineyardd is still alive
+    VINEYARD_CHECK_OK(client.Open(ipc_socket));
+    client.CloseSession();
+    LOG(INFO) << "Passed session reservation test...";
+  }
+
+  LOG(INFO) << "Passed session quota tests...";
+  return 0;
+}
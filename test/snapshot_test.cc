@@ -0,0 +1,148 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include "arrow/api.h"
+#include "arrow/io/api.h"
+
+#include "basic/ds/array.h"
+#include "basic/ds/tensor.h"
+#include "client/client.h"
+#include "client/ds/object_meta.h"
+#include "client/snapshot.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("usage ./snapshot_test <ipc_socket>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  char path_template[] = "/tmp/vineyard_snapshot_XXXXXX";
+  CHECK(mkdtemp(path_template) != nullptr);
+  std::string path = path_template;
+
+  {
+    std::vector<double> double_array = {1.0, 7.0, 3.0, 4.0, 2.0};
+    ArrayBuilder<double> builder(client, double_array);
+    auto sealed =
+        std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+    VINEYARD_CHECK_OK(SnapshotObject(client, sealed->id(), path + "/array"));
+
+    for (auto mode :
+         {SnapshotRestoreMode::kMmapCopy, SnapshotRestoreMode::kRead}) {
+      ObjectID restored_id = InvalidObjectID();
+      VINEYARD_CHECK_OK(
+          RestoreObject(client, path + "/array", restored_id, mode, 2));
+      CHECK(restored_id != sealed->id());
+      auto restored = std::dynamic_pointer_cast<Array<double>>(
+          client.GetObject(restored_id));
+      CHECK_EQ(restored->size(), double_array.size());
+      for (size_t i = 0; i < double_array.size(); ++i) {
+        CHECK_EQ((*restored)[i], double_array[i]);
+      }
+      VINEYARD_CHECK_OK(client.DelData(restored_id));
+    }
+    VINEYARD_CHECK_OK(client.DelData(sealed->id()));
+    LOG(INFO) << "Passed array snapshot tests...";
+  }
+
+  {
+    TensorBuilder<double> builder(client, {256, 1024});
+    double* data = builder.data();
+    for (int i = 0; i < 256 * 1024; ++i) {
+      data[i] = i;
+    }
+    auto sealed =
+        std::dynamic_pointer_cast<Tensor<double>>(builder.Seal(client));
+    VINEYARD_CHECK_OK(
+        SnapshotObject(client, sealed->id(), path + "/tensor", 4));
+    // snapshots again into the same directory
+    VINEYARD_CHECK_OK(
+        SnapshotObject(client, sealed->id(), path + "/tensor", 4));
+
+    ObjectID restored_id = InvalidObjectID();
+    VINEYARD_CHECK_OK(RestoreObject(client, path + "/tensor", restored_id));
+    auto restored = std::dynamic_pointer_cast<Tensor<double>>(
+        client.GetObject(restored_id));
+    auto tensor = restored->ArrowTensor();
+    CHECK_EQ(tensor->shape()[0], 256);
+    CHECK_EQ(tensor->shape()[1], 1024);
+    const double* restored_data = restored->data();
+    for (int i = 0; i < 256 * 1024; ++i) {
+      CHECK_EQ(restored_data[i], i);
+    }
+    VINEYARD_CHECK_OK(client.DelData(restored_id));
+
+    // a truncated snapshot is rejected rather than faulting when mapped
+    CHECK_EQ(truncate((path + "/tensor/blobs").c_str(), 4096), 0);
+    for (auto mode :
+         {SnapshotRestoreMode::kMmapCopy, SnapshotRestoreMode::kRead}) {
+      CHECK(!RestoreObject(client, path + "/tensor", restored_id, mode).ok());
+    }
+    VINEYARD_CHECK_OK(client.DelData(sealed->id()));
+    LOG(INFO) << "Passed tensor snapshot tests...";
+  }
+
+  {
+    // the shared members are restored once
+    std::vector<double> double_array = {1.0, 7.0, 3.0};
+    ArrayBuilder<double> builder(client, double_array);
+    auto array = builder.Seal(client);
+    ObjectMeta meta;
+    meta.SetTypeName("vineyard::SharedPair");
+    meta.AddMember("first", array);
+    meta.AddMember("second", array);
+    ObjectID pair_id = InvalidObjectID();
+    VINEYARD_CHECK_OK(client.CreateMetaData(meta, pair_id));
+    VINEYARD_CHECK_OK(SnapshotObject(client, pair_id, path + "/pair"));
+
+    ObjectID restored_id = InvalidObjectID();
+    VINEYARD_CHECK_OK(RestoreObject(client, path + "/pair", restored_id));
+    ObjectMeta restored;
+    VINEYARD_CHECK_OK(client.GetMetaData(restored_id, restored));
+    CHECK_EQ(restored.GetMemberMeta("first").GetId(),
+             restored.GetMemberMeta("second").GetId());
+    CHECK(restored.GetMemberMeta("first").GetId() != array->id());
+    VINEYARD_CHECK_OK(client.DelData(restored_id));
+    VINEYARD_CHECK_OK(client.DelData(pair_id));
+    LOG(INFO) << "Passed shared members snapshot tests...";
+  }
+
+  {
+    ObjectID restored_id = InvalidObjectID();
+    CHECK(!RestoreObject(client, path + "/not_exists", restored_id).ok());
+  }
+
+  CHECK_EQ(system(("rm -rf " + path).c_str()), 0);
+
+  LOG(INFO) << "Passed snapshot tests...";
+
+  client.Disconnect();
+
+  return 0;
+}
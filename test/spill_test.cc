@@ -15,6 +15,7 @@ limitations under the License.
 
 #include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "arrow/api.h"
@@ -171,12 +172,164 @@ void ReloadTest(Client& client) {
   }
 }
 
+void PinTest(Client& client) {
+  LOG(INFO) << "Start Pin Test...";
+  auto double_array = InitArray<double>(50, [](int i) { return i; });
+  auto scratch_array = InitArray<double>(100, [](int i) { return -i; });
+  ObjectID id, bid;
+  {
+    ArrayBuilder<double> builder(client, double_array);
+    auto sealed_double_array =
+        std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+    id = sealed_double_array->id();
+    bid = GetObjectID(sealed_double_array);
+    VINEYARD_CHECK_OK(client.Pin(id));
+    VINEYARD_CHECK_OK(client.Release({id, bid}));
+  }
+  {
+    bool is_spilled{true}, is_pinned{false};
+    SpillPriority priority = SpillPriority::kLow;
+    VINEYARD_CHECK_OK(client.IsSpilled(bid, is_spilled, priority, is_pinned));
+    CHECK(!is_spilled);
+    CHECK(is_pinned);
+    CHECK(priority == SpillPriority::kNormal);
+  }
+  // the scratch blobs are spilled first, and the pinned blob never
+  std::vector<ObjectID> scratch_bids;
+  for (int i = 0; i < 3; ++i) {
+    ArrayBuilder<double> builder(client, scratch_array);
+    auto sealed_scratch_array =
+        std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+    auto scratch_id = sealed_scratch_array->id();
+    scratch_bids.push_back(GetObjectID(sealed_scratch_array));
+    VINEYARD_CHECK_OK(client.SetSpillPriority(scratch_id, SpillPriority::kLow));
+    VINEYARD_CHECK_OK(client.Release({scratch_id, scratch_bids.back()}));
+  }
+  {
+    bool is_spilled{false}, is_pinned{true};
+    SpillPriority priority = SpillPriority::kNormal;
+    VINEYARD_CHECK_OK(client.IsSpilled(scratch_bids.front(), is_spilled,
+                                       priority, is_pinned));
+    CHECK(is_spilled);
+    CHECK(!is_pinned);
+    CHECK(priority == SpillPriority::kLow);
+    VINEYARD_CHECK_OK(client.IsSpilled(bid, is_spilled));
+    CHECK(!is_spilled);
+  }
+  {
+    std::shared_ptr<InstanceStatus> status;
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    CHECK_GE(status->cold_blobs["pinned"]["objects"].get<int64_t>(), 1);
+    CHECK_GE(status->cold_blobs["low"]["spilled_objects"].get<int64_t>(), 1);
+  }
+  VINEYARD_CHECK_OK(client.Unpin(id));
+  {
+    bool is_spilled{false}, is_pinned{true};
+    SpillPriority priority = SpillPriority::kLow;
+    VINEYARD_CHECK_OK(client.IsSpilled(bid, is_spilled, priority, is_pinned));
+    CHECK(!is_pinned);
+    auto double_array_copy = client.GetObject<Array<double>>(id);
+    CHECK(double_array_copy->size() == double_array.size());
+    for (size_t i = 0; i < double_array.size(); i++) {
+      CHECK(abs(double_array[i] - (*double_array_copy)[i]) < delta);
+    }
+  }
+  LOG(INFO) << "Finish Pin Test...";
+}
+
+// the pins of different clients are counted, one's unpin doesn't unpin the
+// blob for the other
+void PinCountTest(Client& client1, Client& client2) {
+  LOG(INFO) << "Start Pin Count Test...";
+  auto double_array = InitArray<double>(50, [](int i) { return i; });
+  ObjectID id, bid;
+  {
+    ArrayBuilder<double> builder(client1, double_array);
+    auto sealed_double_array =
+        std::dynamic_pointer_cast<Array<double>>(builder.Seal(client1));
+    id = sealed_double_array->id();
+    bid = GetObjectID(sealed_double_array);
+    VINEYARD_CHECK_OK(client1.Pin(id));
+    VINEYARD_CHECK_OK(client2.Pin(id));
+    VINEYARD_CHECK_OK(client1.Release({id, bid}));
+  }
+  auto check_pinned = [&](bool expected) {
+    bool is_spilled{false}, is_pinned{!expected};
+    SpillPriority priority = SpillPriority::kNormal;
+    VINEYARD_CHECK_OK(
+        client1.IsSpilled(bid, is_spilled, priority, is_pinned));
+    CHECK_EQ(is_pinned, expected);
+  };
+  VINEYARD_CHECK_OK(client2.Unpin(id));
+  check_pinned(true);
+  VINEYARD_CHECK_OK(client1.Unpin(id));
+  check_pinned(false);
+  // unpinning a blob that isn't pinned has no effect
+  VINEYARD_CHECK_OK(client2.Unpin(id));
+  VINEYARD_CHECK_OK(client1.Pin(id));
+  check_pinned(true);
+  VINEYARD_CHECK_OK(client1.Unpin(id));
+  check_pinned(false);
+  LOG(INFO) << "Finish Pin Count Test...";
+}
+
+// the cold blobs that compress well are moved to the compressed tier rather
+// than to disk, and are decompressed back when accessed again
+void CompressedTierTest(Client& client) {
+  LOG(INFO) << "Start Compressed Tier Test...";
+  auto tier_counter = [&client](const std::string& name) {
+    std::shared_ptr<InstanceStatus> status;
+    VINEYARD_CHECK_OK(client.InstanceStatus(status));
+    return status->compressed_tier.value(name, size_t{0});
+  };
+  size_t compressed_objects = tier_counter("compressed_objects");
+  size_t decompressed_objects = tier_counter("decompressed_objects");
+
+  auto zeros_array = InitArray<double>(150, [](int) { return 0.0; });
+  auto scratch_array = InitArray<double>(150, [](int i) { return -i; });
+  ObjectID id, bid;
+  {
+    ArrayBuilder<double> builder(client, zeros_array);
+    auto sealed_double_array =
+        std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+    id = sealed_double_array->id();
+    bid = GetObjectID(sealed_double_array);
+    VINEYARD_CHECK_OK(client.Release({id, bid}));
+  }
+  // pushes the zeros out of the shared memory
+  for (int i = 0; i < 3; ++i) {
+    ArrayBuilder<double> builder(client, scratch_array);
+    auto sealed_scratch_array =
+        std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+    VINEYARD_CHECK_OK(client.Release(
+        {sealed_scratch_array->id(), GetObjectID(sealed_scratch_array)}));
+  }
+  {
+    bool is_spilled{false};
+    VINEYARD_CHECK_OK(client.IsSpilled(bid, is_spilled));
+    CHECK(is_spilled);
+    CHECK_GT(tier_counter("compressed_objects"), compressed_objects);
+    CHECK_GE(tier_counter("objects"), 1);
+  }
+  {
+    auto double_array_copy = client.GetObject<Array<double>>(id);
+    CHECK(double_array_copy->size() == zeros_array.size());
+    for (size_t i = 0; i < zeros_array.size(); i++) {
+      CHECK(abs((*double_array_copy)[i]) < delta);
+    }
+    CHECK_GT(tier_counter("decompressed_objects"), decompressed_objects);
+  }
+  LOG(INFO) << "Finish Compressed Tier Test...";
+}
+
 int main(int argc, char** argv) {
   if (argc < 2) {
-    printf("usage ./spill_test <ipc_socket>");
+    printf("usage ./spill_test <ipc_socket> [compressed]");
     return 1;
   }
   std::string ipc_socket = std::string(argv[1]);
+  // whether vineyardd runs with the compressed tier
+  bool compressed = argc > 2 && std::string(argv[2]) == "compressed";
 
   Client client1, client2;
   VINEYARD_CHECK_OK(client1.Connect(ipc_socket));
@@ -185,6 +338,11 @@ int main(int argc, char** argv) {
 
   BasicTest(client1);
   ReloadTest(client2);
+  PinTest(client1);
+  PinCountTest(client1, client2);
+  if (compressed) {
+    CompressedTierTest(client2);
+  }
   // TODO(ZjuYTW): add more complex tests...
 
   LOG(INFO) << "Passed spill tests ...";
@@ -0,0 +1,101 @@
+/** Copyright 2020-2021 Alibaba Group Holding Limited.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "basic/ds/array.h"
+#include "client/client.h"
+#include "common/util/logging.h"
+
+using namespace vineyard;  // NOLINT(build/namespaces)
+
+// the memory usage of the connected vineyardd
+size_t MemoryUsage(Client& client) {
+  std::shared_ptr<InstanceStatus> status;
+  VINEYARD_CHECK_OK(client.InstanceStatus(status));
+  return status->memory_usage;
+}
+
+// The test runs twice against a vineyardd launched with `--meta local` and
+// `--state_path`: the "put" phase creates a named array, then vineyardd is
+// restarted (stopped, or killed) and the "get" phase expects the same object
+// back, with its memory still accounted to the instance.
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printf("usage ./warm_restart_test <ipc_socket> <put|get>");
+    return 1;
+  }
+  std::string ipc_socket = std::string(argv[1]);
+  std::string phase = std::string(argv[2]);
+
+  Client client;
+  VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+  LOG(INFO) << "Connected to IPCServer: " << ipc_socket;
+
+  // large enough to dominate the other blobs of the instance
+  std::vector<double> double_array(1024 * 1024);
+  for (size_t i = 0; i < double_array.size(); ++i) {
+    double_array[i] = static_cast<double>(i);
+  }
+  size_t array_bytes = double_array.size() * sizeof(double);
+
+  if (phase == "put") {
+    size_t usage = MemoryUsage(client);
+    ArrayBuilder<double> builder(client, double_array);
+    auto array = std::dynamic_pointer_cast<Array<double>>(builder.Seal(client));
+    VINEYARD_CHECK_OK(client.Persist(array->id()));
+    VINEYARD_CHECK_OK(client.PutName(array->id(), "warm_restart_array"));
+    CHECK_GE(MemoryUsage(client), usage + array_bytes);
+    LOG(INFO) << "put array " << ObjectIDToString(array->id());
+  } else {
+    // the reattached blobs are charged to the instance
+    size_t usage = MemoryUsage(client);
+    CHECK_GE(usage, array_bytes);
+
+    ObjectID id = InvalidObjectID();
+    VINEYARD_CHECK_OK(client.GetName("warm_restart_array", id));
+    auto array = std::dynamic_pointer_cast<Array<double>>(client.GetObject(id));
+    CHECK(array != nullptr);
+    CHECK_EQ(array->size(), double_array.size());
+    for (size_t i = 0; i < double_array.size(); ++i) {
+      CHECK_EQ((*array)[i], double_array[i]);
+    }
+    LOG(INFO) << "get array " << ObjectIDToString(id);
+
+    VINEYARD_CHECK_OK(client.DropName("warm_restart_array"));
+    VINEYARD_CHECK_OK(client.DelData(id));
+    array = nullptr;
+    client.Disconnect();
+
+    // and given back when deleted, once the blob is no longer in use
+    VINEYARD_CHECK_OK(client.Connect(ipc_socket));
+    for (int retries = 0;
+         retries < 10 && MemoryUsage(client) + array_bytes > usage;
+         ++retries) {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    CHECK_LE(MemoryUsage(client) + array_bytes, usage);
+  }
+
+  LOG(INFO) << "Passed warm restart test (" << phase << ")...";
+
+  client.Disconnect();
+
+  return 0;
+}